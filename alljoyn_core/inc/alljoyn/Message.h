@@ -27,6 +27,7 @@
 
 #include <qcc/platform.h>
 #include <qcc/String.h>
+#include <qcc/AtomTable.h>
 #include <qcc/ManagedObj.h>
 
 #include <alljoyn/MsgArg.h>
@@ -157,6 +158,7 @@ class HeaderFields {
 class _Message;
 class _RemoteEndpoint;
 class BusAttachment;
+class MessageBufferPool;
 
 /**
  * @cond ALLJOYN_DEV
@@ -448,6 +450,37 @@ class _Message {
         }
     }
 
+    /**
+     * Get the interned atom for the interface of this message. Comparing atoms is cheaper
+     * than comparing the names they stand for.
+     *
+     * @return
+     *      - The atom for the interface name
+     *      - qcc::AtomTable::NONE if there is no interface
+     *      - qcc::AtomTable::UNKNOWN if the interface name has not been interned
+     */
+    qcc::Atom GetInterfaceAtom() const {
+        if (ifaceAtom == ATOM_UNRESOLVED) {
+            ifaceAtom = qcc::AtomTable::Lookup(GetInterface());
+        }
+        return ifaceAtom;
+    }
+
+    /**
+     * Get the interned atom for the member (method/signal) name of this message.
+     *
+     * @return
+     *      - The atom for the member name
+     *      - qcc::AtomTable::NONE if there is no member name
+     *      - qcc::AtomTable::UNKNOWN if the member name has not been interned
+     */
+    qcc::Atom GetMemberNameAtom() const {
+        if (memberAtom == ATOM_UNRESOLVED) {
+            memberAtom = qcc::AtomTable::Lookup(GetMemberName());
+        }
+        return memberAtom;
+    }
+
     /**
      * Accessor function to get the reply serial number for the message. Only meaningful for #MESSAGE_METHOD_RET
      * @return
@@ -625,6 +658,18 @@ class _Message {
      */
     _Message(const _Message& other);
 
+    /**
+     * @internal
+     * Construct a message for another bus attachment in the same process that shares the
+     * message buffer of another message instead of copying it. The other message is kept
+     * alive until this message is destroyed or marshaled again. The other message must not be encrypted or need
+     * an endian swap because unmarshaling those modifies the buffer.
+     *
+     * @param other   The message whose buffer is shared.
+     * @param bus     The bus attachment the new message is delivered to.
+     */
+    _Message(Message& other, BusAttachment& bus);
+
   protected:
 
     /*
@@ -778,7 +823,9 @@ class _Message {
 
     /**
      * @internal
-     * Reads a message from a remote endpoint. If data is not available it returns immediately
+     * Reads a message from a remote endpoint. If data is not available it returns immediately.
+     * Data is pulled through the endpoint's receive buffer so a burst of messages can be read
+     * with a single read on the underlying stream.
      *
      * @param endpoint       The endpoint to marshal the message data from.
      * @param checkSender    True if message's sender field should be validated against the endpoint's unique name.
@@ -816,16 +863,51 @@ class _Message {
      */
     QStatus Deliver(RemoteEndpoint& endpoint);
 
+    /**
+     * @internal
+     * Write position of a marshaled message that is being delivered to a remote endpoint.
+     * The marshaled buffer is shared by all endpoints the message is routed to so each
+     * endpoint keeps its own cursor rather than a copy of the message.
+     */
+    struct WriteCursor {
+        AllJoynMessageState state;  ///< The current state of the message during write.
+        const uint8_t* ptr;         ///< Pointer to the current write position in the buffer.
+        size_t count;               ///< Number of bytes remaining to write for completion of the message.
+
+        WriteCursor() : state(MESSAGE_NEW), ptr(NULL), count(0) { }
+    };
+
     /**
      * @internal
      * Deliver a marshaled message to a remote endpoint. Non-blocking
      *
      * @param endpoint   Endpoint to receive marshaled message.
+     * @param cursor     The endpoint's write position in this message.
      * @return
      *      - #ER_OK if successful
      *      - An error status otherwise
      */
-    QStatus DeliverNonBlocking(RemoteEndpoint& endpoint);
+    QStatus DeliverNonBlocking(RemoteEndpoint& endpoint, WriteCursor& cursor);
+    /**
+     * @internal
+     * Get the marshaled bytes of a message that can be written to a remote endpoint as is,
+     * i.e. a message that is not empty, has no handles, does not need to be encrypted and has
+     * not expired.
+     *
+     * @param[out] buf   The marshaled message.
+     * @param[out] len   Length of the marshaled message.
+     * @return  true if the message can be written as is.
+     */
+    bool GetDeliveryBuffer(const uint8_t*& buf, size_t& len);
+
+    /**
+     * @internal
+     * Get the length of the marshaled message.
+     *
+     * @return  Number of bytes in the marshaled message.
+     */
+    size_t GetBufferLength() const { return bufEOD - reinterpret_cast<const uint8_t*>(msgBuf); }
+
     /**
      * @internal
      * Marshal the message again with the new sender name if one was provided.
@@ -926,6 +1008,8 @@ class _Message {
 
     MessageHeader msgHeader;     ///< Current message header.
     uint8_t* _msgBuf;            ///< Pointer to the current msg buffer.
+    MessageBufferPool* bufPool;  ///< Pool that _msgBuf was borrowed from or NULL if it was allocated.
+    Message bufOwner;            ///< Message that owns msgBuf when the buffer is shared with another message.
     uint64_t* msgBuf;            ///< Pointer to the current msg buffer (8 byte aligned pointer into _msgBuf).
     MsgArg* msgArgs;             ///< Pointer to the unmarshaled arguments.
     uint8_t numMsgArgs;          ///< Number of message args (signature cannot be longer than 255 chars).
@@ -953,16 +1037,32 @@ class _Message {
     size_t countRead;               ///< Number of bytes remaining to read for completion of the message.
     size_t maxFds;                  ///< Store the number of max FDs for the endpoint, so it doesnt need to be calculated each time.
 
-    AllJoynMessageState writeState; ///< The current state of the message during write.
-    uint8_t* writePtr;              ///< Pointer to the current write position in the buffer.
-    size_t countWrite;              ///< Number of bytes remaining to write for completion of the message.
-
     /**
      * The header fields for this message. Which header fields are present depends on the message
      * type defined in the message header.
      */
     HeaderFields hdrFields;
 
+    /** Value of an atom that has not been looked up yet */
+    static const qcc::Atom ATOM_UNRESOLVED = qcc::AtomTable::UNKNOWN - 1;
+
+    mutable qcc::Atom ifaceAtom;    ///< Atom for the interface header field, looked up on first use.
+    mutable qcc::Atom memberAtom;   ///< Atom for the member header field, looked up on first use.
+
+    /**
+     * Forget the atoms looked up for the header fields. Must be called whenever the interface
+     * or member header fields are changed.
+     */
+    void ResetAtoms() { ifaceAtom = memberAtom = ATOM_UNRESOLVED; }
+
+    /**
+     * Free a message buffer, putting it back in the pool it was borrowed from if there is one.
+     *
+     * @param buf   The buffer to free, may be NULL.
+     * @param pool  The pool the buffer was borrowed from or NULL if it was allocated.
+     */
+    static void FreeBuf(uint8_t* buf, MessageBufferPool* pool);
+
     /* Internal methods unmarshal side */
 
     void ClearHeader();
@@ -1008,8 +1108,8 @@ class _Message {
     qcc::String ToString(const MsgArg* args, size_t numArgs) const;
 
     /* Internal methods for read */
-    inline QStatus InterpretHeader();
-    QStatus PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic = true, uint32_t timeout = 0);
+    inline QStatus InterpretHeader(MessageBufferPool* pool);
+    QStatus PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic = true, uint32_t timeout = 0, bool buffered = false);
 };
 
 }
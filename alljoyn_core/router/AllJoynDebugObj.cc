@@ -26,9 +26,11 @@
 #include <qcc/platform.h>
 
 #include <assert.h>
+#include <string.h>
 
 #include <map>
 
+#include <qcc/AtomTable.h>
 #include <qcc/Log.h>
 #include <qcc/String.h>
 #include <qcc/StringMapKey.h>
@@ -46,6 +48,8 @@ using namespace debug;
  */
 AllJoynDebugObj* AllJoynDebugObj::self = NULL;
 
+static const char* AtomTableInterfaceName = "org.alljoyn.Debug.AtomTable";
+
 
 AllJoynDebugObj* AllJoynDebugObj::GetAllJoynDebugObj()
 {
@@ -75,6 +79,9 @@ QStatus AllJoynDebugObj::Init()
 
         status = AddMethodHandlers(methodEntries, ArraySize(methodEntries));
 
+        if (status == ER_OK) {
+            status = AddAtomTableInterface();
+        }
         if (status == ER_OK) {
             status = bus->RegisterBusObject(*this);
         }
@@ -82,6 +89,56 @@ QStatus AllJoynDebugObj::Init()
     return status;
 }
 
+QStatus AllJoynDebugObj::AddAtomTableInterface()
+{
+    InterfaceDescription* ifc;
+    QStatus status = bus->CreateInterface(AtomTableInterfaceName, ifc);
+    if (status != ER_OK) {
+        return status;
+    }
+    const Properties::Info* propInfo;
+    size_t propInfoSize;
+    atomTableProperties.GetProperyInfo(propInfo, propInfoSize);
+    for (size_t i = 0; i < propInfoSize; ++i) {
+        ifc->AddProperty(propInfo[i].name, propInfo[i].signature, propInfo[i].access);
+    }
+    ifc->Activate();
+
+    status = AddInterface(*ifc);
+    if (status == ER_OK) {
+        properties.insert(std::pair<qcc::StringMapKey, Properties*>(AtomTableInterfaceName, &atomTableProperties));
+    }
+    return status;
+}
+
+QStatus AllJoynDebugObj::AtomTableProperties::Get(const char* propName, MsgArg& val) const
+{
+    qcc::AtomTable::Stats stats;
+    qcc::AtomTable::GetStats(stats);
+    if (strcmp(propName, "Size") == 0) {
+        return val.Set("u", static_cast<uint32_t>(stats.size));
+    } else if (strcmp(propName, "Capacity") == 0) {
+        return val.Set("u", static_cast<uint32_t>(stats.capacity));
+    } else if (strcmp(propName, "Lookups") == 0) {
+        return val.Set("t", stats.lookups);
+    } else if (strcmp(propName, "Hits") == 0) {
+        return val.Set("t", stats.hits);
+    }
+    return ER_BUS_NO_SUCH_PROPERTY;
+}
+
+void AllJoynDebugObj::AtomTableProperties::GetProperyInfo(const Info*& info, size_t& infoSize)
+{
+    static const Info atomTableInfo[] = {
+        { "Size",     "u", PROP_ACCESS_READ },
+        { "Capacity", "u", PROP_ACCESS_READ },
+        { "Lookups",  "t", PROP_ACCESS_READ },
+        { "Hits",     "t", PROP_ACCESS_READ }
+    };
+    info = atomTableInfo;
+    infoSize = ArraySize(atomTableInfo);
+}
+
 
 QStatus AllJoynDebugObj::AddDebugInterface(AllJoynDebugObjAddon* addon,
                                            const char* ifaceName,
@@ -164,8 +164,27 @@ class AllJoynDebugObj : public BusObject {
 
     void GenericMethodHandler(const InterfaceDescription::Member* member, Message& msg);
 
+    /**
+     * Read-only properties of the org.alljoyn.Debug.AtomTable interface: the size of the atom
+     * table and how many atom lookups find an interned string.
+     */
+    class AtomTableProperties : public Properties {
+      public:
+        QStatus Get(const char* propName, MsgArg& val) const;
+        void GetProperyInfo(const Info*& info, size_t& infoSize);
+    };
+
+    /**
+     * Add the org.alljoyn.Debug.AtomTable interface to this object.
+     *
+     * @return ER_OK if successful.
+     */
+    QStatus AddAtomTableInterface();
+
     BusController* busController;
 
+    AtomTableProperties atomTableProperties;
+
     PropertyStore properties;
 
     AddonMethodHandlerMap methodHandlerMap;
@@ -441,7 +441,7 @@ void AllJoynObj::UnbindSessionPort(const InterfaceDescription::Member* member, M
     SessionMapType::iterator it = SessionMapLowerBound(sender, 0);
     while ((it != sessionMap.end()) && (it->first.first == sender) && (it->first.second == 0)) {
         if (it->second.sessionPort == sessionPort) {
-            sessionMap.erase(it);
+            SessionMapErase(it);
             replyCode = ALLJOYN_UNBINDSESSIONPORT_REPLY_SUCCESS;
             break;
         }
@@ -658,7 +658,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                             /* Add (local) joiner to list of session members since no AttachSession will be sent */
                             SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, newSessionId);
                             if (smEntry) {
-                                smEntry->memberNames.push_back(sender);
+                                ajObj.SessionMapAddMember(*smEntry, sender);
                                 smEntry->isInitializing = false;
                                 sme = *smEntry;
                             } else {
@@ -685,7 +685,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                             SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, sme.id);
                             if (smEntry) {
                                 smEntry->fd = fds[0];
-                                smEntry->memberNames.push_back(sender);
+                                ajObj.SessionMapAddMember(*smEntry, sender);
 
                                 /* Create a joiner side entry in sessionMap */
                                 SessionMapEntry sme2 = sme;
@@ -723,8 +723,12 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
 
             /* Check for existing multipoint session */
             if (vSessionEp->IsValid() && optsIn.isMultipoint) {
-                SessionMapType::iterator it = ajObj.sessionMap.begin();
-                while (it != ajObj.sessionMap.end()) {
+                /* Only sessions the host has been part of need to be examined */
+                vector<SessionMapType::iterator> hostEntries;
+                ajObj.SessionMapNameEntries(vSessionEp->GetUniqueName(), hostEntries);
+                vector<SessionMapType::iterator>::iterator hit = hostEntries.begin();
+                while (hit != hostEntries.end()) {
+                    SessionMapType::iterator it = *hit++;
                     if ((it->second.sessionHost == vSessionEp->GetUniqueName()) && (it->second.sessionPort == sessionPort)) {
                         if (it->second.opts.IsCompatible(optsIn)) {
                             b2bEp = vSessionEp->GetBusToBusEndpoint(it->second.id);
@@ -738,7 +742,6 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                         }
                         break;
                     }
-                    ++it;
                 }
             }
 
@@ -999,7 +1002,7 @@ ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunJoin()
                 /* Add joiner to any local member's sessionMap entry  since no AttachSession is sent */
                 SessionMapEntry* smEntry = ajObj.SessionMapFind(member, id);
                 if (smEntry) {
-                    smEntry->memberNames.push_back(sender);
+                    ajObj.SessionMapAddMember(*smEntry, sender);
                 }
                 /* Multipoint session member is local to this daemon. Send MPSessionChanged */
                 if (optsOut.isMultipoint) {
@@ -1525,7 +1528,7 @@ qcc::ThreadReturn STDCALL AllJoynObj::JoinSessionThread::RunAttach()
                         SessionMapEntry* smEntry = ajObj.SessionMapFind(sme.endpointName, sme.id);
                         /* Update sessionMap */
                         if (smEntry) {
-                            smEntry->memberNames.push_back(srcStr);
+                            ajObj.SessionMapAddMember(*smEntry, srcStr);
                             id = smEntry->id;
                             destIsLocal = true;
                             creatorName = creatorEp->GetUniqueName();
@@ -1820,68 +1823,61 @@ void AllJoynObj::RemoveSessionRefs(const char* epName, SessionId id, bool sendSe
     SessionMapEntry smeRemoved;
     bool foundSME = false;
 
-    SessionMapType::iterator it = sessionMap.begin();
-    /* Look through sessionMap for entries matching id */
-    while (it != sessionMap.end()) {
-        if (it->first.second == id) {
-            if (it->first.first == epNameStr) {
-                /* Exact key matches are removed */
-
-                if (sendSessionLost) {
-                    smeRemoved = it->second;
-                    pair<String, SessionId> key = it->first;
-
-                    epChangedSessionMembers.push_back(smeRemoved.sessionHost);
-                    vector<String>::iterator mit = smeRemoved.memberNames.begin();
-                    while (mit != smeRemoved.memberNames.end()) {
-                        if (epNameStr != *mit) {
-                            epChangedSessionMembers.push_back(*mit++);
-                        } else {
-                            ++mit;
-                        }
+    /* Look through the sessionMap entries of session id */
+    vector<SessionMapType::iterator> entries;
+    SessionMapIdEntries(id, entries);
+    vector<SessionMapType::iterator>::iterator eit = entries.begin();
+    while (eit != entries.end()) {
+        SessionMapType::iterator it = *eit++;
+        if (it->first.first == epNameStr) {
+            /* Exact key matches are removed */
+
+            if (sendSessionLost) {
+                smeRemoved = it->second;
+
+                epChangedSessionMembers.push_back(smeRemoved.sessionHost);
+                vector<String>::iterator mit = smeRemoved.memberNames.begin();
+                while (mit != smeRemoved.memberNames.end()) {
+                    if (epNameStr != *mit) {
+                        epChangedSessionMembers.push_back(*mit++);
+                    } else {
+                        ++mit;
                     }
-                    sessionMap.erase(it++);
-                    foundSME = true;
-                } else {
-                    sessionMap.erase(it++);
                 }
+                SessionMapErase(it);
+                foundSME = true;
             } else {
-                if (endpoint == router.FindEndpoint(it->second.sessionHost)) {
-                    /* Modify entry to remove matching sessionHost */
-                    it->second.sessionHost.clear();
-                    if (it->second.opts.isMultipoint) {
-                        changedSessionMembers.push_back(it->first);
-                    }
-                } else {
-                    /* Remove matching session members */
-                    vector<String>::iterator mit = it->second.memberNames.begin();
-                    while (mit != it->second.memberNames.end()) {
-                        if (epNameStr == *mit) {
-                            mit = it->second.memberNames.erase(mit);
-                            if (it->second.opts.isMultipoint) {
-                                changedSessionMembers.push_back(it->first);
-                            }
-                        } else {
-                            ++mit;
-                        }
-                    }
+                SessionMapErase(it);
+            }
+        } else {
+            if (endpoint == router.FindEndpoint(it->second.sessionHost)) {
+                /* Modify entry to remove matching sessionHost */
+                it->second.sessionHost.clear();
+                if (it->second.opts.isMultipoint) {
+                    changedSessionMembers.push_back(it->first);
                 }
-                /* Session is lost when members + sessionHost together contain only one entry */
-                if ((it->second.fd == -1) && (it->second.memberNames.empty() || ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty()))) {
-                    SessionMapEntry tsme = it->second;
-                    pair<String, SessionId> key = it->first;
-                    if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
+            } else {
+                /* Remove matching session members */
+                vector<String>::iterator mit = it->second.memberNames.begin();
+                while (mit != it->second.memberNames.end()) {
+                    if (epNameStr == *mit) {
+                        mit = it->second.memberNames.erase(mit);
+                        if (it->second.opts.isMultipoint) {
+                            changedSessionMembers.push_back(it->first);
+                        }
                     } else {
-                        ++it;
+                        ++mit;
                     }
-                    sessionsLost.push_back(tsme);
-                } else {
-                    ++it;
                 }
             }
-        } else {
-            ++it;
+            /* Session is lost when members + sessionHost together contain only one entry */
+            if ((it->second.fd == -1) && (it->second.memberNames.empty() || ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty()))) {
+                SessionMapEntry tsme = it->second;
+                if (!it->second.isInitializing) {
+                    SessionMapErase(it);
+                }
+                sessionsLost.push_back(tsme);
+            }
         }
     }
     ReleaseLocks();
@@ -1932,57 +1928,58 @@ void AllJoynObj::RemoveSessionRefs(const String& vepName, const String& b2bEpNam
 
     vector<pair<String, SessionId> > changedSessionMembers;
     vector<SessionMapEntry> sessionsLost;
-    SessionMapType::iterator it = sessionMap.begin();
-    while (it != sessionMap.end()) {
+
+    /*
+     * Examine sessions with ids that are affected by removal of vep through b2bep.
+     * Only sessions that route through a single (matching) b2bEp are affected.
+     */
+    vector<SessionMapType::iterator> entries;
+    set<SessionId> sessionIds;
+    vep->GetSessionIdsForB2B(b2bEp, sessionIds);
+    set<SessionId>::const_iterator iit = sessionIds.begin();
+    while (iit != sessionIds.end()) {
         int count;
+        SessionId id = *iit++;
         /* Skip binding reservations */
-        if (it->first.second == 0) {
-            ++it;
-            continue;
+        if ((id != 0) && (vep->GetBusToBusEndpoint(id, &count) == b2bEp) && (count == 1)) {
+            SessionMapIdEntries(id, entries);
         }
-        /* Examine sessions with ids that are affected by removal of vep through b2bep */
-        /* Only sessions that route through a single (matching) b2bEp are affected */
-        if ((vep->GetBusToBusEndpoint(it->first.second, &count) == b2bEp) && (count == 1)) {
-            if (it->first.first == vepName) {
-                /* Key matches can be removed from sessionMap */
-                sessionMap.erase(it++);
+    }
+    vector<SessionMapType::iterator>::iterator eit = entries.begin();
+    while (eit != entries.end()) {
+        SessionMapType::iterator it = *eit++;
+        if (it->first.first == vepName) {
+            /* Key matches can be removed from sessionMap */
+            SessionMapErase(it);
+        } else {
+            if (BusEndpoint::cast(vep) == router.FindEndpoint(it->second.sessionHost)) {
+                /* If the session's sessionHost is vep, then clear it out of the session */
+                it->second.sessionHost.clear();
+                if (it->second.opts.isMultipoint) {
+                    changedSessionMembers.push_back(it->first);
+                }
             } else {
-                if (BusEndpoint::cast(vep) == router.FindEndpoint(it->second.sessionHost)) {
-                    /* If the session's sessionHost is vep, then clear it out of the session */
-                    it->second.sessionHost.clear();
-                    if (it->second.opts.isMultipoint) {
-                        changedSessionMembers.push_back(it->first);
-                    }
-                } else {
-                    /* Clear vep from any session members */
-                    vector<String>::iterator mit = it->second.memberNames.begin();
-                    while (mit != it->second.memberNames.end()) {
-                        if (vepName == *mit) {
-                            mit = it->second.memberNames.erase(mit);
-                            if (it->second.opts.isMultipoint) {
-                                changedSessionMembers.push_back(it->first);
-                            }
-                        } else {
-                            ++mit;
+                /* Clear vep from any session members */
+                vector<String>::iterator mit = it->second.memberNames.begin();
+                while (mit != it->second.memberNames.end()) {
+                    if (vepName == *mit) {
+                        mit = it->second.memberNames.erase(mit);
+                        if (it->second.opts.isMultipoint) {
+                            changedSessionMembers.push_back(it->first);
                         }
-                    }
-                }
-                /* A session with only one member and no sessionHost or only a sessionHost are "lost" */
-                if ((it->second.fd == -1) && (it->second.memberNames.empty() || ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty()))) {
-                    SessionMapEntry tsme = it->second;
-                    pair<String, SessionId> key = it->first;
-                    if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
                     } else {
-                        ++it;
+                        ++mit;
                     }
-                    sessionsLost.push_back(tsme);
-                } else {
-                    ++it;
                 }
             }
-        } else {
-            ++it;
+            /* A session with only one member and no sessionHost or only a sessionHost are "lost" */
+            if ((it->second.fd == -1) && (it->second.memberNames.empty() || ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty()))) {
+                SessionMapEntry tsme = it->second;
+                if (!it->second.isInitializing) {
+                    SessionMapErase(it);
+                }
+                sessionsLost.push_back(tsme);
+            }
         }
     }
     ReleaseLocks();
@@ -2429,13 +2426,93 @@ AllJoynObj::SessionMapType::iterator AllJoynObj::SessionMapLowerBound(const qcc:
 void AllJoynObj::SessionMapInsert(SessionMapEntry& sme)
 {
     pair<String, SessionId> key(sme.endpointName, sme.id);
-    sessionMap.insert(pair<pair<String, SessionId>, SessionMapEntry>(key, sme));
+    SessionMapType::iterator it = sessionMap.insert(pair<pair<String, SessionId>, SessionMapEntry>(key, sme));
+
+    /* Binding reservations (id 0) are only found by endpointName so they are not indexed */
+    if (sme.id != 0) {
+        SessionIndexEntry& ie = sessionIdIndex[sme.id];
+        it->second.indexPos = ie.entries.size();
+        ie.entries.push_back(it);
+        SessionMapIndexName(sme.id, ie, sme.endpointName);
+        SessionMapIndexName(sme.id, ie, sme.sessionHost);
+        for (size_t i = 0; i < sme.memberNames.size(); ++i) {
+            SessionMapIndexName(sme.id, ie, sme.memberNames[i]);
+        }
+    }
 }
 
 void AllJoynObj::SessionMapErase(SessionMapEntry& sme)
 {
     pair<String, SessionId> key(sme.endpointName, sme.id);
-    sessionMap.erase(key);
+    SessionMapType::iterator it = sessionMap.lower_bound(key);
+    while ((it != sessionMap.end()) && (it->first == key)) {
+        SessionMapErase(it++);
+    }
+}
+
+void AllJoynObj::SessionMapErase(SessionMapType::iterator it)
+{
+    SessionId id = it->first.second;
+    unordered_map<SessionId, SessionIndexEntry>::iterator iit = (id != 0) ? sessionIdIndex.find(id) : sessionIdIndex.end();
+    if (iit != sessionIdIndex.end()) {
+        /* Move the last entry into the place of the erased one so that erasing stays constant time */
+        vector<SessionMapType::iterator>& entries = iit->second.entries;
+        size_t pos = it->second.indexPos;
+        assert((pos < entries.size()) && (entries[pos] == it));
+        entries[pos] = entries.back();
+        entries[pos]->second.indexPos = pos;
+        entries.pop_back();
+        /* Once the last entry of a session is gone the session is dropped from the name index */
+        if (entries.empty()) {
+            set<String>::const_iterator nit = iit->second.names.begin();
+            while (nit != iit->second.names.end()) {
+                map<String, set<SessionId> >::iterator sit = sessionNameIndex.find(*nit++);
+                if (sit != sessionNameIndex.end()) {
+                    sit->second.erase(id);
+                    if (sit->second.empty()) {
+                        sessionNameIndex.erase(sit);
+                    }
+                }
+            }
+            sessionIdIndex.erase(iit);
+        }
+    }
+    sessionMap.erase(it);
+}
+
+void AllJoynObj::SessionMapAddMember(SessionMapEntry& sme, const qcc::String& name)
+{
+    sme.memberNames.push_back(name);
+    unordered_map<SessionId, SessionIndexEntry>::iterator iit = (sme.id != 0) ? sessionIdIndex.find(sme.id) : sessionIdIndex.end();
+    if (iit != sessionIdIndex.end()) {
+        SessionMapIndexName(sme.id, iit->second, name);
+    }
+}
+
+void AllJoynObj::SessionMapIdEntries(SessionId id, vector<SessionMapType::iterator>& entries)
+{
+    unordered_map<SessionId, SessionIndexEntry>::const_iterator iit = (id != 0) ? sessionIdIndex.find(id) : sessionIdIndex.end();
+    if (iit != sessionIdIndex.end()) {
+        entries.insert(entries.end(), iit->second.entries.begin(), iit->second.entries.end());
+    }
+}
+
+void AllJoynObj::SessionMapNameEntries(const qcc::String& name, vector<SessionMapType::iterator>& entries)
+{
+    map<String, set<SessionId> >::const_iterator sit = sessionNameIndex.find(name);
+    if (sit != sessionNameIndex.end()) {
+        set<SessionId>::const_iterator iit = sit->second.begin();
+        while (iit != sit->second.end()) {
+            SessionMapIdEntries(*iit++, entries);
+        }
+    }
+}
+
+void AllJoynObj::SessionMapIndexName(SessionId id, SessionIndexEntry& ie, const qcc::String& name)
+{
+    if (!name.empty() && ie.names.insert(name).second) {
+        sessionNameIndex[name].insert(id);
+    }
 }
 
 void AllJoynObj::SetLinkTimeout(const InterfaceDescription::Member* member, Message& msg)
@@ -3611,67 +3688,65 @@ void AllJoynObj::NameOwnerChanged(const qcc::String& alias, const qcc::String* o
         AcquireLocks();
         vector<pair<String, SessionId> > changedSessionMembers;
         vector<SessionMapEntry> sessionsLost;
-        SessionMapType::iterator it = sessionMap.begin();
-        while (it != sessionMap.end()) {
-            if (it->first.first == alias) {
-                /* If endpoint has gone then just delete the session map entry */
-                sessionMap.erase(it++);
-            } else if (it->first.second != 0) {
-                /* Remove member entries from existing sessions */
-                if (it->second.sessionHost == alias) {
-                    if (it->second.opts.isMultipoint) {
-                        changedSessionMembers.push_back(it->first);
-                    }
-                    it->second.sessionHost.clear();
-                } else {
-                    vector<String>::iterator mit = it->second.memberNames.begin();
-                    while (mit != it->second.memberNames.end()) {
-                        if (*mit == alias) {
-                            it->second.memberNames.erase(mit);
-                            if (it->second.opts.isMultipoint) {
-                                changedSessionMembers.push_back(it->first);
-                            }
-                            break;
+
+        /* If endpoint has gone then just delete its session map entries (including bindings) */
+        SessionMapType::iterator it = SessionMapLowerBound(alias, 0);
+        while ((it != sessionMap.end()) && (it->first.first == alias)) {
+            SessionMapErase(it++);
+        }
+
+        /* Remove member entries from the other sessions the endpoint was part of */
+        vector<SessionMapType::iterator> entries;
+        SessionMapNameEntries(alias, entries);
+        vector<SessionMapType::iterator>::iterator eit = entries.begin();
+        while (eit != entries.end()) {
+            it = *eit++;
+            if (it->second.sessionHost == alias) {
+                if (it->second.opts.isMultipoint) {
+                    changedSessionMembers.push_back(it->first);
+                }
+                it->second.sessionHost.clear();
+            } else {
+                vector<String>::iterator mit = it->second.memberNames.begin();
+                while (mit != it->second.memberNames.end()) {
+                    if (*mit == alias) {
+                        it->second.memberNames.erase(mit);
+                        if (it->second.opts.isMultipoint) {
+                            changedSessionMembers.push_back(it->first);
                         }
-                        ++mit;
+                        break;
                     }
+                    ++mit;
                 }
-                /*
-                 * Remove empty session entry.
-                 * Preserve raw sessions until GetSessionFd is called.
-                 */
-                /*
-                 * If the session is point-to-point and the memberNames are empty.
-                 * if the sessionHost is not empty (implied) and there are no member names send
-                 * the  sessionLost signal as long as the session is not a raw session
-                 */
-                bool noMemberSingleHost = it->second.memberNames.empty();
-                /*
-                 * If the session is a Multipoint session it will list its own unique
-                 * name in the list of memberNames. If There is only one name in the
-                 * memberNames list and there is no session host it is safe to send
-                 * the session lost signal as long as the session does not contain a
-                 * raw session.
-                 */
-                bool singleMemberNoHost = ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty());
-                /*
-                 * as long as the file descriptor is -1 this is not a raw session
-                 */
-                bool noRawSession = (it->second.fd == -1);
-                if ((noMemberSingleHost || singleMemberNoHost) && noRawSession) {
-                    SessionMapEntry tsme = it->second;
-                    pair<String, SessionId> key = it->first;
-                    if (!it->second.isInitializing) {
-                        sessionMap.erase(it++);
-                    } else {
-                        ++it;
-                    }
-                    sessionsLost.push_back(tsme);
-                } else {
-                    ++it;
+            }
+            /*
+             * Remove empty session entry.
+             * Preserve raw sessions until GetSessionFd is called.
+             */
+            /*
+             * If the session is point-to-point and the memberNames are empty.
+             * if the sessionHost is not empty (implied) and there are no member names send
+             * the  sessionLost signal as long as the session is not a raw session
+             */
+            bool noMemberSingleHost = it->second.memberNames.empty();
+            /*
+             * If the session is a Multipoint session it will list its own unique
+             * name in the list of memberNames. If There is only one name in the
+             * memberNames list and there is no session host it is safe to send
+             * the session lost signal as long as the session does not contain a
+             * raw session.
+             */
+            bool singleMemberNoHost = ((it->second.memberNames.size() == 1) && it->second.sessionHost.empty());
+            /*
+             * as long as the file descriptor is -1 this is not a raw session
+             */
+            bool noRawSession = (it->second.fd == -1);
+            if ((noMemberSingleHost || singleMemberNoHost) && noRawSession) {
+                SessionMapEntry tsme = it->second;
+                if (!it->second.isInitializing) {
+                    SessionMapErase(it);
                 }
-            } else {
-                ++it;
+                sessionsLost.push_back(tsme);
             }
         }
         ReleaseLocks();
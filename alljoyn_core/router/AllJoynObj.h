@@ -25,6 +25,7 @@
 #include <qcc/platform.h>
 #include <vector>
 #include <map>
+#include <set>
 
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
@@ -34,6 +35,7 @@
 #include <qcc/SocketTypes.h>
 #include <qcc/Timer.h>
 #include <qcc/GUID.h>
+#include <qcc/STLContainer.h>
 
 #include <alljoyn/BusObject.h>
 #include <alljoyn/Message.h>
@@ -56,6 +58,7 @@ class BusController;
  */
 class AllJoynObj : public BusObject, public NameListener, public TransportListener, public qcc::AlarmListener {
     friend class _RemoteEndpoint;
+    friend class AllJoynObjTest;
 
   public:
     /**
@@ -539,19 +542,30 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
         std::vector<qcc::String> memberNames;
         bool isInitializing;
         bool isRawReady;
+        size_t indexPos;    /**< Position of this entry in the entries of its sessionIdIndex entry */
         SessionMapEntry() :
             id(0),
             sessionPort(0),
             opts(),
             fd(-1),
             isInitializing(false),
-            isRawReady(false) { }
+            isRawReady(false),
+            indexPos(0) { }
     };
 
     typedef std::multimap<std::pair<qcc::String, SessionId>, SessionMapEntry> SessionMapType;
 
     SessionMapType sessionMap;  /**< Map (endpointName,sessionId) to session info */
 
+    /* sessionMap entries of a session */
+    struct SessionIndexEntry {
+        std::vector<SessionMapType::iterator> entries;  /**< sessionMap entries keyed by the session id, in no particular order */
+        std::set<qcc::String> names;                     /**< Names that have been an endpointName, sessionHost or member of the session */
+    };
+
+    std::unordered_map<SessionId, SessionIndexEntry> sessionIdIndex;   /**< Index of sessionMap by sessionId (excludes bindings) */
+    std::map<qcc::String, std::set<SessionId> > sessionNameIndex;       /**< Sessions that each name has been part of */
+
     /*
      * Helper function to get session map interator
      */
@@ -572,6 +586,31 @@ class AllJoynObj : public BusObject, public NameListener, public TransportListen
      */
     void SessionMapErase(SessionMapEntry& sme);
 
+    /**
+     * Helper function to erase a single sesssion map entry
+     */
+    void SessionMapErase(SessionMapType::iterator it);
+
+    /**
+     * Helper function to add a member to a session map entry
+     */
+    void SessionMapAddMember(SessionMapEntry& sme, const qcc::String& name);
+
+    /**
+     * Helper function to get the session map entries of a session (not including bindings)
+     */
+    void SessionMapIdEntries(SessionId id, std::vector<SessionMapType::iterator>& entries);
+
+    /**
+     * Helper function to get the session map entries of the sessions a name has been part of
+     */
+    void SessionMapNameEntries(const qcc::String& name, std::vector<SessionMapType::iterator>& entries);
+
+    /**
+     * Helper function to record that a name is part of a session
+     */
+    void SessionMapIndexName(SessionId id, SessionIndexEntry& ie, const qcc::String& name);
+
     const qcc::GUID128& guid;                                  /**< Global GUID of this daemon */
 
     const InterfaceDescription::Member* exchangeNamesSignal;   /**< org.alljoyn.Daemon.ExchangeNames signal member */
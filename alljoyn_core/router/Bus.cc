@@ -26,6 +26,7 @@
 #include <assert.h>
 
 #include "Bus.h"
+#include "DaemonConfig.h"
 #include "DaemonRouter.h"
 #include "TransportList.h"
 
@@ -41,10 +42,41 @@ using namespace std;
  */
 const uint32_t EP_CONCURRENCY = 4;
 
+/*
+ * Default number of IODispatch event loops that remote endpoints are sharded
+ * across. This can be raised with <limit iodispatch_loops="N"/> so that endpoint
+ * read and write callbacks are spread over several cores. The callback threads are
+ * divided between the loops rather than created for each one.
+ */
+const uint32_t IODISPATCH_LOOPS_DEFAULT = 1;
+
+/*
+ * Default number of bytes of queued messages that a remote endpoint coalesces into
+ * a single vectored write. This can be changed with <limit tx_batch_bytes="N"/>;
+ * zero writes queued messages one at a time.
+ */
+const uint32_t TX_BATCH_BYTES_DEFAULT = 16 * 1024;
+
+/*
+ * Default limits of the transmit queue of each remote endpoint. These can be changed with
+ * <limit tx_queue_messages="N"/> and <limit tx_queue_bytes="N"/>. Unless
+ * <limit tx_queue_nonblocking="0"/> is set, a broadcast, sessionless or TTL signal pushed to
+ * a full queue is dropped rather than stalling the router thread behind a slow consumer.
+ * Method calls, replies and router control signals always wait for room in the queue.
+ */
+const uint32_t TX_QUEUE_MESSAGES_DEFAULT = 30;
+const uint32_t TX_QUEUE_BYTES_DEFAULT = 4 * 1024 * 1024;
+const uint32_t TX_QUEUE_NONBLOCKING_DEFAULT = 1;
+
 Bus::Bus(const char* applicationName, TransportFactoryContainer& factories, const char* listenSpecs) :
-    BusAttachment(new Internal(applicationName, *this, factories, new DaemonRouter, true, listenSpecs, EP_CONCURRENCY), EP_CONCURRENCY)
+    BusAttachment(new Internal(applicationName, *this, factories, new DaemonRouter, true, listenSpecs, EP_CONCURRENCY,
+                               DaemonConfig::Access()->Get("limit@iodispatch_loops", IODISPATCH_LOOPS_DEFAULT)), EP_CONCURRENCY)
 {
     GetInternal().GetRouter().SetGlobalGUID(GetInternal().GetGlobalGUID());
+    GetInternal().SetTxBatchLimit(DaemonConfig::Access()->Get("limit@tx_batch_bytes", TX_BATCH_BYTES_DEFAULT));
+    GetInternal().SetTxQueueLimits(DaemonConfig::Access()->Get("limit@tx_queue_messages", TX_QUEUE_MESSAGES_DEFAULT),
+                                   DaemonConfig::Access()->Get("limit@tx_queue_bytes", TX_QUEUE_BYTES_DEFAULT),
+                                   DaemonConfig::Access()->Get("limit@tx_queue_nonblocking", TX_QUEUE_NONBLOCKING_DEFAULT) != 0);
 }
 
 Bus::~Bus()
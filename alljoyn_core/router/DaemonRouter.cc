@@ -22,6 +22,7 @@
 
 #include <qcc/platform.h>
 
+#include <algorithm>
 #include <assert.h>
 
 #include <qcc/Debug.h>
@@ -48,7 +49,9 @@ using namespace qcc;
 namespace ajn {
 
 
-DaemonRouter::DaemonRouter() : ruleTable(), nameTable(), busController(NULL)
+DaemonRouter::DaemonRouter() : ruleTable(), nameTable(), busController(NULL),
+    daemonIfaceAtom(AtomTable::Intern(org::alljoyn::Daemon::InterfaceName)),
+    detachSessionAtom(AtomTable::Intern("DetachSession"))
 {
 }
 
@@ -65,7 +68,9 @@ static inline QStatus SendThroughEndpoint(Message& msg, BusEndpoint& ep, Session
         status = ep->PushMessage(msg);
     }
     // if the bus is stopping or the endpoint is closing we don't expect to be able to send
-    if ((status != ER_OK) && (status != ER_BUS_ENDPOINT_CLOSING) && (status != ER_BUS_STOPPING)) {
+    if (status == ER_BUS_WRITE_QUEUE_FULL) {
+        QCC_DbgHLPrintf(("SendThroughEndpoint(dest=%s, ep=%s, id=%u) dropped message because the tx queue is full", msg->GetDestination(), ep->GetUniqueName().c_str(), sessionId));
+    } else if ((status != ER_OK) && (status != ER_BUS_ENDPOINT_CLOSING) && (status != ER_BUS_STOPPING)) {
         QCC_LogError(status, ("SendThroughEndpoint(dest=%s, ep=%s, id=%u) failed", msg->GetDestination(), ep->GetUniqueName().c_str(), sessionId));
     }
     return status;
@@ -116,7 +121,6 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
 
     bool destinationEmpty = destination[0] == '\0';
     if (!destinationEmpty) {
-        nameTable.Lock();
         BusEndpoint destEndpoint = nameTable.FindEndpoint(destination);
         if (destEndpoint->IsValid()) {
             /* If this message is coming from a bus-to-bus ep, make sure the receiver is willing to receive it */
@@ -135,9 +139,7 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                     BusEndpoint busEndpoint = BusEndpoint::cast(localEndpoint);
                     PushMessage(msg, busEndpoint);
                 } else {
-                    nameTable.Unlock();
                     status = SendThroughEndpoint(msg, destEndpoint, sessionId);
-                    nameTable.Lock();
                 }
             } else {
                 QCC_DbgPrintf(("Blocking message from %s to %s (serial=%d) because receiver does not allow remote messages",
@@ -153,13 +155,11 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
                     PushMessage(msg, busEndpoint);
                 }
             }
-            // if the bus is stopping or the endpoint is closing we can't push the message
-            if ((ER_OK != status) && (ER_BUS_ENDPOINT_CLOSING != status) && (status != ER_BUS_STOPPING)) {
+            // if the bus is stopping, the endpoint is closing or its tx queue is full we can't push the message
+            if ((ER_OK != status) && (ER_BUS_ENDPOINT_CLOSING != status) && (status != ER_BUS_STOPPING) && (status != ER_BUS_WRITE_QUEUE_FULL)) {
                 QCC_LogError(status, ("BusEndpoint::PushMessage failed"));
             }
-            nameTable.Unlock();
         } else {
-            nameTable.Unlock();
             if ((msg->GetFlags() & ALLJOYN_FLAG_AUTO_START) &&
                 (sender->GetEndpointType() != ENDPOINT_TYPE_BUS2BUS) &&
                 (sender->GetEndpointType() != ENDPOINT_TYPE_NULL)) {
@@ -198,32 +198,23 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
          * The message has an empty destination field and no session is specified so this is a
          * regular broadcast message.
          */
-        nameTable.Lock();
+        std::vector<BusEndpoint> dests;
         ruleTable.Lock();
-        RuleIterator it = ruleTable.Begin();
-        while (it != ruleTable.End()) {
-            if (it->second.IsMatch(msg)) {
-                BusEndpoint dest = it->first;
-                QCC_DbgPrintf(("Routing %s (%d) to %s", msg->Description().c_str(), msg->GetCallSerial(), dest->GetUniqueName().c_str()));
-                /*
-                 * If the message originated locally or the destination allows remote messages
-                 * forward the message, otherwise silently ignore it.
-                 */
-                if (!((sender->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) && !dest->AllowRemoteMessages())) {
-                    ruleTable.Unlock();
-                    nameTable.Unlock();
-                    QStatus tStatus = SendThroughEndpoint(msg, dest, sessionId);
-                    status = (status == ER_OK) ? tStatus : status;
-                    nameTable.Lock();
-                    ruleTable.Lock();
-                }
-                it = ruleTable.AdvanceToNextEndpoint(dest);
-            } else {
-                ++it;
+        ruleTable.GetMatchingEndpoints(msg, dests);
+        ruleTable.Unlock();
+
+        for (std::vector<BusEndpoint>::iterator it = dests.begin(); it != dests.end(); ++it) {
+            BusEndpoint& dest = *it;
+            QCC_DbgPrintf(("Routing %s (%d) to %s", msg->Description().c_str(), msg->GetCallSerial(), dest->GetUniqueName().c_str()));
+            /*
+             * If the message originated locally or the destination allows remote messages
+             * forward the message, otherwise silently ignore it.
+             */
+            if (!((sender->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS) && !dest->AllowRemoteMessages())) {
+                QStatus tStatus = SendThroughEndpoint(msg, dest, sessionId);
+                status = (status == ER_OK) ? tStatus : status;
             }
         }
-        ruleTable.Unlock();
-        nameTable.Unlock();
 
         if (msg->IsSessionless()) {
             /* Give "locally generated" sessionless message to SessionlessObj */
@@ -247,7 +238,7 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
              * message body is used for selecting a B2B endpoint rather than the one that is in the
              * message header (0).
              */
-            if ((sessionId == 0) && (::strcmp("DetachSession", msg->GetMemberName()) == 0) && (::strcmp(org::alljoyn::Daemon::InterfaceName, msg->GetInterface()) == 0)) {
+            if ((sessionId == 0) && (msg->GetMemberNameAtom() == detachSessionAtom) && (msg->GetInterfaceAtom() == daemonIfaceAtom)) {
                 /* Clone the message since this message is unmarshalled by the LocalEndpoint too
                  * and the process of unmarshalling is not thread-safe.
                  */
@@ -262,22 +253,32 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
 
             /* Route global broadcast to all bus-to-bus endpoints that aren't the sender of the message */
             m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-            set<RemoteEndpoint>::iterator it = m_b2bEndpoints.begin();
-            while (it != m_b2bEndpoints.end()) {
-                RemoteEndpoint ep = *it;
-                if ((ep != origSender) && ((sessionId == 0) || ep->GetSessionId() == sessionId)) {
-                    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
-                    BusEndpoint busEndpoint = BusEndpoint::cast(ep);
-                    QStatus tStatus = SendThroughEndpoint(msg, busEndpoint, sessionId);
-                    status = (status == ER_OK) ? tStatus : status;
-                    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-                    it = m_b2bEndpoints.lower_bound(ep);
+            if (sessionId == 0) {
+                /* Hold a reference to the list of endpoints so they can be sent to without the lock */
+                ManagedObj<vector<RemoteEndpoint> > b2bList = m_b2bList;
+                m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+                for (vector<RemoteEndpoint>::iterator it = b2bList->begin(); it != b2bList->end(); ++it) {
+                    if (*it != origSender) {
+                        BusEndpoint busEndpoint = BusEndpoint::cast(*it);
+                        QStatus tStatus = SendThroughEndpoint(msg, busEndpoint, sessionId);
+                        status = (status == ER_OK) ? tStatus : status;
+                    }
                 }
-                if (it != m_b2bEndpoints.end()) {
-                    ++it;
+            } else {
+                unordered_map<SessionId, vector<RemoteEndpoint> >::const_iterator bit = m_b2bSessions.find(sessionId);
+                vector<RemoteEndpoint> b2bEps;
+                if (bit != m_b2bSessions.end()) {
+                    b2bEps = bit->second;
+                }
+                m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+                for (vector<RemoteEndpoint>::iterator it = b2bEps.begin(); it != b2bEps.end(); ++it) {
+                    if (*it != origSender) {
+                        BusEndpoint busEndpoint = BusEndpoint::cast(*it);
+                        QStatus tStatus = SendThroughEndpoint(msg, busEndpoint, sessionId);
+                        status = (status == ER_OK) ? tStatus : status;
+                    }
                 }
             }
-            m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
         }
 
     } else {
@@ -285,45 +286,20 @@ QStatus DaemonRouter::PushMessage(Message& msg, BusEndpoint& origSender)
          * The message has an empty destination field and a session id was specified so this is a
          * session multicast message.
          */
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        RemoteEndpoint lastB2b;
-        /* We need to obtain the first entry in the sessionCastSet that has the id equal to 'sessionId'
-         * and the src equal to 'msg->GetSender()'.
-         * Note: sce.id has been set to sessionId - 1. Since the src is compared first, and session Ids
-         * are integers, upper_bound will return the iterator to the first element with the desired or
-         * greater src(if not present) and desired or greater id in most cases.
-         */
-        SessionCastEntry sce(sessionId - 1, msg->GetSender());
-        set<SessionCastEntry>::iterator sit = sessionCastSet.upper_bound(sce);
-        bool foundDest = false;
-
-        /* In other cases, it may return the iterator to an element that has the desired src and
-         * (sessionId - 1). In that case iterate, until the id is less than the desired one.
-         */
-        while ((sit != sessionCastSet.end()) && (sit->src == sce.src) && (sit->id < sessionId)) {
-            sit++;
-        }
-
-        while ((sit != sessionCastSet.end()) && (sit->id == sessionId) && (sit->src == sce.src)) {
-            if (sit->b2bEp != lastB2b) {
-                foundDest = true;
-                lastB2b = sit->b2bEp;
-                SessionCastEntry entry = *sit;
-                BusEndpoint ep = sit->destEp;
-                sessionCastSetLock.Unlock(MUTEX_CONTEXT);
-                QStatus tStatus = SendThroughEndpoint(msg, ep, sessionId);
+        sessionCastMapLock.Lock(MUTEX_CONTEXT);
+        SessionCastMap::iterator sit = sessionCastMap.find(SessionCastKey(sessionId, msg->GetSender()));
+        if (sit != sessionCastMap.end()) {
+            /* Hold a reference to the destinations so they can be sent to without the lock */
+            ManagedObj<vector<BusEndpoint> > dests = sit->second.dests;
+            sessionCastMapLock.Unlock(MUTEX_CONTEXT);
+            for (vector<BusEndpoint>::iterator it = dests->begin(); it != dests->end(); ++it) {
+                QStatus tStatus = SendThroughEndpoint(msg, *it, sessionId);
                 status = (status == ER_OK) ? tStatus : status;
-                sessionCastSetLock.Lock(MUTEX_CONTEXT);
-                sit = sessionCastSet.lower_bound(entry);
             }
-            if (sit != sessionCastSet.end()) {
-                ++sit;
-            }
-        }
-        if (!foundDest) {
+        } else {
+            sessionCastMapLock.Unlock(MUTEX_CONTEXT);
             status = ER_BUS_NO_ROUTE;
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
     }
 
     return status;
@@ -339,12 +315,9 @@ BusEndpoint DaemonRouter::FindEndpoint(const qcc::String& busName)
     BusEndpoint ep = nameTable.FindEndpoint(busName);
     if (!ep->IsValid()) {
         m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-        for (set<RemoteEndpoint>::const_iterator it = m_b2bEndpoints.begin(); it != m_b2bEndpoints.end(); ++it) {
-            if ((*it)->GetUniqueName() == busName) {
-                RemoteEndpoint rep = *it;
-                ep = BusEndpoint::cast(rep);
-                break;
-            }
+        unordered_map<StringMapKey, RemoteEndpoint>::iterator it = m_b2bEndpoints.find(busName);
+        if (it != m_b2bEndpoints.end()) {
+            ep = BusEndpoint::cast(it->second);
         }
         m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
     }
@@ -390,7 +363,12 @@ QStatus DaemonRouter::RegisterEndpoint(BusEndpoint& endpoint)
 
         /* Add to list of bus-to-bus endpoints */
         m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-        m_b2bEndpoints.insert(busToBusEndpoint);
+        m_b2bEndpoints[busToBusEndpoint->GetUniqueName()] = busToBusEndpoint;
+        SessionId id = busToBusEndpoint->GetSessionId();
+        if (id != 0) {
+            m_b2bSessions[id].push_back(busToBusEndpoint);
+        }
+        UpdateB2BList();
         m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
     } else {
         /* Bus-to-client endpoints appear directly on the bus */
@@ -422,28 +400,32 @@ void DaemonRouter::UnregisterEndpoint(const qcc::String& epName, EndpointType ep
 
         /* Remove the bus2bus endpoint from the list */
         m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
-        set<RemoteEndpoint>::iterator it = m_b2bEndpoints.begin();
-        while (it != m_b2bEndpoints.end()) {
-            RemoteEndpoint rep = *it;
-            if (rep == busToBusEndpoint) {
-                m_b2bEndpoints.erase(it);
-                break;
+        unordered_map<StringMapKey, RemoteEndpoint>::iterator it = m_b2bEndpoints.find(busToBusEndpoint->GetUniqueName());
+        if ((it != m_b2bEndpoints.end()) && (it->second == busToBusEndpoint)) {
+            m_b2bEndpoints.erase(it);
+            unordered_map<SessionId, vector<RemoteEndpoint> >::iterator bit = m_b2bSessions.find(busToBusEndpoint->GetSessionId());
+            if (bit != m_b2bSessions.end()) {
+                bit->second.erase(remove(bit->second.begin(), bit->second.end(), busToBusEndpoint), bit->second.end());
+                if (bit->second.empty()) {
+                    m_b2bSessions.erase(bit);
+                }
             }
-            ++it;
+            UpdateB2BList();
         }
         m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
 
-        /* Remove entries from sessionCastSet with same b2bEp */
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        set<SessionCastEntry>::iterator sit = sessionCastSet.begin();
-        while (sit != sessionCastSet.end()) {
-            set<SessionCastEntry>::iterator doomed = sit;
-            ++sit;
-            if (doomed->b2bEp == endpoint) {
-                sessionCastSet.erase(doomed);
+        /* Remove session multicast routes through this b2bEp */
+        sessionCastMapLock.Lock(MUTEX_CONTEXT);
+        SessionCastMap::iterator sit = sessionCastMap.begin();
+        while (sit != sessionCastMap.end()) {
+            vector<SessionCastRoute>& routes = sit->second.routes;
+            size_t numRoutes = routes.size();
+            for (vector<SessionCastRoute>::iterator rit = routes.begin(); rit != routes.end();) {
+                rit = (rit->b2bEp == busToBusEndpoint) ? routes.erase(rit) : rit + 1;
             }
+            sit = (routes.size() != numRoutes) ? UpdateSessionCast(sit) : ++sit;
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        sessionCastMapLock.Unlock(MUTEX_CONTEXT);
     } else {
         /* Remove any session routes */
         RemoveSessionRoutes(endpoint->GetUniqueName().c_str(), 0);
@@ -498,23 +480,26 @@ QStatus DaemonRouter::AddSessionRoute(SessionId id, BusEndpoint& srcEp, RemoteEn
     /* Set sessionId on B2B endpoints */
     if (status == ER_OK) {
         if (srcB2bEp) {
-            (*srcB2bEp)->SetSessionId(id);
+            SetB2BSessionId(*srcB2bEp, id);
         }
-        destB2bEp->SetSessionId(id);
+        SetB2BSessionId(destB2bEp, id);
     }
 
     /* Add sessionCast entries */
     if (status == ER_OK) {
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        SessionCastEntry entry(id, srcEp->GetUniqueName(), destB2bEp, destEp);
-        sessionCastSet.insert(entry);
+        sessionCastMapLock.Lock(MUTEX_CONTEXT);
+        SessionCastRoutes& routes = sessionCastMap[SessionCastKey(id, srcEp->GetUniqueName())];
+        routes.routes.push_back(SessionCastRoute(destB2bEp, destEp));
+        routes.UpdateDests();
+        SessionCastRoutes& reverseRoutes = sessionCastMap[SessionCastKey(id, destEp->GetUniqueName())];
         if (srcB2bEp) {
-            sessionCastSet.insert(SessionCastEntry(id, destEp->GetUniqueName(), *srcB2bEp, srcEp));
+            reverseRoutes.routes.push_back(SessionCastRoute(*srcB2bEp, srcEp));
         } else {
             RemoteEndpoint none;
-            sessionCastSet.insert(SessionCastEntry(id, destEp->GetUniqueName(), none, srcEp));
+            reverseRoutes.routes.push_back(SessionCastRoute(none, srcEp));
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        reverseRoutes.UpdateDests();
+        sessionCastMapLock.Unlock(MUTEX_CONTEXT);
     }
     return status;
 }
@@ -540,21 +525,33 @@ QStatus DaemonRouter::RemoveSessionRoute(SessionId id, BusEndpoint& srcEp, BusEn
         vSrcEp->RemoveSessionRef(id);
     }
 
-    /* Remove entries from sessionCastSet */
+    /* Remove sessionCast entries */
     if (status == ER_OK) {
-        sessionCastSetLock.Lock(MUTEX_CONTEXT);
-        SessionCastEntry entry(id, srcEp->GetUniqueName(), destB2bEp, destEp);
-        set<SessionCastEntry>::iterator it = sessionCastSet.find(entry);
-        if (it != sessionCastSet.end()) {
-            sessionCastSet.erase(it);
+        sessionCastMapLock.Lock(MUTEX_CONTEXT);
+        SessionCastMap::iterator it = sessionCastMap.find(SessionCastKey(id, srcEp->GetUniqueName()));
+        if (it != sessionCastMap.end()) {
+            vector<SessionCastRoute>& routes = it->second.routes;
+            for (vector<SessionCastRoute>::iterator rit = routes.begin(); rit != routes.end(); ++rit) {
+                if ((rit->b2bEp == destB2bEp) && (rit->destEp == destEp)) {
+                    routes.erase(rit);
+                    UpdateSessionCast(it);
+                    break;
+                }
+            }
         }
 
-        SessionCastEntry entry2(id, destEp->GetUniqueName(), srcB2bEp, srcEp);
-        set<SessionCastEntry>::iterator it2 = sessionCastSet.find(entry2);
-        if (it2 != sessionCastSet.end()) {
-            sessionCastSet.erase(it2);
+        SessionCastMap::iterator it2 = sessionCastMap.find(SessionCastKey(id, destEp->GetUniqueName()));
+        if (it2 != sessionCastMap.end()) {
+            vector<SessionCastRoute>& routes = it2->second.routes;
+            for (vector<SessionCastRoute>::iterator rit = routes.begin(); rit != routes.end(); ++rit) {
+                if ((rit->b2bEp == srcB2bEp) && (rit->destEp == srcEp)) {
+                    routes.erase(rit);
+                    UpdateSessionCast(it2);
+                    break;
+                }
+            }
         }
-        sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+        sessionCastMapLock.Unlock(MUTEX_CONTEXT);
     }
     return status;
 }
@@ -564,20 +561,86 @@ void DaemonRouter::RemoveSessionRoutes(const char* src, SessionId id)
     String srcStr = src;
     BusEndpoint ep = FindEndpoint(srcStr);
 
-    sessionCastSetLock.Lock(MUTEX_CONTEXT);
-    set<SessionCastEntry>::const_iterator it = sessionCastSet.begin();
-    while (it != sessionCastSet.end()) {
-        if (((it->id == id) || (id == 0)) && ((it->src == src) || (it->destEp == ep))) {
-            if ((it->id != 0) && (it->destEp->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
-                BusEndpoint destEp = it->destEp;
-                VirtualEndpoint::cast(destEp)->RemoveSessionRef(it->id);
-            }
-            sessionCastSet.erase(it++);
-        } else {
+    sessionCastMapLock.Lock(MUTEX_CONTEXT);
+    SessionCastMap::iterator it = sessionCastMap.begin();
+    while (it != sessionCastMap.end()) {
+        if ((it->first.id != id) && (id != 0)) {
             ++it;
+            continue;
+        }
+        bool isSrc = (it->first.src == StringMapKey(src));
+        vector<SessionCastRoute>& routes = it->second.routes;
+        size_t numRoutes = routes.size();
+        for (vector<SessionCastRoute>::iterator rit = routes.begin(); rit != routes.end();) {
+            if (isSrc || (rit->destEp == ep)) {
+                if ((it->first.id != 0) && (rit->destEp->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL)) {
+                    VirtualEndpoint::cast(rit->destEp)->RemoveSessionRef(it->first.id);
+                }
+                rit = routes.erase(rit);
+            } else {
+                ++rit;
+            }
         }
+        it = (routes.size() != numRoutes) ? UpdateSessionCast(it) : ++it;
+    }
+    sessionCastMapLock.Unlock(MUTEX_CONTEXT);
+}
+
+void DaemonRouter::SetB2BSessionId(RemoteEndpoint& b2bEp, SessionId id)
+{
+    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    SessionId oldId = b2bEp->GetSessionId();
+    b2bEp->SetSessionId(id);
+
+    /* Only registered bus-to-bus endpoints are in a bucket */
+    unordered_map<StringMapKey, RemoteEndpoint>::iterator it = b2bEp->IsValid() ? m_b2bEndpoints.find(b2bEp->GetUniqueName()) : m_b2bEndpoints.end();
+    if ((oldId != id) && (it != m_b2bEndpoints.end()) && (it->second == b2bEp)) {
+        unordered_map<SessionId, vector<RemoteEndpoint> >::iterator bit = m_b2bSessions.find(oldId);
+        if (bit != m_b2bSessions.end()) {
+            bit->second.erase(remove(bit->second.begin(), bit->second.end(), b2bEp), bit->second.end());
+            if (bit->second.empty()) {
+                m_b2bSessions.erase(bit);
+            }
+        }
+        if (id != 0) {
+            m_b2bSessions[id].push_back(b2bEp);
+        }
+    }
+    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+}
+
+void DaemonRouter::UpdateB2BList()
+{
+    ManagedObj<vector<RemoteEndpoint> > b2bList;
+    b2bList->reserve(m_b2bEndpoints.size());
+    for (unordered_map<StringMapKey, RemoteEndpoint>::iterator it = m_b2bEndpoints.begin(); it != m_b2bEndpoints.end(); ++it) {
+        b2bList->push_back(it->second);
+    }
+    m_b2bList = b2bList;
+}
+
+void DaemonRouter::SessionCastRoutes::UpdateDests()
+{
+    /*
+     * A message for remote destinations only needs to be sent once through each bus-to-bus
+     * endpoint. The daemon at the other end delivers it to all of its session members.
+     */
+    dests = ManagedObj<vector<BusEndpoint> >();
+    set<RemoteEndpoint> b2bEps;
+    for (vector<SessionCastRoute>::iterator it = routes.begin(); it != routes.end(); ++it) {
+        if (b2bEps.insert(it->b2bEp).second) {
+            dests->push_back(it->destEp);
+        }
+    }
+}
+
+DaemonRouter::SessionCastMap::iterator DaemonRouter::UpdateSessionCast(SessionCastMap::iterator it)
+{
+    if (it->second.routes.empty()) {
+        return sessionCastMap.erase(it);
     }
-    sessionCastSetLock.Unlock(MUTEX_CONTEXT);
+    it->second.UpdateDests();
+    return ++it;
 }
 
 }
@@ -24,7 +24,14 @@
 
 #include <qcc/platform.h>
 
+#include <vector>
+
+#include <qcc/AtomTable.h>
+#include <qcc/ManagedObj.h>
+#include <qcc/STLContainer.h>
+#include <qcc/StringMapKey.h>
 #include <qcc/Thread.h>
+#include <qcc/Util.h>
 
 #include "Transport.h"
 
@@ -356,38 +363,86 @@ class DaemonRouter : public Router {
     RuleTable ruleTable;            /**< Routing rule table */
     NameTable nameTable;            /**< BusName to transport lookupl table */
     BusController* busController;   /**< The bus controller used with this router */
+    qcc::Atom daemonIfaceAtom;      /**< Atom for org::alljoyn::Daemon::InterfaceName */
+    qcc::Atom detachSessionAtom;    /**< Atom for the DetachSession member */
 
-    std::set<RemoteEndpoint> m_b2bEndpoints; /**< Collection of Bus-to-bus endpoints */
-    qcc::Mutex m_b2bEndpointsLock;           /**< Lock that protects m_b2bEndpoints */
+    /**
+     * Set the session id of a bus-to-bus endpoint and move it to the matching bucket of
+     * m_b2bSessions.
+     *
+     * @param b2bEp   The bus-to-bus endpoint.
+     * @param id      The session id.
+     */
+    void SetB2BSessionId(RemoteEndpoint& b2bEp, SessionId id);
 
-    /** Session multicast destination map */
-    struct SessionCastEntry {
-        SessionId id;
-        qcc::String src;
-        RemoteEndpoint b2bEp;
-        BusEndpoint destEp;
+    /** Rebuild m_b2bList from m_b2bEndpoints. Must be called with m_b2bEndpointsLock held. */
+    void UpdateB2BList();
 
-        SessionCastEntry(SessionId id, const qcc::String& src) :
-            id(id), src(src) { }
+    std::unordered_map<qcc::StringMapKey, RemoteEndpoint> m_b2bEndpoints;       /**< Bus-to-bus endpoints by unique name */
+    qcc::ManagedObj<std::vector<RemoteEndpoint> > m_b2bList;                   /**< All bus-to-bus endpoints. Replaced, not modified, so senders can hold a reference */
+    std::unordered_map<SessionId, std::vector<RemoteEndpoint> > m_b2bSessions; /**< Bus-to-bus endpoints by their (non-zero) session id */
+    qcc::Mutex m_b2bEndpointsLock;           /**< Lock that protects m_b2bEndpoints, m_b2bList and m_b2bSessions */
 
-        SessionCastEntry(SessionId id, const qcc::String& src, RemoteEndpoint& b2bEp, BusEndpoint& destEp) :
-            id(id), src(src), b2bEp(b2bEp), destEp(destEp) { }
+    /** Key of the session multicast routes from one sender in one session */
+    struct SessionCastKey {
+        SessionId id;            /**< Session id */
+        qcc::StringMapKey src;   /**< Unique name of the sender */
 
-        bool operator<(const SessionCastEntry& other) const {
-            /* The order of comparison of src and id has been reversed, so that upper_bound can be
-             * used with (desiredID -1) to obtain the first entry that has the desired src and id.
-             */
-            return (src < other.src) || ((src == other.src) && ((id < other.id) || ((id == other.id) && ((b2bEp < other.b2bEp) || ((b2bEp == other.b2bEp) && (destEp < other.destEp))))));
+        SessionCastKey(SessionId id, const qcc::String& src) : id(id), src(src) { }
+        SessionCastKey(SessionId id, const char* src) : id(id), src(src) { }
+    };
 
+    /** Functor to compute a hash for SessionCastKey */
+    struct SessionCastHash {
+        size_t operator()(const SessionCastKey& k) const {
+            return qcc::hash_string(k.src.c_str()) * 7 + static_cast<size_t>(k.id);
         }
+    };
 
-        bool operator==(const SessionCastEntry& other) const {
-            return (id == other.id)  && (src == other.src) && (b2bEp == other.b2bEp) && (destEp == other.destEp);
+    /** Functor to compare SessionCastKeys */
+    struct SessionCastEqual {
+        bool operator()(const SessionCastKey& k1, const SessionCastKey& k2) const {
+            return (k1.id == k2.id) && (k1.src == k2.src);
         }
     };
 
-    std::set<SessionCastEntry> sessionCastSet; /**< Session multicast set */
-    qcc::Mutex sessionCastSetLock;             /**< Lock that protects sessionCastSet */
+    /** A session multicast route to one destination */
+    struct SessionCastRoute {
+        RemoteEndpoint b2bEp;    /**< Bus-to-bus endpoint for a remote destination */
+        BusEndpoint destEp;      /**< Destination endpoint */
+
+        SessionCastRoute(const RemoteEndpoint& b2bEp, const BusEndpoint& destEp) : b2bEp(b2bEp), destEp(destEp) { }
+    };
+
+    /**
+     * Session multicast routes from one sender in one session. Messages are sent to dests, which
+     * is rebuilt from routes whenever a route is added or removed so that PushMessage does not
+     * have to walk the routes. Remote destinations reached through the same bus-to-bus endpoint
+     * appear only once in dests. A new dests vector is built each time so PushMessage can keep
+     * sending to a copy of the old one without holding sessionCastMapLock.
+     */
+    struct SessionCastRoutes {
+        std::vector<SessionCastRoute> routes;                   /**< Routes added by AddSessionRoute */
+        qcc::ManagedObj<std::vector<BusEndpoint> > dests;       /**< Endpoints a multicast message is sent to */
+
+        /** Rebuild dests from routes */
+        void UpdateDests();
+    };
+
+    typedef std::unordered_map<SessionCastKey, SessionCastRoutes, SessionCastHash, SessionCastEqual> SessionCastMap;
+
+    /**
+     * Rebuild the destinations of session multicast routes after some of the routes were
+     * removed. The entry is removed from the map if no routes are left.
+     *
+     * @param it   Iterator to the routes from one sender in one session.
+     *
+     * @return  Iterator to the next entry in the map.
+     */
+    SessionCastMap::iterator UpdateSessionCast(SessionCastMap::iterator it);
+
+    SessionCastMap sessionCastMap;      /**< Session multicast routes */
+    qcc::Mutex sessionCastMapLock;      /**< Lock that protects sessionCastMap */
 };
 
 }
@@ -29,6 +29,8 @@
 #include <qcc/Logger.h>
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/atomic.h>
 
 #include "NameTable.h"
 #include "VirtualEndpoint.h"
@@ -43,6 +45,28 @@ using namespace qcc;
 
 namespace ajn {
 
+const size_t NameTable::ROUTE_SHARDS;
+
+NameTable::NameTable() : uniqueId(0), uniquePrefix(":1.")
+{
+    for (size_t i = 0; i < ROUTE_SHARDS; ++i) {
+        routes[i] = new RouteMap();
+    }
+}
+
+NameTable::~NameTable()
+{
+    for (size_t i = 0; i < ROUTE_SHARDS; ++i) {
+        delete routes[i];
+    }
+    for (map<size_t, RouteMap*>::iterator it = pendingRoutes.begin(); it != pendingRoutes.end(); ++it) {
+        delete it->second;
+    }
+    for (vector<RouteMap*>::iterator it = retiredRoutes.begin(); it != retiredRoutes.end(); ++it) {
+        delete *it;
+    }
+}
+
 qcc::String NameTable::GenerateUniqueName(void)
 {
     return uniquePrefix + U32ToString(IncrementAndFetch((int32_t*)&uniqueId));
@@ -64,7 +88,10 @@ void NameTable::AddUniqueName(BusEndpoint& endpoint)
     QCC_DbgPrintf(("Add unique name %s", uniqueName.c_str()));
     lock.Lock(MUTEX_CONTEXT);
     uniqueNames[uniqueName] = endpoint;
+    UpdateRoute(uniqueName);
+    PublishRoutes();
     lock.Unlock(MUTEX_CONTEXT);
+    ReclaimRoutes();
 
     /* Notify listeners */
     CallListeners(uniqueName, NULL, &uniqueName);
@@ -123,10 +150,13 @@ void NameTable::RemoveUniqueName(const qcc::String& uniqueName)
 
         if (it != uniqueNames.end()) {
             uniqueNames.erase(it);
+            UpdateRoute(uniqueName);
+            PublishRoutes();
             QCC_DbgPrintf(("Removed ep=%s from name table", uniqueName.c_str()));
         }
 
         lock.Unlock(MUTEX_CONTEXT);
+        ReclaimRoutes();
         /* Notify listeners */
         CallListeners(uniqueName, &uniqueName, NULL);
     } else {
@@ -191,7 +221,12 @@ QStatus NameTable::AddAlias(const qcc::String& aliasName,
                 origOwner = vit->second->GetUniqueName();
             }
         }
+        if (newOwner) {
+            UpdateRoute(aliasName);
+            PublishRoutes();
+        }
         lock.Unlock(MUTEX_CONTEXT);
+        ReclaimRoutes();
 
         if (listener) {
             listener->AddAliasComplete(aliasName, disposition, context);
@@ -231,7 +266,7 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
             /* Remove primary */
             if (queue.size() > 1) {
                 queue.pop_front();
-                BusEndpoint ep = FindEndpoint(queue[0].endpointName);
+                BusEndpoint ep = LookupEndpoint(queue[0].endpointName);
                 if (ep->IsValid()) {
                     newOwner = queue[0].endpointName;
                 }
@@ -246,6 +281,8 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
             }
             oldOwner = ownerName;
             disposition = DBUS_RELEASE_NAME_REPLY_RELEASED;
+            UpdateRoute(aliasNameCopy);
+            PublishRoutes();
         } else {
             /* Alias is not owned by ownerName */
             disposition = DBUS_RELEASE_NAME_REPLY_NOT_OWNER;
@@ -255,6 +292,7 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
     }
 
     lock.Unlock(MUTEX_CONTEXT);
+    ReclaimRoutes();
 
     if (listener) {
         listener->RemoveAliasComplete(aliasNameCopy, disposition, context);
@@ -267,8 +305,67 @@ void NameTable::RemoveAlias(const qcc::String& aliasName,
 BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
 {
     BusEndpoint ep;
+    /* The shard cannot be freed while we are registered as a reader */
+    Reclaimer::ScopedReader reader(routeReaders);
+    const RouteMap* shard = routes[RouteShard(busName)];
+    RouteMap::const_iterator it = shard->find(busName);
+    if (it != shard->end()) {
+        ep = it->second;
+    }
+    return ep;
+}
 
+void NameTable::UpdateRoute(const qcc::String& busName)
+{
+    size_t shard = RouteShard(busName);
+    RouteMap*& copy = pendingRoutes[shard];
+    if (!copy) {
+        copy = new RouteMap(*routes[shard]);
+    }
+    BusEndpoint ep = LookupEndpoint(busName);
+    if (ep->IsValid()) {
+        (*copy)[busName] = ep;
+    } else {
+        copy->erase(busName);
+    }
+}
+
+void NameTable::PublishRoutes()
+{
+    if (pendingRoutes.empty()) {
+        return;
+    }
+    /* The copies must be complete before a reader can find them */
+    MemoryFence();
+    for (map<size_t, RouteMap*>::iterator it = pendingRoutes.begin(); it != pendingRoutes.end(); ++it) {
+        RouteMap* replaced = routes[it->first];
+        retiredRoutes.push_back(replaced);
+        routes[it->first] = it->second;
+    }
+    pendingRoutes.clear();
+}
+
+void NameTable::ReclaimRoutes()
+{
+    vector<RouteMap*> retired;
     lock.Lock(MUTEX_CONTEXT);
+    retired.swap(retiredRoutes);
+    lock.Unlock(MUTEX_CONTEXT);
+    if (retired.empty()) {
+        return;
+    }
+
+    /* Readers that started before the shards were replaced may still be using them */
+    routeReaders.Synchronize();
+    for (vector<RouteMap*>::iterator it = retired.begin(); it != retired.end(); ++it) {
+        delete *it;
+    }
+}
+
+BusEndpoint NameTable::LookupEndpoint(const qcc::String& busName) const
+{
+    BusEndpoint ep;
+
     if (busName[0] == ':') {
         unordered_map<qcc::String, BusEndpoint, Hash, Equal>::const_iterator it = uniqueNames.find(busName);
         if (it != uniqueNames.end()) {
@@ -278,7 +375,7 @@ BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
         unordered_map<qcc::String, deque<NameQueueEntry>, Hash, Equal>::const_iterator it = aliasNames.find(busName);
         if (it != aliasNames.end()) {
             assert(!it->second.empty());
-            ep = FindEndpoint(it->second[0].endpointName);
+            ep = LookupEndpoint(it->second[0].endpointName);
         }
         /* Fallback to virtual (remote) aliases if a suitable local one cannot be found */
         if (!ep->IsValid()) {
@@ -289,7 +386,6 @@ BusEndpoint NameTable::FindEndpoint(const qcc::String& busName) const
             }
         }
     }
-    lock.Unlock(MUTEX_CONTEXT);
     return ep;
 }
 
@@ -324,7 +420,7 @@ void NameTable::GetUniqueNamesAndAliases(vector<pair<qcc::String, vector<qcc::St
     unordered_map<qcc::String, deque<NameQueueEntry>, Hash, Equal>::const_iterator ait = aliasNames.begin();
     while (ait != aliasNames.end()) {
         if (!ait->second.empty()) {
-            BusEndpoint ep = FindEndpoint(ait->second.front().endpointName);
+            BusEndpoint ep = LookupEndpoint(ait->second.front().endpointName);
             if (ep->IsValid()) {
                 epMap.insert(pair<BusEndpoint, qcc::String>(ep, ait->first));
             }
@@ -383,8 +479,10 @@ void NameTable::GetQueuedNames(const qcc::String& busName, std::vector<qcc::Stri
 
 void NameTable::RemoveVirtualAliases(const qcc::String& epName)
 {
+    vector<String> removed;
+
     lock.Lock(MUTEX_CONTEXT);
-    BusEndpoint tempEp = FindEndpoint(epName);
+    BusEndpoint tempEp = LookupEndpoint(epName);
     VirtualEndpoint ep = VirtualEndpoint::cast(tempEp);
 
     QCC_DbgTrace(("NameTable::RemoveVirtualAliases(%s)", ep->IsValid() ? ep->GetUniqueName().c_str() : "<none>"));
@@ -395,18 +493,23 @@ void NameTable::RemoveVirtualAliases(const qcc::String& epName)
             if (vit->second == ep) {
                 String alias = vit->first.c_str();
                 virtualAliasNames.erase(vit++);
+                UpdateRoute(alias);
                 if (aliasNames.find(alias) == aliasNames.end()) {
-                    lock.Unlock(MUTEX_CONTEXT);
-                    CallListeners(alias, &epName, NULL);
-                    lock.Lock(MUTEX_CONTEXT);
-                    vit = virtualAliasNames.upper_bound(alias);
+                    removed.push_back(alias);
                 }
             } else {
                 ++vit;
             }
         }
+        /* Listeners must not be able to route to the aliases once they are told they are gone */
+        PublishRoutes();
     }
     lock.Unlock(MUTEX_CONTEXT);
+    ReclaimRoutes();
+
+    for (vector<String>::iterator it = removed.begin(); it != removed.end(); ++it) {
+        CallListeners(*it, &epName, NULL);
+    }
 }
 
 bool NameTable::SetVirtualAlias(const qcc::String& alias,
@@ -451,11 +554,16 @@ bool NameTable::SetVirtualAlias(const qcc::String& alias,
         madeChange = true;
         virtualAliasNames.erase(StringMapKey(alias));
     }
+    if (madeChange) {
+        UpdateRoute(alias);
+        PublishRoutes();
+    }
 
     String oldName = oldOwner->IsValid() ? oldOwner->GetUniqueName() : "";
     String newName = newOwner ? (*newOwner)->GetUniqueName() : "";
 
     lock.Unlock(MUTEX_CONTEXT);
+    ReclaimRoutes();
 
     /* Virtual aliases cannot override locally requested aliases */
     if (madeChange && !maskingLocalName) {
@@ -25,11 +25,13 @@
 #include <qcc/platform.h>
 
 #include <deque>
+#include <map>
 #include <vector>
 #include <set>
 
 #include <qcc/Mutex.h>
 #include <qcc/Environ.h>
+#include <qcc/Reclaimer.h>
 #include <qcc/String.h>
 #include <qcc/StringMapKey.h>
 
@@ -67,7 +69,12 @@ class NameTable {
     /**
      * Constructor
      */
-    NameTable() : uniqueId(0), uniquePrefix(":1.") { }
+    NameTable();
+
+    /**
+     * Destructor
+     */
+    ~NameTable();
 
     /**
      * Set the GUID of the bus.
@@ -172,6 +179,9 @@ class NameTable {
 
     /**
      * Find an endpoint for a given unique or alias bus name.
+     * This does not take the name table lock. The lookup is made in a read-only snapshot of
+     * the name table. The snapshot is split into shards and a change to a name republishes
+     * only the shard that holds it.
      *
      * @param busName   Name of bus.
      * @return  Returns the endpoint if it was found or an invalid endpoint if not found
@@ -241,6 +251,50 @@ class NameTable {
     std::set<ProtectedNameListener> listeners;                         /**< Listeners regsitered with name table */
     std::map<qcc::StringMapKey, VirtualEndpoint> virtualAliasNames;    /**< map of virtual aliases to virtual endpts */
 
+    /** Unique, alias and virtual alias names mapped to the endpoint FindEndpoint() returns for them */
+    typedef std::unordered_map<qcc::String, BusEndpoint, Hash, Equal> RouteMap;
+
+    /** Number of shards the route snapshot is split into. A change only copies one shard. */
+    static const size_t ROUTE_SHARDS = 64;
+
+    RouteMap* volatile routes[ROUTE_SHARDS];    /**< Published shards, replaced but never modified once published */
+    std::map<size_t, RouteMap*> pendingRoutes;  /**< Modified copies of shards that have not been published yet */
+    std::vector<RouteMap*> retiredRoutes;       /**< Replaced shards that readers may still be using */
+    qcc::Reclaimer routeReaders;                /**< Readers of the published shards */
+
+    /**
+     * Find an endpoint in the name tables. Must be called with the lock held.
+     *
+     * @param busName   Name of bus.
+     * @return  Returns the endpoint if it was found or an invalid endpoint if not found
+     */
+    BusEndpoint LookupEndpoint(const qcc::String& busName) const;
+
+    /**
+     * Get the shard of the route snapshot that holds a name.
+     */
+    static size_t RouteShard(const qcc::String& busName) { return Hash()(busName) % ROUTE_SHARDS; }
+
+    /**
+     * Update the route for a name in a copy of its shard after the name tables have changed.
+     * The change is not visible to FindEndpoint() until PublishRoutes() is called. Must be
+     * called with the lock held.
+     *
+     * @param busName   Name whose route may have changed.
+     */
+    void UpdateRoute(const qcc::String& busName);
+
+    /**
+     * Publish the shards modified by UpdateRoute(). Must be called with the lock held.
+     */
+    void PublishRoutes();
+
+    /**
+     * Free the shards replaced by PublishRoutes() once no reader is using them. This waits for
+     * readers so it should be called after the lock has been released.
+     */
+    void ReclaimRoutes();
+
     /**
      * Helper used to call the listners
      *
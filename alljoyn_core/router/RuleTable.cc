@@ -21,6 +21,7 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 
+#include <algorithm>
 #include <cstring>
 
 #include "RuleTable.h"
@@ -145,7 +146,8 @@ QStatus RuleTable::AddRule(BusEndpoint& endpoint, const Rule& rule)
 {
     QCC_DbgPrintf(("AddRule for endpoint %s\n  %s", endpoint->GetUniqueName().c_str(), rule.ToString().c_str()));
     Lock();
-    rules.insert(std::pair<BusEndpoint, Rule>(endpoint, rule));
+    RuleIterator it = rules.insert(std::pair<BusEndpoint, Rule>(endpoint, rule));
+    index[StringMapKey(rule.iface)][StringMapKey(rule.member)].push_back(it);
     Unlock();
     return ER_OK;
 }
@@ -158,6 +160,7 @@ QStatus RuleTable::RemoveRule(BusEndpoint& endpoint, Rule& rule)
     std::pair<RuleIterator, RuleIterator> range = rules.equal_range(endpoint);
     while (range.first != range.second) {
         if (range.first->second == rule) {
+            Unindex(range.first);
             rules.erase(range.first);
             break;
         }
@@ -172,10 +175,81 @@ QStatus RuleTable::RemoveAllRules(BusEndpoint& endpoint)
     Lock();
     std::pair<RuleIterator, RuleIterator> range = rules.equal_range(endpoint);
     if (range.first != rules.end()) {
+        for (RuleIterator it = range.first; it != range.second; ++it) {
+            Unindex(it);
+        }
         rules.erase(range.first, range.second);
     }
     Unlock();
     return ER_OK;
 }
 
+void RuleTable::GetMatchingEndpoints(const Message& msg, std::vector<BusEndpoint>& dests)
+{
+    const char* iface = msg->GetInterface();
+    const char* member = msg->GetMemberName();
+
+    /*
+     * A rule can only match if its interface and member are either unspecified or equal to
+     * the message's so at most four buckets need to be checked.
+     */
+    MatchBucket(msg, iface, member, dests);
+    if (*member) {
+        MatchBucket(msg, iface, "", dests);
+    }
+    if (*iface) {
+        MatchBucket(msg, "", member, dests);
+        if (*member) {
+            MatchBucket(msg, "", "", dests);
+        }
+    }
+
+    /* An endpoint with several matching rules must only receive the message once */
+    if (dests.size() > 1) {
+        std::sort(dests.begin(), dests.end());
+        dests.erase(std::unique(dests.begin(), dests.end()), dests.end());
+    }
+}
+
+void RuleTable::MatchBucket(const Message& msg, const char* iface, const char* member, std::vector<BusEndpoint>& dests)
+{
+    RuleIndex::iterator iit = index.find(iface);
+    if (iit == index.end()) {
+        return;
+    }
+    MemberIndex::iterator mit = iit->second.find(member);
+    if (mit == iit->second.end()) {
+        return;
+    }
+    std::vector<RuleIterator>& bucket = mit->second;
+    for (std::vector<RuleIterator>::iterator it = bucket.begin(); it != bucket.end(); ++it) {
+        if ((*it)->second.IsMatch(msg)) {
+            dests.push_back((*it)->first);
+        }
+    }
+}
+
+void RuleTable::Unindex(RuleIterator it)
+{
+    RuleIndex::iterator iit = index.find(it->second.iface.c_str());
+    if (iit == index.end()) {
+        return;
+    }
+    MemberIndex::iterator mit = iit->second.find(it->second.member.c_str());
+    if (mit == iit->second.end()) {
+        return;
+    }
+    std::vector<RuleIterator>& bucket = mit->second;
+    std::vector<RuleIterator>::iterator bit = std::find(bucket.begin(), bucket.end(), it);
+    if (bit != bucket.end()) {
+        bucket.erase(bit);
+    }
+    if (bucket.empty()) {
+        iit->second.erase(mit);
+        if (iit->second.empty()) {
+            index.erase(iit);
+        }
+    }
+}
+
 }
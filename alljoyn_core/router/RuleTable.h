@@ -27,8 +27,10 @@
 #include <qcc/platform.h>
 
 #include <map>
+#include <vector>
 
 #include <qcc/String.h>
+#include <qcc/StringMapKey.h>
 #include <qcc/Mutex.h>
 
 #include <alljoyn/Message.h>
@@ -37,6 +39,8 @@
 
 #include <alljoyn/Status.h>
 
+#include <qcc/STLContainer.h>
+
 namespace ajn {
 
 /**
@@ -202,9 +206,38 @@ class RuleTable {
         return ret;
     }
 
+    /**
+     * Get the endpoints that have at least one rule matching a message.
+     * Only the rules indexed under the message's interface and member (or under the
+     * wildcard buckets for rules that leave either unspecified) are evaluated.
+     * Caller should obtain lock before calling this method.
+     *
+     * @param msg        Message to match.
+     * @param[out] dests Matching endpoints in endpoint order, each listed once.
+     */
+    void GetMatchingEndpoints(const Message& msg, std::vector<BusEndpoint>& dests);
+
   private:
+
+    /** Rules that share a member name, keyed by member ("" for rules that match any member) */
+    typedef std::unordered_map<qcc::StringMapKey, std::vector<RuleIterator> > MemberIndex;
+
+    /** Rules keyed by interface ("" for rules that match any interface) and then by member */
+    typedef std::unordered_map<qcc::StringMapKey, MemberIndex> RuleIndex;
+
+    /**
+     * Add candidates from a single index bucket to dests.
+     */
+    void MatchBucket(const Message& msg, const char* iface, const char* member, std::vector<BusEndpoint>& dests);
+
+    /**
+     * Remove a rule from the index. Must be called before the rule is erased from rules.
+     */
+    void Unindex(RuleIterator it);
+
     qcc::Mutex lock;                            /**< Lock protecting rule table */
     std::multimap<BusEndpoint, Rule> rules;    /**< Rule table */
+    RuleIndex index;                            /**< Index of rules by interface and member */
 };
 
 }
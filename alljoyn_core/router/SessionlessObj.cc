@@ -21,6 +21,9 @@
 
 #include <qcc/platform.h>
 
+#include <assert.h>
+#include <vector>
+
 #include <alljoyn/AllJoynStd.h>
 #include <alljoyn/Session.h>
 
@@ -341,8 +344,15 @@ QStatus SessionlessObj::PushMessage(Message& msg)
     if (it == messageMap.end()) {
         messageMap.insert(pair<MessageMapKey, pair<uint32_t, Message> >(key, val));
     } else {
+        changeIdIndex.erase(pair<uint32_t, MessageMapKey>(it->second.first, key));
         it->second = val;
     }
+    changeIdIndex.insert(pair<uint32_t, MessageMapKey>(curChangeId, key));
+    uint32_t tilExpire;
+    msg->IsExpired(&tilExpire);
+    if (tilExpire != ::numeric_limits<uint32_t>::max()) {
+        expiryHeap.push(ExpiryEntry(GetTimestamp64() + tilExpire, key, curChangeId));
+    }
     lock.Unlock();
     uint32_t zero = 0;
     SessionlessObj* slObj = this;
@@ -404,7 +414,7 @@ QStatus SessionlessObj::CancelMessage(const qcc::String& sender, uint32_t serial
             if (!it->second.second->IsExpired()) {
                 status = ER_OK;
             }
-            messageMap.erase(it);
+            EraseMessage(it);
             messageErased = true;
             break;
         }
@@ -508,7 +518,7 @@ void SessionlessObj::NameOwnerChanged(const String& name,
         MessageMapKey key(oldOwner->c_str(), "", "", "");
         map<MessageMapKey, pair<uint32_t, Message> >::iterator mit = messageMap.lower_bound(key);
         while ((mit != messageMap.end()) && (::strcmp(oldOwner->c_str(), mit->second.second->GetSender()) == 0)) {
-            messageMap.erase(mit++);
+            EraseMessage(mit++);
         }
         /* Alert the advertiser worker if messageMap is empty */
         if (messageMap.empty()) {
@@ -711,43 +721,59 @@ void SessionlessObj::HandleRangeRequest(const char* sender, SessionId sessionId,
         advanceChangeId = false;
     }
 
-    /* Send all messages in messageMap in range [fromChangeId, toChangeId) */
-    map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.begin();
-    uint32_t rangeLen = toChangeId - fromChangeId;
-    while (it != messageMap.end()) {
-        if (IN_WINDOW(uint32_t, fromChangeId, rangeLen, it->second.first)) {
-            MessageMapKey key = it->first;
+    /*
+     * Collect all messages in messageMap in range [fromChangeId, toChangeId). The range may wrap
+     * around in which case it is collected as [fromChangeId, 0xFFFFFFFF] followed by
+     * [0, toChangeId).
+     */
+    std::vector<Message> msgs;
+    bool wraps = toChangeId < fromChangeId;
+    set<pair<uint32_t, MessageMapKey> >::iterator iit = changeIdIndex.lower_bound(pair<uint32_t, MessageMapKey>(fromChangeId, MessageMapKey()));
+    for (int pass = 0; pass < 2; ++pass) {
+        while ((iit != changeIdIndex.end()) && ((wraps && (pass == 0)) || (iit->first < toChangeId))) {
+            map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.find(iit->second);
+            ++iit;
+            assert(it != messageMap.end());
             if (it->second.second->IsExpired()) {
                 /* Remove expired message without sending */
-                messageMap.erase(it++);
+                EraseMessage(it);
                 messageErased = true;
             } else {
-                /* Send message */
-                lock.Unlock();
-                router.LockNameTable();
-                BusEndpoint ep = router.FindEndpoint(sender);
-                if (ep->IsValid()) {
-                    router.UnlockNameTable();
-                    if (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL) {
-                        status = VirtualEndpoint::cast(ep)->PushMessage(it->second.second, sessionId);
-                    } else {
-                        status = ep->PushMessage(it->second.second);
-                    }
-                } else {
-                    router.UnlockNameTable();
-                }
-                lock.Lock();
-                it = messageMap.upper_bound(key);
+                msgs.push_back(it->second.second);
             }
-            if (status != ER_OK) {
-                QCC_LogError(status, ("Failed to push sessionless signal to %s", sender));
-            }
-        } else {
-            ++it;
         }
+        if (!wraps) {
+            break;
+        }
+        iit = changeIdIndex.begin();
     }
     lock.Unlock();
 
+    /*
+     * Send the messages. The requester is normally a remote daemon so the whole range is
+     * queued on its bus-to-bus endpoint in one operation and goes out in vectored writes.
+     */
+    if (!msgs.empty()) {
+        router.LockNameTable();
+        BusEndpoint ep = router.FindEndpoint(sender);
+        router.UnlockNameTable();
+        if (!ep->IsValid()) {
+            status = ER_BUS_NO_ENDPOINT;
+        } else if (ep->GetEndpointType() == ENDPOINT_TYPE_VIRTUAL) {
+            status = VirtualEndpoint::cast(ep)->PushMessages(msgs, sessionId);
+        } else if ((ep->GetEndpointType() == ENDPOINT_TYPE_REMOTE) || (ep->GetEndpointType() == ENDPOINT_TYPE_BUS2BUS)) {
+            size_t numPushed;
+            status = RemoteEndpoint::cast(ep)->PushMessages(msgs, numPushed);
+        } else {
+            for (size_t i = 0; (i < msgs.size()) && (status == ER_OK); ++i) {
+                status = ep->PushMessage(msgs[i]);
+            }
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to push sessionless signals to %s", sender));
+        }
+    }
+
     /* Alert the advertiser worker */
     if (messageErased) {
         uint32_t zero = 0;
@@ -765,6 +791,53 @@ void SessionlessObj::HandleRangeRequest(const char* sender, SessionId sessionId,
 }
 
 
+void SessionlessObj::EraseMessage(map<MessageMapKey, pair<uint32_t, Message> >::iterator it)
+{
+    changeIdIndex.erase(pair<uint32_t, MessageMapKey>(it->second.first, it->first));
+    messageMap.erase(it);
+}
+
+void SessionlessObj::PurgeExpiredMessages(uint32_t& tilExpire)
+{
+    uint64_t now = GetTimestamp64();
+    while (!expiryHeap.empty() && (expiryHeap.top().expireTime <= now)) {
+        ExpiryEntry entry = expiryHeap.top();
+        expiryHeap.pop();
+        /* Skip entries for messages that have been replaced or removed */
+        map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.find(entry.key);
+        if ((it != messageMap.end()) && (it->second.first == entry.changeId)) {
+            uint32_t expire;
+            if (it->second.second->IsExpired(&expire)) {
+                EraseMessage(it);
+            } else {
+                entry.expireTime = now + expire;
+                expiryHeap.push(entry);
+            }
+        }
+    }
+    /*
+     * Rebuild the heap if it is mostly made up of entries for messages that have been replaced
+     * or removed.
+     */
+    if (expiryHeap.size() > (2 * messageMap.size() + 64)) {
+        expiryHeap = std::priority_queue<ExpiryEntry>();
+        map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.begin();
+        while (it != messageMap.end()) {
+            uint32_t expire;
+            it->second.second->IsExpired(&expire);
+            if (expire != ::numeric_limits<uint32_t>::max()) {
+                expiryHeap.push(ExpiryEntry(now + expire, it->first, it->second.first));
+            }
+            ++it;
+        }
+    }
+    if (expiryHeap.empty()) {
+        tilExpire = ::numeric_limits<uint32_t>::max();
+    } else {
+        tilExpire = static_cast<uint32_t>(expiryHeap.top().expireTime - now);
+    }
+}
+
 void SessionlessObj::AlarmTriggered(const Alarm& alarm, QStatus reason)
 {
     QCC_DbgTrace(("SessionlessObj::AlarmTriggered(alarm, %s)", QCC_StatusText(reason)));
@@ -773,21 +846,15 @@ void SessionlessObj::AlarmTriggered(const Alarm& alarm, QStatus reason)
 
     if (reason == ER_OK) {
         uint32_t tilExpire = ::numeric_limits<uint32_t>::max();
-        uint32_t expire;
         uint32_t maxChangeId = 0;
         bool mapIsEmpty = true;
 
         /* Purge the messageMap of expired messages */
         lock.Lock();
-        map<MessageMapKey, pair<uint32_t, Message> >::iterator it = messageMap.begin();
-        while (it != messageMap.end()) {
-            if (it->second.second->IsExpired(&expire)) {
-                messageMap.erase(it++);
-            } else {
-                maxChangeId = max(maxChangeId, it->second.first);
-                mapIsEmpty = false;
-                ++it;
-            }
+        PurgeExpiredMessages(tilExpire);
+        if (!messageMap.empty()) {
+            maxChangeId = changeIdIndex.rbegin()->first;
+            mapIsEmpty = false;
         }
         lock.Unlock();
 
@@ -212,6 +212,8 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
     QStatus RereceiveMessages(const qcc::String& sender, const qcc::String& guid);
 
   private:
+    friend class SessionlessObjTest;
+
     /**
      * SessionlessObj worker.
      *
@@ -264,6 +266,9 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
     /* Class used as key for messageMap */
     class MessageMapKey : public qcc::String {
       public:
+        /* The empty key orders before all other keys */
+        MessageMapKey() { }
+
         MessageMapKey(const char* sender, const char* iface, const char* member, const char* objPath) :
             qcc::String(sender, 0, ::strlen(sender) + ::strlen(iface) + ::strlen(member) + ::strlen(objPath) + 4)
         {
@@ -279,6 +284,40 @@ class SessionlessObj : public BusObject, public NameListener, public SessionList
     /** Storage for sessionless messages waiting to be delivered */
     std::map<MessageMapKey, std::pair<uint32_t, Message> > messageMap;
 
+    /** Index of messageMap ordered by change id */
+    std::set<std::pair<uint32_t, MessageMapKey> > changeIdIndex;
+
+    /** Expiry time of a message in messageMap that has a TTL */
+    struct ExpiryEntry {
+        ExpiryEntry(uint64_t expireTime, const MessageMapKey& key, uint32_t changeId) : expireTime(expireTime), key(key), changeId(changeId) { }
+        uint64_t expireTime;
+        MessageMapKey key;
+        uint32_t changeId;
+        /* Order by expiry time with the earliest expiry at the top of the heap */
+        bool operator<(const ExpiryEntry& other) const { return expireTime > other.expireTime; }
+    };
+
+    /**
+     * Heap of the expiry times of messages in messageMap. Entries for messages that have been
+     * replaced or removed from messageMap are discarded when they reach the top of the heap.
+     */
+    std::priority_queue<ExpiryEntry> expiryHeap;
+
+    /**
+     * Remove a message from messageMap and changeIdIndex. Must be called with lock held.
+     *
+     * @param it   Iterator of the messageMap entry to remove.
+     */
+    void EraseMessage(std::map<MessageMapKey, std::pair<uint32_t, Message> >::iterator it);
+
+    /**
+     * Remove the messages that have expired. Must be called with lock held.
+     *
+     * @param[out] tilExpire   Returns the number of ms until the next message expires or
+     *                         numeric_limits<uint32_t>::max() if no stored messages have a TTL.
+     */
+    void PurgeExpiredMessages(uint32_t& tilExpire);
+
     /** Count the number of rules (per endpoint) that specify sesionless=TRUE */
     std::map<qcc::String, uint32_t> ruleCountMap;
 
@@ -310,6 +310,18 @@
  * This AuthStop() will cause the endpoint to be scavenged using the above mechanism
  * the next time through the accept loop.
  *
+ * A thread per authenticating connection does not hold up well when many
+ * clients connect at once, for example when a network comes back up.  If the
+ * "auth_workers" limit is configured, Authenticate() does not start a thread.
+ * Instead it registers the socket with the bus IODispatch, which keeps one
+ * persistent registration per socket, and when the socket becomes readable the
+ * endpoint is handed to one of a fixed number of auth worker threads
+ * (DispatchAuth()).  The worker runs AuthStep(), which feeds whatever SASL or
+ * hello data has arrived to the endpoint authentication code without blocking
+ * and re-enables the read callback if it needs more.
+ * The AUTH_FAILED and AUTH_SUCCEEDED states and the scavenging described above
+ * work in the same way in both modes.
+ *
  * A daemon transport can accept incoming connections, and it can make outgoing
  * connections to another daemon.  This case is simpler than the accept case
  * since it is expected that a socket connect can block, so it is possible to do
@@ -401,216 +413,6 @@ const char* TCPTransport::TransportName = "tcp";
  */
 const char* const TCPTransport::ALLJOYN_DEFAULT_ROUTER_ADVERTISEMENT_PREFIX = "org.alljoyn.BusNode.";
 
-/*
- * An endpoint class to handle the details of authenticating a connection in a
- * way that avoids denial of service attacks.
- */
-class _TCPEndpoint : public _RemoteEndpoint {
-  public:
-    /**
-     * There are three threads that can be running around in this data
-     * structure.  An auth thread is run before the endpoint is started in order
-     * to handle the security stuff that must be taken care of before messages
-     * can start passing.  This enum reflects the states of the authentication
-     * process and the state can be found in m_authState.  Once authentication
-     * is complete, the auth thread must go away, but it must also be joined,
-     * which is indicated by the AUTH_DONE state.  The other threads are the
-     * endpoint RX and TX threads, which are dealt with by the EndpointState.
-     */
-    enum AuthState {
-        AUTH_ILLEGAL = 0,
-        AUTH_INITIALIZED,    /**< This endpoint structure has been allocated but no auth thread has been run */
-        AUTH_AUTHENTICATING, /**< We have spun up an authentication thread and it has begun running our user function */
-        AUTH_FAILED,         /**< The authentication has failed and the authentication thread is exiting immidiately */
-        AUTH_SUCCEEDED,      /**< The auth process (Establish) has succeeded and the connection is ready to be started */
-        AUTH_DONE,           /**< The auth thread has been successfully shut down and joined */
-    };
-
-    /**
-     * There are three threads that can be running around in this data
-     * structure.  Two threads, and RX thread and a TX thread are used to pump
-     * messages through an endpoint.  These threads cannot be run until the
-     * authentication process has completed.  This enum reflects the states of
-     * the endpoint RX and TX threads and can be found in m_epState.  The auth
-     * thread is dealt with by the AuthState enum above.  These threads must be
-     * joined when they exit, which is indicated by the EP_DONE state.
-     */
-    enum EndpointState {
-        EP_ILLEGAL = 0,
-        EP_INITIALIZED,      /**< This endpoint structure has been allocated but not used */
-        EP_FAILED,           /**< Starting the RX and TX threads has failed and this endpoint is not usable */
-        EP_STARTING,          /**< The RX and TX threads are being started */
-        EP_STARTED,          /**< The RX and TX threads have been started (they work as a unit) */
-        EP_STOPPING,         /**< The RX and TX threads are stopping (have run ThreadExit) but have not been joined */
-        EP_DONE              /**< The RX and TX threads have been shut down and joined */
-    };
-
-    /**
-     * Connections can either be created as a result of a Connect() or an Accept().
-     * If a connection happens as a result of a connect it is the active side of
-     * a connection.  If a connection happens because of an Accpet() it is the
-     * passive side of a connection.  This is important because of reference
-     * counting of bus-to-bus endpoints.
-     */
-    enum SideState {
-        SIDE_ILLEGAL = 0,
-        SIDE_INITIALIZED,    /**< This endpoint structure has been allocated but don't know if active or passive yet */
-        SIDE_ACTIVE,         /**< This endpoint is the active side of a connection */
-        SIDE_PASSIVE         /**< This endpoint is the passive side of a connection */
-    };
-
-    _TCPEndpoint(TCPTransport* transport,
-                 BusAttachment& bus,
-                 bool incoming,
-                 const qcc::String connectSpec,
-                 qcc::SocketFd sock,
-                 const qcc::IPAddress& ipAddr,
-                 uint16_t port) :
-        _RemoteEndpoint(bus, incoming, connectSpec, &m_stream, "tcp"),
-        m_transport(transport),
-        m_sideState(SIDE_INITIALIZED),
-        m_authState(AUTH_INITIALIZED),
-        m_epState(EP_INITIALIZED),
-        m_tStart(qcc::Timespec(0)),
-        m_authThread(this),
-        m_stream(sock),
-        m_ipAddr(ipAddr),
-        m_port(port),
-        m_wasSuddenDisconnect(!incoming) { }
-
-    virtual ~_TCPEndpoint() { }
-
-    QStatus GetLocalIp(qcc::String& ipAddrStr) {
-        SocketFd sockFd = m_stream.GetSocketFd();
-        IPAddress ipaddr;
-        uint16_t port;
-        QStatus status = GetLocalAddress(sockFd, ipaddr, port);
-        if (status == ER_OK) {
-            ipAddrStr = ipaddr.ToString();
-        }
-        return status;
-    };
-
-    QStatus GetRemoteIp(qcc::String& ipAddrStr) {
-        ipAddrStr = m_ipAddr.ToString();
-        return ER_OK;
-    };
-
-    void SetStartTime(qcc::Timespec tStart) { m_tStart = tStart; }
-    qcc::Timespec GetStartTime(void) { return m_tStart; }
-    QStatus Authenticate(void);
-    void AuthStop(void);
-    void AuthJoin(void);
-    const qcc::IPAddress& GetIPAddress() { return m_ipAddr; }
-    uint16_t GetPort() { return m_port; }
-
-    SideState GetSideState(void) { return m_sideState; }
-
-    void SetActive(void)
-    {
-        m_sideState = SIDE_ACTIVE;
-    }
-
-    void SetPassive(void)
-    {
-        m_sideState = SIDE_PASSIVE;
-    }
-
-
-    AuthState GetAuthState(void) { return m_authState; }
-
-    void SetAuthDone(void)
-    {
-        Timespec tNow;
-        GetTimeNow(&tNow);
-        SetStartTime(tNow);
-        m_authState = AUTH_DONE;
-    }
-
-    EndpointState GetEpState(void) { return m_epState; }
-
-    void SetEpFailed(void)
-    {
-        m_epState = EP_FAILED;
-    }
-
-    void SetEpStarting(void)
-    {
-        m_epState = EP_STARTING;
-    }
-
-    void SetEpStarted(void)
-    {
-        m_epState = EP_STARTED;
-    }
-
-    void SetEpStopping(void)
-    {
-        assert(m_epState == EP_STARTING || m_epState == EP_STARTED || m_epState == EP_STOPPING || m_epState == EP_FAILED);
-        m_epState = EP_STOPPING;
-    }
-
-    void SetEpDone(void)
-    {
-        assert(m_epState == EP_FAILED || m_epState == EP_STOPPING);
-        m_epState = EP_DONE;
-    }
-
-    bool IsSuddenDisconnect() { return m_wasSuddenDisconnect; }
-    void SetSuddenDisconnect(bool val) { m_wasSuddenDisconnect = val; }
-
-    QStatus SetLinkTimeout(uint32_t& linkTimeout)
-    {
-        QStatus status = ER_OK;
-        if (linkTimeout > 0) {
-            uint32_t to = max(linkTimeout, TCP_LINK_TIMEOUT_MIN_LINK_TIMEOUT);
-            to -= TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * TCP_LINK_TIMEOUT_PROBE_ATTEMPTS;
-            status = _RemoteEndpoint::SetLinkTimeout(to, TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY, TCP_LINK_TIMEOUT_PROBE_ATTEMPTS);
-            if ((status == ER_OK) && (to > 0)) {
-                linkTimeout = to + TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * TCP_LINK_TIMEOUT_PROBE_ATTEMPTS;
-            }
-
-        } else {
-            _RemoteEndpoint::SetLinkTimeout(0, 0, 0);
-        }
-        return status;
-    }
-
-    /*
-     * Return true if the auth thread is STARTED, RUNNING or STOPPING.  A true
-     * response means the authentication thread is in a state that indicates
-     * a possibility it might touch the endpoint data structure.  This means
-     * don't delete the endpoint if this method returns true.  This method
-     * indicates nothing about endpoint rx and tx thread state.
-     */
-    bool IsAuthThreadRunning(void)
-    {
-        return m_authThread.IsRunning();
-    }
-    virtual void ThreadExit(qcc::Thread* thread);
-
-  private:
-    class AuthThread : public qcc::Thread {
-      public:
-        AuthThread(_TCPEndpoint* ep) : Thread("auth"), m_endpoint(ep)  { }
-      private:
-        virtual qcc::ThreadReturn STDCALL Run(void* arg);
-
-        _TCPEndpoint* m_endpoint;
-    };
-
-    TCPTransport* m_transport;        /**< The server holding the connection */
-    volatile SideState m_sideState;   /**< Is this an active or passive connection */
-    volatile AuthState m_authState;   /**< The state of the endpoint authentication process */
-    volatile EndpointState m_epState; /**< The state of the endpoint authentication process */
-    qcc::Timespec m_tStart;           /**< Timestamp indicating when the authentication process started */
-    AuthThread m_authThread;          /**< Thread used to do blocking calls during startup */
-    qcc::SocketStream m_stream;       /**< Stream used by authentication code */
-    qcc::IPAddress m_ipAddr;          /**< Remote IP address. */
-    uint16_t m_port;                  /**< Remote port. */
-    bool m_wasSuddenDisconnect;       /**< If true, assumption is that any disconnect is unexpected due to lower level error */
-};
-
 void _TCPEndpoint::ThreadExit(qcc::Thread* thread)
 {
     /* If the auth thread exits before it even enters the AuthThread::Run() function, set the state to AUTH_FAILED. */
@@ -623,9 +425,40 @@ void _TCPEndpoint::ThreadExit(qcc::Thread* thread)
     _RemoteEndpoint::ThreadExit(thread);
 }
 
+QStatus _TCPEndpoint::SetLinkTimeout(uint32_t& linkTimeout)
+{
+    QStatus status = ER_OK;
+    if (linkTimeout > 0) {
+        uint32_t to = max(linkTimeout, TCP_LINK_TIMEOUT_MIN_LINK_TIMEOUT);
+        to -= TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * TCP_LINK_TIMEOUT_PROBE_ATTEMPTS;
+        status = _RemoteEndpoint::SetLinkTimeout(to, TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY, TCP_LINK_TIMEOUT_PROBE_ATTEMPTS);
+        if ((status == ER_OK) && (to > 0)) {
+            linkTimeout = to + TCP_LINK_TIMEOUT_PROBE_RESPONSE_DELAY * TCP_LINK_TIMEOUT_PROBE_ATTEMPTS;
+        }
+
+    } else {
+        _RemoteEndpoint::SetLinkTimeout(0, 0, 0);
+    }
+    return status;
+}
+
 QStatus _TCPEndpoint::Authenticate(void)
 {
     QCC_DbgTrace(("TCPEndpoint::Authenticate()"));
+    /*
+     * If the transport has auth workers there is no authentication thread to
+     * start.  The connection is dispatched to a worker as soon as the client
+     * sends something.
+     */
+    if (m_transport->m_authDispatcher) {
+        m_authNonBlocking = true;
+        m_authState = AUTH_AUTHENTICATING;
+        QStatus status = WatchAuth();
+        if (status != ER_OK) {
+            m_authState = AUTH_FAILED;
+        }
+        return status;
+    }
     /*
      * Start the authentication thread.
      */
@@ -649,7 +482,21 @@ void _TCPEndpoint::AuthStop(void)
      * notice that the thread failed the next time through the main server run
      * loop, join the thread via AuthJoin below and delete the endpoint.  Note
      * that this is a lazy cleanup of the endpoint.
-     */
+     *
+     * A non-blocking authentication that is not being worked on fails right
+     * away.  If an auth worker owns the endpoint, the worker fails the
+     * authentication when it finishes its current step.
+     */
+    if (m_authNonBlocking) {
+        m_authLock.Lock(MUTEX_CONTEXT);
+        m_authAbort = true;
+        if (!m_authBusy && (m_authState == AUTH_AUTHENTICATING)) {
+            AbortAccept();
+            m_authState = AUTH_FAILED;
+        }
+        m_authLock.Unlock(MUTEX_CONTEXT);
+        return;
+    }
     m_authThread.Stop();
 }
 
@@ -662,10 +509,159 @@ void _TCPEndpoint::AuthJoin(void)
      * order to communicate their return status.  The auth thread is no exception.
      * This is done in a lazy fashion from the main server accept loop, where we
      * cleanup every time through the loop.
-     */
+     *
+     * There is no thread to join for a non-blocking authentication but it may
+     * have been abandoned part way through, in which case the socket is taken
+     * out of IODispatch and the authentication state it holds (and its
+     * reference to this endpoint) is released here.
+     */
+    if (m_authNonBlocking) {
+        UnwatchAuth();
+        AbortAccept();
+        return;
+    }
     m_authThread.Join();
 }
 
+void _TCPEndpoint::AuthStep(QStatus reason)
+{
+    QCC_DbgTrace(("TCPEndpoint::AuthStep()"));
+
+    /*
+     * This is the non-blocking counterpart of AuthThread::Run().  It is run by
+     * an auth worker when the server accept loop sees data to read on the
+     * connection.  All reads are done with a zero timeout so the worker never
+     * waits on a slow client; if the authentication needs more data the read
+     * callback is re-enabled and the connection is dispatched again when the
+     * data arrives.  A reason other than ER_OK means the auth workers are
+     * shutting down.
+     */
+    QStatus status = reason;
+    if ((status == ER_OK) && m_authAbort) {
+        status = ER_BUS_ENDPOINT_CLOSING;
+    }
+
+    if ((status == ER_OK) && !m_authAccepting) {
+        /*
+         * Eat the first byte of the stream.  This is required to be zero by the
+         * DBus protocol.
+         */
+        uint8_t byte;
+        size_t nbytes;
+        status = m_stream.PullBytes(&byte, 1, nbytes, 0);
+        if ((status == ER_OK) && ((nbytes != 1) || (byte != 0))) {
+            status = ER_FAIL;
+        }
+        if (status == ER_OK) {
+            /* Initialized the features for this endpoint */
+            GetFeatures().isBusToBus = false;
+            GetFeatures().handlePassing = false;
+
+            /*
+             * See AuthThread::Run() for why the listener must be set before
+             * the establishment starts.
+             */
+            DaemonRouter& router = reinterpret_cast<DaemonRouter&>(m_transport->m_bus.GetInternal().GetRouter());
+            AuthListener* authListener = router.GetBusController()->GetAuthListener();
+            SetListener(m_transport);
+            if (authListener) {
+                status = StartAccept("ALLJOYN_PIN_KEYX ANONYMOUS", authListener);
+            } else {
+                status = StartAccept("ANONYMOUS", authListener);
+            }
+            m_authAccepting = (status == ER_OK);
+        } else if (status != ER_TIMEOUT) {
+            QCC_LogError(status, ("Failed to read first byte from stream"));
+        }
+    }
+
+    if ((status == ER_OK) && m_authAccepting) {
+        qcc::String authName;
+        status = ContinueAccept(authName);
+        if ((status != ER_OK) && (status != ER_WOULDBLOCK)) {
+            QCC_LogError(status, ("Failed to establish TCP endpoint"));
+        }
+    }
+
+    if (status == ER_OK) {
+        /*
+         * Tell the transport that the authentication has succeeded and that it can
+         * now bring the connection up.  Starting the endpoint registers the stream
+         * with IODispatch again, so the authentication registration must be gone.
+         */
+        UnwatchAuth();
+        TCPEndpoint tcpEp = TCPEndpoint::wrap(this);
+        m_transport->Authenticated(tcpEp);
+    }
+
+    /*
+     * Hand the endpoint back.  As with the auth thread, setting AUTH_FAILED or
+     * AUTH_SUCCEEDED tells the server accept loop it may clean up the endpoint;
+     * otherwise the endpoint goes back to waiting for data.
+     */
+    bool waiting = (status == ER_WOULDBLOCK) || (status == ER_TIMEOUT);
+    m_authLock.Lock(MUTEX_CONTEXT);
+    if (waiting && !m_authAbort) {
+        status = m_transport->m_bus.GetInternal().GetIODispatch().EnableReadCallback(&m_stream);
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to wait for more authentication data"));
+            waiting = false;
+        }
+    }
+    if (status == ER_OK) {
+        if (!waiting) {
+            m_authState = AUTH_SUCCEEDED;
+        }
+    } else if (!waiting || m_authAbort) {
+        AbortAccept();
+        m_authState = AUTH_FAILED;
+    }
+    m_authBusy = false;
+    m_authLock.Unlock(MUTEX_CONTEXT);
+}
+
+QStatus _TCPEndpoint::AuthWatcher::ReadCallback(qcc::Source& source, bool isTimedOut)
+{
+    TCPEndpoint tcpEp = TCPEndpoint::wrap(m_endpoint);
+    m_endpoint->m_transport->DispatchAuth(tcpEp);
+    return ER_OK;
+}
+
+QStatus _TCPEndpoint::WatchAuth(void)
+{
+    m_authLock.Lock(MUTEX_CONTEXT);
+    m_authWatcher.m_exited = false;
+    QStatus status = m_transport->m_bus.GetInternal().GetIODispatch().StartStream(&m_stream, &m_authWatcher, NULL, &m_authWatcher, true, false);
+    m_authWatched = (status == ER_OK);
+    m_authLock.Unlock(MUTEX_CONTEXT);
+    if (status != ER_OK) {
+        QCC_LogError(status, ("TCPEndpoint::WatchAuth(): Failed to register authenticating connection"));
+    }
+    return status;
+}
+
+void _TCPEndpoint::UnwatchAuth(void)
+{
+    m_authLock.Lock(MUTEX_CONTEXT);
+    bool watched = m_authWatched;
+    m_authWatched = false;
+    m_authLock.Unlock(MUTEX_CONTEXT);
+    if (watched) {
+        /*
+         * JoinStream() polls every few milliseconds, which would hold up an
+         * auth worker for longer than the rest of the authentication.  The
+         * exit callback is normally made right away, so wait for it first.
+         */
+        IODispatch& iodispatch = m_transport->m_bus.GetInternal().GetIODispatch();
+        if (iodispatch.StopStream(&m_stream) == ER_OK) {
+            while (!m_authWatcher.m_exited) {
+                qcc::Sleep(0);
+            }
+        }
+        iodispatch.JoinStream(&m_stream);
+    }
+}
+
 void* _TCPEndpoint::AuthThread::Run(void* arg)
 {
     QCC_DbgTrace(("TCPEndpoint::AuthThread::Run()"));
@@ -817,7 +813,7 @@ void* _TCPEndpoint::AuthThread::Run(void* arg)
 }
 
 TCPTransport::TCPTransport(BusAttachment& bus)
-    : Thread("TCPTransport"), m_bus(bus), m_stopping(false), m_listener(0),
+    : Thread("TCPTransport"), m_authDispatcher(NULL), m_bus(bus), m_stopping(false), m_listener(0),
     m_foundCallback(m_listener),
     m_isAdvertising(false), m_isDiscovering(false), m_isListening(false),
     m_isNsEnabled(false), m_reload(STATE_RELOADING),
@@ -905,6 +901,48 @@ void TCPTransport::Authenticated(TCPEndpoint& conn)
     }
 }
 
+void TCPTransport::DispatchAuth(TCPEndpoint& conn)
+{
+    QCC_DbgTrace(("TCPTransport::DispatchAuth()"));
+
+    /*
+     * Claim the endpoint for an auth worker.  This fails if the endpoint has
+     * been stopped or a worker already has it.
+     */
+    if (!conn->IsAuthWaiting(true)) {
+        return;
+    }
+    /*
+     * The alarm context holds a reference to the endpoint until the worker is
+     * done with it.
+     */
+    TCPEndpoint* context = new TCPEndpoint(conn);
+    AlarmListener* listener = this;
+    QStatus status = m_authDispatcher->AddAlarm(Alarm(listener, context));
+    if (status != ER_OK) {
+        QCC_LogError(status, ("TCPTransport::DispatchAuth(): Failed to dispatch authentication"));
+        conn->AuthStep(status);
+        delete context;
+    }
+}
+
+void TCPTransport::AlarmTriggered(const Alarm& alarm, QStatus reason)
+{
+    TCPEndpoint* conn = static_cast<TCPEndpoint*>(alarm->GetContext());
+    (*conn)->AuthStep(reason);
+    bool done = ((*conn)->GetAuthState() != _TCPEndpoint::AUTH_AUTHENTICATING);
+    delete conn;
+
+    /*
+     * Wake up the server accept loop to deal with the result of the
+     * authentication.  A connection that is still waiting for data is left to
+     * IODispatch.
+     */
+    if (done) {
+        Alert();
+    }
+}
+
 QStatus TCPTransport::Start()
 {
     /*
@@ -1426,7 +1464,9 @@ void TCPTransport::ManageEndpoints(Timespec authTimeout, Timespec sessionSetupTi
              */
             QCC_DbgHLPrintf(("TCPTransport::ManageEndpoints(): Scavenging slow authenticator"));
             ep->AuthStop();
-            qcc::Sleep(1);
+            if (!ep->IsAuthNonBlocking()) {
+                qcc::Sleep(1);
+            }
         }
         ++i;
     }
@@ -1571,6 +1611,21 @@ void* TCPTransport::Run(void* arg)
      */
     uint32_t maxConn = config->Get("limit@max_completed_connections", ALLJOYN_MAX_COMPLETED_CONNECTIONS_TCP_DEFAULT);
 
+    /*
+     * authWorkers is the number of threads used to authenticate incoming
+     * connections without blocking.  If zero, every incoming connection gets
+     * its own authentication thread.
+     */
+    uint32_t authWorkers = config->Get("limit@auth_workers", ALLJOYN_AUTH_WORKERS_TCP_DEFAULT);
+    if (authWorkers > 0) {
+        m_authDispatcher = new Timer("tcpauth", true, authWorkers);
+        if (m_authDispatcher->Start() != ER_OK) {
+            QCC_LogError(ER_FAIL, ("TCPTransport::Run(): Failed to start auth workers"));
+            delete m_authDispatcher;
+            m_authDispatcher = NULL;
+        }
+    }
+
     QStatus status = ER_OK;
 
     while (!IsStopping()) {
@@ -1609,14 +1664,32 @@ void* TCPTransport::Run(void* arg)
         }
         m_listenFdsLock.Unlock(MUTEX_CONTEXT);
 
+        /*
+         * Connections being authenticated by the auth workers are watched by
+         * IODispatch, and we only hear about them when they are done.  A client
+         * that goes quiet would then not be timed out until something else
+         * wakes us up, so don't wait longer than the auth timeout while there
+         * are any.
+         */
+        uint32_t maxWait = Event::WAIT_FOREVER;
+        if (m_authDispatcher) {
+            m_endpointListLock.Lock(MUTEX_CONTEXT);
+            if (!m_authList.empty()) {
+                maxWait = static_cast<uint32_t>(authTimeout.GetAbsoluteMillis());
+            }
+            m_endpointListLock.Unlock(MUTEX_CONTEXT);
+        }
+
         /*
          * We have our list of events, so now wait for something to happen
          * on that list (or get alerted).
          */
         signaledEvents.clear();
 
-        status = Event::Wait(checkEvents, signaledEvents);
-        if (ER_OK != status) {
+        status = Event::Wait(checkEvents, signaledEvents, maxWait);
+        if (ER_TIMEOUT == status) {
+            ManageEndpoints(authTimeout, sessionSetupTimeout);
+        } else if (ER_OK != status) {
             QCC_LogError(status, ("Event::Wait failed"));
             break;
         }
@@ -1758,6 +1831,18 @@ void* TCPTransport::Run(void* arg)
     m_reload = STATE_EXITED;
     m_listenFdsLock.Unlock(MUTEX_CONTEXT);
 
+    /*
+     * Shut down the auth workers.  Any authentication step still queued is
+     * run with ER_TIMER_EXITING, which fails it, and the connections are left
+     * on the m_authList for Join() to clean up.
+     */
+    if (m_authDispatcher) {
+        m_authDispatcher->Stop();
+        m_authDispatcher->Join();
+        delete m_authDispatcher;
+        m_authDispatcher = NULL;
+    }
+
     QCC_DbgPrintf(("TCPTransport::Run is exiting status=%s", QCC_StatusText(status)));
     return (void*) status;
 }
@@ -27,6 +27,7 @@
 #error Only include TCPTransport.h in C++ code.
 #endif
 
+#include <assert.h>
 #include <list>
 #include <queue>
 #include <alljoyn/Status.h>
@@ -35,8 +36,10 @@
 #include <qcc/String.h>
 #include <qcc/Mutex.h>
 #include <qcc/Thread.h>
+#include <qcc/IODispatch.h>
 #include <qcc/Socket.h>
 #include <qcc/SocketStream.h>
+#include <qcc/Timer.h>
 #include <qcc/time.h>
 
 #include <alljoyn/TransportMask.h>
@@ -61,7 +64,7 @@ typedef qcc::ManagedObj<_TCPEndpoint> TCPEndpoint;
  * versions revolves around routing and discovery. This class provides a
  * specialization of class Transport for use by daemons.
  */
-class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener, public qcc::Thread {
+class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener, public qcc::Thread, public qcc::AlarmListener {
     friend class _TCPEndpoint;
 
   public:
@@ -283,6 +286,18 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     static const char* TransportName;
 
+  protected:
+    /**
+     * @internal
+     * @brief Hand an authenticating connection that has data to read to one
+     * of the auth workers.
+     *
+     * @param conn Reference to the TCPEndpoint to run an authentication step on.
+     */
+    void DispatchAuth(TCPEndpoint& conn);
+
+    qcc::Timer* m_authDispatcher;                                  /**< Auth workers for non-blocking authentication, NULL if each connection gets an auth thread */
+
   private:
     TCPTransport(const TCPTransport& other);
     TCPTransport& operator =(const TCPTransport& other);
@@ -446,6 +461,13 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     void Authenticated(TCPEndpoint& conn);
 
+    /**
+     * @internal
+     * @brief Auth worker entry point.  Runs one non-blocking authentication
+     * step on the connection passed as the alarm context.
+     */
+    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+
     /**
      * @internal
      * @brief Normalize a listen specification.
@@ -513,6 +535,18 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
      */
     static const uint32_t ALLJOYN_MAX_INCOMPLETE_CONNECTIONS_TCP_DEFAULT = 10;
 
+    /**
+     * @brief The default value for the number of auth worker threads.
+     *
+     * To override this value, change the limit, "auth_workers".  If zero, each
+     * incoming connection is authenticated by its own thread running a blocking
+     * Establish().  Otherwise connections are authenticated without blocking by
+     * this many worker threads, which are handed a connection by the server
+     * accept loop whenever it has data to read.  Raise "max_incomplete_connections"
+     * along with this value if many clients are expected to connect at once.
+     */
+    static const uint32_t ALLJOYN_AUTH_WORKERS_TCP_DEFAULT = 0;
+
     /**
      * @brief The default value for the maximum number of TCP connections
      * (remote endpoints).
@@ -683,6 +717,272 @@ class TCPTransport : public Transport, public _RemoteEndpoint::EndpointListener,
 
 };
 
+/*
+ * An endpoint class to handle the details of authenticating a connection in a
+ * way that avoids denial of service attacks.
+ */
+class _TCPEndpoint : public _RemoteEndpoint {
+  public:
+    /**
+     * There are three threads that can be running around in this data
+     * structure.  An auth thread is run before the endpoint is started in order
+     * to handle the security stuff that must be taken care of before messages
+     * can start passing.  This enum reflects the states of the authentication
+     * process and the state can be found in m_authState.  Once authentication
+     * is complete, the auth thread must go away, but it must also be joined,
+     * which is indicated by the AUTH_DONE state.  The other threads are the
+     * endpoint RX and TX threads, which are dealt with by the EndpointState.
+     */
+    enum AuthState {
+        AUTH_ILLEGAL = 0,
+        AUTH_INITIALIZED,    /**< This endpoint structure has been allocated but no auth thread has been run */
+        AUTH_AUTHENTICATING, /**< We have spun up an authentication thread and it has begun running our user function */
+        AUTH_FAILED,         /**< The authentication has failed and the authentication thread is exiting immidiately */
+        AUTH_SUCCEEDED,      /**< The auth process (Establish) has succeeded and the connection is ready to be started */
+        AUTH_DONE,           /**< The auth thread has been successfully shut down and joined */
+    };
+
+    /**
+     * There are three threads that can be running around in this data
+     * structure.  Two threads, and RX thread and a TX thread are used to pump
+     * messages through an endpoint.  These threads cannot be run until the
+     * authentication process has completed.  This enum reflects the states of
+     * the endpoint RX and TX threads and can be found in m_epState.  The auth
+     * thread is dealt with by the AuthState enum above.  These threads must be
+     * joined when they exit, which is indicated by the EP_DONE state.
+     */
+    enum EndpointState {
+        EP_ILLEGAL = 0,
+        EP_INITIALIZED,      /**< This endpoint structure has been allocated but not used */
+        EP_FAILED,           /**< Starting the RX and TX threads has failed and this endpoint is not usable */
+        EP_STARTING,          /**< The RX and TX threads are being started */
+        EP_STARTED,          /**< The RX and TX threads have been started (they work as a unit) */
+        EP_STOPPING,         /**< The RX and TX threads are stopping (have run ThreadExit) but have not been joined */
+        EP_DONE              /**< The RX and TX threads have been shut down and joined */
+    };
+
+    /**
+     * Connections can either be created as a result of a Connect() or an Accept().
+     * If a connection happens as a result of a connect it is the active side of
+     * a connection.  If a connection happens because of an Accpet() it is the
+     * passive side of a connection.  This is important because of reference
+     * counting of bus-to-bus endpoints.
+     */
+    enum SideState {
+        SIDE_ILLEGAL = 0,
+        SIDE_INITIALIZED,    /**< This endpoint structure has been allocated but don't know if active or passive yet */
+        SIDE_ACTIVE,         /**< This endpoint is the active side of a connection */
+        SIDE_PASSIVE         /**< This endpoint is the passive side of a connection */
+    };
+
+    _TCPEndpoint(TCPTransport* transport,
+                 BusAttachment& bus,
+                 bool incoming,
+                 const qcc::String connectSpec,
+                 qcc::SocketFd sock,
+                 const qcc::IPAddress& ipAddr,
+                 uint16_t port) :
+        _RemoteEndpoint(bus, incoming, connectSpec, &m_stream, "tcp"),
+        m_transport(transport),
+        m_sideState(SIDE_INITIALIZED),
+        m_authState(AUTH_INITIALIZED),
+        m_epState(EP_INITIALIZED),
+        m_tStart(qcc::Timespec(0)),
+        m_authThread(this),
+        m_authNonBlocking(false),
+        m_authAccepting(false),
+        m_authBusy(false),
+        m_authAbort(false),
+        m_authWatcher(this),
+        m_authWatched(false),
+        m_stream(sock),
+        m_ipAddr(ipAddr),
+        m_port(port),
+        m_wasSuddenDisconnect(!incoming) { }
+
+    virtual ~_TCPEndpoint() { }
+
+    QStatus GetLocalIp(qcc::String& ipAddrStr) {
+        qcc::SocketFd sockFd = m_stream.GetSocketFd();
+        qcc::IPAddress ipaddr;
+        uint16_t port;
+        QStatus status = qcc::GetLocalAddress(sockFd, ipaddr, port);
+        if (status == ER_OK) {
+            ipAddrStr = ipaddr.ToString();
+        }
+        return status;
+    };
+
+    QStatus GetRemoteIp(qcc::String& ipAddrStr) {
+        ipAddrStr = m_ipAddr.ToString();
+        return ER_OK;
+    };
+
+    void SetStartTime(qcc::Timespec tStart) { m_tStart = tStart; }
+    qcc::Timespec GetStartTime(void) { return m_tStart; }
+    QStatus Authenticate(void);
+    void AuthStop(void);
+    void AuthJoin(void);
+    const qcc::IPAddress& GetIPAddress() { return m_ipAddr; }
+    uint16_t GetPort() { return m_port; }
+
+    SideState GetSideState(void) { return m_sideState; }
+
+    void SetActive(void)
+    {
+        m_sideState = SIDE_ACTIVE;
+    }
+
+    void SetPassive(void)
+    {
+        m_sideState = SIDE_PASSIVE;
+    }
+
+
+    AuthState GetAuthState(void) { return m_authState; }
+
+    void SetAuthDone(void)
+    {
+        qcc::Timespec tNow;
+        qcc::GetTimeNow(&tNow);
+        SetStartTime(tNow);
+        m_authState = AUTH_DONE;
+    }
+
+    EndpointState GetEpState(void) { return m_epState; }
+
+    void SetEpFailed(void)
+    {
+        m_epState = EP_FAILED;
+    }
+
+    void SetEpStarting(void)
+    {
+        m_epState = EP_STARTING;
+    }
+
+    void SetEpStarted(void)
+    {
+        m_epState = EP_STARTED;
+    }
+
+    void SetEpStopping(void)
+    {
+        assert(m_epState == EP_STARTING || m_epState == EP_STARTED || m_epState == EP_STOPPING || m_epState == EP_FAILED);
+        m_epState = EP_STOPPING;
+    }
+
+    void SetEpDone(void)
+    {
+        assert(m_epState == EP_FAILED || m_epState == EP_STOPPING);
+        m_epState = EP_DONE;
+    }
+
+    bool IsSuddenDisconnect() { return m_wasSuddenDisconnect; }
+    void SetSuddenDisconnect(bool val) { m_wasSuddenDisconnect = val; }
+
+    QStatus SetLinkTimeout(uint32_t& linkTimeout);
+
+    /*
+     * Return true if the auth thread is STARTED, RUNNING or STOPPING.  A true
+     * response means the authentication thread is in a state that indicates
+     * a possibility it might touch the endpoint data structure.  This means
+     * don't delete the endpoint if this method returns true.  This method
+     * indicates nothing about endpoint rx and tx thread state.
+     */
+    bool IsAuthThreadRunning(void)
+    {
+        return m_authThread.IsRunning();
+    }
+    virtual void ThreadExit(qcc::Thread* thread);
+
+    /*
+     * Return true if this endpoint is authenticated without an auth thread.
+     * In that case the socket is registered with the bus IODispatch until the
+     * authentication is over.  When the connection becomes readable it is
+     * handed to one of the transport's auth workers through DispatchAuth().
+     * The worker runs AuthStep() which processes whatever data has arrived
+     * and returns without waiting for more.
+     */
+    bool IsAuthNonBlocking(void) { return m_authNonBlocking; }
+
+    /*
+     * Return true if this endpoint is waiting for data in order to continue a
+     * non-blocking authentication.  If claim is true, the endpoint is marked as
+     * owned by an auth worker until AuthStep() completes.
+     */
+    bool IsAuthWaiting(bool claim = false)
+    {
+        m_authLock.Lock(MUTEX_CONTEXT);
+        bool waiting = m_authNonBlocking && !m_authBusy && !m_authAbort && (m_authState == AUTH_AUTHENTICATING);
+        if (waiting && claim) {
+            m_authBusy = true;
+        }
+        m_authLock.Unlock(MUTEX_CONTEXT);
+        return waiting;
+    }
+
+    void AuthStep(QStatus reason);
+
+    qcc::SocketFd GetSocketFd(void) { return m_stream.GetSocketFd(); }
+
+  private:
+    /*
+     * Hands a non-blocking authentication to an auth worker when IODispatch
+     * sees data to read on the connection.  This cannot be done by the
+     * endpoint itself since its read and exit callbacks belong to the
+     * running endpoint.
+     */
+    class AuthWatcher : public qcc::IOReadListener, public qcc::IOExitListener {
+      public:
+        AuthWatcher(_TCPEndpoint* ep) : m_exited(false), m_endpoint(ep) { }
+        QStatus ReadCallback(qcc::Source& source, bool isTimedOut);
+        void ExitCallback() { m_exited = true; }
+        volatile bool m_exited;       /**< True once IODispatch has made the exit callback */
+      private:
+        _TCPEndpoint* m_endpoint;
+    };
+
+    /*
+     * Register the socket of a non-blocking authentication with IODispatch.
+     */
+    QStatus WatchAuth(void);
+
+    /*
+     * Remove the socket of a non-blocking authentication from IODispatch and
+     * wait until no callback can be made for it any more.  This must be done
+     * before the endpoint is started or deleted.
+     */
+    void UnwatchAuth(void);
+
+    class AuthThread : public qcc::Thread {
+      public:
+        AuthThread(_TCPEndpoint* ep) : Thread("auth"), m_endpoint(ep)  { }
+      private:
+        virtual qcc::ThreadReturn STDCALL Run(void* arg);
+
+        _TCPEndpoint* m_endpoint;
+    };
+
+    TCPTransport* m_transport;        /**< The server holding the connection */
+    volatile SideState m_sideState;   /**< Is this an active or passive connection */
+    volatile AuthState m_authState;   /**< The state of the endpoint authentication process */
+    volatile EndpointState m_epState; /**< The state of the endpoint authentication process */
+    qcc::Timespec m_tStart;           /**< Timestamp indicating when the authentication process started */
+    AuthThread m_authThread;          /**< Thread used to do blocking calls during startup */
+    bool m_authNonBlocking;           /**< If true, authentication is driven by the transport's auth workers instead of m_authThread */
+    bool m_authAccepting;             /**< True once a non-blocking authentication has read the first byte and started the SASL exchange */
+    volatile bool m_authBusy;         /**< True while an auth worker is running a non-blocking authentication step */
+    volatile bool m_authAbort;        /**< True if a non-blocking authentication has been asked to stop */
+    qcc::Mutex m_authLock;            /**< Mutex that protects m_authBusy, m_authAbort, m_authWatched and the non-blocking m_authState transitions */
+    AuthWatcher m_authWatcher;        /**< Read and exit listener for the IODispatch registration of a non-blocking authentication */
+    bool m_authWatched;               /**< True while the stream is registered with IODispatch for a non-blocking authentication */
+    qcc::SocketStream m_stream;       /**< Stream used by authentication code */
+    qcc::IPAddress m_ipAddr;          /**< Remote IP address. */
+    uint16_t m_port;                  /**< Remote port. */
+    bool m_wasSuddenDisconnect;       /**< If true, assumption is that any disconnect is unexpected due to lower level error */
+};
+
 } // namespace ajn
 
 #endif // _ALLJOYN_TCPTRANSPORT_H
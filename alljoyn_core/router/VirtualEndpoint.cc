@@ -24,6 +24,7 @@
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <alljoyn/Message.h>
@@ -59,31 +60,61 @@ QStatus _VirtualEndpoint::PushMessage(Message& msg, SessionId id)
     QCC_DbgTrace(("_VirtualEndpoint::PushMessage(this=%s [%x], SessionId=%u)", GetUniqueName().c_str(), this, id));
 
     QStatus status = ER_BUS_NO_ROUTE;
-    vector<RemoteEndpoint> tryEndpoints;
+    RemoteEndpoint ep;
     /*
-     * There may be multiple routes from this virtual endpoint so we are going to try all of
-     * them until we either succeed or run out of options.
+     * There may be multiple routes from this virtual endpoint so we are going to try them in
+     * turn until we either succeed or run out of options. Messages always go over the first
+     * route that works so the messages of a session stay in order.
      */
-    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    for (size_t n = 0; (status != ER_OK) && GetRoute(id, n, ep); ++n) {
+        status = ep->PushMessage(msg);
+    }
+    return status;
+}
 
-    multimap<SessionId, RemoteEndpoint>::iterator it = (id == 0) ? m_b2bEndpoints.begin() : m_b2bEndpoints.lower_bound(id);
-    while ((it != m_b2bEndpoints.end()) && (id == it->first)) {
-        RemoteEndpoint ep = it->second;
-        tryEndpoints.push_back(ep);
-        ++it;
+QStatus _VirtualEndpoint::PushMessages(std::vector<Message>& msgs, SessionId id)
+{
+    QCC_DbgTrace(("_VirtualEndpoint::PushMessages(this=%s [%x], SessionId=%u, count=%d)", GetUniqueName().c_str(), this, id, msgs.size()));
+
+    if (msgs.empty()) {
+        return ER_OK;
     }
-    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+    QStatus status = ER_BUS_NO_ROUTE;
+    RemoteEndpoint ep;
     /*
-     * We got the candidates so now try them all.
+     * As for PushMessage() try each route in turn. If a route fails part way through, the
+     * messages it did not take are sent over the next route.
      */
-    for (vector<RemoteEndpoint>::iterator iter = tryEndpoints.begin(); iter != tryEndpoints.end(); ++iter) {
-        if (status != ER_OK) {
-            status = (*iter)->PushMessage(msg);
+    size_t sent = 0;
+    for (size_t n = 0; (sent < msgs.size()) && GetRoute(id, n, ep); ++n) {
+        size_t numPushed;
+        if (sent == 0) {
+            status = ep->PushMessages(msgs, numPushed);
+        } else {
+            vector<Message> rest(msgs.begin() + sent, msgs.end());
+            status = ep->PushMessages(rest, numPushed);
         }
+        sent += numPushed;
     }
     return status;
 }
 
+bool _VirtualEndpoint::GetRoute(SessionId id, size_t n, RemoteEndpoint& ep) const
+{
+    m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
+    multimap<SessionId, RemoteEndpoint>::const_iterator it = m_b2bEndpoints.lower_bound(id);
+    while ((it != m_b2bEndpoints.end()) && (it->first == id) && (n > 0)) {
+        ++it;
+        --n;
+    }
+    bool found = (it != m_b2bEndpoints.end()) && (it->first == id);
+    if (found) {
+        ep = it->second;
+    }
+    m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
+    return found;
+}
+
 RemoteEndpoint _VirtualEndpoint::GetBusToBusEndpoint(SessionId sessionId, int* b2bCount) const
 {
     RemoteEndpoint ret;
@@ -159,6 +190,7 @@ bool _VirtualEndpoint::RemoveBusToBusEndpoint(RemoteEndpoint& endpoint)
             ++it;
         }
     }
+    m_routeSessions.erase(endpoint);
 
     /*
      * This Virtual endpoint reports itself as empty (of b2b endpoints) when any of the following are true:
@@ -223,6 +255,7 @@ QStatus _VirtualEndpoint::AddSessionRef(SessionId id, RemoteEndpoint& b2bEp)
         b2bEp->IncrementRef();
         /* Map sessionId to b2bEp */
         m_b2bEndpoints.insert(pair<SessionId, RemoteEndpoint>(id, b2bEp));
+        ++m_routeSessions[b2bEp];
         m_hasRefs = true;
     }
     m_b2bEndpointsLock.Unlock(MUTEX_CONTEXT);
@@ -234,17 +267,15 @@ QStatus _VirtualEndpoint::AddSessionRef(SessionId id, SessionOpts* opts, RemoteE
     QCC_DbgTrace(("_VirtualEndpoint::AddSessionRef(this=%s [%x], %u, <opts>, %s)", GetUniqueName().c_str(), this, id, b2bEp->GetUniqueName().c_str()));
 
     RemoteEndpoint bestEp;
-    //uint32_t hops = 1000;
 
     m_b2bEndpointsLock.Lock(MUTEX_CONTEXT);
 
-    /* TODO: Placeholder until we exchange session opts and hop count via ExchangeNames */
+    /* TODO: Session opts and hop count are not exchanged via ExchangeNames so routes are chosen by load alone */
     multimap<SessionId, RemoteEndpoint>::const_iterator it = m_b2bEndpoints.find(id);
-    if (it == m_b2bEndpoints.end()) {
-        it = m_b2bEndpoints.begin();
-    }
-    if ((it != m_b2bEndpoints.end()) && ((it->first == 0) || it->first == id)) {
+    if (it != m_b2bEndpoints.end()) {
         bestEp = it->second;
+    } else {
+        bestEp = GetLeastLoadedRoute();
     }
 
     /* Map session id to bestEp */
@@ -256,6 +287,68 @@ QStatus _VirtualEndpoint::AddSessionRef(SessionId id, SessionOpts* opts, RemoteE
     return bestEp->IsValid() ? ER_OK : ER_BUS_NO_ENDPOINT;
 }
 
+RemoteEndpoint _VirtualEndpoint::GetLeastLoadedRoute() const
+{
+    /*
+     * The transmit queue is usually empty when a session is set up so the number of sessions
+     * already using a route is counted as load too.
+     */
+    struct RouteLoad {
+        RemoteEndpoint ep;
+        uint64_t load;
+        uint32_t rtt;
+    };
+    vector<RouteLoad> routes;
+    uint64_t rttSum = 0;
+    uint64_t numMeasured = 0;
+    multimap<SessionId, RemoteEndpoint>::const_iterator it = m_b2bEndpoints.begin();
+    while ((it != m_b2bEndpoints.end()) && (it->first == 0)) {
+        RouteLoad route;
+        route.ep = it->second;
+        _RemoteEndpoint::TxQueueStats stats;
+        route.ep->GetTxQueueStats(stats);
+        map<RemoteEndpoint, uint32_t>::const_iterator sit = m_routeSessions.find(route.ep);
+        route.load = stats.depth + ((sit != m_routeSessions.end()) ? sit->second : 0) + 1;
+        route.rtt = stats.rtt;
+        if (stats.rtt) {
+            rttSum += stats.rtt;
+            ++numMeasured;
+        }
+        routes.push_back(route);
+        ++it;
+    }
+
+    /*
+     * The load is scaled by the round trip time of the route relative to the mean of the routes
+     * that have one, so that faster links get more of the sessions, but by no less than half and
+     * no more than twice. Only idle links are probed so a busy link may have no round trip time;
+     * it is taken to be average rather than fast.
+     */
+    uint64_t meanRtt = numMeasured ? (rttSum / numMeasured) : 0;
+    RemoteEndpoint bestEp;
+    uint64_t bestCost = 0;
+    for (vector<RouteLoad>::const_iterator rit = routes.begin(); rit != routes.end(); ++rit) {
+        uint64_t eighths = 8;
+        if (meanRtt && rit->rtt) {
+            eighths = (std::min)((std::max)((8 * static_cast<uint64_t>(rit->rtt)) / meanRtt, static_cast<uint64_t>(4)), static_cast<uint64_t>(16));
+        }
+        uint64_t cost = rit->load * eighths;
+        if (!bestEp->IsValid() || (cost < bestCost)) {
+            bestEp = rit->ep;
+            bestCost = cost;
+        }
+    }
+    return bestEp;
+}
+
+void _VirtualEndpoint::RemoveRouteSession(const RemoteEndpoint& b2bEp)
+{
+    map<RemoteEndpoint, uint32_t>::iterator it = m_routeSessions.find(b2bEp);
+    if ((it != m_routeSessions.end()) && (--it->second == 0)) {
+        m_routeSessions.erase(it);
+    }
+}
+
 void _VirtualEndpoint::RemoveSessionRef(SessionId id)
 {
     QCC_DbgTrace(("_VirtualEndpoint::RemoveSessionRef(this=%s [%x], id=%u)", GetUniqueName().c_str(), this, id));
@@ -264,6 +357,7 @@ void _VirtualEndpoint::RemoveSessionRef(SessionId id)
     multimap<SessionId, RemoteEndpoint>::iterator it = m_b2bEndpoints.find(id);
     if (it != m_b2bEndpoints.end()) {
         it->second->DecrementRef();
+        RemoveRouteSession(it->second);
         m_b2bEndpoints.erase(it);
     } else {
         QCC_DbgPrintf(("_VirtualEndpoint::RemoveSessionRef: vep=%s failed to find session = %u", m_uniqueName.c_str(), id));
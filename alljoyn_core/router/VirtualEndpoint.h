@@ -23,6 +23,10 @@
 #define _ALLJOYN_VIRTUALENDPOINT_H
 
 #include <qcc/platform.h>
+
+#include <map>
+#include <vector>
+
 #include <qcc/ManagedObj.h>
 #include <qcc/String.h>
 
@@ -85,6 +89,18 @@ class _VirtualEndpoint : public _BusEndpoint {
      */
     QStatus PushMessage(Message& msg, SessionId id);
 
+    /**
+     * Send a sequence of outgoing messages over a specific session. The messages are queued,
+     * in order, on a single bus-to-bus endpoint where possible.
+     *
+     * @param msgs  Messages to be sent.
+     * @param id    SessionId to use for the outgoing messages.
+     * @return
+     *      - ER_OK if successful.
+     *      - An error status otherwise
+     */
+    QStatus PushMessages(std::vector<Message>& msgs, SessionId id);
+
     /**
      * Get unique bus name.
      *
@@ -230,8 +246,37 @@ class _VirtualEndpoint : public _BusEndpoint {
     bool IsStopping(void) { return m_epState == EP_STOPPING; }
   private:
 
+    /**
+     * Get one of the routes for a session.
+     *
+     * @param id         The session id.
+     * @param n          Index of the route, starting from 0 for the route normally used.
+     * @param[out] ep    Returns the bus-to-bus endpoint of the route.
+     * @return  true if the session has at least n + 1 routes.
+     */
+    bool GetRoute(SessionId id, size_t n, RemoteEndpoint& ep) const;
+
+    /**
+     * Get the bus-to-bus endpoint with the lowest load to use for a new session. The load
+     * of a route is the depth of its transmit queue plus the number of sessions using it,
+     * scaled by between half and twice according to how its round trip time compares with
+     * the mean of the routes. Routes without a round trip time count as average. Must be
+     * called with m_b2bEndpointsLock held.
+     *
+     * @return  The least loaded bus-to-bus endpoint or an invalid endpoint if there are none.
+     */
+    RemoteEndpoint GetLeastLoadedRoute() const;
+
+    /**
+     * Take a session off the session count of a route. Must be called with m_b2bEndpointsLock held.
+     *
+     * @param b2bEp    The bus-to-bus endpoint of the route.
+     */
+    void RemoveRouteSession(const RemoteEndpoint& b2bEp);
+
     const qcc::String m_uniqueName;                             /**< The unique name for this endpoint */
     std::multimap<SessionId, RemoteEndpoint> m_b2bEndpoints;    /**< Set of b2bs that can route for this virtual ep */
+    std::map<RemoteEndpoint, uint32_t> m_routeSessions;         /**< Number of sessions mapped to each b2b */
 
     /** B2BInfo is a data container that holds B2B endpoint selection criteria */
     struct B2BInfo {
@@ -0,0 +1,432 @@
+/**
+ * @file
+ * Connection storm benchmark for the TCP transport accept and authentication path.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+#include <qcc/Debug.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <map>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Event.h>
+#include <qcc/IPAddress.h>
+#include <qcc/Socket.h>
+#include <qcc/SocketStream.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+#include <qcc/time.h>
+
+#include <alljoyn/BusAttachment.h>
+
+#include <alljoyn/Status.h>
+
+#include "RemoteEndpoint.h"
+#include "TCPTransport.h"
+#include "DaemonTransport.h"
+
+#include "Bus.h"
+#include "BusController.h"
+#include "DaemonConfig.h"
+#include "Transport.h"
+#include "TransportList.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+using namespace qcc;
+using namespace std;
+using namespace ajn;
+
+/** How long the clients keep trying to reach the daemon before giving up */
+static const uint32_t CONNECT_TIMEOUT = 10000;
+
+/**
+ * Samples the thread count, resident set size and open sockets of this process from
+ * /proc so the daemon's cost of absorbing the storm can be reported.
+ */
+class ProcessMonitor : public Thread {
+  public:
+
+    ProcessMonitor() : Thread("ProcessMonitor"), peakThreads(0), peakRss(0), peakSockets(0) { }
+
+    static uint32_t CountSockets()
+    {
+        uint32_t sockets = 0;
+        DIR* dir = opendir("/proc/self/fd");
+        if (!dir) {
+            return 0;
+        }
+        while (struct dirent* entry = readdir(dir)) {
+            char path[64];
+            char target[64];
+            snprintf(path, sizeof(path), "/proc/self/fd/%s", entry->d_name);
+            ssize_t len = readlink(path, target, sizeof(target) - 1);
+            if ((len > 0) && (strncmp(target, "socket:", 7) == 0)) {
+                ++sockets;
+            }
+        }
+        closedir(dir);
+        return sockets;
+    }
+
+    static void Sample(uint32_t& threads, uint32_t& rssKb, uint32_t& hwmKb)
+    {
+        threads = rssKb = hwmKb = 0;
+        FILE* fp = fopen("/proc/self/status", "r");
+        if (!fp) {
+            return;
+        }
+        char line[128];
+        while (fgets(line, sizeof(line), fp)) {
+            if (strncmp(line, "Threads:", 8) == 0) {
+                threads = StringToU32(Trim(line + 8), 10, 0);
+            } else if (strncmp(line, "VmRSS:", 6) == 0) {
+                rssKb = StringToU32(Trim(qcc::String(line + 6, strcspn(line + 6, "k"))), 10, 0);
+            } else if (strncmp(line, "VmHWM:", 6) == 0) {
+                hwmKb = StringToU32(Trim(qcc::String(line + 6, strcspn(line + 6, "k"))), 10, 0);
+            }
+        }
+        fclose(fp);
+    }
+
+    qcc::ThreadReturn STDCALL Run(void* arg)
+    {
+        while (!IsStopping()) {
+            uint32_t threads, rssKb, hwmKb;
+            Sample(threads, rssKb, hwmKb);
+            peakThreads = max(peakThreads, threads);
+            peakRss = max(peakRss, max(rssKb, hwmKb));
+            peakSockets = max(peakSockets, CountSockets());
+            qcc::Sleep(10);
+        }
+        return 0;
+    }
+
+    uint32_t peakThreads;
+    uint32_t peakRss;
+    uint32_t peakSockets;
+};
+
+/**
+ * One loopback client. It connects, sends the initial NUL byte and runs the same SASL and
+ * BusHello exchange a remote daemon runs in TCPTransport::Connect().
+ */
+class StormClient : public Thread {
+  public:
+
+    StormClient(BusAttachment& bus, Event& go, const IPAddress& addr, uint16_t port) :
+        Thread("StormClient"), bus(bus), go(go), addr(addr), port(port), stream(NULL),
+        status(ER_FAIL), start(0), elapsed(0) { }
+
+    ~StormClient()
+    {
+        Stop();
+        Join();
+        ep = RemoteEndpoint();
+        delete stream;
+    }
+
+    qcc::ThreadReturn STDCALL Run(void* arg)
+    {
+        Event::Wait(go);
+        start = GetTimestamp64();
+
+        SocketFd sockFd;
+        status = Socket(QCC_AF_INET, QCC_SOCK_STREAM, sockFd);
+        if (status != ER_OK) {
+            return 0;
+        }
+        status = Connect(sockFd, addr, port);
+        if (status != ER_OK) {
+            qcc::Close(sockFd);
+            return 0;
+        }
+        uint8_t nul = 0;
+        size_t sent;
+        status = Send(sockFd, &nul, 1, sent);
+        if (status != ER_OK) {
+            qcc::Close(sockFd);
+            return 0;
+        }
+
+        static const bool falsiness = false;
+        stream = new SocketStream(sockFd);
+        ep = RemoteEndpoint(bus, falsiness, "tcp:", stream, "tcpstorm");
+        ep->GetFeatures().isBusToBus = true;
+        ep->GetFeatures().allowRemote = true;
+        ep->GetFeatures().handlePassing = false;
+
+        qcc::String authName;
+        qcc::String redirection;
+        status = ep->Establish("ANONYMOUS", authName, redirection);
+        elapsed = GetTimestamp64() - start;
+        return 0;
+    }
+
+    BusAttachment& bus;
+    Event& go;
+    IPAddress addr;
+    uint16_t port;
+    SocketStream* stream;
+    RemoteEndpoint ep;
+    QStatus status;
+    uint64_t start;
+    uint64_t elapsed;
+};
+
+static void usage(void)
+{
+    printf("Usage: tcpstorm [-h] [-n <clients>] [-p <port>] [-i <max incomplete>] [-c <max completed>] [-a <auth timeout>] [-w <auth workers>]\n\n");
+    printf("Options:\n");
+    printf("   -h                    = Print this help message\n");
+    printf("   -n <clients>          = Number of concurrent loopback clients (default 100)\n");
+    printf("   -p <port>             = TCP port the daemon listens on (default 9956)\n");
+    printf("   -i <max incomplete>   = limit@max_incomplete_connections (default 16)\n");
+    printf("   -c <max completed>    = limit@max_completed_connections (default 1024)\n");
+    printf("   -a <auth timeout>     = limit@auth_timeout in ms (default 20000)\n");
+    printf("   -w <auth workers>     = limit@auth_workers, 0 for a thread per connection (default 0)\n");
+}
+
+static uint64_t Percentile(const vector<uint64_t>& sorted, uint32_t pct)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t i = (sorted.size() * pct + 99) / 100;
+    return sorted[(i > 0) ? i - 1 : 0];
+}
+
+/*
+ * Run the clients. Returns the number of clients that completed the BusHello exchange.
+ */
+static int RunClients(uint32_t numClients, uint16_t port)
+{
+    IPAddress addr("127.0.0.1");
+    BusAttachment bus("tcpstorm", false);
+
+    /* The client endpoints need a started bus to build their messages */
+    QStatus status = bus.Start();
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Failed to start the client bus"));
+        return 0;
+    }
+
+    /* Wait for the daemon to start listening before starting the storm */
+    uint64_t deadline = GetTimestamp64() + CONNECT_TIMEOUT;
+    status = ER_FAIL;
+    while (status != ER_OK && GetTimestamp64() < deadline) {
+        SocketFd sockFd;
+        status = Socket(QCC_AF_INET, QCC_SOCK_STREAM, sockFd);
+        if (status == ER_OK) {
+            status = Connect(sockFd, addr, port);
+            qcc::Close(sockFd);
+        }
+        if (status != ER_OK) {
+            qcc::Sleep(50);
+        }
+    }
+    if (status != ER_OK) {
+        QCC_LogError(status, ("Daemon is not listening on port %u", port));
+        return 0;
+    }
+    /* Let the daemon notice the probe connection going away */
+    qcc::Sleep(100);
+
+    Event go;
+    vector<StormClient*> clients;
+    for (uint32_t i = 0; i < numClients; ++i) {
+        StormClient* client = new StormClient(bus, go, addr, port);
+        status = client->Start();
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to start client %u", i));
+            delete client;
+            break;
+        }
+        clients.push_back(client);
+    }
+
+    uint64_t start = GetTimestamp64();
+    go.SetEvent();
+    for (size_t i = 0; i < clients.size(); ++i) {
+        clients[i]->Join();
+    }
+    uint64_t elapsed = GetTimestamp64() - start;
+
+    vector<uint64_t> times;
+    map<QStatus, uint32_t> failures;
+    for (size_t i = 0; i < clients.size(); ++i) {
+        if (clients[i]->status == ER_OK) {
+            times.push_back(clients[i]->elapsed);
+        } else {
+            failures[clients[i]->status]++;
+        }
+    }
+    sort(times.begin(), times.end());
+
+    printf("clients:          %u\n", (unsigned int)clients.size());
+    printf("completed:        %u\n", (unsigned int)times.size());
+    for (map<QStatus, uint32_t>::iterator it = failures.begin(); it != failures.end(); ++it) {
+        printf("failed:           %u (%s)\n", it->second, QCC_StatusText(it->first));
+    }
+    printf("time-to-Hello:    p50 %u ms, p99 %u ms, max %u ms\n",
+           (unsigned int)Percentile(times, 50), (unsigned int)Percentile(times, 99),
+           (unsigned int)(times.empty() ? 0 : times.back()));
+    printf("accepts/s:        %.1f\n", (1000.0 * times.size()) / max(elapsed, (uint64_t)1));
+    fflush(stdout);
+
+    /* Hold every connection until all clients are done so the daemon sees the full load */
+    for (size_t i = 0; i < clients.size(); ++i) {
+        delete clients[i];
+    }
+    return (int)times.size();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numClients = 100;
+    uint16_t port = 9956;
+    uint32_t maxIncomplete = 16;
+    uint32_t maxCompleted = 1024;
+    uint32_t authTimeout = 20000;
+    uint32_t authWorkers = 0;
+
+    /* Parse command line args */
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp("-h", argv[i])) {
+            usage();
+            exit(0);
+        } else if ((i + 1) == argc) {
+            printf("option %s requires a parameter\n", argv[i]);
+            usage();
+            exit(1);
+        } else if (0 == strcmp("-n", argv[i])) {
+            numClients = StringToU32(argv[++i], 0, numClients);
+        } else if (0 == strcmp("-p", argv[i])) {
+            port = (uint16_t)StringToU32(argv[++i], 0, port);
+        } else if (0 == strcmp("-i", argv[i])) {
+            maxIncomplete = StringToU32(argv[++i], 0, maxIncomplete);
+        } else if (0 == strcmp("-c", argv[i])) {
+            maxCompleted = StringToU32(argv[++i], 0, maxCompleted);
+        } else if (0 == strcmp("-a", argv[i])) {
+            authTimeout = StringToU32(argv[++i], 0, authTimeout);
+        } else if (0 == strcmp("-w", argv[i])) {
+            authWorkers = StringToU32(argv[++i], 0, authWorkers);
+        } else {
+            printf("Unknown option %s\n", argv[i]);
+            usage();
+            exit(1);
+        }
+    }
+
+    printf("tcpstorm: %u clients, max_incomplete_connections=%u, max_completed_connections=%u, auth_timeout=%u, auth_workers=%u\n",
+           numClients, maxIncomplete, maxCompleted, authTimeout, authWorkers);
+    fflush(stdout);
+
+    /*
+     * The clients run in a child process so that the thread count and memory reported for the
+     * daemon are not inflated by the client threads. Fork before any threads are started.
+     */
+    pid_t child = fork();
+    if (child < 0) {
+        printf("fork failed\n");
+        return 1;
+    }
+    if (child == 0) {
+        int completed = RunClients(numClients, port);
+        _exit((completed == (int)numClients) ? 0 : 1);
+    }
+
+    /*
+     * The TCP transport only listens without advertisements if it may take untrusted clients.
+     * The storm clients connect as remote daemons, so they are not untrusted.
+     */
+    qcc::String config =
+        "<busconfig>"
+        "  <type>alljoyn</type>"
+        "  <limit auth_timeout=\"" + U32ToString(authTimeout) + "\"/>"
+        "  <limit max_incomplete_connections=\"" + U32ToString(maxIncomplete) + "\"/>"
+        "  <limit max_completed_connections=\"" + U32ToString(maxCompleted) + "\"/>"
+        "  <limit auth_workers=\"" + U32ToString(authWorkers) + "\"/>"
+        "  <limit max_untrusted_clients=\"1\"/>"
+        "  <property restrict_untrusted_clients=\"true\"/>"
+        "</busconfig>";
+    DaemonConfig::Load(config.c_str());
+
+    qcc::String serverArgs = "unix:abstract=tcpstorm;tcp:addr=127.0.0.1,port=" + U32ToString(port);
+
+    TransportFactoryContainer cntr;
+    cntr.Add(new TransportFactory<DaemonTransport>(DaemonTransport::TransportName, true));
+    cntr.Add(new TransportFactory<TCPTransport>(TCPTransport::TransportName, false));
+
+    Bus bus("tcpstorm", cntr, serverArgs.c_str());
+    BusController controller(bus);
+
+    ProcessMonitor monitor;
+    uint32_t baseThreads, baseRss, baseHwm, baseSockets;
+
+    QStatus status = controller.Init(serverArgs);
+    if (status == ER_OK) {
+        ProcessMonitor::Sample(baseThreads, baseRss, baseHwm);
+        baseSockets = ProcessMonitor::CountSockets();
+        monitor.Start();
+    } else {
+        QCC_LogError(status, ("BusController initialization failed"));
+        kill(child, SIGKILL);
+    }
+
+    int childStatus = 0;
+    waitpid(child, &childStatus, 0);
+
+    if (status == ER_OK) {
+        monitor.Stop();
+        monitor.Join();
+        printf("daemon threads:   %u idle, %u peak\n", baseThreads, monitor.peakThreads);
+        printf("daemon RSS:       %u kB idle, %u kB peak\n", baseRss, monitor.peakRss);
+        /*
+         * Each connection the daemon holds open is one socket, so the sockets above the idle
+         * count are the connections that were pending or up at the peak.
+         */
+        uint32_t pending = (monitor.peakSockets > baseSockets) ? monitor.peakSockets - baseSockets : 0;
+        if (pending > 0) {
+            uint32_t growth = (monitor.peakRss > baseRss) ? monitor.peakRss - baseRss : 0;
+            printf("RSS/connection:   %.1f kB (%u connections at peak)\n", (double)growth / pending, pending);
+        }
+        fflush(stdout);
+        bus.StopListen(serverArgs.c_str());
+        controller.Stop();
+        controller.Join();
+    }
+
+    DaemonConfig::Release();
+
+    if (!WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0) {
+        return 1;
+    }
+    return (int) status;
+}
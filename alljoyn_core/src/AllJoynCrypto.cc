@@ -82,12 +82,15 @@ static qcc::String ConcatenateCompressedFields(uint8_t* hdr, size_t hdrLen, cons
     return result;
 }
 
-QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
+QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, const MessageCipher& cipher, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
 {
     QStatus status;
     switch (keyBlob.GetType()) {
     case KeyBlob::AES:
-        {
+        if (!cipher->GetAES()) {
+            status = ER_CRYPTO_ERROR;
+            QCC_LogError(status, ("No cipher for message encryption"));
+        } else {
             uint8_t* body = msgBuf + hdrLen;
             uint8_t nd[5];
             uint32_t serial = message.GetCallSerial();
@@ -102,7 +105,7 @@ QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
             QCC_DbgHLPrintf(("Encrypt key:   %s", BytesToHexString(keyBlob.GetData(), keyBlob.GetSize()).c_str()));
             QCC_DbgHLPrintf(("        nonce: %s", BytesToHexString(nonce.GetData(), nonce.GetSize()).c_str()));
 
-            Crypto_AES aes(keyBlob, Crypto_AES::CCM);
+            Crypto_AES& aes = *cipher->GetAES();
             if (message.GetFlags() & ALLJOYN_FLAG_COMPRESSED) {
                 /*
                  * To prevent an attack where the attacker sends a bogus expansion rule we
@@ -124,12 +127,15 @@ QStatus Crypto::Encrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
     return status;
 }
 
-QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
+QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, const MessageCipher& cipher, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen)
 {
     QStatus status;
     switch (keyBlob.GetType()) {
     case KeyBlob::AES:
-        {
+        if (!cipher->GetAES()) {
+            status = ER_CRYPTO_ERROR;
+            QCC_LogError(status, ("No cipher for message decryption"));
+        } else {
             uint8_t* body = msgBuf + hdrLen;
             uint8_t nd[5];
             uint32_t serial = message.GetCallSerial();
@@ -144,7 +150,7 @@ QStatus Crypto::Decrypt(const _Message& message, const KeyBlob& keyBlob, uint8_t
             QCC_DbgHLPrintf(("Decrypt key:   %s", BytesToHexString(keyBlob.GetData(), keyBlob.GetSize()).c_str()));
             QCC_DbgHLPrintf(("        nonce: %s", BytesToHexString(nonce.GetData(), nonce.GetSize()).c_str()));
 
-            Crypto_AES aes(keyBlob, Crypto_AES::CCM);
+            Crypto_AES& aes = *cipher->GetAES();
             if (message.GetFlags() & ALLJOYN_FLAG_COMPRESSED) {
                 /*
                  * To prevent an attack where the attacker sends a bogus expansion rule we
@@ -26,7 +26,9 @@
 #endif
 
 #include <qcc/platform.h>
+#include <qcc/Crypto.h>
 #include <qcc/KeyBlob.h>
+#include <qcc/ManagedObj.h>
 
 #include <alljoyn/Message.h>
 
@@ -35,6 +37,63 @@
 
 namespace ajn {
 
+/**
+ * The cipher for a message encryption key. Message encryption keys are long lived so the AES key
+ * schedule is expanded once when the key is set and then reused for every message.
+ */
+class _MessageCipher {
+  public:
+
+    /**
+     * Default constructor for a cipher with no key.
+     */
+    _MessageCipher() : aes(NULL) { }
+
+    /**
+     * Constructor
+     *
+     * @param key   The message encryption key.
+     */
+    _MessageCipher(const qcc::KeyBlob& key) : aes(NULL)
+    {
+        if (key.GetType() == qcc::KeyBlob::AES) {
+            aes = new qcc::Crypto_AES(key, qcc::Crypto_AES::CCM);
+        }
+    }
+
+    /**
+     * Destructor
+     */
+    ~_MessageCipher() { delete aes; }
+
+    /**
+     * Get the AES-CCM cipher.
+     *
+     * @return  The AES-CCM cipher or NULL if there is no AES key.
+     */
+    qcc::Crypto_AES* GetAES() const { return aes; }
+
+  private:
+
+    /**
+     * Copy constructor is private
+     */
+    _MessageCipher(const _MessageCipher& other);
+
+    /**
+     * Assigment operator is private
+     */
+    _MessageCipher& operator=(const _MessageCipher& other);
+
+    qcc::Crypto_AES* aes;   /**< AES-CCM cipher with the expanded key schedule */
+};
+
+/**
+ * MessageCipher is a reference counted (managed) _MessageCipher so a cipher that is in use can
+ * outlive a rekey.
+ */
+typedef qcc::ManagedObj<_MessageCipher> MessageCipher;
+
 /**
  * Class for encapsulating AllJoyn message encryption and decryption operations.
  */
@@ -48,6 +107,7 @@ class Crypto {
      *
      * @param message         The message being encrypted
      * @param keyBlob         The key blob containing the key for the encryption operation.
+     * @param cipher          The cipher for keyBlob.
      * @param msgBuf          The message data to be encrypted. The data buffer must be large enough to handle
      *                        the expansion specified in the ExpansionBytes member variable.
      * @param hdrLen          The length of the header part of the message that will not be encrypted.
@@ -58,7 +118,7 @@ class Crypto {
      *         - ER_BUS_KEYBLOB_OP_INVALID if the key blob cannot be used for encryption.
      *         - Other errors if the arguments are invalid.
      */
-    static QStatus Encrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
+    static QStatus Encrypt(const _Message& message, const qcc::KeyBlob& keyBlob, const MessageCipher& cipher, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
 
     /**
      * Decrypt and authenticate marshaled message inplace using the key blob provided and the
@@ -66,6 +126,7 @@ class Crypto {
      *
      * @param message         The message being decrypted
      * @param keyBlob         The key blob containing the key for the decryption operation.
+     * @param cipher          The cipher for keyBlob.
      * @param msgBuf          The message data to be decrypted.
      * @param hdrLen          The length of the non-encrypted header part of the message.
      * @param bodyLen[in/out] On input the size of the crypttext body, on output the size of the
@@ -75,7 +136,7 @@ class Crypto {
      *         - ER_BUS_KEYBLOB_OP_INVALID if the key blob cannot be used for decryption.
      *         - Other errors if the arguments are invalid.
      */
-    static QStatus Decrypt(const _Message& message, const qcc::KeyBlob& keyBlob, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
+    static QStatus Decrypt(const _Message& message, const qcc::KeyBlob& keyBlob, const MessageCipher& cipher, uint8_t* msgBuf, size_t hdrLen, size_t& bodyLen);
 
     /**
      * Compute a SHA1 hash over the header fields and return the result in a key blob.
@@ -104,12 +104,17 @@ BusAttachment::Internal::Internal(const char* appName,
                                   Router* router,
                                   bool allowRemoteMessages,
                                   const char* listenAddresses,
-                                  uint32_t concurrency) :
+                                  uint32_t concurrency,
+                                  uint32_t ioDispatchLoops) :
     application(appName ? appName : "unknown"),
     bus(bus),
     listenersLock(),
     listeners(),
-    m_ioDispatch("iodisp", 96),
+    m_ioDispatch("iodisp", 96, ioDispatchLoops),
+    txBatchLimit(16 * 1024),
+    txQueueMaxMessages(30),
+    txQueueMaxBytes(4 * 1024 * 1024),
+    txQueueNonBlocking(false),
     transportList(bus, factories, &m_ioDispatch, concurrency),
     keyStore(application),
     authManager(keyStore),
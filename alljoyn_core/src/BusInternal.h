@@ -130,6 +130,62 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
      * @return  The iodispatch
      */
     qcc::IODispatch& GetIODispatch(void) { return m_ioDispatch; }
+
+    /**
+     * Get the maximum number of bytes of queued messages that a remote endpoint of this bus
+     * coalesces into a single vectored write.
+     *
+     * @return  The byte budget or 0 if queued messages are written one at a time.
+     */
+    size_t GetTxBatchLimit(void) const { return txBatchLimit; }
+
+    /**
+     * Set the maximum number of bytes of queued messages that a remote endpoint of this bus
+     * coalesces into a single vectored write.
+     *
+     * @param limit  The byte budget or 0 to write queued messages one at a time.
+     */
+    void SetTxBatchLimit(size_t limit) { txBatchLimit = limit; }
+
+    /**
+     * Get the maximum number of messages that can be queued for transmission on a remote endpoint.
+     *
+     * @return  The maximum number of queued messages.
+     */
+    size_t GetTxQueueMaxMessages(void) const { return txQueueMaxMessages; }
+
+    /**
+     * Get the maximum number of bytes that can be queued for transmission on a remote endpoint.
+     * A message is always accepted by an empty queue even if it is larger than this.
+     *
+     * @return  The maximum number of queued bytes.
+     */
+    size_t GetTxQueueMaxBytes(void) const { return txQueueMaxBytes; }
+
+    /**
+     * Check if pushing a broadcast, sessionless or TTL signal to the full transmit queue of a
+     * remote endpoint fails with ER_BUS_WRITE_QUEUE_FULL rather than waiting for the queue to
+     * drain. Other messages always wait.
+     *
+     * @return  true if pushes to a full transmit queue do not block.
+     */
+    bool IsTxQueueNonBlocking(void) const { return txQueueNonBlocking; }
+
+    /**
+     * Set the transmit queue limits for the remote endpoints of this bus.
+     *
+     * @param maxMessages  Maximum number of queued messages.
+     * @param maxBytes     Maximum number of queued bytes.
+     * @param nonBlocking  If true pushes of droppable signals to a full queue fail rather than wait
+     *                     for the queue to drain.
+     */
+    void SetTxQueueLimits(size_t maxMessages, size_t maxBytes, bool nonBlocking)
+    {
+        txQueueMaxMessages = maxMessages;
+        txQueueMaxBytes = maxBytes;
+        txQueueNonBlocking = nonBlocking;
+    }
+
     /**
      * Get the header compression rules
      *
@@ -144,6 +200,8 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
 
     /**
      * Constructor called by BusAttachment.
+     *
+     * @param ioDispatchLoops  Number of IODispatch event loops that remote endpoints are sharded across.
      */
     Internal(const char* appName,
              BusAttachment& bus,
@@ -151,7 +209,8 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
              Router* router,
              bool allowRemoteMessages,
              const char* listenAddresses,
-             uint32_t concurrency);
+             uint32_t concurrency,
+             uint32_t ioDispatchLoops = 1);
 
     /*
      * Destructor also called by BusAttachment
@@ -277,6 +336,10 @@ class BusAttachment::Internal : public MessageReceiver, public JoinSessionAsyncC
     typedef std::set<ProtectedBusListener> ListenerSet;
     ListenerSet listeners;               /* List of registered BusListeners */
     qcc::IODispatch m_ioDispatch;         /* iodispatch for this bus */
+    size_t txBatchLimit;                  /* Byte budget for vectored writes of queued messages by remote endpoints */
+    size_t txQueueMaxMessages;            /* Maximum number of messages queued for transmission on a remote endpoint */
+    size_t txQueueMaxBytes;               /* Maximum number of bytes queued for transmission on a remote endpoint */
+    bool txQueueNonBlocking;              /* true iff pushing to a full remote endpoint transmit queue fails instead of waiting */
     TransportList transportList;          /* List of active transports */
     KeyStore keyStore;                    /* The key store for the bus attachment */
     AuthManager authManager;              /* The authentication manager for the bus attachment */
@@ -160,7 +160,31 @@ QStatus EndpointAuth::WaitHello(qcc::String& authUsed)
     if (status != ER_OK) {
         return status;
     }
-    status = hello->Unmarshal(endpoint, false);
+    status = HandleHello(hello, authUsed, redirection);
+    if ((ER_OK == status) && !redirection.empty()) {
+        /*
+         * We expect the other end to shutdown the endpoint socket as soon as it receives the
+         * redirection error response. The only way we can tell if the socket is closed is by
+         * attempting to read or write to it. We do a read with a timeout. If we actually read data
+         * or the timeout expires it means the socket wasn't closed by the other end so we assume
+         * the the redirection failed.
+         */
+        uint8_t buf[1];
+        size_t sz;
+        Source& source = endpoint->GetSource();
+        status = source.PullBytes(buf, sizeof(buf), sz, REDIRECT_TIMEOUT);
+        if (status == ER_OK || status == ER_TIMEOUT) {
+            status = ER_BUS_ESTABLISH_FAILED;
+        } else {
+            status = ER_BUS_ENDPOINT_REDIRECTED;
+        }
+    }
+    return status;
+}
+
+QStatus EndpointAuth::HandleHello(Message& hello, const qcc::String& authUsed, qcc::String& redirection)
+{
+    QStatus status = hello->Unmarshal(endpoint, false);
     if (ER_OK == status) {
         if (hello->GetType() != MESSAGE_METHOD_CALL) {
             QCC_DbgPrintf(("First message must be Hello/BusHello method call"));
@@ -266,24 +290,6 @@ QStatus EndpointAuth::WaitHello(qcc::String& authUsed)
             QCC_LogError(status, ("%s", __FUNCTION__));
         }
     }
-    if ((ER_OK == status) && !redirection.empty()) {
-        /*
-         * We expect the other end to shutdown the endpoint socket as soon as it receives the
-         * redirection error response. The only way we can tell if the socket is closed is by
-         * attempting to read or write to it. We do a read with a timeout. If we actually read data
-         * or the timeout expires it means the socket wasn't closed by the other end so we assume
-         * the the redirection failed.
-         */
-        uint8_t buf[1];
-        size_t sz;
-        Source& source = endpoint->GetSource();
-        status = source.PullBytes(buf, sizeof(buf), sz, REDIRECT_TIMEOUT);
-        if (status == ER_OK || status == ER_TIMEOUT) {
-            status = ER_BUS_ESTABLISH_FAILED;
-        } else {
-            status = ER_BUS_ENDPOINT_REDIRECTED;
-        }
-    }
     return status;
 }
 
@@ -479,4 +485,109 @@ ExitEstablish:
     return status;
 }
 
+QStatus EndpointAuth::StartAccept(const qcc::String& authMechanisms, AuthListener* listener)
+{
+    QCC_DbgPrintf(("EndpointAuth::StartAccept authMechanisms=\"%s\"", authMechanisms.c_str()));
+
+    if (!isAccepting || sasl) {
+        return ER_BUS_ESTABLISH_FAILED;
+    }
+    if (listener) {
+        authListener.Set(listener);
+    }
+    sasl = new SASLEngine(bus, AuthMechanism::CHALLENGER, authMechanisms, NULL, authListener, this);
+    /*
+     * The server's GUID is sent to the client when the authentication succeeds
+     */
+    String guidStr = bus.GetInternal().GetGlobalGUID().ToString();
+    sasl->SetLocalId(guidStr);
+    return ER_OK;
+}
+
+QStatus EndpointAuth::ContinueAccept(qcc::String& authUsed)
+{
+    QStatus status = ER_OK;
+    size_t numPushed;
+    SASLEngine::AuthState state;
+    qcc::String outStr;
+
+    if (!sasl) {
+        return ER_BUS_ESTABLISH_FAILED;
+    }
+    /*
+     * The SASL exchange is line based. A line that has only partly arrived is kept in acceptLine
+     * until the rest of it is received. Once authentication succeeds acceptAuthUsed is set and
+     * the remaining input is the hello message.
+     */
+    while (acceptAuthUsed.empty()) {
+        status = endpoint->GetSource().GetLine(acceptLine, 0);
+        if (status == ER_TIMEOUT) {
+            return ER_WOULDBLOCK;
+        }
+        if (status != ER_OK) {
+            QCC_LogError(status, ("Failed to read from stream"));
+            goto ExitAccept;
+        }
+        status = sasl->Advance(acceptLine, outStr, state);
+        acceptLine.clear();
+        if (status != ER_OK) {
+            QCC_DbgPrintf(("Server authentication failed %s", QCC_StatusText(status)));
+            goto ExitAccept;
+        }
+        if (state == SASLEngine::ALLJOYN_AUTH_SUCCESS) {
+            /*
+             * Remember the authentication mechanism that was used
+             */
+            acceptAuthUsed = sasl->GetMechanism();
+            break;
+        }
+        /*
+         * Send the response. SASL responses are short so this does not block in practice.
+         */
+        status = endpoint->GetSink().PushBytes((void*)(outStr.data()), outStr.length(), numPushed);
+        if (status == ER_OK) {
+            QCC_DbgPrintf(("Sent %s", outStr.c_str()));
+        } else {
+            QCC_LogError(status, ("Failed to write to stream"));
+            goto ExitAccept;
+        }
+    }
+    /*
+     * Read as much of the hello message as is available. The message is read straight from the
+     * source so that no bytes following it are consumed before the endpoint is started.
+     */
+    while (status == ER_OK && (acceptHello->readState != MESSAGE_COMPLETE)) {
+        status = acceptHello->PullBytes(endpoint, false, true, 0);
+    }
+    if (status == ER_TIMEOUT) {
+        return ER_WOULDBLOCK;
+    }
+    if (status == ER_OK) {
+        qcc::String redirection;
+        status = HandleHello(acceptHello, acceptAuthUsed, redirection);
+        if ((status == ER_OK) && !redirection.empty()) {
+            /*
+             * Unlike WaitHello() we do not wait to see if the other end closes the connection,
+             * a redirected endpoint is not going to be used either way.
+             */
+            status = ER_BUS_ENDPOINT_REDIRECTED;
+        }
+    } else {
+        QCC_LogError(status, ("Failed to read hello message"));
+    }
+    if (status == ER_OK) {
+        authUsed = acceptAuthUsed;
+    }
+
+ExitAccept:
+
+    authListener.Set(NULL);
+    delete sasl;
+    sasl = NULL;
+
+    QCC_DbgPrintf(("Accept complete %s", QCC_StatusText(status)));
+
+    return status;
+}
+
 }
@@ -28,6 +28,8 @@
 #include <qcc/GUID.h>
 #include <qcc/Stream.h>
 
+#include <alljoyn/Message.h>
+
 #include "BusInternal.h"
 #include "SASLEngine.h"
 
@@ -59,13 +61,15 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
         endpoint(endpoint),
         uniqueName(bus.GetInternal().GetRouter().GenerateUniqueName()),
         isAccepting(isAcceptor),
-        remoteProtocolVersion(0)
+        remoteProtocolVersion(0),
+        sasl(NULL),
+        acceptHello(bus)
     { }
 
     /**
      * Destructor
      */
-    ~EndpointAuth() { };
+    ~EndpointAuth() { delete sasl; };
 
     /**
      * Establish a connection.
@@ -83,6 +87,34 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
      */
     QStatus Establish(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection, AuthListener* listener = NULL);
 
+    /**
+     * Start establishing an accepted connection without blocking. The establishment is then
+     * driven by calling ContinueAccept() each time the endpoint's source has data available.
+     *
+     * @param authMechanisms  The authentication mechanisms to accept.
+     * @param listener        Authentication credentials listener
+     *
+     * @return
+     *      - ER_OK if successful
+     *      - ER_BUS_ESTABLISH_FAILED if this is not the accepting side of the connection.
+     */
+    QStatus StartAccept(const qcc::String& authMechanisms, AuthListener* listener = NULL);
+
+    /**
+     * Process whatever SASL or hello data the endpoint's source has available without blocking.
+     * Replies are written to the endpoint's sink as they become due.
+     *
+     * @param authUsed   Returns the name of the authentication method that was used to establish the
+     *                   connection. This value is only meaningful if the return status is ER_OK.
+     *
+     * @return
+     *      - ER_OK if the connection has been established
+     *      - ER_WOULDBLOCK if more data must be received before the establishment can complete
+     *      - ER_BUS_ENDPOINT_REDIRECTED if the endpoint was redirected
+     *      - An error status otherwise
+     */
+    QStatus ContinueAccept(qcc::String& authUsed);
+
     /**
      * Get the unique bus name assigned by the bus for this endpoint.
      *
@@ -145,10 +177,16 @@ class EndpointAuth : public SASLEngine::ExtensionHandler {
     uint32_t nameTransfer;
     ProtectedAuthListener authListener;  ///< Authentication listener
 
+    SASLEngine* sasl;                ///< SASL engine for a non-blocking accept
+    qcc::String acceptLine;          ///< Partially received SASL line of a non-blocking accept
+    qcc::String acceptAuthUsed;      ///< Authentication mechanism agreed by a non-blocking accept
+    Message acceptHello;             ///< Partially received hello message of a non-blocking accept
+
     /* Internal methods */
 
     QStatus Hello(qcc::String& redirection);
     QStatus WaitHello(qcc::String& authUsed);
+    QStatus HandleHello(Message& hello, const qcc::String& authUsed, qcc::String& redirection);
 };
 
 }
@@ -22,6 +22,7 @@
  ******************************************************************************/
 #include <qcc/platform.h>
 
+#include <deque>
 #include <list>
 
 #include <qcc/Debug.h>
@@ -55,11 +56,21 @@ namespace ajn {
 
 static const uint32_t LOCAL_ENDPOINT_CONCURRENCY = 4;
 
+/*
+ * Maximum number of messages waiting to be dispatched on each dispatcher thread before a
+ * sender is blocked.
+ */
+static const uint32_t LOCAL_ENDPOINT_MAX_PENDING = 10;
+
+/*
+ * Maximum number of strands kept on each dispatcher thread for senders that have nothing waiting
+ * to be dispatched. The least recently used strands beyond this are deleted.
+ */
+static const uint32_t LOCAL_ENDPOINT_MAX_IDLE_STRANDS = 32;
 
-class _LocalEndpoint::Dispatcher : public qcc::Timer, public qcc::AlarmListener {
+class _LocalEndpoint::DeferredCallbacks : public qcc::AlarmListener {
   public:
-    Dispatcher(_LocalEndpoint* endpoint, uint32_t concurrency = LOCAL_ENDPOINT_CONCURRENCY) : Timer("lepDisp", true, concurrency, true, 10), AlarmListener(), endpoint(endpoint) { }
-    QStatus DispatchMessage(Message& msg);
+    DeferredCallbacks(_LocalEndpoint* ep) : endpoint(ep) { }
 
     void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
 
@@ -67,16 +78,108 @@ class _LocalEndpoint::Dispatcher : public qcc::Timer, public qcc::AlarmListener
     _LocalEndpoint* endpoint;
 };
 
-class _LocalEndpoint::DeferredCallbacks : public qcc::AlarmListener {
+/*
+ * The dispatcher runs the method, signal and reply callbacks for messages received by the local
+ * endpoint. Messages are grouped into strands by sender so that messages from one sender are
+ * delivered in order. A strand with messages to deliver is queued on the thread picked by
+ * hashing the sender, and threads with nothing to do steal strands queued on busy threads.
+ *
+ * Only one callback runs at a time until a callback calls EnableReentrancy(). This also releases
+ * the callback's strand so the following messages from the same sender can be dispatched on
+ * other threads while the callback blocks.
+ *
+ * A strand that runs dry is kept for the next message from the same sender, so an active sender
+ * does not allocate a strand per burst of messages. Only the most recently drained strands of each
+ * thread are kept, so the strands of senders that have gone away are eventually deleted.
+ */
+class _LocalEndpoint::Dispatcher {
   public:
-    DeferredCallbacks(_LocalEndpoint* ep) : endpoint(ep) { }
+    Dispatcher(_LocalEndpoint* endpoint, uint32_t concurrency = LOCAL_ENDPOINT_CONCURRENCY);
 
-    void AlarmTriggered(const qcc::Alarm& alarm, QStatus reason);
+    ~Dispatcher();
+
+    QStatus Start();
+
+    QStatus Stop();
+
+    QStatus Join();
+
+    QStatus DispatchMessage(Message& msg);
+
+    QStatus DispatchCallback(DeferredCallbacks* callbacks);
+
+    void EnableReentrancy();
+
+    bool ThreadHoldsLock();
 
   private:
+
+    /* A message to push into the endpoint or deferred callbacks to run */
+    struct Work {
+        Message* msg;
+        DeferredCallbacks* callbacks;
+
+        Work(Message* msg, DeferredCallbacks* callbacks) : msg(msg), callbacks(callbacks) { }
+
+        void Trigger(QStatus reason) const {
+            uint32_t zero = 0;
+            callbacks->AlarmTriggered(qcc::Alarm(zero, callbacks), reason);
+        }
+    };
+
+    class Worker;
+
+    /* The messages from one sender. Protected by the lock of the home worker. */
+    struct Strand {
+        qcc::String sender;
+        Worker* home;
+        std::deque<Work> pending;
+        bool queued;              /* true iff the strand is on the ready queue of its home worker */
+        bool running;             /* true iff a worker is running the first message of the strand */
+        uint32_t drained;         /* Drain count of the home worker when the strand ran dry, 0 while it has work */
+
+        Strand(const char* sender, Worker* home) : sender(sender), home(home), queued(false), running(false), drained(0) { }
+    };
+
+    class Worker : public qcc::Thread {
+      public:
+        Worker(Dispatcher& dispatcher) : Thread("lepDisp"), dispatcher(dispatcher), drainCount(0), numPending(0),
+            numWaiting(0), idle(false), hasLock(false), current(NULL) { }
+
+        qcc::ThreadReturn STDCALL Run(void* arg) { return dispatcher.WorkerRun(*this); }
+
+        Dispatcher& dispatcher;
+        qcc::Mutex lock;                   /* Protects the strands homed on this worker */
+        std::deque<Strand*> ready;         /* Strands with messages to dispatch */
+        std::unordered_map<qcc::StringMapKey, Strand*> strands;  /* Strands homed on this worker by sender */
+        std::deque<std::pair<Strand*, uint32_t> > drained;      /* Strands that ran dry and their drain counts, oldest first */
+        uint32_t drainCount;               /* Number of times a strand homed on this worker ran dry */
+        uint32_t numPending;               /* Messages waiting in the strands homed on this worker */
+        uint32_t numWaiting;               /* Senders blocked until numPending drops */
+        qcc::Event notFull;                /* Set when numPending drops below the maximum */
+        qcc::Event wake;                   /* Set to wake this worker when it is idle */
+        bool idle;                         /* true iff this worker is waiting for work and has not been woken */
+        bool hasLock;                      /* true iff this worker holds the reentrancy lock */
+        Strand* current;                   /* Strand being run by this worker */
+    };
+
+    QStatus Enqueue(const char* sender, const Work& work);
+    bool Take(Worker& from, bool steal, Strand*& strand, Work& work);
+    void Release(Strand* strand);
+    void Wake(Worker* preferred);
+    void SetIdle(Worker& worker, bool idle);
+    Worker* GetCurrentWorker();
+    void Discard(const Work& work);
+    qcc::ThreadReturn WorkerRun(Worker& worker);
+
     _LocalEndpoint* endpoint;
+    std::vector<Worker*> workers;
+    qcc::Mutex reentrancyLock;          /* Held by the thread running a callback until it calls EnableReentrancy() */
+    qcc::Mutex idleLock;                /* Protects the idle flags of the workers */
+    volatile bool isRunning;
 };
 
+
 LocalTransport::~LocalTransport()
 {
     Stop();
@@ -390,22 +493,361 @@ QStatus _LocalEndpoint::PeerInterface(Message& message)
 }
 
 
-QStatus _LocalEndpoint::Dispatcher::DispatchMessage(Message& msg)
+_LocalEndpoint::Dispatcher::Dispatcher(_LocalEndpoint* endpoint, uint32_t concurrency) :
+    endpoint(endpoint),
+    workers(max(concurrency, (uint32_t)1)),
+    isRunning(false)
+{
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i] = new Worker(*this);
+    }
+}
+
+_LocalEndpoint::Dispatcher::~Dispatcher()
 {
-    uint32_t zero = 0;
-    void* context = new Message(msg);
-    qcc::AlarmListener* localEndpointListener = this;
-    Alarm alarm(zero, localEndpointListener, context, zero);
-    QStatus status = AddAlarm(alarm);
+    Stop();
+    Join();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        delete workers[i];
+    }
+}
+
+QStatus _LocalEndpoint::Dispatcher::Start()
+{
+    QStatus status = ER_OK;
+    isRunning = true;
+    for (size_t i = 0; (status == ER_OK) && (i < workers.size()); ++i) {
+        status = workers[i]->Start();
+    }
     if (status != ER_OK) {
-        Message* temp = static_cast<Message*>(context);
-        if (temp) {
-            delete temp;
+        QCC_LogError(status, ("Failed to start local endpoint dispatcher"));
+        Stop();
+    }
+    return status;
+}
+
+QStatus _LocalEndpoint::Dispatcher::Stop()
+{
+    QStatus status = ER_OK;
+    isRunning = false;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        Worker* worker = workers[i];
+        /*
+         * Taking the lock ensures any sender that saw the dispatcher running has finished
+         * queueing its message before Join() discards the queues.
+         */
+        worker->lock.Lock(MUTEX_CONTEXT);
+        worker->notFull.SetEvent();
+        worker->lock.Unlock(MUTEX_CONTEXT);
+        QStatus tStatus = worker->Stop();
+        status = (status == ER_OK) ? tStatus : status;
+    }
+    return status;
+}
+
+QStatus _LocalEndpoint::Dispatcher::Join()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        QStatus tStatus = workers[i]->Join();
+        status = (status == ER_OK) ? tStatus : status;
+    }
+    /*
+     * Expire anything that was not dispatched
+     */
+    for (size_t i = 0; i < workers.size(); ++i) {
+        Worker* worker = workers[i];
+        worker->lock.Lock(MUTEX_CONTEXT);
+        while (!worker->strands.empty()) {
+            Strand* strand = worker->strands.begin()->second;
+            worker->strands.erase(worker->strands.begin());
+            worker->lock.Unlock(MUTEX_CONTEXT);
+            while (!strand->pending.empty()) {
+                Discard(strand->pending.front());
+                strand->pending.pop_front();
+            }
+            delete strand;
+            worker->lock.Lock(MUTEX_CONTEXT);
         }
+        worker->ready.clear();
+        worker->drained.clear();
+        worker->numPending = 0;
+        worker->lock.Unlock(MUTEX_CONTEXT);
     }
     return status;
 }
 
+QStatus _LocalEndpoint::Dispatcher::DispatchMessage(Message& msg)
+{
+    return Enqueue(msg->GetSender(), Work(new Message(msg), NULL));
+}
+
+QStatus _LocalEndpoint::Dispatcher::DispatchCallback(DeferredCallbacks* callbacks)
+{
+    return Enqueue("", Work(NULL, callbacks));
+}
+
+QStatus _LocalEndpoint::Dispatcher::Enqueue(const char* sender, const Work& work)
+{
+    QStatus status = ER_OK;
+    Worker* home = workers[hash_string(sender) % workers.size()];
+    bool isWorker = (GetCurrentWorker() != NULL);
+
+    home->lock.Lock(MUTEX_CONTEXT);
+    /*
+     * Don't allow an infinite number of messages to queue up. Dispatcher threads are never
+     * blocked since they may be the ones that have to make room.
+     */
+    while (isRunning && !isWorker && (home->numPending >= LOCAL_ENDPOINT_MAX_PENDING)) {
+        home->notFull.ResetEvent();
+        ++home->numWaiting;
+        home->lock.Unlock(MUTEX_CONTEXT);
+        status = Event::Wait(home->notFull);
+        home->lock.Lock(MUTEX_CONTEXT);
+        --home->numWaiting;
+        if (status == ER_ALERTED_THREAD) {
+            Thread::GetThread()->GetStopEvent().ResetEvent();
+        } else if (status != ER_OK) {
+            break;
+        }
+        status = ER_OK;
+    }
+    if (!isRunning) {
+        status = ER_TIMER_EXITING;
+    }
+    if (status != ER_OK) {
+        home->lock.Unlock(MUTEX_CONTEXT);
+        delete work.msg;
+        return status;
+    }
+
+    Strand* strand;
+    unordered_map<StringMapKey, Strand*>::iterator it = home->strands.find(StringMapKey(sender));
+    if (it == home->strands.end()) {
+        strand = new Strand(sender, home);
+        home->strands.insert(pair<StringMapKey, Strand*>(StringMapKey(strand->sender), strand));
+    } else {
+        strand = it->second;
+    }
+    strand->drained = 0;
+    strand->pending.push_back(work);
+    ++home->numPending;
+    bool wake = !strand->running && !strand->queued;
+    if (wake) {
+        strand->queued = true;
+        home->ready.push_back(strand);
+    }
+    home->lock.Unlock(MUTEX_CONTEXT);
+
+    if (wake) {
+        Wake(home);
+    }
+    return status;
+}
+
+bool _LocalEndpoint::Dispatcher::Take(Worker& from, bool steal, Strand*& strand, Work& work)
+{
+    bool more = false;
+    strand = NULL;
+    from.lock.Lock(MUTEX_CONTEXT);
+    if (!from.ready.empty()) {
+        /* Thieves take from the back so the owner keeps working through its queue in order */
+        if (steal) {
+            strand = from.ready.back();
+            from.ready.pop_back();
+        } else {
+            strand = from.ready.front();
+            from.ready.pop_front();
+        }
+        strand->queued = false;
+        strand->running = true;
+        work = strand->pending.front();
+        strand->pending.pop_front();
+        --from.numPending;
+        if (from.numWaiting > 0) {
+            from.notFull.SetEvent();
+        }
+        more = !from.ready.empty();
+    }
+    from.lock.Unlock(MUTEX_CONTEXT);
+    if (more) {
+        Wake(NULL);
+    }
+    return strand != NULL;
+}
+
+void _LocalEndpoint::Dispatcher::Release(Strand* strand)
+{
+    Worker* home = strand->home;
+    home->lock.Lock(MUTEX_CONTEXT);
+    strand->running = false;
+    bool wake = !strand->pending.empty();
+    if (wake) {
+        strand->queued = true;
+        home->ready.push_back(strand);
+    } else {
+        /*
+         * Keep the strand for the sender's next message. A strand is only deleted when the entry
+         * for its latest drain reaches the front and it has not been given more work since.
+         */
+        if (++home->drainCount == 0) {
+            ++home->drainCount;
+        }
+        strand->drained = home->drainCount;
+        home->drained.push_back(pair<Strand*, uint32_t>(strand, strand->drained));
+        while (home->drained.size() > LOCAL_ENDPOINT_MAX_IDLE_STRANDS) {
+            Strand* oldest = home->drained.front().first;
+            if (oldest->drained == home->drained.front().second) {
+                home->strands.erase(StringMapKey(oldest->sender.c_str()));
+                delete oldest;
+            }
+            home->drained.pop_front();
+        }
+    }
+    home->lock.Unlock(MUTEX_CONTEXT);
+    if (wake) {
+        Wake(home);
+    }
+}
+
+void _LocalEndpoint::Dispatcher::Wake(Worker* preferred)
+{
+    /*
+     * Workers set their idle flag before they make a last check for work so a worker that has
+     * not seen the new work yet is either still looking or is idle and gets woken here. The
+     * flag is cleared by the waker so the next call wakes a different worker.
+     */
+    Worker* idle = NULL;
+    idleLock.Lock(MUTEX_CONTEXT);
+    if (preferred && preferred->idle) {
+        idle = preferred;
+    }
+    for (size_t i = 0; !idle && (i < workers.size()); ++i) {
+        if (workers[i]->idle) {
+            idle = workers[i];
+        }
+    }
+    if (idle) {
+        idle->idle = false;
+        idle->wake.SetEvent();
+    }
+    idleLock.Unlock(MUTEX_CONTEXT);
+}
+
+void _LocalEndpoint::Dispatcher::SetIdle(Worker& worker, bool idle)
+{
+    idleLock.Lock(MUTEX_CONTEXT);
+    if (idle) {
+        worker.wake.ResetEvent();
+    }
+    worker.idle = idle;
+    idleLock.Unlock(MUTEX_CONTEXT);
+}
+
+_LocalEndpoint::Dispatcher::Worker* _LocalEndpoint::Dispatcher::GetCurrentWorker()
+{
+    Thread* thread = Thread::GetThread();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (workers[i] == thread) {
+            return workers[i];
+        }
+    }
+    return NULL;
+}
+
+void _LocalEndpoint::Dispatcher::Discard(const Work& work)
+{
+    if (work.msg) {
+        delete work.msg;
+    } else {
+        work.Trigger(ER_TIMER_EXITING);
+    }
+}
+
+qcc::ThreadReturn _LocalEndpoint::Dispatcher::WorkerRun(Worker& worker)
+{
+    size_t self = 0;
+    while (workers[self] != &worker) {
+        ++self;
+    }
+    while (!worker.IsStopping()) {
+        Strand* strand = NULL;
+        Work work(NULL, NULL);
+        /*
+         * Look for work on our own queue and then try to steal from the others. If there is
+         * none flag ourselves idle and look once more before waiting to be woken.
+         */
+        bool idle = false;
+        for (int pass = 0; !strand && (pass < 2); ++pass) {
+            if (pass == 1) {
+                SetIdle(worker, true);
+                idle = true;
+            }
+            for (size_t i = 0; !strand && (i < workers.size()); ++i) {
+                Take(*workers[(self + i) % workers.size()], i != 0, strand, work);
+            }
+        }
+        if (!strand) {
+            Event::Wait(worker.wake);
+            SetIdle(worker, false);
+            continue;
+        }
+        if (idle) {
+            SetIdle(worker, false);
+        }
+
+        reentrancyLock.Lock(MUTEX_CONTEXT);
+        worker.hasLock = true;
+        worker.current = strand;
+        if (work.msg) {
+            if (isRunning) {
+                QStatus status = endpoint->DoPushMessage(*work.msg);
+                // ER_BUS_STOPPING is a common shutdown error
+                if (status != ER_OK && status != ER_BUS_STOPPING) {
+                    QCC_LogError(status, ("LocalEndpoint::DoPushMessage failed"));
+                }
+            }
+            delete work.msg;
+        } else {
+            work.Trigger(isRunning ? ER_OK : ER_TIMER_EXITING);
+        }
+        if (worker.hasLock) {
+            worker.hasLock = false;
+            reentrancyLock.Unlock(MUTEX_CONTEXT);
+        }
+        /* The strand was already released if the callback called EnableReentrancy() */
+        if (worker.current) {
+            worker.current = NULL;
+            Release(strand);
+        }
+    }
+    return 0;
+}
+
+void _LocalEndpoint::Dispatcher::EnableReentrancy()
+{
+    Worker* worker = GetCurrentWorker();
+    if (worker) {
+        if (worker->hasLock) {
+            worker->hasLock = false;
+            reentrancyLock.Unlock(MUTEX_CONTEXT);
+        }
+        if (worker->current) {
+            Strand* strand = worker->current;
+            worker->current = NULL;
+            Release(strand);
+        }
+    } else {
+        QCC_DbgPrintf(("Invalid call to EnableReentrancy from thread %s; only allowed from a dispatcher thread", Thread::GetThreadName()));
+    }
+}
+
+bool _LocalEndpoint::Dispatcher::ThreadHoldsLock()
+{
+    Worker* worker = GetCurrentWorker();
+    return worker && worker->hasLock;
+}
+
 void _LocalEndpoint::EnableReentrancy()
 {
     if (dispatcher) {
@@ -422,21 +864,6 @@ bool _LocalEndpoint::IsReentrantCall()
 
 }
 
-void _LocalEndpoint::Dispatcher::AlarmTriggered(const Alarm& alarm, QStatus reason)
-{
-    Message* msg = static_cast<Message*>(alarm->GetContext());
-    if (msg) {
-        if (reason == ER_OK) {
-            QStatus status = endpoint->DoPushMessage(*msg);
-            // ER_BUS_STOPPING is a common shutdown error
-            if (status != ER_OK && status != ER_BUS_STOPPING) {
-                QCC_LogError(status, ("LocalEndpoint::DoPushMessage failed"));
-            }
-        }
-        delete msg;
-    }
-}
-
 QStatus _LocalEndpoint::PushMessage(Message& message)
 {
     QStatus ret;
@@ -877,8 +1304,8 @@ QStatus _LocalEndpoint::HandleMethodCall(Message& message)
 
     /* Look up the member */
     MethodTable::SafeEntry* safeEntry = methodTable.Find(message->GetObjectPath(),
-                                                         message->GetInterface(),
-                                                         message->GetMemberName());
+                                                         message->GetInterfaceAtom(),
+                                                         message->GetMemberNameAtom());
     const MethodTable::Entry* entry = safeEntry ? safeEntry->entry : NULL;
 
     if (entry == NULL) {
@@ -968,34 +1395,40 @@ QStatus _LocalEndpoint::HandleSignal(Message& message)
 {
     QStatus status = ER_OK;
 
-    signalTable.Lock();
-
-    /* Look up the signal */
-    pair<SignalTable::const_iterator, SignalTable::const_iterator> range =
-        signalTable.Find(message->GetObjectPath(), message->GetInterface(), message->GetMemberName());
-
     /*
-     * Quick exit if there are no handlers for this signal
+     * Signals are looked up in a snapshot of the signal table so the table lock is not taken
+     * for each signal. The snapshot holds its own copy of the handlers so it stays valid if a
+     * handler is unregistered while the signal is being dispatched. Getting the atoms for the
+     * interface and member looks up each string in the atom table, which hashes it once per
+     * message but does not take a lock.
      */
-    if (range.first == range.second) {
-        signalTable.Unlock();
-        return ER_OK;
-    }
+    Atom iface = message->GetInterfaceAtom();
+    Atom member = message->GetMemberNameAtom();
+    const char* sourcePath = message->GetObjectPath();
+    const SignalTable::Dispatch* dispatch = signalTable.AcquireDispatch(iface, member);
+
     /*
-     * Build a list of all signal handlers for this signal
+     * Find the first handler for this signal
      */
-    list<SignalTable::Entry> callList;
-    const InterfaceDescription::Member* signal = range.first->second.member;
-    do {
-        callList.push_back(range.first->second);
-    } while (++range.first != range.second);
+    vector<SignalTable::Dispatch::Handler>::const_iterator first;
+    if (dispatch) {
+        for (first = dispatch->GetHandlers().begin(); first != dispatch->GetHandlers().end(); ++first) {
+            if (first->Matches(iface, member, sourcePath)) {
+                break;
+            }
+        }
+    }
     /*
-     * We have our callback list so we can unlock the signal table.
+     * Quick exit if there are no handlers for this signal
      */
-    signalTable.Unlock();
+    if (!dispatch || (first == dispatch->GetHandlers().end())) {
+        SignalTable::ReleaseDispatch(dispatch);
+        return ER_OK;
+    }
     /*
      * Validate and unmarshal the signal
      */
+    const InterfaceDescription::Member* signal = first->entry.member;
     if (signal->iface->IsSecure() && !message->IsEncrypted()) {
         status = ER_BUS_MESSAGE_NOT_ENCRYPTED;
         QCC_LogError(status, ("Signal from secure interface was not encrypted"));
@@ -1008,11 +1441,13 @@ QStatus _LocalEndpoint::HandleSignal(Message& message)
             status = ER_OK;
         }
     } else {
-        list<SignalTable::Entry>::const_iterator callit;
-        for (callit = callList.begin(); callit != callList.end(); ++callit) {
-            (callit->object->*callit->handler)(callit->member, message->GetObjectPath(), message);
+        for (vector<SignalTable::Dispatch::Handler>::const_iterator it = first; it != dispatch->GetHandlers().end(); ++it) {
+            if (it->Matches(iface, member, sourcePath)) {
+                (it->entry.object->*it->entry.handler)(it->entry.member, message->GetObjectPath(), message);
+            }
         }
     }
+    SignalTable::ReleaseDispatch(dispatch);
     return status;
 }
 
@@ -1101,9 +1536,8 @@ void _LocalEndpoint::OnBusConnected()
     /*
      * Use the local endpoint's dispatcher to call back to report the object registrations.
      */
-    uint32_t zero = 0;
     if (dispatcher) {
-        dispatcher->AddAlarm(Alarm(zero, deferredCallbacks));
+        dispatcher->DispatchCallback(deferredCallbacks);
     }
 }
 
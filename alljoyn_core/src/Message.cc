@@ -39,6 +39,7 @@
 
 #include "BusInternal.h"
 #include "BusUtil.h"
+#include "MessageBufferPool.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -304,6 +305,8 @@ _Message::_Message(BusAttachment& bus) :
     bus(&bus),
     endianSwap(false),
     _msgBuf(NULL),
+    bufPool(NULL),
+    bufOwner(Message::Null()),
     msgBuf(NULL),
     msgArgs(NULL),
     numMsgArgs(0),
@@ -312,17 +315,16 @@ _Message::_Message(BusAttachment& bus) :
     numHandles(0),
     encrypt(false),
     readState(MESSAGE_NEW),
-    countRead(0),
-    writeState(MESSAGE_NEW),
-    countWrite(0)
+    countRead(0)
 {
     msgHeader.msgType = MESSAGE_INVALID;
     msgHeader.endian = myEndian;
+    ResetAtoms();
 }
 
 _Message::~_Message(void)
 {
-    delete [] _msgBuf;
+    FreeBuf(_msgBuf, bufPool);
     delete [] msgArgs;
     while (numHandles) {
         qcc::Close(handles[--numHandles]);
@@ -330,10 +332,21 @@ _Message::~_Message(void)
     delete [] handles;
 }
 
+void _Message::FreeBuf(uint8_t* buf, MessageBufferPool* pool)
+{
+    if (pool) {
+        pool->Put(buf);
+    } else {
+        delete [] buf;
+    }
+}
+
 _Message::_Message(const _Message& other) :
     bus(other.bus),
     endianSwap(other.endianSwap),
     msgHeader(other.msgHeader),
+    bufPool(NULL),
+    bufOwner(Message::Null()),
     numMsgArgs(other.numMsgArgs),
     bufSize(other.bufSize),
     ttl(other.ttl),
@@ -345,9 +358,9 @@ _Message::_Message(const _Message& other) :
     encrypt(other.encrypt),
     readState(other.readState),
     countRead(other.countRead),
-    writeState(other.writeState),
-    countWrite(other.countWrite),
-    hdrFields(other.hdrFields)
+    hdrFields(other.hdrFields),
+    ifaceAtom(other.ifaceAtom),
+    memberAtom(other.memberAtom)
 {
     if (bufSize > 0) {
         assert(other.msgBuf != NULL);
@@ -387,6 +400,43 @@ _Message::_Message(const _Message& other) :
     }
 }
 
+_Message::_Message(Message& other, BusAttachment& bus) :
+    bus(&bus),
+    endianSwap(other->endianSwap),
+    msgHeader(other->msgHeader),
+    _msgBuf(NULL),
+    bufPool(NULL),
+    bufOwner(other),
+    msgBuf(other->msgBuf),
+    msgArgs(NULL),
+    numMsgArgs(0),
+    bufSize(other->bufSize),
+    bufEOD(other->bufEOD),
+    bufPos(other->bufPos),
+    bodyPtr(other->bodyPtr),
+    ttl(other->ttl),
+    timestamp(other->timestamp),
+    replySignature(other->replySignature),
+    authMechanism(other->authMechanism),
+    rcvEndpointName(other->rcvEndpointName),
+    handles(NULL),
+    numHandles(0),
+    encrypt(other->encrypt),
+    readState(other->readState),
+    countRead(other->countRead),
+    hdrFields(other->hdrFields),
+    ifaceAtom(other->ifaceAtom),
+    memberAtom(other->memberAtom)
+{
+    /*
+     * Unmarshaling the body of an encrypted or byte swapped message rewrites the buffer so those
+     * messages cannot share it. The body is always parsed again from the shared buffer rather than
+     * copying args that the other message may already have unmarshaled.
+     */
+    assert(!(msgHeader.flags & ALLJOYN_FLAG_ENCRYPTED) && !endianSwap);
+    assert(other->numHandles == 0);
+}
+
 
 QStatus _Message::ReMarshal(const char* senderName)
 {
@@ -405,6 +455,8 @@ QStatus _Message::ReMarshal(const char* senderName)
      * We delete the current buffer after we have copied the body data
      */
     uint8_t* _savBuf = _msgBuf;
+    MessageBufferPool* savPool = bufPool;
+    bufPool = NULL;
 
     /*
      * Compute the new header sizes
@@ -448,7 +500,8 @@ QStatus _Message::ReMarshal(const char* senderName)
      */
     assert((size_t)(bufEOD - (uint8_t*)msgBuf) < bufSize);
     memset(bufEOD, 0, (uint8_t*)msgBuf + bufSize - bufEOD);
-    delete [] _savBuf;
+    FreeBuf(_savBuf, savPool);
+    bufOwner = Message::Null();
     return ER_OK;
 }
 
@@ -502,6 +555,7 @@ void _Message::ClearHeader()
         encrypt = false;
         authMechanism.clear();
     }
+    ResetAtoms();
 }
 
 }
@@ -0,0 +1,82 @@
+/**
+ * @file
+ *
+ * This file implements a pool of buffers for small received messages
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/atomic.h>
+
+#include "MessageBufferPool.h"
+
+#define QCC_MODULE "ALLJOYN"
+
+namespace ajn {
+
+const size_t MessageBufferPool::BUFFER_SIZE;
+
+MessageBufferPool::MessageBufferPool() : refs(1)
+{
+}
+
+MessageBufferPool::~MessageBufferPool()
+{
+    while (!freeBufs.empty()) {
+        delete [] freeBufs.back();
+        freeBufs.pop_back();
+    }
+}
+
+uint8_t* MessageBufferPool::Get()
+{
+    uint8_t* buf = NULL;
+    lock.Lock(MUTEX_CONTEXT);
+    if (!freeBufs.empty()) {
+        buf = freeBufs.back();
+        freeBufs.pop_back();
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    if (!buf) {
+        buf = new uint8_t[BUFFER_SIZE + 7];
+    }
+    qcc::IncrementAndFetch(&refs);
+    return buf;
+}
+
+void MessageBufferPool::Put(uint8_t* buf)
+{
+    lock.Lock(MUTEX_CONTEXT);
+    if (freeBufs.size() < MAX_FREE) {
+        freeBufs.push_back(buf);
+        buf = NULL;
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+    delete [] buf;
+    Release();
+}
+
+void MessageBufferPool::Release()
+{
+    if (qcc::DecrementAndFetch(&refs) == 0) {
+        delete this;
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef _ALLJOYN_MESSAGEBUFFERPOOL_H
+#define _ALLJOYN_MESSAGEBUFFERPOOL_H
+/**
+ * @file
+ * This file defines a pool of buffers for small received messages
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#ifndef __cplusplus
+#error Only include MessageBufferPool.h in C++ code.
+#endif
+
+#include <qcc/platform.h>
+
+#include <vector>
+
+#include <qcc/Mutex.h>
+
+namespace ajn {
+
+/**
+ * Buffers for small messages received on an endpoint. A message borrows a buffer from the
+ * pool of the endpoint it was read on and puts it back when the message is freed, so a steady
+ * stream of small messages does not allocate a buffer for each one.
+ *
+ * Messages can outlive the endpoint they were received on so the pool is reference counted.
+ * The endpoint and each borrowed buffer hold a reference.
+ */
+class MessageBufferPool {
+  public:
+
+    /** Size of the buffers, not counting the bytes needed to align them */
+    static const size_t BUFFER_SIZE = 512;
+
+    /** Constructor, the caller holds the first reference */
+    MessageBufferPool();
+
+    /**
+     * Borrow a buffer. The buffer is BUFFER_SIZE + 7 bytes long so an 8 byte aligned buffer of
+     * BUFFER_SIZE bytes fits in it.
+     *
+     * @return  The buffer, must be put back with Put().
+     */
+    uint8_t* Get();
+
+    /**
+     * Put back a buffer returned by Get(). This may free the pool.
+     *
+     * @param buf  The buffer.
+     */
+    void Put(uint8_t* buf);
+
+    /**
+     * Drop the reference of the caller of the constructor. The pool is freed once every
+     * borrowed buffer has been put back.
+     */
+    void Release();
+
+  private:
+
+    MessageBufferPool(const MessageBufferPool& other);
+    MessageBufferPool& operator=(const MessageBufferPool& other);
+
+    ~MessageBufferPool();
+
+    /** Maximum number of buffers kept for reuse */
+    static const size_t MAX_FREE = 8;
+
+    volatile int32_t refs;          /**< The owner reference plus one for each borrowed buffer */
+    qcc::Mutex lock;                /**< Protects freeBufs */
+    std::vector<uint8_t*> freeBufs; /**< Buffers that have been put back */
+};
+
+}
+
+#endif
@@ -43,6 +43,7 @@
 #include "AllJoynPeerObj.h"
 #include "SignatureUtils.h"
 #include "BusInternal.h"
+#include "MessageBufferPool.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -517,19 +518,26 @@ QStatus _Message::Deliver(RemoteEndpoint& endpoint)
     return status;
 }
 
-QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint)
+bool _Message::GetDeliveryBuffer(const uint8_t*& buf, size_t& len)
+{
+    buf = reinterpret_cast<const uint8_t*>(msgBuf);
+    len = bufEOD - buf;
+    return (len > 0) && !handles && !encrypt && !(ttl && IsExpired());
+}
+
+QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint, WriteCursor& cursor)
 {
     size_t pushed;
     QStatus status = ER_OK;
     Sink& sink = endpoint->GetSink();
 
-    switch (writeState) {
+    switch (cursor.state) {
     case MESSAGE_NEW:
-        writePtr = reinterpret_cast<uint8_t*>(msgBuf);
-        countWrite = bufEOD - writePtr;
+        cursor.ptr = reinterpret_cast<const uint8_t*>(msgBuf);
+        cursor.count = bufEOD - cursor.ptr;
         pushed = 0;
 
-        if (countWrite == 0) {
+        if (cursor.count == 0) {
             status = ER_BUS_EMPTY_MESSAGE;
             QCC_LogError(status, ("Message is empty"));
             return status;
@@ -561,32 +569,32 @@ QStatus _Message::DeliverNonBlocking(RemoteEndpoint& endpoint)
                 return ER_OK;
             }
         }
-        writeState = MESSAGE_HEADERFIELDS;
+        cursor.state = MESSAGE_HEADERFIELDS;
 
     case MESSAGE_HEADERFIELDS:
         if (handles) {
-            status = sink.PushBytesAndFds(writePtr, countWrite, pushed, handles, numHandles, endpoint->GetProcessId());
+            status = sink.PushBytesAndFds(cursor.ptr, cursor.count, pushed, handles, numHandles, endpoint->GetProcessId());
         } else {
-            status = sink.PushBytes(writePtr, countWrite, pushed, (msgHeader.flags & ALLJOYN_FLAG_SESSIONLESS) ? (ttl * 1000) : ttl);
+            status = sink.PushBytes(cursor.ptr, cursor.count, pushed, (msgHeader.flags & ALLJOYN_FLAG_SESSIONLESS) ? (ttl * 1000) : ttl);
         }
 
         if (status == ER_OK) {
-            countWrite -= pushed;
-            writePtr += pushed;
-            writeState = MESSAGE_HEADER_BODY;
+            cursor.count -= pushed;
+            cursor.ptr += pushed;
+            cursor.state = MESSAGE_HEADER_BODY;
         } else { break; }
 
     case MESSAGE_HEADER_BODY:
         status = ER_OK;
-        while (status == ER_OK && countWrite > 0) {
-            status = sink.PushBytes(writePtr, countWrite, pushed);
+        while (status == ER_OK && cursor.count > 0) {
+            status = sink.PushBytes(cursor.ptr, cursor.count, pushed);
             if (status == ER_OK) {
-                countWrite -= pushed;
-                writePtr += pushed;
+                cursor.count -= pushed;
+                cursor.ptr += pushed;
             }
         }
-        if (countWrite == 0) {
-            writeState = MESSAGE_COMPLETE;
+        if (cursor.count == 0) {
+            cursor.state = MESSAGE_COMPLETE;
         }
         break;
 
@@ -735,8 +743,9 @@ size_t _Message::ComputeHeaderLen()
 QStatus _Message::EncryptMessage()
 {
     KeyBlob key;
+    MessageCipher cipher;
     PeerState peerState = bus->GetInternal().GetPeerStateTable()->GetPeerState(GetDestination());
-    QStatus status = peerState->GetKey(key, PEER_SESSION_KEY);
+    QStatus status = peerState->GetKey(key, cipher, PEER_SESSION_KEY);
 
     if (status == ER_OK) {
         /*
@@ -750,7 +759,7 @@ QStatus _Message::EncryptMessage()
     if (status == ER_OK) {
         size_t argsLen = msgHeader.bodyLen - ajn::Crypto::MACLength;
         size_t hdrLen = ROUNDUP8(sizeof(msgHeader) + msgHeader.headerLen);
-        status = ajn::Crypto::Encrypt(*this, key, (uint8_t*)msgBuf, hdrLen, argsLen);
+        status = ajn::Crypto::Encrypt(*this, key, cipher, (uint8_t*)msgBuf, hdrLen, argsLen);
         if (status == ER_OK) {
             QCC_DbgHLPrintf(("EncryptMessage: %s", Description().c_str()));
             /*
@@ -819,6 +828,7 @@ QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
      * marshaling may point into the old message.
      */
     uint8_t* _oldMsgBuf = _msgBuf;
+    MessageBufferPool* oldPool = bufPool;
     /*
      * Clear out stale message data
      */
@@ -827,6 +837,7 @@ QStatus _Message::MarshalMessage(const qcc::String& expectedSignature,
     bufEOD = NULL;
     msgBuf = NULL;
     _msgBuf = NULL;
+    bufPool = NULL;
     /*
      * There should be a mapping for every field type
      */
@@ -982,7 +993,8 @@ ExitMarshalMessage:
     /*
      * Don't need the old message buffer any more
      */
-    delete [] _oldMsgBuf;
+    FreeBuf(_oldMsgBuf, oldPool);
+    bufOwner = Message::Null();
 
     if (status == ER_OK) {
         QCC_DbgHLPrintf(("MarshalMessage: %d+%d %s %s", hdrLen, msgHeader.bodyLen, Description().c_str(), encrypt ? " (encrypted)" : ""));
@@ -42,6 +42,7 @@
 #include "AllJoynPeerObj.h"
 #include "SignatureUtils.h"
 #include "BusInternal.h"
+#include "MessageBufferPool.h"
 
 #define QCC_MODULE "ALLJOYN"
 
@@ -561,8 +562,19 @@ QStatus _Message::UnmarshalArgs(const qcc::String& expectedSignature, const char
     int _numMsgArgs = 0;
     MsgArg* _msgArgs = NULL;
 
-    /* Check if message body is already unmarshaled */
+    /*
+     * Check if message body is already unmarshaled, for example a method call handed over by
+     * another bus attachment in this process. The expected signatures still apply.
+     */
     if (msgArgs != NULL) {
+        if ((expectedSignature != sig) && (expectedSignature != WildCardSignature)) {
+            status = ER_BUS_SIGNATURE_MISMATCH;
+            QCC_LogError(status, ("Expected \"%s\" got \"%s\"", expectedSignature.c_str(), sig));
+            return status;
+        }
+        if (expectedReplySignature) {
+            replySignature = expectedReplySignature;
+        }
         return ER_OK;
     }
 
@@ -590,7 +602,8 @@ QStatus _Message::UnmarshalArgs(const qcc::String& expectedSignature, const char
         size_t hdrLen = bodyPtr - (uint8_t*)msgBuf;
         PeerState peerState = bus->GetInternal().GetPeerStateTable()->GetPeerState(GetSender());
         KeyBlob key;
-        status = peerState->GetKey(key, broadcast ? PEER_GROUP_KEY : PEER_SESSION_KEY);
+        MessageCipher cipher;
+        status = peerState->GetKey(key, cipher, broadcast ? PEER_GROUP_KEY : PEER_SESSION_KEY);
         if (status != ER_OK) {
             QCC_LogError(status, ("Unable to decrypt message"));
             /*
@@ -612,7 +625,7 @@ QStatus _Message::UnmarshalArgs(const qcc::String& expectedSignature, const char
          * algorithm adds appends a MAC block to the end of the encrypted data.
          */
         size_t bodyLen = msgHeader.bodyLen;
-        status = ajn::Crypto::Decrypt(*this, key, (uint8_t*)msgBuf, hdrLen, bodyLen);
+        status = ajn::Crypto::Decrypt(*this, key, cipher, (uint8_t*)msgBuf, hdrLen, bodyLen);
         if (status != ER_OK) {
             goto ExitUnmarshalArgs;
         }
@@ -841,7 +854,7 @@ QStatus _Message::HeaderChecks(bool pedantic)
 }
 
 /* Check the first 16 bytes of the header */
-QStatus _Message::InterpretHeader()
+QStatus _Message::InterpretHeader(MessageBufferPool* pool)
 {
     readState = MESSAGE_HEADER_BODY;
     /*
@@ -890,7 +903,13 @@ QStatus _Message::InterpretHeader()
      * message reducing the places where we need to check for bufEOD when unmarshaling the body.
      */
     bufSize = sizeof(msgHeader) + ((pktSize + 7) & ~7) + sizeof(uint64_t);
-    _msgBuf = new uint8_t[bufSize + 7];
+    if (pool && (bufSize <= MessageBufferPool::BUFFER_SIZE)) {
+        /* Small messages borrow a buffer from the endpoint's pool */
+        _msgBuf = pool->Get();
+        bufPool = pool;
+    } else {
+        _msgBuf = new uint8_t[bufSize + 7];
+    }
     msgBuf = (uint64_t*)((uintptr_t)(_msgBuf + 7) & ~7); /* Align to 8 byte boundary */
     /*
      * Copy header into the buffer
@@ -917,7 +936,7 @@ QStatus _Message::InterpretHeader()
 
 }
 
-QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic, uint32_t timeout)
+QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool pedantic, uint32_t timeout, bool buffered)
 {
     QStatus status;
     qcc::SocketFd fdList[qcc::SOCKET_MAX_FILE_DESCRIPTORS];
@@ -951,6 +970,8 @@ QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool ped
                 handles = new qcc::SocketFd[numHandles];
                 memcpy(handles, fdList, numHandles * sizeof(qcc::SocketFd));
             }
+        } else if (buffered && (maxFds == 0)) {
+            status = endpoint->PullBufferedBytes(bufPos, toRead, read, timeout);
         } else {
             status = source.PullBytes(bufPos, toRead, read, timeout);
         }
@@ -961,14 +982,18 @@ QStatus _Message::PullBytes(RemoteEndpoint& endpoint, bool checkSender, bool ped
             break;
         }
         if (countRead == 0) {
-            status = InterpretHeader();
+            status = InterpretHeader(buffered ? endpoint->GetBufferPool() : NULL);
         }
         break;
 
     case MESSAGE_HEADER_BODY:
         /* Read the rest of the message header and body */
         toRead = (std::min)(countRead, MAX_PULL);
-        status = source.PullBytes(bufPos, toRead, read, timeout);
+        if (buffered && (maxFds == 0)) {
+            status = endpoint->PullBufferedBytes(bufPos, toRead, read, timeout);
+        } else {
+            status = source.PullBytes(bufPos, toRead, read, timeout);
+        }
         if (status == ER_ALERTED_THREAD) {
             QCC_LogError(status, ("PullBytes ALERTED continuing"));
             status = ER_OK;
@@ -999,7 +1024,7 @@ QStatus _Message::ReadNonBlocking(RemoteEndpoint& endpoint, bool checkSender, bo
 
     QStatus status = ER_OK;
     while ((status == ER_OK) && (readState != MESSAGE_COMPLETE)) {
-        status = PullBytes(endpoint, checkSender, pedantic, 0); /* timeout zero */
+        status = PullBytes(endpoint, checkSender, pedantic, 0, true); /* timeout zero, read through the endpoint's receive buffer */
     }
     if (status == ER_OK) {
         status = ((readState == MESSAGE_COMPLETE) ? ER_OK : ER_TIMEOUT);
@@ -1018,8 +1043,9 @@ QStatus _Message::Read(RemoteEndpoint& endpoint, bool checkSender, bool pedantic
      * Clear out any stale message state
      */
     msgBuf = NULL;
-    delete [] _msgBuf;
+    FreeBuf(_msgBuf, bufPool);
     _msgBuf = NULL;
+    bufPool = NULL;
     ClearHeader();
     readState = MESSAGE_NEW;
 
@@ -1047,6 +1073,7 @@ QStatus _Message::Unmarshal(RemoteEndpoint& endpoint, bool checkSender, bool ped
     bufPos = (uint8_t*)msgBuf + sizeof(msgHeader);
     endOfHdr = bufPos + msgHeader.headerLen;
     rcvEndpointName = endpoint->GetUniqueName();
+    ResetAtoms();
 
     /*
      * Parse the received header fields - each header starts on an 8 byte boundary
@@ -1272,8 +1299,9 @@ ExitUnmarshal:
          * There was an unrecoverable failure while unmarshaling the message, cleanup before we return.
          */
         msgBuf = NULL;
-        delete [] _msgBuf;
+        FreeBuf(_msgBuf, bufPool);
         _msgBuf = NULL;
+        bufPool = NULL;
         ClearHeader();
         if ((status != ER_SOCK_OTHER_END_CLOSED) && (status != ER_STOPPING_THREAD)) {
             QCC_LogError(status, ("Failed to unmarshal message received on %s", endpoint->GetUniqueName().c_str()));
@@ -52,18 +52,20 @@ void MethodTable::Add(BusObject* object,
 {
     Entry* entry = new Entry(object, func, member, context);
     lock.Lock(MUTEX_CONTEXT);
-    hashTable[Key(object->GetPath(), entry->ifaceStr.empty() ? NULL : entry->ifaceStr.c_str(), member->name.c_str())] = entry;
+    qcc::String path = object->GetPath();
+    Atom method = AtomTable::Intern(member->name);
+    hashTable[Key(path, AtomTable::Intern(entry->ifaceStr), method)] = entry;
 
-    /* Method calls don't require an interface so we need to add an entry with a NULL interface */
+    /* Method calls don't require an interface so we need to add an entry with no interface */
     if (!entry->ifaceStr.empty()) {
-        hashTable[Key(object->GetPath(), NULL, member->name.c_str())] = new Entry(*entry);
+        hashTable[Key(path, AtomTable::NONE, method)] = new Entry(*entry);
     }
     lock.Unlock(MUTEX_CONTEXT);
 }
 
 MethodTable::SafeEntry* MethodTable::Find(const char* objectPath,
-                                          const char* iface,
-                                          const char* methodName)
+                                          Atom iface,
+                                          Atom methodName)
 {
     SafeEntry* entry = NULL;
     Key key(objectPath, iface, methodName);
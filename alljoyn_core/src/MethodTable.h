@@ -26,6 +26,8 @@
 #include <vector>
 
 #include <qcc/String.h>
+#include <qcc/StringMapKey.h>
+#include <qcc/AtomTable.h>
 #include <qcc/Mutex.h>
 #include <qcc/Thread.h>
 #include <qcc/atomic.h>
@@ -122,13 +124,13 @@ class MethodTable {
      * Find an Entry based on set of criteria.
      *
      * @param objectPath   The object path.
-     * @param iface        The interface.
-     * @param methodName   The method name.
+     * @param iface        Atom for the interface.
+     * @param methodName   Atom for the method name.
      * @return
      *      - Entry that matches objectPath, interface and method
      *      - NULL if not found
      */
-    SafeEntry* Find(const char* objectPath, const char* iface, const char* methodName);
+    SafeEntry* Find(const char* objectPath, qcc::Atom iface, qcc::Atom methodName);
 
     /**
      * Remove all hash entries related to the specified object.
@@ -149,14 +151,25 @@ class MethodTable {
     qcc::Mutex lock; /**< Lock protecting the method table */
 
     /**
-     * Type definition for method hash table key
+     * Type definition for method hash table key. The interface is qcc::AtomTable::NONE for the
+     * entries that match method calls that do not specify an interface. Object paths are kept as
+     * strings rather than atoms because atoms are never freed and objects come and go.
      */
     class Key {
       public:
-        const char* objPath;
-        const char* iface;
-        const char* methodName;
-        Key(const char* obj, const char* ifc, const char* method) : objPath(obj), iface((ifc && *ifc) ? ifc : NULL), methodName(method) { }
+        qcc::StringMapKey objPath;
+        qcc::Atom iface;
+        qcc::Atom methodName;
+
+        /**
+         * Constructor used for lookups only (no storage)
+         */
+        Key(const char* obj, qcc::Atom ifc, qcc::Atom method) : objPath(obj), iface(ifc), methodName(method) { }
+
+        /**
+         * Constructor used for storage into hash table (no dangling char*)
+         */
+        Key(const qcc::String& obj, qcc::Atom ifc, qcc::Atom method) : objPath(obj), iface(ifc), methodName(method) { }
     };
 
     /**
@@ -165,18 +178,10 @@ class MethodTable {
     struct Hash {
         /** Calculate hash for Key k  */
         size_t operator()(const Key& k) const {
-            size_t hash = 37;
-            for (const char* p = k.methodName; *p; ++p) {
-                hash = *p + hash * 11;
-            }
-            for (const char* p = k.objPath; *p; ++p) {
+            size_t hash = static_cast<size_t>(k.methodName) * 11 + static_cast<size_t>(k.iface) * 7;
+            for (const char* p = k.objPath.c_str(); *p; ++p) {
                 hash = *p + hash * 5;
             }
-            if (k.iface) {
-                for (const char* p = k.iface; *p; ++p) {
-                    hash += *p * 7;
-                }
-            }
             return hash;
         }
     };
@@ -189,15 +194,10 @@ class MethodTable {
          * Return true two keys are equal
          */
         bool operator()(const Key& k1, const Key& k2) const {
-            if ((k1.iface == NULL) || (k2.iface == NULL)) {
-                return (k1.iface == k2.iface) && (strcmp(k1.methodName, k2.methodName) == 0) && (strcmp(k1.objPath, k2.objPath) == 0);
-            } else {
-                return (strcmp(k1.methodName, k2.methodName) == 0) && (strcmp(k1.iface, k2.iface) == 0) && (strcmp(k1.objPath, k2.objPath) == 0);
-            }
+            return (k1.methodName == k2.methodName) && (k1.iface == k2.iface) && (k1.objPath == k2.objPath);
         }
     };
 
-    /** The hash table */
     typedef std::unordered_map<Key, Entry*, Hash, Equal> MapType;
     MapType hashTable;
 };
@@ -210,12 +210,31 @@ QStatus _NullEndpoint::PushMessage(Message& msg)
         /*
          * We need to clone broadcast signals because each receiving bus attachment must be
          * able to unmarshal the arg list including decrypting and doing header expansion.
+         * Unmarshaling only reads the buffer of a message that is not encrypted and does not
+         * need byte swapping so the clone can share the buffer instead of copying it.
          */
         if (msg->IsBroadcastSignal()) {
-            Message clone(msg, true /*deep copy*/);
-            clone->bus = &clientBus;
-            status = clientBus.GetInternal().GetRouter().PushMessage(clone, busEndpoint);
+            if (!(msg->GetFlags() & ALLJOYN_FLAG_ENCRYPTED) && !msg->endianSwap && (msg->numHandles == 0)) {
+                Message clone(msg, clientBus);
+                status = clientBus.GetInternal().GetRouter().PushMessage(clone, busEndpoint);
+            } else {
+                Message clone(msg, true /*deep copy*/);
+                clone->bus = &clientBus;
+                status = clientBus.GetInternal().GetRouter().PushMessage(clone, busEndpoint);
+            }
         } else {
+            /*
+             * A method call from another bus attachment in this process is parsed before it is
+             * handed over so the receiver dispatches it without unmarshaling it. Encrypted
+             * calls are left to the receiver, which must decrypt them and check that the sender
+             * is authorized.
+             */
+            if ((msg->GetType() == MESSAGE_METHOD_CALL) && !(msg->GetFlags() & ALLJOYN_FLAG_ENCRYPTED) && !msg->endianSwap && (msg->numHandles == 0)) {
+                BusEndpoint sender = routerBus.GetInternal().GetRouter().FindEndpoint(msg->GetSender());
+                if (sender->GetEndpointType() == ENDPOINT_TYPE_NULL) {
+                    msg->UnmarshalArgs("*");
+                }
+            }
             msg->bus = &clientBus;
             status = clientBus.GetInternal().GetRouter().PushMessage(msg, busEndpoint);
         }
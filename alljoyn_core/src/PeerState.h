@@ -43,6 +43,8 @@
 
 #include <alljoyn/Status.h>
 
+#include "AllJoynCrypto.h"
+
 namespace ajn {
 
 /* Forward declaration */
@@ -142,6 +144,7 @@ class _PeerState {
      */
     void SetKey(const qcc::KeyBlob& key, PeerKeyType keyType) {
         keys[keyType] = key;
+        ciphers[keyType] = MessageCipher(key);
         isSecure = key.IsValid();
     }
 
@@ -168,12 +171,32 @@ class _PeerState {
         }
     }
 
+    /**
+     * Gets the session key for this peer and the cipher for that key.
+     *
+     * @param key     [out]Returns the session key.
+     * @param cipher  [out]Returns the cipher for the session key.
+     *
+     * @return  - ER_OK if there is a session key set for this peer.
+     *          - ER_BUS_KEY_UNAVAILABLE if no session key has been set for this peer.
+     *          - ER_BUS_KEY_EXPIRED if there was a session key but the key has expired.
+     */
+    QStatus GetKey(qcc::KeyBlob& key, MessageCipher& cipher, PeerKeyType keyType) {
+        QStatus status = GetKey(key, keyType);
+        if (status == ER_OK) {
+            cipher = ciphers[keyType];
+        }
+        return status;
+    }
+
     /**
      * Clear the keys for this peer.
      */
     void ClearKeys() {
         keys[PEER_SESSION_KEY].Erase();
         keys[PEER_GROUP_KEY].Erase();
+        ciphers[PEER_SESSION_KEY] = MessageCipher();
+        ciphers[PEER_GROUP_KEY] = MessageCipher();
         isSecure = false;
     }
 
@@ -315,6 +338,11 @@ class _PeerState {
      */
     qcc::KeyBlob keys[2];
 
+    /**
+     * The ciphers for the session keys, these are replaced whenever the keys are set.
+     */
+    MessageCipher ciphers[2];
+
     /**
      * Serial number window. Used by IsValidSerial() to detect replay attacks. The size of the
      * window defines that largest tolerable gap between consecutive serial numbers.
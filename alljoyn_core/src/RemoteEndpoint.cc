@@ -20,6 +20,8 @@
 #include <qcc/platform.h>
 
 #include <assert.h>
+#include <string.h>
+#include <vector>
 
 #include <qcc/Debug.h>
 #include <qcc/String.h>
@@ -38,6 +40,7 @@
 #include "LocalTransport.h"
 #include "AllJoynPeerObj.h"
 #include "BusInternal.h"
+#include "MessageBufferPool.h"
 
 #ifndef NDEBUG
 #include <qcc/time.h>
@@ -60,6 +63,9 @@ class _RemoteEndpoint::Internal {
         bus(bus),
         stream(stream),
         txQueue(),
+        txQueueBytes(0),
+        txQueueTtlCount(0),
+        txStats(),
         txWaitQueue(),
         lock(),
         exitCount(0),
@@ -75,25 +81,86 @@ class _RemoteEndpoint::Internal {
         maxIdleProbes(0),
         idleTimeout(0),
         probeTimeout(0),
+        probeSentTime(0),
+        rtt(0),
         threadName(threadName),
         started(false),
         currentReadMsg(bus),
+        rxBuf(NULL),
+        bufPool(new MessageBufferPool()),
+        rxPos(0),
+        rxEnd(0),
         validateSender(incoming),
         hasRxSessionMsg(false),
         getNextMsg(true),
         currentWriteMsg(bus),
+        writeCursor(),
+        txBatch(),
+        txBatchIov(),
+        txBatchPos(0),
         stopping(false),
-        sessionId(0)
+        sessionId(0),
+        acceptAuth(NULL)
     {
     }
 
     ~Internal() {
+        delete [] rxBuf;
+        bufPool->Release();
+        delete acceptAuth;
     }
 
     BusAttachment& bus;                      /**< Message bus associated with this endpoint */
     qcc::Stream* stream;                     /**< Stream for this endpoint or NULL if uninitialized */
 
+    /**
+     * Add a message to the transmit queue. Must be called with the lock held.
+     */
+    void PushTx(Message& msg)
+    {
+        txQueue.push_front(msg);
+        txQueueBytes += msg->GetBufferLength();
+        if (msg->IsUnreliable()) {
+            ++txQueueTtlCount;
+        }
+        txStats.highWaterDepth = (std::max)(txStats.highWaterDepth, txQueue.size());
+        txStats.highWaterBytes = (std::max)(txStats.highWaterBytes, txQueueBytes);
+    }
+
+    /**
+     * Remove a message from the transmit queue. Must be called with the lock held.
+     */
+    void EraseTx(std::deque<Message>::iterator it)
+    {
+        assert(txQueueBytes >= (*it)->GetBufferLength());
+        txQueueBytes -= (*it)->GetBufferLength();
+        if ((*it)->IsUnreliable()) {
+            --txQueueTtlCount;
+        }
+        txQueue.erase(it);
+    }
+
+    /**
+     * Remove the oldest message from the transmit queue. Must be called with the lock held.
+     */
+    void PopTx()
+    {
+        EraseTx(--txQueue.end());
+    }
+
+    /**
+     * Check if a message fits in the transmit queue. An empty queue accepts any message so
+     * messages larger than the byte limit can still be sent. Must be called with the lock held.
+     */
+    bool TxQueueHasRoom(size_t len, size_t maxMessages, size_t maxBytes) const
+    {
+        return txQueue.empty() || ((txQueue.size() < maxMessages) && ((txQueueBytes + len) <= maxBytes));
+    }
+
     std::deque<Message> txQueue;             /**< Transmit message queue */
+    size_t txQueueBytes;                     /**< Number of bytes in the txQueue */
+    size_t txQueueTtlCount;                  /**< Number of messages in the txQueue that have a TTL */
+    TxQueueStats txStats;                    /**< High-water marks and drop counts of the txQueue */
     std::deque<qcc::Thread*> txWaitQueue;    /**< Threads waiting for txQueue to become not-full */
     qcc::Mutex lock;                         /**< Mutex that protects the txQueue and timeout values */
     int32_t exitCount;                       /**< Number of sub-threads (rx and tx) that have exited (atomically incremented) */
@@ -114,6 +181,8 @@ class _RemoteEndpoint::Internal {
     uint32_t maxIdleProbes;                  /**< Maximum number of missed idle probes before shutdown */
     uint32_t idleTimeout;                    /**< RX idle seconds before sending probe */
     uint32_t probeTimeout;                   /**< Probe timeout in seconds */
+    uint64_t probeSentTime;                  /**< Time the last unanswered ProbeReq was sent or 0 */
+    uint32_t rtt;                            /**< Smoothed ProbeReq to ProbeAck round trip time in ms */
 
     String uniqueName;                       /**< Obtained from EndpointAuth */
     String remoteName;                       /**< Obtained from EndpointAuth */
@@ -122,12 +191,21 @@ class _RemoteEndpoint::Internal {
     bool started;                            /**< Is this EP started? */
 
     Message currentReadMsg;                  /**< The message currently being read for this endpoint */
+    uint8_t* rxBuf;                          /**< Receive buffer, allocated on the first buffered read */
+    MessageBufferPool* bufPool;              /**< Buffers for small messages read through rxBuf */
+    size_t rxPos;                            /**< Offset of the first unconsumed byte in rxBuf */
+    size_t rxEnd;                            /**< Offset one past the last valid byte in rxBuf */
     bool validateSender;                     /**< If true, the sender field on incomming messages will be overwritten with actual endpoint name */
     bool hasRxSessionMsg;                    /**< true iff this endpoint has previously processed a non-control message */
     bool getNextMsg;                         /**< If true, read the next message from the txQueue */
     Message currentWriteMsg;                 /**< The message currently being read for this endpoint */
+    _Message::WriteCursor writeCursor;       /**< Write position in currentWriteMsg for this endpoint */
+    std::vector<Message> txBatch;            /**< Messages taken from the txQueue to be written with a single vectored write */
+    std::vector<qcc::IOVec> txBatchIov;      /**< Marshaled buffers of the messages in txBatch */
+    size_t txBatchPos;                       /**< Index of the first buffer in txBatchIov that is not completely written */
     bool stopping;                           /**< Is this EP stopping? */
     uint32_t sessionId;                      /**< SessionId for BusToBus endpoint. (not used for non-B2B endpoints) */
+    EndpointAuth* acceptAuth;                /**< Authentication state of a non-blocking accept in progress */
 };
 
 
@@ -136,6 +214,7 @@ void _RemoteEndpoint::SetStream(qcc::Stream* s)
 
     if (internal) {
         internal->stream = s;
+        internal->rxPos = internal->rxEnd = 0;
     }
 }
 
@@ -228,18 +307,71 @@ QStatus _RemoteEndpoint::Establish(const qcc::String& authMechanisms, qcc::Strin
 
         status = auth.Establish(authMechanisms, authUsed, redirection, listener);
         if (status == ER_OK) {
-            internal->uniqueName = auth.GetUniqueName();
-            internal->remoteName = auth.GetRemoteName();
-            internal->remoteGUID = auth.GetRemoteGUID();
-            internal->features.protocolVersion = auth.GetRemoteProtocolVersion();
-            internal->features.trusted = (authUsed != "ANONYMOUS");
-            internal->features.nameTransfer = (SessionOpts::NameTransferType)auth.GetNameTransfer();
-
+            SetEstablished(auth, authUsed);
         }
     }
     return status;
 }
 
+QStatus _RemoteEndpoint::StartAccept(const qcc::String& authMechanisms, AuthListener* listener)
+{
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    if (internal->acceptAuth) {
+        return ER_BUS_ESTABLISH_FAILED;
+    }
+    /*
+     * The EndpointAuth holds a reference to this endpoint so it must be released by
+     * ContinueAccept() or AbortAccept() for the endpoint to be freed.
+     */
+    RemoteEndpoint rep = RemoteEndpoint::wrap(this);
+    internal->acceptAuth = new EndpointAuth(internal->bus, rep, true);
+    QStatus status = internal->acceptAuth->StartAccept(authMechanisms, listener);
+    if (status != ER_OK) {
+        AbortAccept();
+    }
+    return status;
+}
+
+QStatus _RemoteEndpoint::ContinueAccept(qcc::String& authUsed)
+{
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    if (!internal->acceptAuth) {
+        return ER_BUS_ESTABLISH_FAILED;
+    }
+    QStatus status = internal->acceptAuth->ContinueAccept(authUsed);
+    if (status == ER_WOULDBLOCK) {
+        return status;
+    }
+    if (status == ER_OK) {
+        SetEstablished(*internal->acceptAuth, authUsed);
+    }
+    AbortAccept();
+    return status;
+}
+
+void _RemoteEndpoint::AbortAccept()
+{
+    if (internal) {
+        EndpointAuth* auth = internal->acceptAuth;
+        internal->acceptAuth = NULL;
+        delete auth;
+    }
+}
+
+void _RemoteEndpoint::SetEstablished(const EndpointAuth& auth, const qcc::String& authUsed)
+{
+    internal->uniqueName = auth.GetUniqueName();
+    internal->remoteName = auth.GetRemoteName();
+    internal->remoteGUID = auth.GetRemoteGUID();
+    internal->features.protocolVersion = auth.GetRemoteProtocolVersion();
+    internal->features.trusted = (authUsed != "ANONYMOUS");
+    internal->features.nameTransfer = (SessionOpts::NameTransferType)auth.GetNameTransfer();
+}
+
 QStatus _RemoteEndpoint::SetLinkTimeout(uint32_t& idleTimeout)
 {
     if (internal) {
@@ -398,7 +530,7 @@ QStatus _RemoteEndpoint::StopAfterTxEmpty(uint32_t maxWaitMs)
     /* Wait for txqueue to empty before triggering stop */
     internal->lock.Lock(MUTEX_CONTEXT);
     while (true) {
-        if (internal->txQueue.empty() || (maxWaitMs && (qcc::GetTimestamp() > (startTime + maxWaitMs)))) {
+        if ((internal->txQueue.empty() && internal->txBatch.empty()) || (maxWaitMs && (qcc::GetTimestamp() > (startTime + maxWaitMs)))) {
             status = Stop();
             break;
         } else {
@@ -463,6 +595,18 @@ static inline bool IsControlMessage(Message& msg)
     return (::strcmp(sender + offset, ".1") == 0) ? true : false;
 }
 
+/*
+ * Only signals that receivers cannot count on getting may be dropped when the transmit queue is
+ * full. Method calls, replies and messages from a router's local endpoint (which include the
+ * bus-to-bus control signals) must wait for the queue to drain.
+ */
+static inline bool IsDroppable(Message& msg)
+{
+    return (msg->GetType() == MESSAGE_SIGNAL) &&
+           (msg->IsBroadcastSignal() || msg->IsSessionless() || msg->IsUnreliable()) &&
+           !IsControlMessage(msg);
+}
+
 void _RemoteEndpoint::ExitCallback() {
     /* Ensure the endpoint is valid */
     if (!internal) {
@@ -505,6 +649,62 @@ void _RemoteEndpoint::ExitCallback() {
     internal->exitCount = 1;
 }
 
+/*
+ * Size of the receive buffer. Large enough to hold a burst of typical small messages.
+ */
+static const size_t RX_BUFFER_SIZE = 32 * 1024;
+
+QStatus _RemoteEndpoint::PullBufferedBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout)
+{
+    actualBytes = 0;
+    if (!internal) {
+        return ER_BUS_NO_ENDPOINT;
+    }
+    QStatus status = ER_OK;
+    uint8_t* outPtr = (uint8_t*)buf;
+    while (reqBytes > 0) {
+        /* Copy buffered bytes first */
+        if (internal->rxEnd > internal->rxPos) {
+            size_t n = (std::min)(reqBytes, internal->rxEnd - internal->rxPos);
+            memcpy(outPtr, internal->rxBuf + internal->rxPos, n);
+            internal->rxPos += n;
+            outPtr += n;
+            reqBytes -= n;
+            continue;
+        }
+        size_t read = 0;
+        if ((reqBytes >= RX_BUFFER_SIZE) || internal->armRxPause) {
+            /*
+             * Large reads go directly to the caller's buffer. Don't read ahead if rx is going to
+             * be paused because the stream will be handed over after the next reply.
+             */
+            status = internal->stream->PullBytes(outPtr, reqBytes, read, timeout);
+            if (status == ER_OK) {
+                outPtr += read;
+            }
+            break;
+        }
+        /* The buffer is empty so refill it from the start */
+        if (!internal->rxBuf) {
+            internal->rxBuf = new uint8_t[RX_BUFFER_SIZE];
+        }
+        internal->rxPos = internal->rxEnd = 0;
+        status = internal->stream->PullBytes(internal->rxBuf, RX_BUFFER_SIZE, read, timeout);
+        if (status != ER_OK) {
+            break;
+        }
+        internal->rxEnd = read;
+    }
+    actualBytes = outPtr - (uint8_t*)buf;
+    /* Report the stream status only if nothing was pulled */
+    return (actualBytes > 0) ? ER_OK : status;
+}
+
+MessageBufferPool* _RemoteEndpoint::GetBufferPool()
+{
+    return internal ? internal->bufPool : NULL;
+}
+
 QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
 {
     /* Remote endpoints can be invalid if they were created with the default
@@ -536,7 +736,15 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                     bool isAck;
                     if (IsProbeMsg(msg, isAck)) {
                         QCC_DbgPrintf(("%s: Received %s\n", GetUniqueName().c_str(), isAck ? "ProbeAck" : "ProbeReq"));
-                        if (!isAck) {
+                        if (isAck) {
+                            internal->lock.Lock(MUTEX_CONTEXT);
+                            uint64_t probeSentTime = internal->probeSentTime;
+                            internal->probeSentTime = 0;
+                            internal->lock.Unlock(MUTEX_CONTEXT);
+                            if (probeSentTime) {
+                                AddRttSample(static_cast<uint32_t>(GetTimestamp64() - probeSentTime));
+                            }
+                        } else {
                             /* Respond to probe request */
                             Message probeMsg(internal->bus);
                             status = GenProbeMsg(true, probeMsg);
@@ -551,13 +759,14 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                         status = router.PushMessage(msg, bep);
                         if (status != ER_OK) {
                             /*
-                             * There are five cases where a failure to push a message to the router is ok:
+                             * There are six cases where a failure to push a message to the router is ok:
                              *
                              * 1) The message received did not match the expected signature.
                              * 2) The message was a method reply that did not match up to a method call.
                              * 3) A daemon is pushing the message to a connected client or service.
                              * 4) Pushing a message to an endpoint that has closed.
                              * 5) Pushing the first non-control message of a new session (must wait for route to be fully setup)
+                             * 6) Pushing a message to an endpoint whose tx queue is full.
                              *
                              */
 
@@ -569,7 +778,7 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
                                     status = router.PushMessage(msg, bep);
                                 }
                             }
-                            if ((router.IsDaemon() && !bus2bus) || (status == ER_BUS_SIGNATURE_MISMATCH) || (status == ER_BUS_UNMATCHED_REPLY_SERIAL) || (status == ER_BUS_ENDPOINT_CLOSING)) {
+                            if ((router.IsDaemon() && !bus2bus) || (status == ER_BUS_SIGNATURE_MISMATCH) || (status == ER_BUS_UNMATCHED_REPLY_SERIAL) || (status == ER_BUS_ENDPOINT_CLOSING) || (status == ER_BUS_WRITE_QUEUE_FULL)) {
                                 QCC_DbgHLPrintf(("Discarding %s: %s", msg->Description().c_str(), QCC_StatusText(status)));
                                 status = ER_OK;
                             }
@@ -660,6 +869,9 @@ QStatus _RemoteEndpoint::ReadCallback(qcc::Source& source, bool isTimedOut)
             Message probeMsg(internal->bus);
             status = GenProbeMsg(false, probeMsg);
             if (status == ER_OK) {
+                internal->lock.Lock(MUTEX_CONTEXT);
+                internal->probeSentTime = GetTimestamp64();
+                internal->lock.Unlock(MUTEX_CONTEXT);
                 PushMessage(probeMsg);
             }
             QCC_DbgPrintf(("%s: Sent ProbeReq (%s)\n", GetUniqueName().c_str(), QCC_StatusText(status)));
@@ -711,13 +923,20 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
         if (internal->getNextMsg) {
             internal->lock.Lock(MUTEX_CONTEXT);
             if (!internal->txQueue.empty()) {
-                /* Make a deep copy of the message since there is state information inside the message.
-                 * Each copy of the message could be in different write state.
-                 */
-                internal->currentWriteMsg = Message(internal->txQueue.back(), true);
+                size_t numTaken = GatherTxBatch();
+                if (numTaken == 0) {
+                    /* The marshaled buffer is shared with every other endpoint this message was routed
+                     * to so only the write position is kept per endpoint. A message that still has to be
+                     * encrypted is modified in place and so needs a private copy.
+                     */
+                    Message& msg = internal->txQueue.back();
+                    internal->currentWriteMsg = msg->encrypt ? Message(msg, true) : msg;
+                    internal->writeCursor = _Message::WriteCursor();
+                    numTaken = 1;
+                }
 
-                /* Alert next thread on wait queue */
-                if (0 < internal->txWaitQueue.size()) {
+                /* Alert next thread(s) on wait queue */
+                while ((0 < numTaken--) && (0 < internal->txWaitQueue.size())) {
                     Thread* wakeMe = internal->txWaitQueue.back();
                     internal->txWaitQueue.pop_back();
                     status = wakeMe->Alert();
@@ -734,9 +953,20 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
                 return ER_OK;
             }
         }
+        if (!internal->txBatch.empty()) {
+            /* Deliver batch of messages */
+            status = PushTxBatch();
+            if (status == ER_OK) {
+                internal->lock.Lock(MUTEX_CONTEXT);
+                internal->txBatch.clear();
+                internal->getNextMsg = true;
+                internal->lock.Unlock(MUTEX_CONTEXT);
+            }
+            continue;
+        }
         /* Deliver message */
         RemoteEndpoint rep = RemoteEndpoint::wrap(this);
-        status = internal->currentWriteMsg->DeliverNonBlocking(rep);
+        status = internal->currentWriteMsg->DeliverNonBlocking(rep, internal->writeCursor);
         /* Report authorization failure as a security violation */
         if (status == ER_BUS_NOT_AUTHORIZED) {
             internal->bus.GetInternal().GetLocalEndpoint()->GetPeerObj()->HandleSecurityViolation(internal->currentWriteMsg, status);
@@ -750,7 +980,7 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
             /* Message has been successfully delivered. i.e. PushBytes is complete
              */
             internal->lock.Lock(MUTEX_CONTEXT);
-            internal->txQueue.pop_back();
+            internal->PopTx();
             internal->getNextMsg = true;
             internal->lock.Unlock(MUTEX_CONTEXT);
         }
@@ -779,13 +1009,97 @@ QStatus _RemoteEndpoint::WriteCallback(qcc::Sink& sink, bool isTimedOut) {
     return status;
 }
 
+size_t _RemoteEndpoint::GatherTxBatch()
+{
+    static const size_t MAX_TX_BATCH_MESSAGES = 64;
+
+    size_t limit = internal->bus.GetInternal().GetTxBatchLimit();
+    if ((limit == 0) || !internal->isSocket) {
+        return 0;
+    }
+    /*
+     * Only batch a run of at least two messages at the head of the queue that fit within
+     * the byte budget. Messages with handles, messages that still need to be encrypted
+     * and expired messages must go through DeliverNonBlocking.
+     */
+    size_t count = 0;
+    size_t total = 0;
+    deque<Message>::reverse_iterator it = internal->txQueue.rbegin();
+    while ((it != internal->txQueue.rend()) && (count < MAX_TX_BATCH_MESSAGES)) {
+        const uint8_t* buf;
+        size_t len;
+        if (!(*it)->GetDeliveryBuffer(buf, len) || ((total + len) > limit)) {
+            break;
+        }
+        total += len;
+        ++count;
+        ++it;
+    }
+    if (count < 2) {
+        return 0;
+    }
+    internal->txBatchIov.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Message& msg = internal->txQueue.back();
+        const uint8_t* buf;
+        size_t len;
+        msg->GetDeliveryBuffer(buf, len);
+        internal->txBatchIov[i].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(buf));
+        internal->txBatchIov[i].len = len;
+        internal->txBatch.push_back(msg);
+        internal->PopTx();
+    }
+    internal->txBatchPos = 0;
+    return count;
+}
+
+QStatus _RemoteEndpoint::PushTxBatch()
+{
+    QStatus status = ER_OK;
+    Sink& sink = GetSink();
+    vector<IOVec>& iov = internal->txBatchIov;
+    while ((status == ER_OK) && (internal->txBatchPos < iov.size())) {
+        size_t pushed;
+        status = sink.PushBytesSG(&iov[internal->txBatchPos], iov.size() - internal->txBatchPos, pushed);
+        while ((status == ER_OK) && (pushed > 0)) {
+            IOVec& v = iov[internal->txBatchPos];
+            if (pushed >= v.len) {
+                pushed -= v.len;
+                ++internal->txBatchPos;
+            } else {
+                v.buf = static_cast<char*>(v.buf) + pushed;
+                v.len -= pushed;
+                pushed = 0;
+            }
+        }
+    }
+    return status;
+}
+
 QStatus _RemoteEndpoint::PushMessage(Message& msg)
 {
     QCC_DbgTrace(("RemoteEndpoint::PushMessage %s (serial=%d)", GetUniqueName().c_str(), msg->GetCallSerial()));
-    static const size_t MAX_TX_QUEUE_SIZE = 30;
 
+    size_t numPushed;
+    return EnqueueTx(&msg, 1, numPushed);
+}
+
+QStatus _RemoteEndpoint::PushMessages(std::vector<Message>& msgs, size_t& numPushed)
+{
+    QCC_DbgTrace(("RemoteEndpoint::PushMessages %s (count=%d)", GetUniqueName().c_str(), msgs.size()));
+
+    if (msgs.empty()) {
+        numPushed = 0;
+        return ER_OK;
+    }
+    return EnqueueTx(&msgs[0], msgs.size(), numPushed);
+}
+
+QStatus _RemoteEndpoint::EnqueueTx(Message* msgs, size_t numMsgs, size_t& numPushed)
+{
     QStatus status = ER_OK;
 
+    numPushed = 0;
     /* Remote endpoints can be invalid if they were created with the default
      * constructor or being torn down. Return ER_BUS_NO_ENDPOINT only if the
      * endpoint was created with the default constructor. i.e. internal=NULL
@@ -801,70 +1115,88 @@ QStatus _RemoteEndpoint::PushMessage(Message& msg)
     if (internal->stopping) {
         return ER_BUS_ENDPOINT_CLOSING;
     }
+    BusAttachment::Internal& busInternal = internal->bus.GetInternal();
+    size_t maxMessages = busInternal.GetTxQueueMaxMessages();
+    size_t maxBytes = busInternal.GetTxQueueMaxBytes();
+
     internal->lock.Lock(MUTEX_CONTEXT);
-    size_t count = internal->txQueue.size();
-    bool wasEmpty = (count == 0);
-    if (MAX_TX_QUEUE_SIZE > count) {
-        internal->txQueue.push_front(msg);
-    } else {
-        while (true) {
-            /* Remove a queue entry whose TTLs is expired if possible */
+    bool wasEmpty = false;
+    while (numPushed < numMsgs) {
+        if (internal->TxQueueHasRoom(msgs[numPushed]->GetBufferLength(), maxMessages, maxBytes)) {
+            /* Check queue wasn't drained while we were waiting */
+            wasEmpty = wasEmpty || internal->txQueue.empty();
+            internal->PushTx(msgs[numPushed]);
+            ++numPushed;
+            status = ER_OK;
+            continue;
+        }
+        /* Remove a queue entry whose TTLs is expired if possible */
+        uint32_t maxWait = 20 * 1000;
+        if (internal->txQueueTtlCount > 0) {
+            bool removed = false;
             deque<Message>::iterator it = internal->txQueue.begin();
-            uint32_t maxWait = 20 * 1000;
             while (it != internal->txQueue.end()) {
                 uint32_t expMs;
                 if ((*it)->IsExpired(&expMs)) {
-                    internal->txQueue.erase(it);
+                    internal->EraseTx(it);
+                    ++internal->txStats.expired;
+                    removed = true;
                     break;
                 } else {
                     ++it;
                 }
                 maxWait = (std::min)(maxWait, expMs);
             }
-            if (internal->txQueue.size() < MAX_TX_QUEUE_SIZE) {
-                /* Check queue wasn't drained while we were waiting */
-                if (internal->txQueue.size() == 0) {
-                    wasEmpty = true;
-                }
-                internal->txQueue.push_front(msg);
-                status = ER_OK;
-                break;
-            } else {
-                /* This thread will have to wait for room in the queue */
-                Thread* thread = Thread::GetThread();
-                assert(thread);
-
-                thread->AddAuxListener(this);
-                internal->txWaitQueue.push_front(thread);
-                internal->lock.Unlock(MUTEX_CONTEXT);
-                status = Event::Wait(Event::neverSet, maxWait);
-                internal->lock.Lock(MUTEX_CONTEXT);
+            if (removed) {
+                continue;
+            }
+        }
+        if (busInternal.IsTxQueueNonBlocking() && IsDroppable(msgs[numPushed])) {
+            /* Drop the signal rather than stall the caller behind a slow consumer */
+            ++internal->txStats.dropped;
+            status = ER_BUS_WRITE_QUEUE_FULL;
+            break;
+        }
+        /*
+         * Messages queued earlier in this call may have filled an empty queue. The writer must
+         * be started before waiting or nothing would drain the queue.
+         */
+        if (wasEmpty) {
+            busInternal.GetIODispatch().EnableWriteCallbackNow(internal->stream);
+            wasEmpty = false;
+        }
 
-                /* Reset alert status */
-                if (ER_ALERTED_THREAD == status) {
-                    if (thread->GetAlertCode() == ENDPOINT_IS_DEAD_ALERTCODE) {
-                        status = ER_BUS_ENDPOINT_CLOSING;
-                    }
-                    thread->GetStopEvent().ResetEvent();
-                }
-                /* Remove thread from wait queue. */
-                thread->RemoveAuxListener(this);
-                deque<Thread*>::iterator eit = find(internal->txWaitQueue.begin(), internal->txWaitQueue.end(), thread);
-                if (eit != internal->txWaitQueue.end()) {
-                    internal->txWaitQueue.erase(eit);
-                }
+        /* This thread will have to wait for room in the queue */
+        Thread* thread = Thread::GetThread();
+        assert(thread);
 
-                if ((ER_OK != status) && (ER_ALERTED_THREAD != status) && (ER_TIMEOUT != status)) {
-                    break;
-                }
+        thread->AddAuxListener(this);
+        internal->txWaitQueue.push_front(thread);
+        internal->lock.Unlock(MUTEX_CONTEXT);
+        status = Event::Wait(Event::neverSet, maxWait);
+        internal->lock.Lock(MUTEX_CONTEXT);
 
+        /* Reset alert status */
+        if (ER_ALERTED_THREAD == status) {
+            if (thread->GetAlertCode() == ENDPOINT_IS_DEAD_ALERTCODE) {
+                status = ER_BUS_ENDPOINT_CLOSING;
             }
+            thread->GetStopEvent().ResetEvent();
+        }
+        /* Remove thread from wait queue. */
+        thread->RemoveAuxListener(this);
+        deque<Thread*>::iterator eit = find(internal->txWaitQueue.begin(), internal->txWaitQueue.end(), thread);
+        if (eit != internal->txWaitQueue.end()) {
+            internal->txWaitQueue.erase(eit);
         }
-    }
 
+        if ((ER_OK != status) && (ER_ALERTED_THREAD != status) && (ER_TIMEOUT != status)) {
+            break;
+        }
+    }
 
     if (wasEmpty) {
-        internal->bus.GetInternal().GetIODispatch().EnableWriteCallbackNow(internal->stream);
+        busInternal.GetIODispatch().EnableWriteCallbackNow(internal->stream);
     }
     internal->lock.Unlock(MUTEX_CONTEXT);
 #ifndef NDEBUG
@@ -873,7 +1205,10 @@ QStatus _RemoteEndpoint::PushMessage(Message& msg)
     static uint32_t lastTime = 0;
     uint32_t now = GetTimestamp();
     if ((now - lastTime) > 1000) {
-        QCC_DbgPrintf(("Tx queue size (%s) = %d", GetUniqueName().c_str(), count));
+        TxQueueStats stats;
+        GetTxQueueStats(stats);
+        QCC_DbgPrintf(("Tx queue size (%s) = %d, %d bytes (high-water %d, %d bytes, dropped %d)", GetUniqueName().c_str(),
+                       stats.depth, stats.bytes, stats.highWaterDepth, stats.highWaterBytes, stats.dropped));
         lastTime = now;
     }
 #undef QCC_MODULE
@@ -882,6 +1217,31 @@ QStatus _RemoteEndpoint::PushMessage(Message& msg)
     return status;
 }
 
+void _RemoteEndpoint::AddRttSample(uint32_t sample)
+{
+    if (!internal) {
+        return;
+    }
+    /* Same gain as TCP's SRTT; a measured round trip time never smooths down to 0 which means unmeasured */
+    internal->lock.Lock(MUTEX_CONTEXT);
+    internal->rtt = (std::max)(internal->rtt ? ((7 * internal->rtt + sample) / 8) : sample, 1U);
+    internal->lock.Unlock(MUTEX_CONTEXT);
+}
+
+void _RemoteEndpoint::GetTxQueueStats(TxQueueStats& stats)
+{
+    if (internal) {
+        internal->lock.Lock(MUTEX_CONTEXT);
+        stats = internal->txStats;
+        stats.depth = internal->txQueue.size();
+        stats.bytes = internal->txQueueBytes;
+        stats.rtt = internal->rtt;
+        internal->lock.Unlock(MUTEX_CONTEXT);
+    } else {
+        stats = TxQueueStats();
+    }
+}
+
 void _RemoteEndpoint::IncrementRef()
 {
     int refs = IncrementAndFetch(&internal->refCount);
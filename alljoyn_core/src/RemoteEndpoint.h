@@ -24,6 +24,7 @@
 #include <qcc/platform.h>
 
 #include <deque>
+#include <vector>
 
 #include <qcc/atomic.h>
 #include <qcc/String.h>
@@ -40,6 +41,8 @@
 namespace ajn {
 
 class _RemoteEndpoint;
+class EndpointAuth;
+class MessageBufferPool;
 
 /**
  * Managed object type that wraps a remote endpoint
@@ -118,6 +121,21 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
         virtual void EndpointExit(RemoteEndpoint& ep) = 0;
     };
 
+    /**
+     * Transmit queue statistics of a remote endpoint.
+     */
+    struct TxQueueStats {
+        size_t depth;              /**< Number of messages in the transmit queue */
+        size_t bytes;              /**< Number of bytes in the transmit queue */
+        size_t highWaterDepth;     /**< Largest number of messages that have been in the transmit queue */
+        size_t highWaterBytes;     /**< Largest number of bytes that have been in the transmit queue */
+        uint32_t expired;          /**< Number of expired messages removed to make room in a full transmit queue */
+        uint32_t dropped;          /**< Number of messages dropped because the transmit queue was full */
+        uint32_t rtt;              /**< Smoothed round trip time in ms of idle probes or 0 if none has been answered */
+
+        TxQueueStats() : depth(0), bytes(0), highWaterDepth(0), highWaterBytes(0), expired(0), dropped(0), rtt(0) { }
+    };
+
     /**
      * Called when a new untrusted client has connected to the daemon.
      * This calls into the transport's UntrustedClientStart function
@@ -165,6 +183,33 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     virtual QStatus PushMessage(Message& msg);
 
+    /**
+     * Send a sequence of outgoing messages. The messages are added to the transmit queue in
+     * order under a single acquisition of the endpoint lock, waiting for room in the queue in
+     * the same way as PushMessage() does.
+     *
+     * @param msgs            Messages to be sent.
+     * @param[out] numPushed  Returns the number of messages, from the start of msgs, that were queued.
+     * @return
+     *      - ER_OK if all of the messages were queued.
+     *      - An error status otherwise
+     */
+    QStatus PushMessages(std::vector<Message>& msgs, size_t& numPushed);
+
+    /**
+     * Add a round trip time measurement to the smoothed round trip time of this endpoint.
+     *
+     * @param sample  The measured round trip time in ms.
+     */
+    void AddRttSample(uint32_t sample);
+
+    /**
+     * Get the transmit queue statistics of this endpoint.
+     *
+     * @param[out] stats  The transmit queue statistics.
+     */
+    void GetTxQueueStats(TxQueueStats& stats);
+
     /**
      * Start the endpoint.
      *
@@ -272,6 +317,41 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     QStatus Establish(const qcc::String& authMechanisms, qcc::String& authUsed, qcc::String& redirection, AuthListener* listener = NULL);
 
+    /**
+     * Start establishing an incoming connection without blocking. The caller then calls
+     * ContinueAccept() whenever the endpoint's stream has data to read until it returns
+     * something other than ER_WOULDBLOCK.
+     *
+     * @param authMechanisms  The authentication mechanism(s) to accept.
+     * @param listener        Optional authentication listener
+     *
+     * @return
+     *      - ER_OK if successful.
+     *      - An error status otherwise
+     */
+    QStatus StartAccept(const qcc::String& authMechanisms, AuthListener* listener = NULL);
+
+    /**
+     * Continue establishing an incoming connection started with StartAccept() using whatever
+     * data is available on the endpoint's stream.
+     *
+     * @param authUsed        [OUT]    Returns the name of the authentication method
+     *                                 that was used to establish the connection.
+     *
+     * @return
+     *      - ER_OK if the connection has been established.
+     *      - ER_WOULDBLOCK if more data is needed.
+     *      - An error status otherwise
+     */
+    QStatus ContinueAccept(qcc::String& authUsed);
+
+    /**
+     * Abandon an establishment started with StartAccept(). The endpoint holds a reference to
+     * itself while an establishment is in progress so this must be called if the establishment
+     * is given up before ContinueAccept() has completed it.
+     */
+    void AbortAccept();
+
     /**
      * Get the GUID of the remote side of a bus-to-bus endpoint.
      *
@@ -308,6 +388,31 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     qcc::Source& GetSource() { return GetStream(); }
 
+    /**
+     * Pull bytes through the receive buffer of this endpoint. The receive buffer is filled
+     * with a single large read from the stream so that a burst of small messages can be
+     * parsed out of it without a read on the stream for each header and body. Requests that
+     * are at least as large as the receive buffer bypass it.
+     *
+     * Bytes that have been buffered can only be consumed with this method so the stream must
+     * not be read directly once this method has been called.
+     *
+     * @param buf          Buffer to store pulled bytes.
+     * @param reqBytes     Number of bytes requested.
+     * @param actualBytes  Returns the number of bytes pulled.
+     * @param timeout      Timeout in milliseconds for reading the stream.
+     *
+     * @return  ER_OK if any bytes were pulled, otherwise the status from the stream.
+     */
+    QStatus PullBufferedBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = 0);
+
+    /**
+     * Get the pool that small messages read through the receive buffer borrow their buffers from.
+     *
+     * @return  The pool or NULL if the endpoint is invalid.
+     */
+    MessageBufferPool* GetBufferPool();
+
     /**
      * Get the data sink for this endpoint
      *
@@ -449,6 +554,39 @@ class _RemoteEndpoint : public _BusEndpoint, public qcc::ThreadListener, public
      */
     bool IsProbeMsg(const Message& msg, bool& isAck);
 
+    /**
+     * Move a run of queued messages that can be written with a single vectored write from
+     * the transmit queue to the transmit batch. Must be called with the endpoint lock held.
+     *
+     * @return  Number of messages moved or 0 if the next message must be written on its own.
+     */
+    size_t GatherTxBatch();
+
+    /**
+     * Add messages to the transmit queue, waiting for room in the queue as needed.
+     *
+     * @param msgs            Array of messages to be queued.
+     * @param numMsgs         Number of messages in msgs.
+     * @param[out] numPushed  Returns the number of messages that were queued.
+     * @return  ER_OK if all of the messages were queued, otherwise an error status.
+     */
+    QStatus EnqueueTx(Message* msgs, size_t numMsgs, size_t& numPushed);
+
+    /**
+     * Record the names and features negotiated by a successful establishment.
+     *
+     * @param auth      The endpoint authenticator that established the connection.
+     * @param authUsed  The authentication mechanism that was used.
+     */
+    void SetEstablished(const EndpointAuth& auth, const qcc::String& authUsed);
+
+    /**
+     * Write the unwritten part of the transmit batch to the endpoint sink.
+     *
+     * @return  ER_OK if the whole batch has been written, otherwise the status from the sink.
+     */
+    QStatus PushTxBatch();
+
     /**
      * Internal callback used to indicate that data is available on the File descriptor.
      * RemoteEndpoint users should not call this method.
@@ -24,6 +24,7 @@
 #include <qcc/platform.h>
 #include <qcc/Debug.h>
 #include <qcc/String.h>
+#include <qcc/Thread.h>
 
 #include <list>
 
@@ -33,9 +34,24 @@
 #define QCC_MODULE "ALLJOYN"
 
 using namespace std;
+using namespace qcc;
 
 namespace ajn {
 
+SignalTable::SignalTable()
+{
+    for (size_t i = 0; i < DISPATCH_BUCKETS; ++i) {
+        dispatch[i] = NULL;
+    }
+}
+
+SignalTable::~SignalTable()
+{
+    for (size_t i = 0; i < DISPATCH_BUCKETS; ++i) {
+        ReleaseDispatch(dispatch[i]);
+    }
+}
+
 void SignalTable::Add(MessageReceiver* receiver,
                       MessageReceiver::SignalHandler handler,
                       const InterfaceDescription::Member* member,
@@ -46,10 +62,19 @@ void SignalTable::Add(MessageReceiver* receiver,
                   member->name.c_str(),
                   sourcePath.c_str()));
     Entry entry(handler, receiver, member);
-    Key key(sourcePath, member->iface->GetName(), member->name);
+    Key key(sourcePath, AtomTable::Intern(member->iface->GetName()), AtomTable::Intern(member->name));
+    vector<Dispatch*> retired;
     lock.Lock(MUTEX_CONTEXT);
     hashTable.insert(pair<const Key, Entry>(key, entry));
+    size_t bucket = GetBucket(key.iface, key.signalName);
+    Dispatch* update = new Dispatch();
+    if (dispatch[bucket]) {
+        update->handlers = dispatch[bucket]->handlers;
+    }
+    update->handlers.push_back(Dispatch::Handler(key, entry));
+    PublishDispatch(bucket, update, retired);
     lock.Unlock(MUTEX_CONTEXT);
+    RetireDispatch(retired);
 }
 
 void SignalTable::Remove(MessageReceiver* receiver,
@@ -57,27 +82,47 @@ void SignalTable::Remove(MessageReceiver* receiver,
                          const InterfaceDescription::Member* member,
                          const char* sourcePath)
 {
-    Key key(sourcePath, member->iface->GetName(), member->name.c_str());
+    Key key(sourcePath, AtomTable::Intern(member->iface->GetName()), AtomTable::Intern(member->name));
     iterator iter;
     pair<iterator, iterator> range;
+    vector<Dispatch*> retired;
 
     lock.Lock(MUTEX_CONTEXT);
     range = hashTable.equal_range(key);
     iter = range.first;
     while (iter != range.second) {
         if ((iter->second.object == receiver) && (iter->second.handler == handler)) {
+            /*
+             * Drop the same handler from the snapshot of the signal's bucket
+             */
+            Key removed = iter->first;
             hashTable.erase(iter);
+            size_t bucket = GetBucket(removed.iface, removed.signalName);
+            Dispatch* update = new Dispatch();
+            bool found = false;
+            const vector<Dispatch::Handler>& handlers = dispatch[bucket]->handlers;
+            for (vector<Dispatch::Handler>::const_iterator it = handlers.begin(); it != handlers.end(); ++it) {
+                if (!found && (it->iface == removed.iface) && (it->signalName == removed.signalName) && (strcmp(it->sourcePath.c_str(), removed.sourcePath.c_str()) == 0) &&
+                    (it->entry.object == receiver) && (it->entry.handler == handler)) {
+                    found = true;
+                } else {
+                    update->handlers.push_back(*it);
+                }
+            }
+            PublishDispatch(bucket, update, retired);
             break;
         } else {
             ++iter;
         }
     }
     lock.Unlock(MUTEX_CONTEXT);
+    RetireDispatch(retired);
 }
 
 void SignalTable::RemoveAll(MessageReceiver* receiver)
 {
     bool removed;
+    vector<Dispatch*> retired;
     lock.Lock(MUTEX_CONTEXT);
     do {
         removed = false;
@@ -89,16 +134,87 @@ void SignalTable::RemoveAll(MessageReceiver* receiver)
             }
         }
     } while (removed);
+    /*
+     * Republish only the buckets that had handlers for this receiver
+     */
+    for (size_t bucket = 0; bucket < DISPATCH_BUCKETS; ++bucket) {
+        if (!dispatch[bucket]) {
+            continue;
+        }
+        const vector<Dispatch::Handler>& handlers = dispatch[bucket]->handlers;
+        Dispatch* update = NULL;
+        for (vector<Dispatch::Handler>::const_iterator it = handlers.begin(); it != handlers.end(); ++it) {
+            if ((it->entry.object == receiver) && !update) {
+                update = new Dispatch();
+                update->handlers.assign(handlers.begin(), it);
+            } else if ((it->entry.object != receiver) && update) {
+                update->handlers.push_back(*it);
+            }
+        }
+        if (update) {
+            PublishDispatch(bucket, update, retired);
+        }
+    }
     lock.Unlock(MUTEX_CONTEXT);
+    RetireDispatch(retired);
 }
 
 pair<SignalTable::const_iterator, SignalTable::const_iterator> SignalTable::Find(const char* sourcePath,
-                                                                                 const char* iface,
-                                                                                 const char* signalName)
+                                                                                 Atom iface,
+                                                                                 Atom signalName)
 {
     Key key(sourcePath, iface, signalName);
     return hashTable.equal_range(key);
 }
 
+void SignalTable::PublishDispatch(size_t bucket, Dispatch* update, vector<Dispatch*>& retired)
+{
+    if (update->handlers.empty()) {
+        delete update;
+        update = NULL;
+    }
+    Dispatch* old = dispatch[bucket];
+    /*
+     * The new snapshot must be complete before it is published
+     */
+    MemoryFence();
+    dispatch[bucket] = update;
+    if (old) {
+        retired.push_back(old);
+    }
+}
+
+void SignalTable::RetireDispatch(const vector<Dispatch*>& retired)
+{
+    if (retired.empty()) {
+        return;
+    }
+    /*
+     * The snapshots were unpublished before this so once the threads already in
+     * AcquireDispatch() have left nobody can still pick up a retired one.
+     */
+    acquiring.Synchronize();
+    for (size_t i = 0; i < retired.size(); ++i) {
+        ReleaseDispatch(retired[i]);
+    }
+}
+
+const SignalTable::Dispatch* SignalTable::AcquireDispatch(Atom iface, Atom signalName)
+{
+    Reclaimer::ScopedReader reader(acquiring);
+    Dispatch* current = dispatch[GetBucket(iface, signalName)];
+    if (current) {
+        IncrementAndFetch(&current->refs);
+    }
+    return current;
+}
+
+void SignalTable::ReleaseDispatch(const Dispatch* dispatch)
+{
+    Dispatch* d = const_cast<Dispatch*>(dispatch);
+    if (d && (DecrementAndFetch(&d->refs) == 0)) {
+        delete d;
+    }
 }
 
+}
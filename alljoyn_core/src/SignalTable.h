@@ -26,13 +26,16 @@
 #endif
 
 #include <qcc/platform.h>
-#include <qcc/StringMapKey.h>
 
+#include <string.h>
 #include <vector>
 
 #include <qcc/String.h>
-#include <qcc/StringMapKey.h>
+#include <qcc/AtomTable.h>
+#include <qcc/atomic.h>
 #include <qcc/Mutex.h>
+#include <qcc/Reclaimer.h>
+#include <qcc/StringMapKey.h>
 
 #include <alljoyn/InterfaceDescription.h>
 #include <alljoyn/MessageReceiver.h>
@@ -51,23 +54,24 @@ class SignalTable {
   public:
 
     /**
-     * Type definition for signal hash table key
+     * Type definition for signal hash table key. Source paths are kept as strings rather than
+     * atoms because atoms are never freed.
      */
     struct Key {
-        qcc::StringMapKey sourcePath;           /**< The object path of the signal sender */
-        qcc::StringMapKey iface;                /**< The Interface name */
-        qcc::StringMapKey signalName;           /**< The signal name */
+        qcc::StringMapKey sourcePath;   /**< The object path of the signal sender */
+        qcc::Atom iface;                /**< Atom for the Interface name */
+        qcc::Atom signalName;           /**< Atom for the signal name */
 
         /**
          * Constructor used for lookups only (no storage)
          */
-        Key(const char* src, const char* ifc, const char* sig)
-            : sourcePath(src), iface(ifc), signalName(sig) { }
+        Key(const char* src, qcc::Atom ifc, qcc::Atom sig)
+            : sourcePath(src ? src : ""), iface(ifc), signalName(sig) { }
 
         /**
          * Constructor used for storage into hash table (no dangling char*)
          */
-        Key(const qcc::String& src, const qcc::String& ifc, const qcc::String& sig)
+        Key(const qcc::String& src, qcc::Atom ifc, qcc::Atom sig)
             : sourcePath(src), iface(ifc), signalName(sig) { }
     };
 
@@ -98,14 +102,7 @@ class SignalTable {
         /** Calculate hash for Key k */
         size_t operator()(const Key& k) const {
             /* source path cannot factor into hash because a key with no sourcepath is considered equal to one that does */
-            size_t hash = 0;
-            for (const char* p = k.signalName.c_str(); *p; ++p) {
-                hash = *p + hash * 11;
-            }
-            for (const char* p = k.iface.c_str(); *p; ++p) {
-                hash += *p * 7;
-            }
-            return hash;
+            return static_cast<size_t>(k.signalName) * 11 + static_cast<size_t>(k.iface) * 7;
         }
     };
 
@@ -114,12 +111,10 @@ class SignalTable {
         /** Return true two keys are equal */
         bool operator()(const Key& k1, const Key& k2) const {
             /* If either source path is null, then this field should be treated as don't care */
-            if ((k1.sourcePath.empty()) || (k2.sourcePath.empty())) {
-                return (0 == strcmp(k1.iface.c_str(), k2.iface.c_str())) && (0 == strcmp(k1.signalName.c_str(), k2.signalName.c_str()));
+            if (k1.sourcePath.empty() || k2.sourcePath.empty()) {
+                return (k1.iface == k2.iface) && (k1.signalName == k2.signalName);
             } else {
-                return (0 == strcmp(k1.iface.c_str(), k2.iface.c_str())) && \
-                       (0 == strcmp(k1.signalName.c_str(), k2.signalName.c_str())) && \
-                       (0 == strcmp(k1.sourcePath.c_str(), k2.sourcePath.c_str()));
+                return (k1.iface == k2.iface) && (k1.signalName == k2.signalName) && (k1.sourcePath == k2.sourcePath);
             }
         }
     };
@@ -134,6 +129,70 @@ class SignalTable {
      */
     typedef std::unordered_multimap<Key, Entry, Hash, Equal>::const_iterator const_iterator;
 
+    /**
+     * Immutable snapshot of the signal handlers in one bucket of signals. The signals are spread
+     * over a fixed number of buckets by interface and signal name, and adding or removing a
+     * handler builds and publishes a new snapshot of just that bucket. Incoming signals are
+     * dispatched from the snapshot without taking the signal table lock.
+     */
+    class Dispatch {
+      public:
+
+        /**
+         * A signal handler and the signal it was registered for.
+         */
+        struct Handler {
+            qcc::Atom iface;        /**< Atom for the interface */
+            qcc::Atom signalName;   /**< Atom for the signal name */
+            qcc::String sourcePath; /**< The source path or empty for all paths */
+            Entry entry;            /**< The signal handler */
+
+            /**
+             * Construct a Handler
+             */
+            Handler(const Key& key, const Entry& entry) :
+                iface(key.iface), signalName(key.signalName), sourcePath(key.sourcePath.c_str()), entry(entry) { }
+
+            /**
+             * Check if this handler should be called for a signal.
+             *
+             * @param iface        Atom for the interface of the signal.
+             * @param signalName   Atom for the signal name.
+             * @param sourcePath   The object path of the signal sender.
+             */
+            bool Matches(qcc::Atom iface, qcc::Atom signalName, const char* sourcePath) const {
+                return (this->iface == iface) && (this->signalName == signalName) &&
+                       (this->sourcePath.empty() || (strcmp(this->sourcePath.c_str(), sourcePath) == 0));
+            }
+        };
+
+        /**
+         * The handlers for all signals in the bucket in the order they were added. The caller
+         * must check each handler with Handler::Matches().
+         */
+        const std::vector<Handler>& GetHandlers() const { return handlers; }
+
+      private:
+
+        friend class SignalTable;
+
+        Dispatch() : refs(1) { }
+
+        std::vector<Handler> handlers;  /**< Handlers for the signals in this bucket */
+
+        volatile int32_t refs;  /**< References held by the signal table and by dispatching threads */
+    };
+
+    /**
+     * Constructor
+     */
+    SignalTable();
+
+    /**
+     * Destructor
+     */
+    ~SignalTable();
+
     /**
      * Add an entry to the signal hash table.
      *
@@ -172,12 +231,31 @@ class SignalTable {
      * Signal table lock should be held until iterators are no longer in use.
      *
      * @param sourcePath   The object path of the signal sender.
-     * @param iface    The interface.
-     * @param signalName   The signal name.
+     * @param iface        Atom for the interface.
+     * @param signalName   Atom for the signal name.
      *
      * @return   Iterator range of entries with matching criteria.
      */
-    std::pair<const_iterator, const_iterator> Find(const char* sourcePath, const char* iface, const char* signalName);
+    std::pair<const_iterator, const_iterator> Find(const char* sourcePath, qcc::Atom iface, qcc::Atom signalName);
+
+    /**
+     * Get a reference to the current dispatch snapshot of the bucket that holds the handlers for
+     * a signal. This does not take the signal table lock. The snapshot remains valid until it is
+     * released with ReleaseDispatch() even if handlers are added or removed in the meantime.
+     *
+     * @param iface        Atom for the interface.
+     * @param signalName   Atom for the signal name.
+     *
+     * @return  The dispatch snapshot or NULL if there are no handlers in the bucket.
+     */
+    const Dispatch* AcquireDispatch(qcc::Atom iface, qcc::Atom signalName);
+
+    /**
+     * Release a reference obtained from AcquireDispatch().
+     *
+     * @param dispatch   The dispatch snapshot to release, may be NULL.
+     */
+    static void ReleaseDispatch(const Dispatch* dispatch);
 
     /**
      * Get the lock that protects the signal table.
@@ -191,10 +269,51 @@ class SignalTable {
 
   private:
 
+    /**
+     * Private copy constructor to prevent copying.
+     */
+    SignalTable(const SignalTable& other);
+
+    /**
+     * Private assignment operator to prevent assignment.
+     */
+    SignalTable& operator=(const SignalTable& other);
+
+    /**
+     * Number of buckets the dispatch snapshots are split into
+     */
+    static const size_t DISPATCH_BUCKETS = 64;
+
+    /**
+     * Get the bucket for a signal.
+     */
+    static size_t GetBucket(qcc::Atom iface, qcc::Atom signalName) {
+        return Hash()(Key("", iface, signalName)) % DISPATCH_BUCKETS;
+    }
+
+    /**
+     * Publish a new dispatch snapshot for a bucket. Must be called with the signal table lock
+     * held. The snapshot it replaces is added to retired.
+     *
+     * @param bucket    The bucket.
+     * @param update    The new snapshot, deleted and replaced by NULL if it has no handlers.
+     * @param retired   Snapshots to pass to RetireDispatch() after the lock is released.
+     */
+    void PublishDispatch(size_t bucket, Dispatch* update, std::vector<Dispatch*>& retired);
+
+    /**
+     * Wait until no thread can still pick up the retired snapshots and drop the references held
+     * by the signal table. Must be called without the signal table lock held.
+     */
+    void RetireDispatch(const std::vector<Dispatch*>& retired);
+
     qcc::Mutex lock; /**< Lock protecting the signal table */
 
     /**  The hash table */
     std::unordered_multimap<Key, Entry, Hash, Equal> hashTable;
+
+    Dispatch* volatile dispatch[DISPATCH_BUCKETS];  /**< The current dispatch snapshot of each bucket */
+    qcc::Reclaimer acquiring;                       /**< Threads in AcquireDispatch() */
 };
 
 }
@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Session.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <AllJoynObj.h>
+#include <VirtualEndpoint.h>
+
+#include "RouterTestSetup.h"
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace qcc;
+using namespace std;
+
+namespace ajn {
+
+class AllJoynObjTest : public testing::Test {
+  public:
+    AllJoynObjTest() : remote("AllJoynObjTestRemote", false), ajObj(NULL) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, router.Start());
+        ASSERT_EQ(ER_OK, remote.Start());
+        ajObj = &router.GetBusController().GetAllJoynObj();
+    }
+
+    /*
+     * Add a session map entry the way JoinSession and AttachSession do
+     */
+    void Join(const qcc::String& name, SessionId id, const qcc::String& host, const vector<qcc::String>& members, bool isMultipoint = true)
+    {
+        AllJoynObj::SessionMapEntry sme;
+        sme.endpointName = name;
+        sme.id = id;
+        sme.sessionHost = host;
+        sme.opts.isMultipoint = isMultipoint;
+        sme.memberNames = members;
+        ajObj->AcquireLocks();
+        ajObj->SessionMapInsert(sme);
+        ajObj->ReleaseLocks();
+    }
+
+    void AddMember(const qcc::String& name, SessionId id, const qcc::String& member)
+    {
+        ajObj->AcquireLocks();
+        AllJoynObj::SessionMapEntry* sme = ajObj->SessionMapFind(name, id);
+        ASSERT_TRUE(sme != NULL);
+        ajObj->SessionMapAddMember(*sme, member);
+        ajObj->ReleaseLocks();
+    }
+
+    void Leave(const qcc::String& name, SessionId id)
+    {
+        ajObj->RemoveSessionRefs(name.c_str(), id, false);
+    }
+
+    VirtualEndpoint AddVirtualEndpoint(const qcc::String& name, RemoteEndpoint& b2bEp)
+    {
+        ajObj->AddVirtualEndpoint(name, b2bEp->GetUniqueName());
+        return ajObj->FindVirtualEndpoint(name);
+    }
+
+    bool IsVirtualEndpoint(const qcc::String& name)
+    {
+        return ajObj->FindVirtualEndpoint(name)->IsValid();
+    }
+
+    vector<qcc::String> MembersOf(const qcc::String& name, SessionId id)
+    {
+        vector<qcc::String> members;
+        ajObj->AcquireLocks();
+        AllJoynObj::SessionMapEntry* sme = ajObj->SessionMapFind(name, id);
+        if (sme) {
+            members = sme->memberNames;
+        }
+        ajObj->ReleaseLocks();
+        return members;
+    }
+
+    bool HasEntry(const qcc::String& name, SessionId id)
+    {
+        ajObj->AcquireLocks();
+        bool found = ajObj->SessionMapFind(name, id) != NULL;
+        ajObj->ReleaseLocks();
+        return found;
+    }
+
+    /*
+     * Sessions a name is indexed under
+     */
+    set<SessionId> SessionsOf(const qcc::String& name)
+    {
+        set<SessionId> ids;
+        ajObj->AcquireLocks();
+        map<qcc::String, set<SessionId> >::const_iterator it = ajObj->sessionNameIndex.find(name);
+        if (it != ajObj->sessionNameIndex.end()) {
+            ids = it->second;
+        }
+        ajObj->ReleaseLocks();
+        return ids;
+    }
+
+    size_t NumIndexedEntries(SessionId id)
+    {
+        vector<AllJoynObj::SessionMapType::iterator> entries;
+        ajObj->AcquireLocks();
+        ajObj->SessionMapIdEntries(id, entries);
+        ajObj->ReleaseLocks();
+        return entries.size();
+    }
+
+    /*
+     * Check that the indexes describe exactly the entries of sessionMap
+     */
+    void CheckIndexes()
+    {
+        ajObj->AcquireLocks();
+        size_t numEntries = 0;
+        for (AllJoynObj::SessionMapType::iterator it = ajObj->sessionMap.begin(); it != ajObj->sessionMap.end(); ++it) {
+            SessionId id = it->first.second;
+            if (id == 0) {
+                continue;
+            }
+            ++numEntries;
+            unordered_map<SessionId, AllJoynObj::SessionIndexEntry>::iterator iit = ajObj->sessionIdIndex.find(id);
+            ASSERT_TRUE(iit != ajObj->sessionIdIndex.end()) << "session " << id << " is not indexed";
+            const AllJoynObj::SessionIndexEntry& ie = iit->second;
+            ASSERT_GT(ie.entries.size(), it->second.indexPos);
+            EXPECT_TRUE(ie.entries[it->second.indexPos] == it) << it->first.first.c_str() << " is indexed at the wrong position";
+            EXPECT_EQ(1U, ie.names.count(it->second.endpointName));
+            if (!it->second.sessionHost.empty()) {
+                EXPECT_EQ(1U, ie.names.count(it->second.sessionHost));
+            }
+            for (size_t i = 0; i < it->second.memberNames.size(); ++i) {
+                EXPECT_EQ(1U, ie.names.count(it->second.memberNames[i]));
+            }
+        }
+
+        size_t numIndexed = 0;
+        for (unordered_map<SessionId, AllJoynObj::SessionIndexEntry>::iterator iit = ajObj->sessionIdIndex.begin(); iit != ajObj->sessionIdIndex.end(); ++iit) {
+            EXPECT_FALSE(iit->second.entries.empty());
+            numIndexed += iit->second.entries.size();
+            for (set<qcc::String>::const_iterator nit = iit->second.names.begin(); nit != iit->second.names.end(); ++nit) {
+                EXPECT_EQ(1U, ajObj->sessionNameIndex[*nit].count(iit->first)) << nit->c_str() << " is missing session " << iit->first;
+            }
+        }
+        EXPECT_EQ(numEntries, numIndexed);
+
+        for (map<qcc::String, set<SessionId> >::iterator sit = ajObj->sessionNameIndex.begin(); sit != ajObj->sessionNameIndex.end(); ++sit) {
+            EXPECT_FALSE(sit->second.empty());
+            for (set<SessionId>::const_iterator iit = sit->second.begin(); iit != sit->second.end(); ++iit) {
+                unordered_map<SessionId, AllJoynObj::SessionIndexEntry>::iterator ie = ajObj->sessionIdIndex.find(*iit);
+                ASSERT_TRUE(ie != ajObj->sessionIdIndex.end()) << sit->first.c_str() << " has stale session " << *iit;
+                EXPECT_EQ(1U, ie->second.names.count(sit->first));
+            }
+        }
+        ajObj->ReleaseLocks();
+    }
+
+    RouterTestSetup router;
+    BusAttachment remote;
+    AllJoynObj* ajObj;
+};
+
+static vector<qcc::String> Names(const qcc::String& a, const qcc::String& b = "", const qcc::String& c = "", const qcc::String& d = "")
+{
+    vector<qcc::String> names;
+    names.push_back(a);
+    if (!b.empty()) {
+        names.push_back(b);
+    }
+    if (!c.empty()) {
+        names.push_back(c);
+    }
+    if (!d.empty()) {
+        names.push_back(d);
+    }
+    return names;
+}
+
+TEST_F(AllJoynObjTest, SessionIndexesFollowJoinLeaveAndBusToBusTeardown)
+{
+    RemoteEndpoint a, b, c, link;
+    ASSERT_EQ(ER_OK, router.AddClient(a));
+    ASSERT_EQ(ER_OK, router.AddClient(b));
+    ASSERT_EQ(ER_OK, router.AddClient(c));
+    ASSERT_EQ(ER_OK, router.AddBusToBus(remote, link));
+    qcc::String A = a->GetUniqueName();
+    qcc::String B = b->GetUniqueName();
+    qcc::String C = c->GetUniqueName();
+
+    /* Two members of the remote node are reached through the bus-to-bus link */
+    qcc::String remoteName = ":" + remote.GetInternal().GetGlobalGUID().ToShortString();
+    qcc::String V1 = remoteName + ".2";
+    qcc::String V2 = remoteName + ".3";
+    VirtualEndpoint v1 = AddVirtualEndpoint(V1, link);
+    VirtualEndpoint v2 = AddVirtualEndpoint(V2, link);
+    ASSERT_TRUE(v1->IsValid());
+    ASSERT_TRUE(v2->IsValid());
+
+    const SessionId S1 = 1001, S2 = 1002, S3 = 1003;
+
+    /* Multipoint session S1 hosted by A, joined by B, C and both remote members */
+    Join(A, S1, A, vector<qcc::String>());
+    AddMember(A, S1, B);
+    Join(B, S1, A, Names(B));
+    AddMember(A, S1, C);
+    AddMember(B, S1, C);
+    Join(C, S1, A, Names(B, C));
+    AddMember(A, S1, V1);
+    AddMember(A, S1, V2);
+    ASSERT_EQ(ER_OK, v1->AddSessionRef(S1, link));
+    ASSERT_EQ(ER_OK, v2->AddSessionRef(S1, link));
+
+    /* Point-to-point session S2 hosted by A and joined by V1 */
+    Join(A, S2, A, Names(V1), false);
+    ASSERT_EQ(ER_OK, v1->AddSessionRef(S2, link));
+
+    /* Session S3 hosted by B and joined by C */
+    Join(B, S3, B, Names(C));
+    Join(C, S3, B, Names(C));
+
+    CheckIndexes();
+    EXPECT_EQ(3U, NumIndexedEntries(S1));
+    EXPECT_EQ(1U, NumIndexedEntries(S2));
+    EXPECT_EQ(2U, NumIndexedEntries(S3));
+    EXPECT_EQ(2U, SessionsOf(A).size());
+    EXPECT_EQ(2U, SessionsOf(V1).size());
+    EXPECT_EQ(2U, SessionsOf(C).size());
+
+    /* C leaves S1 but is still in S3 */
+    Leave(C, S1);
+    CheckIndexes();
+    EXPECT_FALSE(HasEntry(C, S1));
+    EXPECT_EQ(2U, NumIndexedEntries(S1));
+    EXPECT_TRUE(HasEntry(C, S3));
+
+    /* B leaving S3 leaves C alone in it, which ends the session */
+    Leave(B, S3);
+    CheckIndexes();
+    EXPECT_EQ(0U, NumIndexedEntries(S3));
+    EXPECT_EQ(0U, SessionsOf(C).count(S3));
+    EXPECT_EQ(0U, SessionsOf(B).count(S3));
+
+    /* Losing the link takes both remote members out of S1 and ends S2 */
+    router.Remove(link);
+    CheckIndexes();
+    EXPECT_FALSE(IsVirtualEndpoint(V1));
+    EXPECT_EQ(0U, NumIndexedEntries(S2));
+    EXPECT_EQ(0U, SessionsOf(A).count(S2));
+    ASSERT_TRUE(HasEntry(A, S1));
+    EXPECT_EQ(Names(B), MembersOf(A, S1));
+
+    /* The last member leaving ends S1 */
+    Leave(B, S1);
+    CheckIndexes();
+    EXPECT_EQ(0U, NumIndexedEntries(S1));
+    EXPECT_TRUE(SessionsOf(A).empty());
+    EXPECT_TRUE(SessionsOf(V1).empty());
+}
+
+TEST_F(AllJoynObjTest, SessionIndexesFollowLargeMultipointTeardown)
+{
+    static const size_t NUM_MEMBERS = 500;
+    const SessionId S = 2001;
+
+    RemoteEndpoint host;
+    ASSERT_EQ(ER_OK, router.AddClient(host));
+    qcc::String H = host->GetUniqueName();
+    Join(H, S, H, vector<qcc::String>());
+
+    vector<RemoteEndpoint> members(NUM_MEMBERS);
+    for (size_t i = 0; i < NUM_MEMBERS; ++i) {
+        ASSERT_EQ(ER_OK, router.AddClient(members[i]));
+        qcc::String M = members[i]->GetUniqueName();
+        AddMember(H, S, M);
+        Join(M, S, H, Names(M));
+    }
+    CheckIndexes();
+    EXPECT_EQ(NUM_MEMBERS + 1, NumIndexedEntries(S));
+
+    /* Members leave in an order unrelated to the order of the index */
+    for (size_t i = 0; i < NUM_MEMBERS; i += 2) {
+        Leave(members[i]->GetUniqueName(), S);
+    }
+    for (size_t i = 1; i < NUM_MEMBERS; i += 2) {
+        Leave(members[NUM_MEMBERS - i]->GetUniqueName(), S);
+        if ((i % 101) == 0) {
+            CheckIndexes();
+        }
+    }
+    CheckIndexes();
+    EXPECT_EQ(0U, NumIndexedEntries(S));
+    EXPECT_TRUE(SessionsOf(H).empty());
+}
+
+}
@@ -0,0 +1,311 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/AllJoynStd.h>
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <BusInternal.h>
+#include <VirtualEndpoint.h>
+
+#include "RouterTestSetup.h"
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+class DaemonRouterTestMessage : public _Message {
+  public:
+    DaemonRouterTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    /*
+     * A signal without a destination that appears to come from sender
+     */
+    QStatus Signal(const char* sender, SessionId id, const char* iface, const char* member, const MsgArg* args, size_t numArgs, uint8_t flags)
+    {
+        qcc::String signature = MsgArg::Signature(args, numArgs);
+        QStatus status = SignalMsg(signature, NULL, id, "/DaemonRouterTest", iface, member, args, numArgs, flags, 0);
+        if ((status == ER_OK) && sender) {
+            status = ReMarshal(sender);
+        }
+        return status;
+    }
+};
+
+class DaemonRouterTest : public testing::Test {
+  public:
+    DaemonRouterTest() :
+        remote1("DaemonRouterTestRemote1", false), remote2("DaemonRouterTestRemote2", false),
+        queuedA(0), queuedB(0), queued1(0), queued2(0), queued3(0)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, router.Start());
+        ASSERT_EQ(ER_OK, remote1.Start());
+        ASSERT_EQ(ER_OK, remote2.Start());
+
+        ASSERT_EQ(ER_OK, router.AddClient(a));
+        ASSERT_EQ(ER_OK, router.AddClient(b));
+
+        /* Two parallel links to the first remote node and one to the second */
+        ASSERT_EQ(ER_OK, router.AddBusToBus(remote1, link1));
+        ASSERT_EQ(ER_OK, router.AddBusToBus(remote1, link2));
+        ASSERT_EQ(ER_OK, router.AddBusToBus(remote2, link3));
+
+        /* Two members on the first remote node and one on the second */
+        v1 = Virtual(remote1, 2, link1);
+        v2 = Virtual(remote1, 3, link1);
+        v3 = Virtual(remote2, 2, link3);
+    }
+
+    VirtualEndpoint Virtual(BusAttachment& remote, int n, RemoteEndpoint& b2bEp)
+    {
+        qcc::String name = ":" + remote.GetInternal().GetGlobalGUID().ToShortString() + "." + U32ToString(n);
+        return VirtualEndpoint(name, b2bEp);
+    }
+
+    QStatus AddRoute(SessionId id, RemoteEndpoint& src, RemoteEndpoint& dest)
+    {
+        BusEndpoint srcEp = BusEndpoint::cast(src);
+        BusEndpoint destEp = BusEndpoint::cast(dest);
+        RemoteEndpoint none;
+        return router.GetRouter().AddSessionRoute(id, srcEp, NULL, destEp, none);
+    }
+
+    QStatus AddRoute(SessionId id, RemoteEndpoint& src, VirtualEndpoint& dest, RemoteEndpoint& b2bEp)
+    {
+        BusEndpoint srcEp = BusEndpoint::cast(src);
+        BusEndpoint destEp = BusEndpoint::cast(dest);
+        return router.GetRouter().AddSessionRoute(id, srcEp, NULL, destEp, b2bEp);
+    }
+
+    QStatus RemoveRoute(SessionId id, RemoteEndpoint& src, VirtualEndpoint& dest)
+    {
+        BusEndpoint srcEp = BusEndpoint::cast(src);
+        BusEndpoint destEp = BusEndpoint::cast(dest);
+        return router.GetRouter().RemoveSessionRoute(id, srcEp, destEp);
+    }
+
+    /*
+     * Session multicast signal from a local client
+     */
+    QStatus SessionCast(RemoteEndpoint& sender, SessionId id)
+    {
+        ManagedObj<DaemonRouterTestMessage> testMsg(router.GetBus());
+        MsgArg arg("u", id);
+        QStatus status = testMsg->Signal(sender->GetUniqueName().c_str(), id, "org.alljoyn.DaemonRouterTest", "Cast", &arg, 1, 0);
+        if (status == ER_OK) {
+            Message msg = Message::cast(testMsg);
+            BusEndpoint senderEp = BusEndpoint::cast(sender);
+            status = router.GetRouter().PushMessage(msg, senderEp);
+        }
+        return status;
+    }
+
+    /*
+     * Global broadcast from this routing node to the others
+     */
+    QStatus GlobalBroadcast(const char* member, const MsgArg* args, size_t numArgs)
+    {
+        ManagedObj<DaemonRouterTestMessage> testMsg(router.GetBus());
+        QStatus status = testMsg->Signal(NULL, 0, org::alljoyn::Daemon::InterfaceName, member, args, numArgs, ALLJOYN_FLAG_GLOBAL_BROADCAST);
+        if (status == ER_OK) {
+            Message msg = Message::cast(testMsg);
+            BusEndpoint localEp = BusEndpoint::cast(router.GetBus().GetInternal().GetLocalEndpoint());
+            status = router.GetRouter().PushMessage(msg, localEp);
+        }
+        return status;
+    }
+
+    QStatus GlobalBroadcast(const char* member)
+    {
+        MsgArg arg("s", member);
+        return GlobalBroadcast(member, &arg, 1);
+    }
+
+    QStatus DetachSession(SessionId id)
+    {
+        MsgArg args[2];
+        args[0].Set("u", id);
+        args[1].Set("s", ":DaemonRouterTest.1");
+        return GlobalBroadcast("DetachSession", args, ArraySize(args));
+    }
+
+    /*
+     * Messages queued on each endpoint since the last call
+     */
+    void Sent(size_t& toA, size_t& toB, size_t& toLink1, size_t& toLink2, size_t& toLink3)
+    {
+        toA = Delta(a, queuedA);
+        toB = Delta(b, queuedB);
+        toLink1 = Delta(link1, queued1);
+        toLink2 = Delta(link2, queued2);
+        toLink3 = Delta(link3, queued3);
+    }
+
+    void ResetSent()
+    {
+        size_t n;
+        Sent(n, n, n, n, n);
+    }
+
+    static size_t Delta(RemoteEndpoint& ep, size_t& last)
+    {
+        size_t queued = RouterTestSetup::QueuedMessages(ep);
+        size_t delta = queued - last;
+        last = queued;
+        return delta;
+    }
+
+    RouterTestSetup router;
+    BusAttachment remote1;
+    BusAttachment remote2;
+    RemoteEndpoint a, b;
+    RemoteEndpoint link1, link2, link3;
+    VirtualEndpoint v1, v2, v3;
+    size_t queuedA, queuedB, queued1, queued2, queued3;
+};
+
+static const SessionId S1 = 3001;
+static const SessionId S2 = 3002;
+
+TEST_F(DaemonRouterTest, SessionCastSendsOnceThroughEachBusToBusEndpoint)
+{
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, b));
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v1, link1));
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v2, link1));
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v3, link3));
+    size_t toA, toB, toLink1, toLink2, toLink3;
+    ResetSent();
+
+    /* v1 and v2 share link1 so the remote node gets one copy for both */
+    EXPECT_EQ(ER_OK, SessionCast(a, S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toA);
+    EXPECT_EQ(1U, toB);
+    EXPECT_EQ(1U, toLink1);
+    EXPECT_EQ(0U, toLink2);
+    EXPECT_EQ(1U, toLink3);
+
+    /* The reverse route takes b's messages to a only */
+    EXPECT_EQ(ER_OK, SessionCast(b, S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toA);
+    EXPECT_EQ(0U, toB + toLink1 + toLink2 + toLink3);
+
+    /* link1 is still needed for v2 */
+    ASSERT_EQ(ER_OK, RemoveRoute(S1, a, v1));
+    EXPECT_EQ(ER_OK, SessionCast(a, S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toB);
+    EXPECT_EQ(1U, toLink1);
+    EXPECT_EQ(1U, toLink3);
+
+    ASSERT_EQ(ER_OK, RemoveRoute(S1, a, v2));
+    EXPECT_EQ(ER_OK, SessionCast(a, S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toB);
+    EXPECT_EQ(0U, toLink1);
+    EXPECT_EQ(1U, toLink3);
+
+    /* Nothing is routed for a session the sender has no routes in */
+    EXPECT_EQ(ER_BUS_NO_ROUTE, SessionCast(a, S2));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toA + toB + toLink1 + toLink2 + toLink3);
+}
+
+TEST_F(DaemonRouterTest, UnregisteredBusToBusEndpointLosesItsRoutes)
+{
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, b));
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v1, link1));
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v3, link3));
+    qcc::String link1Name = link1->GetUniqueName();
+    EXPECT_TRUE(router.GetRouter().FindEndpoint(link1Name)->IsValid());
+    size_t toA, toB, toLink1, toLink2, toLink3;
+
+    router.Remove(link1);
+    EXPECT_FALSE(router.GetRouter().FindEndpoint(link1Name)->IsValid());
+    ResetSent();
+
+    EXPECT_EQ(ER_OK, SessionCast(a, S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toB);
+    EXPECT_EQ(0U, toLink1);
+    EXPECT_EQ(1U, toLink3);
+
+    /* link1 is no longer in the bucket of its session or in the list of all links */
+    EXPECT_EQ(ER_OK, DetachSession(S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toLink1);
+    EXPECT_EQ(1U, toLink3);
+
+    EXPECT_EQ(ER_OK, GlobalBroadcast("DaemonRouterTest"));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toLink1);
+    EXPECT_EQ(1U, toLink2);
+    EXPECT_EQ(1U, toLink3);
+}
+
+TEST_F(DaemonRouterTest, DetachSessionOnlyGoesToTheLinksOfTheSession)
+{
+    /* link1 carries S1, link3 carries S2 and link2 carries no session */
+    ASSERT_EQ(ER_OK, AddRoute(S1, a, v1, link1));
+    ASSERT_EQ(ER_OK, AddRoute(S2, b, v3, link3));
+    EXPECT_EQ(S1, link1->GetSessionId());
+    EXPECT_EQ(0U, link2->GetSessionId());
+    EXPECT_EQ(S2, link3->GetSessionId());
+    size_t toA, toB, toLink1, toLink2, toLink3;
+    ResetSent();
+
+    EXPECT_EQ(ER_OK, DetachSession(S1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toLink1);
+    EXPECT_EQ(0U, toLink2);
+    EXPECT_EQ(0U, toLink3);
+
+    EXPECT_EQ(ER_OK, DetachSession(S2));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toLink1);
+    EXPECT_EQ(0U, toLink2);
+    EXPECT_EQ(1U, toLink3);
+
+    /* No link carries the session */
+    EXPECT_EQ(ER_OK, DetachSession(S2 + 1));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(0U, toLink1 + toLink2 + toLink3);
+
+    /* Other global broadcasts go to every link */
+    EXPECT_EQ(ER_OK, GlobalBroadcast("DaemonRouterTest"));
+    Sent(toA, toB, toLink1, toLink2, toLink3);
+    EXPECT_EQ(1U, toLink1);
+    EXPECT_EQ(1U, toLink2);
+    EXPECT_EQ(1U, toLink3);
+}
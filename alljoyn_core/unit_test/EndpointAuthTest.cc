@@ -0,0 +1,236 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+#include <algorithm>
+
+#include <qcc/Stream.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+
+#include <alljoyn/AllJoynStd.h>
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/DBusStd.h>
+#include <alljoyn/Message.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <BusInternal.h>
+#include <RemoteEndpoint.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+/*
+ * Stream with separate input and output.  The input is whatever the test has
+ * fed so far and a read never waits for more, in the same way as the zero
+ * timeout reads done by a non-blocking accept.
+ */
+class AcceptTestStream : public qcc::Stream {
+  public:
+    AcceptTestStream() : inPos(0) { }
+
+    QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = Event::WAIT_FOREVER)
+    {
+        actualBytes = (std::min)(reqBytes, in.size() - inPos);
+        if (actualBytes == 0) {
+            return ER_TIMEOUT;
+        }
+        memcpy(buf, in.data() + inPos, actualBytes);
+        inPos += actualBytes;
+        return ER_OK;
+    }
+
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+    {
+        out.append((const char*)buf, numBytes);
+        numSent = numBytes;
+        return ER_OK;
+    }
+
+    void Feed(const qcc::String& bytes) { in += bytes; }
+
+    size_t Unread() const { return in.size() - inPos; }
+
+    qcc::String in;
+    size_t inPos;
+    qcc::String out;
+};
+
+class EndpointAuthTestMessage : public _Message {
+  public:
+
+    EndpointAuthTestMessage(BusAttachment& bus) : _Message(bus) { };
+
+    QStatus BusCall(const char* methodName)
+    {
+        return CallMsg("", org::freedesktop::DBus::WellKnownName, 0, org::freedesktop::DBus::ObjectPath,
+                       org::freedesktop::DBus::InterfaceName, methodName, NULL, 0, 0);
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep)
+    {
+        return _Message::Deliver(ep);
+    }
+};
+
+class EndpointAuthTestListener : public _RemoteEndpoint::EndpointListener {
+  public:
+    EndpointAuthTestListener() : untrustedClients(0) { }
+
+    QStatus UntrustedClientStart() { ++untrustedClients; return ER_OK; }
+
+    void EndpointExit(RemoteEndpoint& ep) { }
+
+    int untrustedClients;
+};
+
+static const bool falsiness = false;
+static const bool truthiness = true;
+
+class EndpointAuthTest : public testing::Test {
+  public:
+    EndpointAuthTest() :
+        serverBus("EndpointAuthTestServer", false),
+        clientBus("EndpointAuthTestClient", false),
+        pStream(&stream),
+        ep(serverBus, truthiness, String::Empty, pStream)
+    { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, serverBus.Start());
+        ASSERT_EQ(ER_OK, clientBus.Start());
+        ep->SetListener(&listener);
+        ASSERT_EQ(ER_OK, ep->StartAccept("ANONYMOUS"));
+    }
+
+    virtual void TearDown()
+    {
+        ep->AbortAccept();
+    }
+
+    /*
+     * The SASL conversation of an anonymous client up to and including BEGIN
+     */
+    qcc::String ClientAuth()
+    {
+        return "AUTH ANONYMOUS\r\n"
+               "INFORM_PROTO_VERSION " + U32ToString(ALLJOYN_PROTOCOL_VERSION) + "\r\n"
+               "BEGIN " + clientBus.GetInternal().GetGlobalGUID().ToString() + "\r\n";
+    }
+
+    /*
+     * The marshaled bytes of the client's hello message
+     */
+    qcc::String ClientHello(const char* methodName = "Hello")
+    {
+        AcceptTestStream helloStream;
+        AcceptTestStream* pHelloStream = &helloStream;
+        RemoteEndpoint helloEp(clientBus, falsiness, String::Empty, pHelloStream);
+        EndpointAuthTestMessage hello(clientBus);
+        EXPECT_EQ(ER_OK, hello.BusCall(methodName));
+        EXPECT_EQ(ER_OK, hello.Deliver(helloEp));
+        return helloStream.out;
+    }
+
+    BusAttachment serverBus;
+    BusAttachment clientBus;
+    AcceptTestStream stream;
+    AcceptTestStream* pStream;
+    EndpointAuthTestListener listener;
+    RemoteEndpoint ep;
+};
+
+TEST_F(EndpointAuthTest, ContinueAcceptOneByteAtATime)
+{
+    qcc::String auth = ClientAuth();
+    qcc::String hello = ClientHello();
+    ASSERT_FALSE(hello.empty());
+    qcc::String input = auth + hello;
+
+    qcc::String authUsed;
+    QStatus status = ER_WOULDBLOCK;
+    size_t fed = 0;
+    while (fed < input.size()) {
+        stream.Feed(input.substr(fed++, 1));
+        status = ep->ContinueAccept(authUsed);
+        if (fed == input.size()) {
+            break;
+        }
+        ASSERT_EQ(ER_WOULDBLOCK, status) << "  Actual Status: " << QCC_StatusText(status) << " after " << fed << " bytes";
+        /*
+         * The first reply is only sent once the whole AUTH line has arrived
+         */
+        if (fed <= auth.find('\n')) {
+            ASSERT_TRUE(stream.out.empty());
+        } else if (fed == (auth.find('\n') + 1)) {
+            ASSERT_EQ(qcc::String("OK ") + serverBus.GetInternal().GetGlobalGUID().ToString() + "\r\n", stream.out);
+        }
+    }
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(qcc::String("ANONYMOUS"), authUsed);
+    EXPECT_EQ((size_t)0, stream.Unread());
+    EXPECT_EQ(1, listener.untrustedClients);
+    EXPECT_EQ((uint32_t)ALLJOYN_PROTOCOL_VERSION, ep->GetRemoteProtocolVersion());
+    EXPECT_FALSE(ep->GetFeatures().trusted);
+
+    /*
+     * The replies to the extension command and the hello follow the OK
+     */
+    qcc::String inform = "INFORM_PROTO_VERSION " + U32ToString(ALLJOYN_PROTOCOL_VERSION) + "\r\n";
+    size_t helloReply = stream.out.find(inform);
+    ASSERT_NE(+qcc::String::npos, helloReply);
+    EXPECT_LT(helloReply + inform.size(), stream.out.size());
+
+    /*
+     * The accept is over so it cannot be continued
+     */
+    status = ep->ContinueAccept(authUsed);
+    EXPECT_EQ(ER_BUS_ESTABLISH_FAILED, status) << "  Actual Status: " << QCC_StatusText(status);
+}
+
+TEST_F(EndpointAuthTest, ContinueAcceptLeavesFollowingBytes)
+{
+    /*
+     * Anything the client sends after the hello belongs to the started
+     * endpoint and must not be consumed by the accept.
+     */
+    qcc::String following = "l\x04\x01\x01";
+    stream.Feed(ClientAuth() + ClientHello() + following);
+
+    qcc::String authUsed;
+    QStatus status = ep->ContinueAccept(authUsed);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(following.size(), stream.Unread());
+}
+
+TEST_F(EndpointAuthTest, ContinueAcceptRejectsBadHello)
+{
+    /*
+     * The first message after BEGIN must be the hello
+     */
+    stream.Feed(ClientAuth() + ClientHello("ListNames"));
+
+    qcc::String authUsed;
+    QStatus status = ep->ContinueAccept(authUsed);
+    EXPECT_EQ(ER_BUS_ESTABLISH_FAILED, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(0, listener.untrustedClients);
+}
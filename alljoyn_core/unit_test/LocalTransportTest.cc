@@ -0,0 +1,335 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include "ajTestCommon.h"
+#include <alljoyn/Message.h>
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/BusObject.h>
+#include <alljoyn/ProxyBusObject.h>
+#include <alljoyn/InterfaceDescription.h>
+#include <qcc/Event.h>
+#include <qcc/Mutex.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+/*
+ * Tests for the dispatcher that runs the method and signal handlers of the local endpoint
+ */
+
+using namespace ajn;
+using namespace qcc;
+
+static const char* LT_INTERFACE = "org.alljoyn.test.LocalTransportTest";
+static const char* LT_PATH = "/org/alljoyn/test/LocalTransportTest";
+
+static const size_t NUM_SENDERS = 4;
+static const uint32_t NUM_SIGNALS = 200;
+
+static void CreateTestInterface(BusAttachment& bus)
+{
+    InterfaceDescription* intf = NULL;
+    QStatus status = bus.CreateInterface(LT_INTERFACE, intf);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    ASSERT_TRUE(intf != NULL);
+    intf->AddSignal("Seq", "uu", "sender,seq");
+    intf->AddMethod("Block", NULL, NULL, NULL);
+    intf->AddMethod("Unblock", NULL, NULL, NULL);
+    intf->Activate();
+}
+
+static void StartAndConnect(BusAttachment& bus)
+{
+    QStatus status = bus.Start();
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    status = bus.Connect(getConnectArg().c_str());
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+}
+
+/*
+ * Emits numbered signals to one destination
+ */
+class SenderObject : public BusObject {
+  public:
+    SenderObject(BusAttachment& bus) : BusObject(LT_PATH), seq(bus.GetInterface(LT_INTERFACE)->GetMember("Seq"))
+    {
+        AddInterface(*bus.GetInterface(LT_INTERFACE));
+    }
+
+    QStatus Send(const char* destination, uint32_t sender, uint32_t num)
+    {
+        MsgArg args[2];
+        args[0].Set("u", sender);
+        args[1].Set("u", num);
+        return Signal(destination, 0, *seq, args, ArraySize(args));
+    }
+
+    const InterfaceDescription::Member* seq;
+};
+
+class SenderThread : public Thread {
+  public:
+    SenderThread(SenderObject& obj, const char* destination, uint32_t sender, uint32_t count) :
+        Thread("SenderThread"), status(ER_OK), obj(obj), destination(destination), sender(sender), count(count) { }
+
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        for (uint32_t i = 0; (status == ER_OK) && (i < count); ++i) {
+            status = obj.Send(destination.c_str(), sender, i);
+        }
+        return 0;
+    }
+
+    QStatus status;
+
+  private:
+    SenderObject& obj;
+    qcc::String destination;
+    uint32_t sender;
+    uint32_t count;
+};
+
+/*
+ * Records the signals it receives and checks they arrive in order for each sender
+ */
+class SeqReceiver : public MessageReceiver {
+  public:
+    SeqReceiver() : received(0), outOfOrder(0), blockFirst(false)
+    {
+        for (size_t i = 0; i < NUM_SENDERS; ++i) {
+            next[i] = 0;
+        }
+    }
+
+    void SeqHandler(const InterfaceDescription::Member* member, const char* srcPath, Message& msg)
+    {
+        uint32_t sender;
+        uint32_t num;
+        QStatus status = msg->GetArgs("uu", &sender, &num);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        lock.Lock();
+        bool first = (received++ == 0);
+        if ((sender >= NUM_SENDERS) || (num != next[sender]++)) {
+            ++outOfOrder;
+        }
+        lock.Unlock();
+        if (first && blockFirst) {
+            entered.SetEvent();
+            Event::Wait(release, 5000);
+        }
+    }
+
+    uint32_t Received()
+    {
+        lock.Lock();
+        uint32_t r = received;
+        lock.Unlock();
+        return r;
+    }
+
+    Mutex lock;
+    uint32_t received;
+    uint32_t outOfOrder;
+    uint32_t next[NUM_SENDERS];
+    bool blockFirst;     /* Block the first handler call until release is set */
+    Event entered;       /* Set when a blocked handler call has been entered */
+    Event release;
+};
+
+TEST(LocalTransportTest, PerSenderOrdering) {
+    BusAttachment receiver("LocalTransportTest.receiver", false, 4);
+    CreateTestInterface(receiver);
+    StartAndConnect(receiver);
+    SeqReceiver seqReceiver;
+    QStatus status = receiver.RegisterSignalHandler(&seqReceiver,
+                                                    static_cast<MessageReceiver::SignalHandler>(&SeqReceiver::SeqHandler),
+                                                    receiver.GetInterface(LT_INTERFACE)->GetMember("Seq"),
+                                                    NULL);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    BusAttachment* senders[NUM_SENDERS];
+    SenderObject* objs[NUM_SENDERS];
+    SenderThread* threads[NUM_SENDERS];
+    for (size_t i = 0; i < NUM_SENDERS; ++i) {
+        senders[i] = new BusAttachment("LocalTransportTest.sender", false);
+        CreateTestInterface(*senders[i]);
+        StartAndConnect(*senders[i]);
+        objs[i] = new SenderObject(*senders[i]);
+        status = senders[i]->RegisterBusObject(*objs[i]);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        threads[i] = new SenderThread(*objs[i], receiver.GetUniqueName().c_str(), i, NUM_SIGNALS);
+    }
+    /*
+     * All senders send at once so the receiver's dispatcher threads interleave their strands
+     */
+    for (size_t i = 0; i < NUM_SENDERS; ++i) {
+        threads[i]->Start();
+    }
+    for (size_t i = 0; i < NUM_SENDERS; ++i) {
+        threads[i]->Join();
+        EXPECT_EQ(ER_OK, threads[i]->status) << "  Actual Status: " << QCC_StatusText(threads[i]->status);
+    }
+    for (int i = 0; (i < 500) && (seqReceiver.Received() < NUM_SENDERS * NUM_SIGNALS); ++i) {
+        qcc::Sleep(10);
+    }
+    EXPECT_EQ(NUM_SENDERS * NUM_SIGNALS, seqReceiver.Received());
+    EXPECT_EQ(0U, seqReceiver.outOfOrder);
+    for (size_t i = 0; i < NUM_SENDERS; ++i) {
+        EXPECT_EQ(NUM_SIGNALS, seqReceiver.next[i]);
+    }
+
+    for (size_t i = 0; i < NUM_SENDERS; ++i) {
+        delete threads[i];
+        senders[i]->UnregisterBusObject(*objs[i]);
+        delete objs[i];
+        senders[i]->Stop();
+        senders[i]->Join();
+        delete senders[i];
+    }
+    receiver.UnregisterAllHandlers(&seqReceiver);
+    receiver.Stop();
+    receiver.Join();
+}
+
+/*
+ * Block does not return until Unblock has been called by the same sender, which can only be
+ * dispatched if Block has released its strand by enabling concurrent callbacks.
+ */
+class BlockingObject : public BusObject {
+  public:
+    BlockingObject(BusAttachment& bus) : BusObject(LT_PATH), bus(bus), blockStatus(ER_FAIL)
+    {
+        const InterfaceDescription* intf = bus.GetInterface(LT_INTERFACE);
+        AddInterface(*intf);
+        const MethodEntry methodEntries[] = {
+            { intf->GetMember("Block"), static_cast<MessageReceiver::MethodHandler>(&BlockingObject::Block) },
+            { intf->GetMember("Unblock"), static_cast<MessageReceiver::MethodHandler>(&BlockingObject::Unblock) }
+        };
+        QStatus status = AddMethodHandlers(methodEntries, ArraySize(methodEntries));
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+
+    void Block(const InterfaceDescription::Member* member, Message& msg)
+    {
+        bus.EnableConcurrentCallbacks();
+        blockStatus = Event::Wait(unblocked, 5000);
+        MethodReply(msg);
+    }
+
+    void Unblock(const InterfaceDescription::Member* member, Message& msg)
+    {
+        unblocked.SetEvent();
+        MethodReply(msg);
+    }
+
+    BusAttachment& bus;
+    QStatus blockStatus;
+    Event unblocked;
+};
+
+class BlockReplyReceiver : public MessageReceiver {
+  public:
+    BlockReplyReceiver() : replyType(MESSAGE_INVALID) { }
+
+    void ReplyHandler(Message& msg, void* context)
+    {
+        replyType = msg->GetType();
+        replied.SetEvent();
+    }
+
+    AllJoynMessageType replyType;
+    Event replied;
+};
+
+TEST(LocalTransportTest, ConcurrentCallbacksReleaseStrand) {
+    BusAttachment service("LocalTransportTest.service", false, 4);
+    CreateTestInterface(service);
+    StartAndConnect(service);
+    BlockingObject obj(service);
+    QStatus status = service.RegisterBusObject(obj);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    BusAttachment client("LocalTransportTest.client", false);
+    CreateTestInterface(client);
+    StartAndConnect(client);
+    ProxyBusObject proxy(client, service.GetUniqueName().c_str(), LT_PATH, 0);
+    proxy.AddInterface(*client.GetInterface(LT_INTERFACE));
+
+    BlockReplyReceiver blockReply;
+    status = proxy.MethodCallAsync(LT_INTERFACE, "Block", &blockReply,
+                                   static_cast<MessageReceiver::ReplyHandler>(&BlockReplyReceiver::ReplyHandler));
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    Message reply(client);
+    status = proxy.MethodCall(LT_INTERFACE, "Unblock", NULL, 0, reply, 5000);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    status = Event::Wait(blockReply.replied, 5000);
+    EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    EXPECT_EQ(MESSAGE_METHOD_RET, blockReply.replyType);
+    EXPECT_EQ(ER_OK, obj.blockStatus) << "  Actual Status: " << QCC_StatusText(obj.blockStatus);
+
+    client.Stop();
+    client.Join();
+    service.UnregisterBusObject(obj);
+    service.Stop();
+    service.Join();
+}
+
+TEST(LocalTransportTest, StopJoinWithQueuedWork) {
+    static const uint32_t NUM_QUEUED = 5;
+
+    /* A single dispatcher thread so the signals queue up behind the blocked handler */
+    BusAttachment receiver("LocalTransportTest.receiver", false, 1);
+    CreateTestInterface(receiver);
+    StartAndConnect(receiver);
+    SeqReceiver seqReceiver;
+    seqReceiver.blockFirst = true;
+    QStatus status = receiver.RegisterSignalHandler(&seqReceiver,
+                                                    static_cast<MessageReceiver::SignalHandler>(&SeqReceiver::SeqHandler),
+                                                    receiver.GetInterface(LT_INTERFACE)->GetMember("Seq"),
+                                                    NULL);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    BusAttachment sender("LocalTransportTest.sender", false);
+    CreateTestInterface(sender);
+    StartAndConnect(sender);
+    SenderObject obj(sender);
+    status = sender.RegisterBusObject(obj);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+    for (uint32_t i = 0; i < NUM_QUEUED; ++i) {
+        status = obj.Send(receiver.GetUniqueName().c_str(), 0, i);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+    status = Event::Wait(seqReceiver.entered, 5000);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    /* Give the remaining signals time to be queued behind the blocked handler */
+    qcc::Sleep(200);
+
+    /*
+     * Join must return once the blocked handler returns and discard the signals that were never
+     * dispatched rather than running them on a stopped bus.
+     */
+    receiver.Stop();
+    seqReceiver.release.SetEvent();
+    receiver.Join();
+    EXPECT_EQ(1U, seqReceiver.Received());
+
+    sender.UnregisterBusObject(obj);
+    sender.Stop();
+    sender.Join();
+}
@@ -16,12 +16,17 @@
 #include <ctype.h>
 #include <qcc/platform.h>
 #include <queue>
+#include <vector>
 #include <algorithm>
+#include <limits>
 
 #include <qcc/Util.h>
 #include <qcc/Pipe.h>
+#include <qcc/SocketStream.h>
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/time.h>
 
 #include <alljoyn/BusAttachment.h>
 #include <alljoyn/Message.h>
@@ -33,6 +38,7 @@
 #include <PeerState.h>
 #include <SignatureUtils.h>
 #include <RemoteEndpoint.h>
+#include <BusInternal.h>
 
 /* Header files included for Google Test Framework */
 #include <gtest/gtest.h>
@@ -124,6 +130,11 @@ class MyMessage : public _Message {
         return test;
     }
 
+    QStatus ReadNonBlocking(RemoteEndpoint& ep, bool pedantic = true)
+    {
+        return _Message::ReadNonBlocking(ep, false, pedantic);
+    }
+
     QStatus Unmarshal(RemoteEndpoint& ep, const qcc::String& endpointName, bool pedantic = true)
     {
         return _Message::Unmarshal(ep, pedantic);
@@ -297,6 +308,476 @@ TEST(MarshalTest, TestMsgUnpack) {
     delete bus;
 }
 
+/*
+ * Size of the receive buffer that remote endpoints read messages through
+ */
+static const size_t RX_BUFFER_SIZE = 32 * 1024;
+
+/*
+ * Marshal a signal carrying a sequence number and a byte array of the given length and
+ * deliver it to the stream of an endpoint.
+ */
+static QStatus DeliverSizedSignal(BusAttachment& bus, RemoteEndpoint& ep, uint32_t seq, size_t len)
+{
+    std::vector<uint8_t> bytes(len + 1);
+    for (size_t i = 0; i < len; ++i) {
+        bytes[i] = static_cast<uint8_t>(seq + i);
+    }
+    MsgArg args[2];
+    args[0].Set("u", seq);
+    args[1].Set("ay", len, &bytes[0]);
+    MyMessage msg(bus);
+    QStatus status = msg.Signal("", "/rx", "org.test.Rx", "Sized", args, ArraySize(args));
+    if (status == ER_OK) {
+        status = msg.Deliver(ep);
+    }
+    return status;
+}
+
+/*
+ * Read signals of various sizes with ReadNonBlocking, feeding the marshaled bytes to the
+ * stream in chunks of the given size.
+ */
+static void ReadSizedSignals(size_t chunk)
+{
+    static const bool falsiness = false;
+    BusAttachment bus("ReadSizedSignals", false);
+    bus.Start();
+
+    /*
+     * The first fill of the receive buffer ends 8 bytes into the header of the third signal.
+     * The fourth signal is larger than the receive buffer and the fifth is too large for a
+     * pooled buffer.
+     */
+    TestPipe staged;
+    TestPipe* pStaged = &staged;
+    RemoteEndpoint stagingEp(bus, falsiness, String::Empty, pStaged);
+    ASSERT_EQ(ER_OK, DeliverSizedSignal(bus, stagingEp, 0, 0));
+    size_t emptySize = staged.AvailBytes();
+    std::vector<size_t> lens;
+    lens.push_back(0);
+    lens.push_back(RX_BUFFER_SIZE - 8 - 2 * emptySize);
+    lens.push_back(3);
+    lens.push_back(RX_BUFFER_SIZE + 8000);
+    lens.push_back(600);
+    for (size_t i = 0; i < 200; ++i) {
+        lens.push_back((i * 37) % 131);
+    }
+    for (size_t i = 1; i < lens.size(); ++i) {
+        ASSERT_EQ(ER_OK, DeliverSizedSignal(bus, stagingEp, i, lens[i]));
+    }
+    ASSERT_EQ(RX_BUFFER_SIZE - 8, 2 * emptySize + lens[1]);
+    qcc::String wire;
+    while (staged.AvailBytes() > 0) {
+        char buf[4096];
+        size_t got;
+        ASSERT_EQ(ER_OK, staged.PullBytes(buf, sizeof(buf), got, 0));
+        wire.append(buf, got);
+    }
+
+    std::vector<qcc::ManagedObj<MyMessage> > received;
+    {
+        TestPipe stream;
+        TestPipe* pStream = &stream;
+        RemoteEndpoint ep(bus, falsiness, String::Empty, pStream);
+        size_t pos = 0;
+        qcc::ManagedObj<MyMessage> msg(bus);
+        while (received.size() < lens.size()) {
+            QStatus status = msg->ReadNonBlocking(ep);
+            if (status == ER_TIMEOUT) {
+                /* The stream is empty, feed it the next chunk */
+                ASSERT_LT(pos, wire.size()) << "Only " << received.size() << " signals were read";
+                size_t sent;
+                ASSERT_EQ(ER_OK, stream.PushBytes(wire.data() + pos, (std::min)(chunk, wire.size() - pos), sent));
+                pos += sent;
+                continue;
+            }
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            status = msg->Unmarshal(ep, ":88.88");
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            received.push_back(msg);
+            msg = qcc::ManagedObj<MyMessage>(bus);
+        }
+        EXPECT_EQ(wire.size(), pos);
+        EXPECT_EQ((size_t)0, stream.AvailBytes());
+    }
+
+    /* The signals outlive the endpoint whose buffers they borrowed */
+    for (size_t i = 0; i < received.size(); ++i) {
+        QStatus status = received[i]->UnmarshalBody();
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        uint32_t seq;
+        size_t len;
+        uint8_t* bytes;
+        ASSERT_EQ(ER_OK, received[i]->GetArgs("uay", &seq, &len, &bytes));
+        EXPECT_EQ(i, seq);
+        ASSERT_EQ(lens[i], len);
+        for (size_t j = 0; j < len; ++j) {
+            if (bytes[j] != static_cast<uint8_t>(seq + j)) {
+                ADD_FAILURE() << "Signal " << i << " is corrupt at byte " << j;
+                break;
+            }
+        }
+    }
+}
+
+TEST(MarshalTest, ReadAcrossReceiveBufferBoundary) {
+    ReadSizedSignals(std::numeric_limits<size_t>::max());
+}
+
+TEST(MarshalTest, ReadAcrossStreamChunks) {
+    ReadSizedSignals(4093);
+}
+
+/*
+ * Pipe that counts the bytes written to it that did not come directly from the marshaled
+ * buffer of the message being routed, i.e. bytes that were copied on the transmit path.
+ */
+class CopyCountingPipe : public qcc::Pipe {
+  public:
+    CopyCountingPipe() : qcc::Pipe() { }
+
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(buf);
+        if (!sharedStart) {
+            /* The first push is a blocking delivery straight from the marshaled buffer */
+            sharedStart = p;
+            sharedEnd = p + numBytes;
+        } else if ((p < sharedStart) || ((p + numBytes) > sharedEnd)) {
+            bytesCopied += numBytes;
+        }
+        bytesPushed += numBytes;
+        return qcc::Pipe::PushBytes(buf, numBytes, numSent);
+    }
+
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent, uint32_t ttl)
+    {
+        return PushBytes(buf, numBytes, numSent);
+    }
+
+    static const uint8_t* sharedStart;
+    static const uint8_t* sharedEnd;
+    static size_t bytesCopied;
+    static size_t bytesPushed;
+};
+
+const uint8_t* CopyCountingPipe::sharedStart = NULL;
+const uint8_t* CopyCountingPipe::sharedEnd = NULL;
+size_t CopyCountingPipe::bytesCopied = 0;
+size_t CopyCountingPipe::bytesPushed = 0;
+
+/*
+ * Benchmark: route the same signal to many remote endpoints through the transmit path and
+ * measure how many bytes are copied per routed signal.
+ */
+TEST(MarshalTest, FanOutBytesCopiedPerSignal) {
+    static const size_t NUM_ENDPOINTS = 16;
+    static const size_t NUM_SIGNALS = 200;
+    static const bool falsiness = false;
+
+    BusAttachment* bus = new BusAttachment("FanOutBytesCopied", false);
+    bus->Start();
+
+    uint8_t payload[1024];
+    memset(payload, 0xA5, sizeof(payload));
+    MsgArg arg("ay", sizeof(payload), payload);
+    qcc::ManagedObj<MyMessage> signal(*bus);
+    QStatus status = signal->Signal("", "/foo/bar", "foo.bar", "fanout", &arg, 1);
+    ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    Message msg = Message::cast(signal);
+
+    /* Locate the marshaled buffer by delivering the signal directly */
+    CopyCountingPipe::sharedStart = NULL;
+    CopyCountingPipe probe;
+    {
+        CopyCountingPipe* pProbe = &probe;
+        RemoteEndpoint probeEp(*bus, falsiness, String::Empty, pProbe);
+        status = signal->Deliver(probeEp);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+    size_t msgLen = CopyCountingPipe::sharedEnd - CopyCountingPipe::sharedStart;
+    CopyCountingPipe::bytesCopied = 0;
+    CopyCountingPipe::bytesPushed = 0;
+
+    CopyCountingPipe pipes[NUM_ENDPOINTS];
+    std::vector<RemoteEndpoint> eps;
+    for (size_t i = 0; i < NUM_ENDPOINTS; ++i) {
+        CopyCountingPipe* pStream = &pipes[i];
+        eps.push_back(RemoteEndpoint(*bus, falsiness, String::Empty, pStream));
+    }
+
+    uint64_t start = GetTimestamp64();
+    for (size_t n = 0; n < NUM_SIGNALS; ++n) {
+        for (size_t i = 0; i < NUM_ENDPOINTS; ++i) {
+            status = eps[i]->PushMessage(msg);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            qcc::IOWriteListener* writer = eps[i].unwrap();
+            status = writer->WriteCallback(pipes[i], false);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        }
+    }
+    uint64_t elapsed = GetTimestamp64() - start;
+
+    size_t numRouted = NUM_SIGNALS * NUM_ENDPOINTS;
+    EXPECT_EQ(numRouted * msgLen, CopyCountingPipe::bytesPushed);
+    printf("%u byte signal routed to %u endpoints %u times: %u bytes copied per routed signal, %u ms\n",
+           (unsigned int)msgLen, (unsigned int)NUM_ENDPOINTS, (unsigned int)NUM_SIGNALS,
+           (unsigned int)(CopyCountingPipe::bytesCopied / numRouted), (unsigned int)elapsed);
+    EXPECT_EQ((size_t)0, CopyCountingPipe::bytesCopied);
+
+    eps.clear();
+    delete bus;
+}
+
+/*
+ * Socket stream that counts the number of send operations used to write to the socket.
+ */
+class SendCountingStream : public qcc::SocketStream {
+  public:
+    SendCountingStream(qcc::SocketFd sock) : qcc::SocketStream(sock), numSends(0) { }
+
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+    {
+        ++numSends;
+        return qcc::SocketStream::PushBytes(buf, numBytes, numSent);
+    }
+
+    QStatus PushBytesSG(const qcc::IOVec* iov, size_t iovLen, size_t& numSent)
+    {
+        ++numSends;
+        return qcc::SocketStream::PushBytesSG(iov, iovLen, numSent);
+    }
+
+    size_t numSends;
+};
+
+TEST(MarshalTest, TxBatchCoalescesQueuedSignals) {
+    static const size_t NUM_SIGNALS = 20;
+    static const bool falsiness = false;
+
+    BusAttachment* bus = new BusAttachment("TxBatch", false);
+    bus->Start();
+
+    qcc::SocketFd fds[2];
+    ASSERT_EQ(ER_OK, qcc::SocketPair(fds));
+    SendCountingStream stream(fds[0]);
+    qcc::SocketStream peer(fds[1]);
+
+    {
+        SendCountingStream* pStream = &stream;
+        RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+        for (size_t n = 0; n < NUM_SIGNALS; ++n) {
+            uint32_t reading = n;
+            MsgArg arg("u", reading);
+            qcc::ManagedObj<MyMessage> signal(*bus);
+            QStatus status = signal->Signal("", "/sensor", "org.test.Sensor", "Reading", &arg, 1);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            Message msg = Message::cast(signal);
+            status = ep->PushMessage(msg);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        }
+        qcc::IOWriteListener* writer = ep.unwrap();
+        QStatus status = writer->WriteCallback(stream, false);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+    }
+
+    /* The queued signals must be written with far fewer sends than there are signals */
+    uint8_t buf[4096];
+    size_t received = 0;
+    while (received < sizeof(buf)) {
+        size_t actual;
+        if (peer.PullBytes(buf + received, sizeof(buf) - received, actual, 100) != ER_OK) {
+            break;
+        }
+        received += actual;
+    }
+    printf("%u queued signals (%u bytes) written with %u sends\n", (unsigned int)NUM_SIGNALS, (unsigned int)received, (unsigned int)stream.numSends);
+    EXPECT_GT(received, (size_t)0);
+    EXPECT_LT(stream.numSends, NUM_SIGNALS / 4);
+
+    delete bus;
+}
+
+TEST(MarshalTest, TxQueueFullWouldBlock) {
+    static const size_t MAX_QUEUED = 4;
+    static const bool falsiness = false;
+
+    BusAttachment* bus = new BusAttachment("TxQueueFull", false);
+    bus->Start();
+    bus->GetInternal().SetTxQueueLimits(MAX_QUEUED, 1024 * 1024, true);
+
+    TestPipe stream;
+    TestPipe* pStream = &stream;
+    {
+        RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+        for (size_t n = 0; n < MAX_QUEUED + 2; ++n) {
+            uint32_t reading = n;
+            MsgArg arg("u", reading);
+            qcc::ManagedObj<MyMessage> signal(*bus);
+            QStatus status = signal->Signal("", "/sensor", "org.test.Sensor", "Reading", &arg, 1);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            Message msg = Message::cast(signal);
+            /* A full queue must fail immediately rather than block the pushing thread */
+            status = ep->PushMessage(msg);
+            EXPECT_EQ((n < MAX_QUEUED) ? ER_OK : ER_BUS_WRITE_QUEUE_FULL, status) << "  Actual Status: " << QCC_StatusText(status);
+        }
+
+        _RemoteEndpoint::TxQueueStats stats;
+        ep->GetTxQueueStats(stats);
+        EXPECT_EQ(MAX_QUEUED, stats.depth);
+        EXPECT_EQ(MAX_QUEUED, stats.highWaterDepth);
+        EXPECT_EQ(stats.bytes, stats.highWaterBytes);
+        EXPECT_EQ((uint32_t)2, stats.dropped);
+
+        /* Draining the queue resets the depth but not the high-water marks */
+        qcc::IOWriteListener* writer = ep.unwrap();
+        QStatus status = writer->WriteCallback(stream, false);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        ep->GetTxQueueStats(stats);
+        EXPECT_EQ((size_t)0, stats.depth);
+        EXPECT_EQ((size_t)0, stats.bytes);
+        EXPECT_EQ(MAX_QUEUED, stats.highWaterDepth);
+    }
+
+    delete bus;
+}
+
+TEST(MarshalTest, TxQueuePushMessagesInOrder) {
+    static const size_t MAX_QUEUED = 4;
+    static const size_t NUM_SIGNALS = 6;
+    static const bool falsiness = false;
+
+    BusAttachment* bus = new BusAttachment("TxQueuePushMessages", false);
+    bus->Start();
+    bus->GetInternal().SetTxQueueLimits(MAX_QUEUED, 1024 * 1024, true);
+
+    std::vector<Message> msgs;
+    for (size_t n = 0; n < NUM_SIGNALS; ++n) {
+        uint32_t reading = n;
+        MsgArg arg("u", reading);
+        qcc::ManagedObj<MyMessage> signal(*bus);
+        QStatus status = signal->Signal("", "/sensor", "org.test.Sensor", "Reading", &arg, 1);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        msgs.push_back(Message::cast(signal));
+    }
+
+    TestPipe stream;
+    TestPipe* pStream = &stream;
+    {
+        RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+        /* The batch is queued up to the queue limit and the caller is told how much was taken */
+        size_t numPushed = 0;
+        QStatus status = ep->PushMessages(msgs, numPushed);
+        EXPECT_EQ(ER_BUS_WRITE_QUEUE_FULL, status) << "  Actual Status: " << QCC_StatusText(status);
+        EXPECT_EQ(MAX_QUEUED, numPushed);
+
+        _RemoteEndpoint::TxQueueStats stats;
+        ep->GetTxQueueStats(stats);
+        EXPECT_EQ(MAX_QUEUED, stats.depth);
+        EXPECT_EQ((uint32_t)1, stats.dropped);
+
+        qcc::IOWriteListener* writer = ep.unwrap();
+        status = writer->WriteCallback(stream, false);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+        /* The rest of the batch fits once the queue has drained */
+        std::vector<Message> rest(msgs.begin() + numPushed, msgs.end());
+        status = ep->PushMessages(rest, numPushed);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        EXPECT_EQ(NUM_SIGNALS - MAX_QUEUED, numPushed);
+        ep->GetTxQueueStats(stats);
+        EXPECT_EQ(NUM_SIGNALS - MAX_QUEUED, stats.depth);
+        status = writer->WriteCallback(stream, false);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+
+        /* The signals come out in the order they were pushed */
+        for (size_t n = 0; n < NUM_SIGNALS; ++n) {
+            MyMessage msg(*bus);
+            status = msg.Read(ep, ":88.88");
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            status = msg.Unmarshal(ep, ":88.88");
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            status = msg.UnmarshalBody();
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            uint32_t reading;
+            ASSERT_EQ(ER_OK, msg.GetArgs("u", &reading));
+            EXPECT_EQ(n, reading);
+        }
+    }
+
+    delete bus;
+}
+
+/*
+ * Drains the transmit queue of an endpoint after a delay.
+ */
+class TxDrainThread : public Thread {
+  public:
+    TxDrainThread(RemoteEndpoint& ep, Stream& stream) : Thread("TxDrainThread"), status(ER_FAIL), ep(ep), stream(stream) { }
+
+    QStatus status;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        qcc::Sleep(100);
+        qcc::IOWriteListener* writer = ep.unwrap();
+        status = writer->WriteCallback(stream, false);
+        return 0;
+    }
+
+  private:
+    RemoteEndpoint& ep;
+    Stream& stream;
+};
+
+TEST(MarshalTest, TxQueueFullMethodCallWaits) {
+    static const size_t MAX_QUEUED = 2;
+    static const bool falsiness = false;
+
+    BusAttachment* bus = new BusAttachment("TxQueueFullMethodCall", false);
+    bus->Start();
+    bus->GetInternal().SetTxQueueLimits(MAX_QUEUED, 1024 * 1024, true);
+
+    TestPipe stream;
+    TestPipe* pStream = &stream;
+    {
+        RemoteEndpoint ep(*bus, falsiness, String::Empty, pStream);
+        for (size_t n = 0; n < MAX_QUEUED; ++n) {
+            uint32_t reading = n;
+            MsgArg arg("u", reading);
+            qcc::ManagedObj<MyMessage> signal(*bus);
+            QStatus status = signal->Signal("", "/sensor", "org.test.Sensor", "Reading", &arg, 1);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+            Message msg = Message::cast(signal);
+            status = ep->PushMessage(msg);
+            ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        }
+
+        /* A method call is never dropped, it waits until the queue has drained */
+        TxDrainThread drain(ep, stream);
+        drain.Start();
+        uint32_t value = 1;
+        MsgArg arg("u", value);
+        qcc::ManagedObj<MyMessage> call(*bus);
+        QStatus status = call->MethodCall(":88.88", "/sensor", "org.test.Sensor", "Calibrate", &arg, 1);
+        ASSERT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        Message msg = Message::cast(call);
+        status = ep->PushMessage(msg);
+        EXPECT_EQ(ER_OK, status) << "  Actual Status: " << QCC_StatusText(status);
+        drain.Join();
+        EXPECT_EQ(ER_OK, drain.status) << "  Actual Status: " << QCC_StatusText(drain.status);
+
+        _RemoteEndpoint::TxQueueStats stats;
+        ep->GetTxQueueStats(stats);
+        EXPECT_EQ((size_t)1, stats.depth);
+        EXPECT_EQ((uint32_t)0, stats.dropped);
+    }
+
+    delete bus;
+}
+
 /*--------------------------FUZZING TEST CODE---------------------------------*/
 static bool fuzzing = false;
 static bool nobig = false;
@@ -0,0 +1,220 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/DBusStd.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <BusEndpoint.h>
+#include <NameTable.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace qcc;
+using namespace std;
+using namespace ajn;
+
+class _NameTableTestEndpoint : public _BusEndpoint {
+  public:
+    _NameTableTestEndpoint(const qcc::String& uniqueName) : _BusEndpoint(ENDPOINT_TYPE_REMOTE), uniqueName(uniqueName) { }
+
+    const qcc::String& GetUniqueName() const { return uniqueName; }
+
+  private:
+    const qcc::String uniqueName;
+};
+
+typedef ManagedObj<_NameTableTestEndpoint> NameTableTestEndpoint;
+
+static BusEndpoint NewEndpoint(const qcc::String& uniqueName)
+{
+    NameTableTestEndpoint ep(uniqueName);
+    return BusEndpoint::cast(ep);
+}
+
+static const char* STABLE_NAME = ":stable.1";
+static const char* STABLE_ALIAS = "org.alljoyn.test.NameTable.Stable";
+
+static qcc::String ChurnName(size_t writer, size_t i)
+{
+    return ":churn" + U32ToString(static_cast<uint32_t>(writer)) + "." + U32ToString(static_cast<uint32_t>(i));
+}
+
+static qcc::String ChurnAlias(size_t writer, size_t i)
+{
+    return "org.alljoyn.test.NameTable.Churn" + U32ToString(static_cast<uint32_t>(writer)) + "_" + U32ToString(static_cast<uint32_t>(i));
+}
+
+/*
+ * Looks up names without the name table lock while the writers change them. Every lookup must
+ * find either nothing or the endpoint that is allowed to own the name.
+ */
+class NameTableReader : public Thread {
+  public:
+    NameTableReader(const NameTable& nameTable, size_t numWriters, size_t numNames) :
+        Thread("NameTableReader"), failures(0), lookups(0), nameTable(nameTable), numWriters(numWriters), numNames(numNames) { }
+
+    size_t failures;
+    volatile size_t lookups;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        while (!IsStopping()) {
+            if (nameTable.FindEndpoint(STABLE_NAME)->GetUniqueName() != STABLE_NAME) {
+                ++failures;
+            }
+            if (nameTable.FindEndpoint(STABLE_ALIAS)->GetUniqueName() != STABLE_NAME) {
+                ++failures;
+            }
+            for (size_t w = 0; w < numWriters; ++w) {
+                for (size_t i = 0; i < numNames; ++i) {
+                    qcc::String name = ChurnName(w, i);
+                    BusEndpoint ep = nameTable.FindEndpoint(name);
+                    if (ep->IsValid() && (ep->GetUniqueName() != name)) {
+                        ++failures;
+                    }
+                    ep = nameTable.FindEndpoint(ChurnAlias(w, i));
+                    if (ep->IsValid() && (ep->GetUniqueName() != name) && (ep->GetUniqueName() != STABLE_NAME)) {
+                        ++failures;
+                    }
+                }
+            }
+            ++lookups;
+        }
+        return 0;
+    }
+
+  private:
+    const NameTable& nameTable;
+    const size_t numWriters;
+    const size_t numNames;
+};
+
+/*
+ * Adds and removes unique names and aliases. The stable endpoint queues for each alias so the
+ * alias must pass to it when the churning owner goes away.
+ */
+class NameTableWriter : public Thread {
+  public:
+    NameTableWriter(NameTable& nameTable, size_t writer, size_t numNames, size_t rounds) :
+        Thread("NameTableWriter"), failures(0), nameTable(nameTable), writer(writer), numNames(numNames), rounds(rounds) { }
+
+    size_t failures;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        for (size_t r = 0; r < rounds; ++r) {
+            size_t i = r % numNames;
+            qcc::String name = ChurnName(writer, i);
+            qcc::String alias = ChurnAlias(writer, i);
+            uint32_t disposition;
+
+            BusEndpoint ep = NewEndpoint(name);
+            nameTable.AddUniqueName(ep);
+            Check(nameTable.FindEndpoint(name) == ep);
+            Check((nameTable.AddAlias(alias, name, 0, disposition) == ER_OK) && (disposition == DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER));
+            Check((nameTable.AddAlias(alias, STABLE_NAME, 0, disposition) == ER_OK) && (disposition == DBUS_REQUEST_NAME_REPLY_IN_QUEUE));
+            Check(nameTable.FindEndpoint(alias) == ep);
+
+            if (r & 1) {
+                /* The owner goes away and the alias passes to the queued endpoint */
+                nameTable.RemoveUniqueName(name);
+                Check(!nameTable.FindEndpoint(name)->IsValid());
+            } else {
+                /* The owner releases the alias and then goes away */
+                nameTable.RemoveAlias(alias, name, disposition);
+                Check(disposition == DBUS_RELEASE_NAME_REPLY_RELEASED);
+                nameTable.RemoveUniqueName(name);
+            }
+            Check(nameTable.FindEndpoint(alias)->GetUniqueName() == STABLE_NAME);
+
+            nameTable.RemoveAlias(alias, STABLE_NAME, disposition);
+            Check(disposition == DBUS_RELEASE_NAME_REPLY_RELEASED);
+            Check(!nameTable.FindEndpoint(alias)->IsValid());
+        }
+        return 0;
+    }
+
+  private:
+    void Check(bool ok)
+    {
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    NameTable& nameTable;
+    const size_t writer;
+    const size_t numNames;
+    const size_t rounds;
+};
+
+TEST(NameTableTest, FindEndpointWhileNamesChange)
+{
+    NameTable nameTable;
+    BusEndpoint stable = NewEndpoint(STABLE_NAME);
+    nameTable.AddUniqueName(stable);
+    uint32_t disposition;
+    ASSERT_EQ(ER_OK, nameTable.AddAlias(STABLE_ALIAS, STABLE_NAME, 0, disposition));
+    ASSERT_EQ(static_cast<uint32_t>(DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER), disposition);
+
+    static const size_t NUM_WRITERS = 3;
+    static const size_t NUM_NAMES = 8;
+    NameTableReader* readers[4];
+    for (size_t t = 0; t < ArraySize(readers); ++t) {
+        readers[t] = new NameTableReader(nameTable, NUM_WRITERS, NUM_NAMES);
+        readers[t]->Start();
+    }
+    NameTableWriter* writers[NUM_WRITERS];
+    for (size_t w = 0; w < NUM_WRITERS; ++w) {
+        writers[w] = new NameTableWriter(nameTable, w, NUM_NAMES, 2000);
+        writers[w]->Start();
+    }
+
+    for (size_t w = 0; w < NUM_WRITERS; ++w) {
+        writers[w]->Join();
+        EXPECT_EQ(static_cast<size_t>(0), writers[w]->failures);
+        delete writers[w];
+    }
+    for (size_t t = 0; t < ArraySize(readers); ++t) {
+        readers[t]->Stop();
+        readers[t]->Join();
+        EXPECT_EQ(static_cast<size_t>(0), readers[t]->failures);
+        EXPECT_GT(readers[t]->lookups, static_cast<size_t>(0));
+        delete readers[t];
+    }
+
+    /* Only the stable names are left */
+    EXPECT_TRUE(nameTable.FindEndpoint(STABLE_NAME) == stable);
+    EXPECT_TRUE(nameTable.FindEndpoint(STABLE_ALIAS) == stable);
+    for (size_t w = 0; w < NUM_WRITERS; ++w) {
+        for (size_t i = 0; i < NUM_NAMES; ++i) {
+            EXPECT_FALSE(nameTable.FindEndpoint(ChurnName(w, i))->IsValid());
+            EXPECT_FALSE(nameTable.FindEndpoint(ChurnAlias(w, i))->IsValid());
+        }
+    }
+}
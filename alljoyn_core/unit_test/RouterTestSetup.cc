@@ -0,0 +1,212 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include "RouterTestSetup.h"
+
+#include <algorithm>
+
+#include <qcc/GUID.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/AllJoynStd.h>
+#include <alljoyn/DBusStd.h>
+#include <alljoyn/Message.h>
+
+/* Private files included for unit testing */
+#include <BusInternal.h>
+#include <DaemonConfig.h>
+#include <DaemonTransport.h>
+
+using namespace qcc;
+using namespace std;
+
+namespace ajn {
+
+/*
+ * Stream with separate input and output.  Reads return whatever the test has
+ * fed so far without waiting for more.
+ */
+class RouterTestStream : public Stream {
+  public:
+    RouterTestStream() : inPos(0) { }
+
+    QStatus PullBytes(void* buf, size_t reqBytes, size_t& actualBytes, uint32_t timeout = Event::WAIT_FOREVER)
+    {
+        actualBytes = (std::min)(reqBytes, in.size() - inPos);
+        if (actualBytes == 0) {
+            return ER_TIMEOUT;
+        }
+        memcpy(buf, in.data() + inPos, actualBytes);
+        inPos += actualBytes;
+        return ER_OK;
+    }
+
+    QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent)
+    {
+        out.append((const char*)buf, numBytes);
+        numSent = numBytes;
+        return ER_OK;
+    }
+
+    qcc::String in;
+    size_t inPos;
+    qcc::String out;
+};
+
+class RouterTestMessage : public _Message {
+  public:
+    RouterTestMessage(BusAttachment& bus) : _Message(bus), peer(bus) { }
+
+    QStatus Hello(const char* iface, const char* wellKnownName, const char* path, const char* hello)
+    {
+        if (strcmp(hello, "BusHello") == 0) {
+            qcc::String guid = peer.GetInternal().GetGlobalGUID().ToString();
+            MsgArg args[2];
+            args[0].Set("s", guid.c_str());
+            args[1].Set("u", SessionOpts::ALL_NAMES << 30 | ALLJOYN_PROTOCOL_VERSION);
+            return CallMsg("su", wellKnownName, 0, path, iface, hello, args, ArraySize(args), 0);
+        } else {
+            return CallMsg("", wellKnownName, 0, path, iface, hello, NULL, 0, 0);
+        }
+    }
+
+    QStatus Deliver(RemoteEndpoint& ep) { return _Message::Deliver(ep); }
+
+  private:
+    BusAttachment& peer;
+};
+
+/*
+ * Endpoint that takes the type of its connection when it is authenticated
+ * rather than when it is started.
+ */
+class _RouterTestEndpoint : public _RemoteEndpoint {
+  public:
+    _RouterTestEndpoint(BusAttachment& bus, bool incoming, const qcc::String& connectSpec, Stream* stream) :
+        _RemoteEndpoint(bus, incoming, connectSpec, stream)
+    {
+    }
+
+    void SetEndpointType()
+    {
+        if (GetFeatures().isBusToBus) {
+            endpointType = ENDPOINT_TYPE_BUS2BUS;
+        }
+    }
+};
+
+typedef ManagedObj<_RouterTestEndpoint> RouterTestEndpoint;
+
+RouterTestSetup::RouterTestSetup() : bus(NULL), controller(NULL), client("RouterTestClient", false)
+{
+    factories.Add(new TransportFactory<DaemonTransport>(DaemonTransport::TransportName, false));
+}
+
+RouterTestSetup::~RouterTestSetup()
+{
+    if (controller) {
+        controller->Stop();
+        controller->Join();
+    }
+    delete controller;
+    delete bus;
+    while (!streams.empty()) {
+        delete streams.front();
+        streams.pop_front();
+    }
+}
+
+QStatus RouterTestSetup::Start()
+{
+    /* Nothing drains the transmit queues so they must hold everything the tests send */
+    DaemonConfig::Load("<busconfig><type>alljoyn</type><limit tx_queue_messages=\"1000000\" tx_queue_bytes=\"1000000000\"/></busconfig>");
+    /* The routing node must listen somewhere although nothing connects to it */
+    qcc::String listenSpec = "unix:abstract=routertest" + qcc::GUID128().ToString();
+    bus = new Bus("RouterTestSetup", factories, listenSpec.c_str());
+    controller = new BusController(*bus);
+    QStatus status = controller->Init(listenSpec);
+    if (status == ER_OK) {
+        status = client.Start();
+    }
+    return status;
+}
+
+QStatus RouterTestSetup::AddClient(RemoteEndpoint& ep)
+{
+    return Accept(client, org::freedesktop::DBus::InterfaceName, org::freedesktop::DBus::WellKnownName, org::freedesktop::DBus::ObjectPath,
+                  "Hello", ep);
+}
+
+QStatus RouterTestSetup::AddBusToBus(BusAttachment& remote, RemoteEndpoint& ep)
+{
+    return Accept(remote, org::alljoyn::Bus::InterfaceName, org::alljoyn::Bus::WellKnownName, org::alljoyn::Bus::ObjectPath,
+                  "BusHello", ep);
+}
+
+QStatus RouterTestSetup::Accept(BusAttachment& peer, const char* iface, const char* wellKnownName, const char* path, const char* hello,
+                                RemoteEndpoint& ep)
+{
+    /* The marshaled hello is captured from an endpoint of the peer */
+    RouterTestStream helloStream;
+    Stream* pHelloStream = &helloStream;
+    static const bool falsiness = false;
+    RemoteEndpoint helloEp(peer, falsiness, String::Empty, pHelloStream);
+    RouterTestMessage helloMsg(peer);
+    QStatus status = helloMsg.Hello(iface, wellKnownName, path, hello);
+    if (status == ER_OK) {
+        status = helloMsg.Deliver(helloEp);
+    }
+    if (status != ER_OK) {
+        return status;
+    }
+
+    RouterTestStream* stream = new RouterTestStream();
+    streams.push_back(stream);
+    stream->in = "AUTH ANONYMOUS\r\n"
+                 "INFORM_PROTO_VERSION " + U32ToString(ALLJOYN_PROTOCOL_VERSION) + "\r\n"
+                 "BEGIN " + peer.GetInternal().GetGlobalGUID().ToString() + "\r\n" + helloStream.out;
+
+    Stream* pStream = stream;
+    static const bool truthiness = true;
+    RouterTestEndpoint testEp(*bus, truthiness, String::Empty, pStream);
+    ep = RemoteEndpoint::cast(testEp);
+    ep->SetListener(this);
+    status = ep->StartAccept("ANONYMOUS");
+    if (status == ER_OK) {
+        qcc::String authUsed;
+        status = ep->ContinueAccept(authUsed);
+    }
+    if (status == ER_OK) {
+        testEp->SetEndpointType();
+        BusEndpoint busEndpoint = BusEndpoint::cast(ep);
+        status = GetRouter().RegisterEndpoint(busEndpoint);
+    }
+    return status;
+}
+
+void RouterTestSetup::Remove(RemoteEndpoint& ep)
+{
+    GetRouter().UnregisterEndpoint(ep->GetUniqueName(), ep->GetEndpointType());
+}
+
+size_t RouterTestSetup::QueuedMessages(RemoteEndpoint& ep)
+{
+    _RemoteEndpoint::TxQueueStats stats;
+    ep->GetTxQueueStats(stats);
+    return stats.depth;
+}
+
+}
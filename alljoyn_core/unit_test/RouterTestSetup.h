@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef ROUTERTESTSETUP_H
+#define ROUTERTESTSETUP_H
+
+#include <qcc/platform.h>
+
+#include <list>
+
+#include <qcc/Stream.h>
+#include <qcc/String.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <Bus.h>
+#include <BusController.h>
+#include <DaemonRouter.h>
+#include <RemoteEndpoint.h>
+#include <TransportFactory.h>
+
+/*
+ * A routing node for the tests of router internals.  Its only transport
+ * listens on a socket that nobody connects to; endpoints are authenticated over in-memory streams and registered with the
+ * router directly.  They are never started, so whatever the router sends them
+ * stays in their transmit queues where the tests can count it.
+ */
+namespace ajn {
+
+class RouterTestSetup : public _RemoteEndpoint::EndpointListener {
+  public:
+
+    RouterTestSetup();
+
+    ~RouterTestSetup();
+
+    /**
+     * Start the routing node.
+     */
+    QStatus Start();
+
+    Bus& GetBus() { return *bus; }
+
+    DaemonRouter& GetRouter() { return reinterpret_cast<DaemonRouter&>(bus->GetInternal().GetRouter()); }
+
+    BusController& GetBusController() { return *controller; }
+
+    /**
+     * Authenticate and register an endpoint of a client of this routing node.
+     *
+     * @param[out] ep   The endpoint.
+     */
+    QStatus AddClient(RemoteEndpoint& ep);
+
+    /**
+     * Authenticate and register a bus-to-bus endpoint from another routing node.
+     * Several endpoints from the same remote node are parallel links to it.
+     *
+     * @param remote    Bus attachment standing in for the remote routing node.
+     * @param[out] ep   The endpoint.
+     */
+    QStatus AddBusToBus(BusAttachment& remote, RemoteEndpoint& ep);
+
+    /**
+     * Unregister an endpoint as if it had disconnected.
+     */
+    void Remove(RemoteEndpoint& ep);
+
+    /**
+     * Number of messages the router has queued on an endpoint.
+     */
+    static size_t QueuedMessages(RemoteEndpoint& ep);
+
+    QStatus UntrustedClientStart() { return ER_OK; }
+
+    void EndpointExit(RemoteEndpoint& ep) { }
+
+  private:
+
+    QStatus Accept(BusAttachment& peer, const char* iface, const char* wellKnownName, const char* path, const char* hello,
+                   RemoteEndpoint& ep);
+
+    TransportFactoryContainer factories;
+    Bus* bus;
+    BusController* controller;
+    BusAttachment client;
+    std::list<qcc::Stream*> streams;
+};
+
+}
+
+#endif
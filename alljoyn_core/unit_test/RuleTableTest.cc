@@ -0,0 +1,213 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+#include <vector>
+
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/time.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <RemoteEndpoint.h>
+#include <RuleTable.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+class RuleTableTestMessage : public _Message {
+  public:
+
+    RuleTableTestMessage(BusAttachment& bus) : _Message(bus) { };
+
+    QStatus Signal(const char* objPath, const char* iface, const char* signalName)
+    {
+        return SignalMsg("", "", 0, objPath, iface, signalName, NULL, 0, 0, 0);
+    }
+};
+
+class RuleTableTest : public testing::Test {
+  public:
+    RuleTableTest() : bus("RuleTableTest", false) { }
+
+    virtual void TearDown()
+    {
+        eps.clear();
+    }
+
+    void AddEndpoints(size_t num)
+    {
+        static const bool falsiness = false;
+        qcc::Pipe* pStream = &pipe;
+        for (size_t i = 0; i < num; ++i) {
+            RemoteEndpoint ep(bus, falsiness, String::Empty, pStream);
+            eps.push_back(BusEndpoint::cast(ep));
+        }
+    }
+
+    Message MakeSignal(const char* iface, const char* member)
+    {
+        qcc::ManagedObj<RuleTableTestMessage> signal(bus);
+        EXPECT_EQ(ER_OK, signal->Signal("/rule/table/test", iface, member));
+        return Message::cast(signal);
+    }
+
+    /* The routing loop used before rules were indexed: evaluate every rule in the table */
+    void LinearMatch(const Message& msg, std::vector<BusEndpoint>& dests)
+    {
+        RuleIterator it = ruleTable.Begin();
+        while (it != ruleTable.End()) {
+            if (it->second.IsMatch(msg)) {
+                BusEndpoint dest = it->first;
+                dests.push_back(dest);
+                it = ruleTable.AdvanceToNextEndpoint(dest);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    BusAttachment bus;
+    qcc::Pipe pipe;
+    std::vector<BusEndpoint> eps;
+    RuleTable ruleTable;
+};
+
+TEST_F(RuleTableTest, WildcardBuckets)
+{
+    AddEndpoints(4);
+    ruleTable.AddRule(eps[0], Rule("type='signal',interface='org.test.A',member='Foo'"));
+    ruleTable.AddRule(eps[1], Rule("type='signal',interface='org.test.A'"));
+    ruleTable.AddRule(eps[2], Rule("type='signal',member='Foo'"));
+    ruleTable.AddRule(eps[3], Rule("type='signal'"));
+    /* A second matching rule must not cause a second delivery */
+    ruleTable.AddRule(eps[3], Rule("type='signal',interface='org.test.A',member='Foo'"));
+
+    std::vector<BusEndpoint> dests;
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.A", "Foo"), dests);
+    EXPECT_EQ((size_t)4, dests.size());
+
+    dests.clear();
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.A", "Bar"), dests);
+    ASSERT_EQ((size_t)2, dests.size());
+    EXPECT_TRUE((dests[0] == eps[1]) || (dests[1] == eps[1]));
+
+    dests.clear();
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.B", "Foo"), dests);
+    ASSERT_EQ((size_t)2, dests.size());
+    EXPECT_TRUE((dests[0] == eps[2]) || (dests[1] == eps[2]));
+
+    /* Rules that do not match the message type are filtered after the index lookup */
+    Rule methodRule("type='method_call',interface='org.test.B',member='Foo'");
+    ruleTable.AddRule(eps[0], methodRule);
+    dests.clear();
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.B", "Foo"), dests);
+    EXPECT_EQ((size_t)2, dests.size());
+
+    ruleTable.RemoveRule(eps[0], methodRule);
+    ruleTable.RemoveAllRules(eps[3]);
+    dests.clear();
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.B", "Foo"), dests);
+    ASSERT_EQ((size_t)1, dests.size());
+    EXPECT_TRUE(dests[0] == eps[2]);
+
+    for (size_t i = 0; i < eps.size(); ++i) {
+        ruleTable.RemoveAllRules(eps[i]);
+    }
+    dests.clear();
+    ruleTable.GetMatchingEndpoints(MakeSignal("org.test.A", "Foo"), dests);
+    EXPECT_TRUE(dests.empty());
+}
+
+/*
+ * Benchmark: route broadcast signals through a table of 10k rules, comparing a linear scan
+ * of every rule against the interface/member index.
+ */
+TEST_F(RuleTableTest, RoutingLatencyWithManyRules)
+{
+    static const size_t NUM_ENDPOINTS = 1000;
+    static const size_t RULES_PER_ENDPOINT = 10;
+    static const size_t NUM_IFACES = 500;
+    static const size_t NUM_MSGS = 1000;
+
+    AddEndpoints(NUM_ENDPOINTS);
+    for (size_t i = 0; i < NUM_ENDPOINTS; ++i) {
+        for (size_t j = 0; j < RULES_PER_ENDPOINT; ++j) {
+            qcc::String iface = "org.test.Iface" + U32ToString((i * RULES_PER_ENDPOINT + j) % NUM_IFACES);
+            qcc::String member = "Signal" + U32ToString(j);
+            qcc::String spec = "type='signal',interface='" + iface + "',member='" + member + "'";
+            /* Sprinkle in some rules that leave the member or everything unspecified */
+            if ((i % 100) == 0 && j == 0) {
+                spec = "type='signal'";
+            } else if ((i % 50) == 0 && j == 1) {
+                spec = "type='signal',interface='" + iface + "'";
+            }
+            ruleTable.AddRule(eps[i], Rule(spec.c_str()));
+        }
+    }
+
+    std::vector<Message> msgs;
+    for (size_t n = 0; n < NUM_MSGS; ++n) {
+        qcc::String iface = "org.test.Iface" + U32ToString(n % NUM_IFACES);
+        qcc::String member = "Signal" + U32ToString(n % RULES_PER_ENDPOINT);
+        msgs.push_back(MakeSignal(iface.c_str(), member.c_str()));
+    }
+
+    size_t linearMatches = 0;
+    uint64_t start = GetTimestamp64();
+    for (size_t n = 0; n < NUM_MSGS; ++n) {
+        std::vector<BusEndpoint> dests;
+        LinearMatch(msgs[n], dests);
+        linearMatches += dests.size();
+    }
+    uint64_t linearElapsed = GetTimestamp64() - start;
+
+    size_t indexedMatches = 0;
+    start = GetTimestamp64();
+    for (size_t n = 0; n < NUM_MSGS; ++n) {
+        std::vector<BusEndpoint> dests;
+        ruleTable.GetMatchingEndpoints(msgs[n], dests);
+        indexedMatches += dests.size();
+    }
+    uint64_t indexedElapsed = GetTimestamp64() - start;
+
+    printf("%u rules, %u signals: linear scan %.1f us/signal, indexed %.1f us/signal, %u deliveries\n",
+           (unsigned int)(NUM_ENDPOINTS * RULES_PER_ENDPOINT), (unsigned int)NUM_MSGS,
+           (1000.0 * linearElapsed) / NUM_MSGS, (1000.0 * indexedElapsed) / NUM_MSGS,
+           (unsigned int)indexedMatches);
+
+    EXPECT_EQ(linearMatches, indexedMatches);
+    for (size_t n = 0; n < NUM_MSGS; n += 97) {
+        std::vector<BusEndpoint> linearDests;
+        std::vector<BusEndpoint> indexedDests;
+        LinearMatch(msgs[n], linearDests);
+        ruleTable.GetMatchingEndpoints(msgs[n], indexedDests);
+        EXPECT_TRUE(linearDests == indexedDests);
+    }
+
+    for (size_t i = 0; i < NUM_ENDPOINTS; ++i) {
+        ruleTable.RemoveAllRules(eps[i]);
+    }
+}
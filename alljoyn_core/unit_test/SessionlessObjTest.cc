@@ -0,0 +1,223 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <limits>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/String.h>
+#include <qcc/Thread.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <SessionlessObj.h>
+
+#include "RouterTestSetup.h"
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace qcc;
+using namespace std;
+
+namespace ajn {
+
+class SessionlessObjTestMessage : public _Message {
+  public:
+    SessionlessObjTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    /*
+     * A sessionless signal; ttl is in seconds with 0 meaning it never expires
+     */
+    QStatus Signal(const char* member, uint32_t value, uint16_t ttl)
+    {
+        MsgArg arg("u", value);
+        return SignalMsg("u", NULL, 0, "/SessionlessObjTest", "org.alljoyn.SessionlessObjTest", member, &arg, 1, ALLJOYN_FLAG_SESSIONLESS, ttl);
+    }
+};
+
+class SessionlessObjTest : public testing::Test {
+  public:
+    SessionlessObjTest() : slObj(NULL) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, router.Start());
+        ASSERT_EQ(ER_OK, router.AddClient(requester));
+        slObj = &router.GetBusController().GetSessionlessObj();
+
+        /* Stop the worker so that only the tests purge and advertise the stored messages */
+        slObj->timer.Stop();
+        slObj->timer.Join();
+    }
+
+    /*
+     * Store a sessionless signal under the given change id
+     */
+    void Push(uint32_t changeId, const char* member, uint16_t ttl = 0)
+    {
+        ManagedObj<SessionlessObjTestMessage> testMsg(router.GetBus());
+        ASSERT_EQ(ER_OK, testMsg->Signal(member, changeId, ttl));
+        Message msg = Message::cast(testMsg);
+        slObj->lock.Lock();
+        slObj->curChangeId = changeId;
+        slObj->lock.Unlock();
+        /* The worker is stopped so kicking it fails */
+        slObj->PushMessage(msg);
+    }
+
+    /*
+     * Number of messages sent to the requester for a range request
+     */
+    size_t RequestRange(uint32_t fromId, uint32_t toId)
+    {
+        size_t before = RouterTestSetup::QueuedMessages(requester);
+        slObj->HandleRangeRequest(requester->GetUniqueName().c_str(), 0, fromId, toId);
+        return RouterTestSetup::QueuedMessages(requester) - before;
+    }
+
+    uint32_t Purge()
+    {
+        uint32_t tilExpire;
+        slObj->lock.Lock();
+        slObj->PurgeExpiredMessages(tilExpire);
+        slObj->lock.Unlock();
+        return tilExpire;
+    }
+
+    size_t NumMessages()
+    {
+        slObj->lock.Lock();
+        size_t num = slObj->messageMap.size();
+        EXPECT_EQ(num, slObj->changeIdIndex.size());
+        slObj->lock.Unlock();
+        return num;
+    }
+
+    size_t HeapSize()
+    {
+        slObj->lock.Lock();
+        size_t size = slObj->expiryHeap.size();
+        slObj->lock.Unlock();
+        return size;
+    }
+
+    /*
+     * Change id of the only stored message
+     */
+    uint32_t StoredChangeId()
+    {
+        slObj->lock.Lock();
+        uint32_t changeId = slObj->messageMap.empty() ? 0 : slObj->messageMap.begin()->second.first;
+        slObj->lock.Unlock();
+        return changeId;
+    }
+
+    RouterTestSetup router;
+    RemoteEndpoint requester;
+    SessionlessObj* slObj;
+};
+
+TEST_F(SessionlessObjTest, RangeRequestWrapsAroundTheChangeIds)
+{
+    Push(0xFFFFFFFE, "A");
+    Push(0xFFFFFFFF, "B");
+    Push(0, "C");
+    Push(1, "D");
+    Push(5, "E");
+    ASSERT_EQ(5U, NumMessages());
+
+    /* [0xFFFFFFFE, 2) is the end of the change ids followed by their beginning */
+    EXPECT_EQ(4U, RequestRange(0xFFFFFFFE, 2));
+    EXPECT_EQ(2U, RequestRange(0xFFFFFFFF, 1));
+    EXPECT_EQ(1U, RequestRange(0, 1));
+    EXPECT_EQ(5U, RequestRange(0xFFFFFFF0, 6));
+
+    /* Ranges that do not wrap */
+    EXPECT_EQ(2U, RequestRange(0xFFFFFFFE, 0));
+    EXPECT_EQ(1U, RequestRange(2, 0xFFFFFFFE));
+    EXPECT_EQ(0U, RequestRange(6, 0xFFFFFFFE));
+    EXPECT_EQ(0U, RequestRange(1, 1));
+}
+
+TEST_F(SessionlessObjTest, ReplacedMessageKeepsItsNewExpiry)
+{
+    /* The first message expires in a second but is replaced by one that never expires */
+    Push(10, "A", 1);
+    Push(11, "A");
+    ASSERT_EQ(1U, NumMessages());
+    EXPECT_EQ(11U, StoredChangeId());
+    EXPECT_EQ(1U, HeapSize());
+
+    /* The heap entry of the replaced message is skipped when it expires */
+    qcc::Sleep(1100);
+    EXPECT_EQ(numeric_limits<uint32_t>::max(), Purge());
+    EXPECT_EQ(1U, NumMessages());
+    EXPECT_EQ(11U, StoredChangeId());
+    EXPECT_EQ(0U, HeapSize());
+    EXPECT_EQ(1U, RequestRange(11, 12));
+
+    /* Replacing it with a message that expires adds a new heap entry */
+    Push(12, "A", 60);
+    uint32_t tilExpire = Purge();
+    EXPECT_GT(tilExpire, 50000U);
+    EXPECT_LE(tilExpire, 60000U);
+    EXPECT_EQ(1U, NumMessages());
+    EXPECT_EQ(1U, HeapSize());
+}
+
+TEST_F(SessionlessObjTest, ExpiredMessageIsPurged)
+{
+    Push(20, "A", 1);
+    Push(21, "B");
+    ASSERT_EQ(2U, NumMessages());
+
+    qcc::Sleep(1100);
+    EXPECT_EQ(numeric_limits<uint32_t>::max(), Purge());
+    EXPECT_EQ(1U, NumMessages());
+    EXPECT_EQ(21U, StoredChangeId());
+    EXPECT_EQ(0U, RequestRange(20, 21));
+}
+
+TEST_F(SessionlessObjTest, HeapIsRebuiltWhenMostlyStale)
+{
+    /* Each replacement leaves a stale heap entry behind */
+    static const uint32_t NUM_BELOW = 2 + 64;
+    for (uint32_t i = 0; i < NUM_BELOW; ++i) {
+        Push(100 + i, "A", 60);
+    }
+    ASSERT_EQ(1U, NumMessages());
+    Purge();
+    EXPECT_EQ(static_cast<size_t>(NUM_BELOW), HeapSize());
+
+    /* One more and the heap is larger than twice the number of messages plus 64 */
+    Push(100 + NUM_BELOW, "A", 60);
+    Purge();
+    EXPECT_EQ(1U, HeapSize());
+    EXPECT_EQ(100 + NUM_BELOW, StoredChangeId());
+
+    /* The rebuilt heap still expires the message */
+    uint32_t tilExpire = Purge();
+    EXPECT_GT(tilExpire, 50000U);
+    EXPECT_LE(tilExpire, 60000U);
+}
+
+}
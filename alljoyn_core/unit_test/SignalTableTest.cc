@@ -0,0 +1,191 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+#include <vector>
+
+#include <qcc/AtomTable.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/time.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/InterfaceDescription.h>
+#include <alljoyn/MessageReceiver.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <SignalTable.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+class SignalTableTestReceiver : public MessageReceiver {
+  public:
+    void Handler(const InterfaceDescription::Member* member, const char* srcPath, Message& message) { }
+    void OtherHandler(const InterfaceDescription::Member* member, const char* srcPath, Message& message) { }
+};
+
+class SignalTableTest : public testing::Test {
+  public:
+    SignalTableTest() : bus("SignalTableTest", false), iface(NULL) { }
+
+    virtual void SetUp()
+    {
+        InterfaceDescription* intf = NULL;
+        ASSERT_EQ(ER_OK, bus.CreateInterface("org.test.SignalTable", intf));
+        ASSERT_EQ(ER_OK, intf->AddSignal("Foo", "s", NULL, 0));
+        ASSERT_EQ(ER_OK, intf->AddSignal("Bar", "s", NULL, 0));
+        intf->Activate();
+        iface = intf;
+    }
+
+    BusAttachment bus;
+    const InterfaceDescription* iface;
+    SignalTable signalTable;
+};
+
+/*
+ * Count the handlers a signal would be dispatched to
+ */
+static size_t CountHandlers(SignalTable& signalTable, Atom iface, Atom signalName, const char* sourcePath)
+{
+    size_t count = 0;
+    const SignalTable::Dispatch* dispatch = signalTable.AcquireDispatch(iface, signalName);
+    if (dispatch) {
+        const vector<SignalTable::Dispatch::Handler>& handlers = dispatch->GetHandlers();
+        for (size_t i = 0; i < handlers.size(); ++i) {
+            if (handlers[i].Matches(iface, signalName, sourcePath)) {
+                ++count;
+            }
+        }
+    }
+    SignalTable::ReleaseDispatch(dispatch);
+    return count;
+}
+
+TEST_F(SignalTableTest, DispatchSnapshot)
+{
+    SignalTableTestReceiver receiver;
+    MessageReceiver::SignalHandler handler = static_cast<MessageReceiver::SignalHandler>(&SignalTableTestReceiver::Handler);
+    MessageReceiver::SignalHandler other = static_cast<MessageReceiver::SignalHandler>(&SignalTableTestReceiver::OtherHandler);
+    Atom ifaceAtom = AtomTable::Intern("org.test.SignalTable");
+    Atom fooAtom = AtomTable::Intern("Foo");
+    Atom barAtom = AtomTable::Intern("Bar");
+    const char* path = "/signal/table/test";
+    const char* otherPath = "/signal/table/other";
+
+    EXPECT_TRUE(signalTable.AcquireDispatch(ifaceAtom, fooAtom) == NULL);
+
+    signalTable.Add(&receiver, handler, iface->GetMember("Foo"), "");
+    signalTable.Add(&receiver, other, iface->GetMember("Foo"), "/signal/table/test");
+    signalTable.Add(&receiver, handler, iface->GetMember("Bar"), "");
+
+    EXPECT_EQ((size_t)2, CountHandlers(signalTable, ifaceAtom, fooAtom, path));
+    EXPECT_EQ((size_t)1, CountHandlers(signalTable, ifaceAtom, fooAtom, otherPath));
+    EXPECT_EQ((size_t)1, CountHandlers(signalTable, ifaceAtom, barAtom, otherPath));
+
+    /* Removing a handler publishes a new snapshot but the one in use stays intact */
+    const SignalTable::Dispatch* dispatch = signalTable.AcquireDispatch(ifaceAtom, fooAtom);
+    ASSERT_TRUE(dispatch != NULL);
+    size_t numHandlers = dispatch->GetHandlers().size();
+    signalTable.Remove(&receiver, other, iface->GetMember("Foo"), "/signal/table/test");
+    EXPECT_EQ(numHandlers, dispatch->GetHandlers().size());
+    SignalTable::ReleaseDispatch(dispatch);
+
+    EXPECT_EQ((size_t)1, CountHandlers(signalTable, ifaceAtom, fooAtom, path));
+    EXPECT_EQ((size_t)1, CountHandlers(signalTable, ifaceAtom, barAtom, path));
+
+    signalTable.RemoveAll(&receiver);
+    EXPECT_EQ((size_t)0, CountHandlers(signalTable, ifaceAtom, fooAtom, path));
+    EXPECT_EQ((size_t)0, CountHandlers(signalTable, ifaceAtom, barAtom, path));
+}
+
+TEST_F(SignalTableTest, SourcePathsAreNotInterned)
+{
+    SignalTableTestReceiver receiver;
+    MessageReceiver::SignalHandler handler = static_cast<MessageReceiver::SignalHandler>(&SignalTableTestReceiver::Handler);
+    const char* path = "/signal/table/not/interned";
+
+    signalTable.Add(&receiver, handler, iface->GetMember("Foo"), path);
+    EXPECT_EQ(AtomTable::UNKNOWN, AtomTable::Lookup(path));
+    EXPECT_EQ((size_t)1, CountHandlers(signalTable, AtomTable::Lookup("org.test.SignalTable"), AtomTable::Lookup("Foo"), path));
+    EXPECT_EQ((size_t)0, CountHandlers(signalTable, AtomTable::Lookup("org.test.SignalTable"), AtomTable::Lookup("Foo"), "/signal/table/other"));
+    signalTable.Remove(&receiver, handler, iface->GetMember("Foo"), path);
+    EXPECT_EQ((size_t)0, CountHandlers(signalTable, AtomTable::Lookup("org.test.SignalTable"), AtomTable::Lookup("Foo"), path));
+}
+
+/*
+ * Benchmark: the cost of finding the handlers for a signal, including the atom table lookups of
+ * the interface and member strings that each received message does once, and the cost of
+ * adding and removing a handler while many others are registered.
+ */
+TEST_F(SignalTableTest, DispatchCost)
+{
+    static const size_t NUM_INTERFACES = 100;
+    static const uint32_t NUM_LOOKUPS = 100000;
+
+    vector<SignalTableTestReceiver> receivers(NUM_INTERFACES);
+    MessageReceiver::SignalHandler handler = static_cast<MessageReceiver::SignalHandler>(&SignalTableTestReceiver::Handler);
+    for (size_t i = 0; i < NUM_INTERFACES; ++i) {
+        InterfaceDescription* intf = NULL;
+        qcc::String name = "org.test.SignalTable.I" + U32ToString(i);
+        ASSERT_EQ(ER_OK, bus.CreateInterface(name.c_str(), intf));
+        ASSERT_EQ(ER_OK, intf->AddSignal("Foo", "s", NULL, 0));
+        intf->Activate();
+        signalTable.Add(&receivers[i], handler, intf->GetMember("Foo"), "");
+    }
+    const char* ifaceName = "org.test.SignalTable.I42";
+    const char* memberName = "Foo";
+    const char* path = "/signal/table/test";
+
+    uint64_t start = GetTimestamp64();
+    size_t found = 0;
+    for (uint32_t n = 0; n < NUM_LOOKUPS; ++n) {
+        found += CountHandlers(signalTable, AtomTable::Lookup(ifaceName), AtomTable::Lookup(memberName), path);
+    }
+    uint64_t withAtomLookups = GetTimestamp64() - start;
+    EXPECT_EQ((size_t)NUM_LOOKUPS, found);
+
+    Atom ifaceAtom = AtomTable::Lookup(ifaceName);
+    Atom memberAtom = AtomTable::Lookup(memberName);
+    start = GetTimestamp64();
+    found = 0;
+    for (uint32_t n = 0; n < NUM_LOOKUPS; ++n) {
+        found += CountHandlers(signalTable, ifaceAtom, memberAtom, path);
+    }
+    uint64_t withAtoms = GetTimestamp64() - start;
+    EXPECT_EQ((size_t)NUM_LOOKUPS, found);
+
+    start = GetTimestamp64();
+    for (uint32_t n = 0; n < NUM_LOOKUPS / 10; ++n) {
+        signalTable.Add(&receivers[0], handler, iface->GetMember("Foo"), "");
+        signalTable.Remove(&receivers[0], handler, iface->GetMember("Foo"), NULL);
+    }
+    uint64_t addRemove = GetTimestamp64() - start;
+
+    printf("%u signal lookups with %u handlers: %u ms including atom lookups, %u ms with atoms resolved\n",
+           NUM_LOOKUPS, (unsigned int)NUM_INTERFACES, (unsigned int)withAtomLookups, (unsigned int)withAtoms);
+    printf("%u add/remove pairs with %u handlers: %u ms\n", NUM_LOOKUPS / 10, (unsigned int)NUM_INTERFACES, (unsigned int)addRemove);
+
+    for (size_t i = 0; i < NUM_INTERFACES; ++i) {
+        signalTable.RemoveAll(&receivers[i]);
+    }
+}
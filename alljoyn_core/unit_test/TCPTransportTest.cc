@@ -0,0 +1,246 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/Event.h>
+#include <qcc/IPAddress.h>
+#include <qcc/Socket.h>
+#include <qcc/String.h>
+#include <qcc/Thread.h>
+#include <qcc/Timer.h>
+#include <qcc/time.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <Bus.h>
+#include <BusInternal.h>
+#include <DaemonConfig.h>
+#include <TCPTransport.h>
+#include <TransportFactory.h>
+#include <ns/IpNameService.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace ajn;
+using namespace qcc;
+using namespace std;
+
+/*
+ * A transport whose auth workers are supplied by the test instead of being
+ * created by the server accept loop, which is never started.
+ */
+class TCPTransportTestTransport : public TCPTransport {
+  public:
+    TCPTransportTestTransport(BusAttachment& bus, Timer& authWorkers) : TCPTransport(bus)
+    {
+        m_authDispatcher = &authWorkers;
+    }
+
+    ~TCPTransportTestTransport()
+    {
+        m_authDispatcher = NULL;
+    }
+
+    using TCPTransport::DispatchAuth;
+};
+
+/*
+ * Keeps the only auth worker busy until it is released.
+ */
+class TCPTransportTestBlocker : public AlarmListener {
+  public:
+    void AlarmTriggered(const Alarm& alarm, QStatus reason)
+    {
+        running.SetEvent();
+        Event::Wait(release, 5000);
+    }
+
+    Event running;
+    Event release;
+};
+
+static const bool truthiness = true;
+
+class TCPTransportTest : public testing::Test {
+  public:
+    TCPTransportTest() : authWorkers("TCPTransportTest", true, 1), bus(NULL), transport(NULL), conn(NULL), peerFd(qcc::INVALID_SOCKET_FD) { }
+
+    virtual void SetUp()
+    {
+        DaemonConfig::Load("<busconfig><type>alljoyn</type></busconfig>");
+        bus = new Bus("TCPTransportTest", factories);
+        /*
+         * Authenticating connections are watched by the bus IODispatch
+         */
+        ASSERT_EQ(ER_OK, bus->Start());
+        /*
+         * The transport releases the name service when it is joined
+         */
+        IpNameService::Instance().Acquire(bus->GetInternal().GetGlobalGUID().ToString());
+        transport = new TCPTransportTestTransport(*bus, authWorkers);
+    }
+
+    virtual void TearDown()
+    {
+        authWorkers.Stop();
+        authWorkers.Join();
+        if (conn) {
+            (*conn)->AuthJoin();
+        }
+        delete conn;
+        if (peerFd != qcc::INVALID_SOCKET_FD) {
+            qcc::Close(peerFd);
+        }
+        delete transport;
+        bus->Stop();
+        bus->Join();
+        delete bus;
+    }
+
+    /*
+     * Create an incoming connection that is waiting for its client to send
+     * something in order to continue a non-blocking authentication.
+     */
+    void Accept()
+    {
+        SocketFd fds[2];
+        ASSERT_EQ(ER_OK, SocketPair(fds));
+        peerFd = fds[1];
+        TCPTransport* t = transport;
+        qcc::String connectSpec("tcp:");
+        IPAddress addr("127.0.0.1");
+        uint16_t port = 0;
+        conn = new TCPEndpoint(t, *bus, truthiness, connectSpec, fds[0], addr, port);
+        ASSERT_EQ(ER_OK, (*conn)->Authenticate());
+        ASSERT_TRUE((*conn)->IsAuthNonBlocking());
+        ASSERT_TRUE((*conn)->IsAuthWaiting());
+    }
+
+    /*
+     * Wait for an auth worker to hand the endpoint back in the given state.
+     * The worker holds a reference to the endpoint until it is done with it.
+     */
+    bool WaitForAuthState(_TCPEndpoint::AuthState state)
+    {
+        uint64_t deadline = GetTimestamp64() + 5000;
+        while (GetTimestamp64() < deadline) {
+            if (((*conn)->GetAuthState() == state) && (conn->GetRefCount() == 1)) {
+                return true;
+            }
+            qcc::Sleep(5);
+        }
+        return false;
+    }
+
+    Timer authWorkers;
+    TransportFactoryContainer factories;
+    Bus* bus;
+    TCPTransportTestTransport* transport;
+    TCPEndpoint* conn;
+    SocketFd peerFd;
+};
+
+TEST_F(TCPTransportTest, AuthStopIdle)
+{
+    ASSERT_NO_FATAL_FAILURE(Accept());
+    TCPEndpoint& ep = *conn;
+
+    /*
+     * No auth worker has the endpoint so the authentication fails right away
+     */
+    ep->AuthStop();
+    EXPECT_EQ(_TCPEndpoint::AUTH_FAILED, ep->GetAuthState());
+    EXPECT_FALSE(ep->IsAuthWaiting());
+    ep->AuthJoin();
+    EXPECT_EQ(1, ep.GetRefCount());
+}
+
+TEST_F(TCPTransportTest, AuthStopWhileWorkerOwnsEndpoint)
+{
+    ASSERT_EQ(ER_OK, authWorkers.Start());
+    ASSERT_NO_FATAL_FAILURE(Accept());
+    TCPEndpoint& ep = *conn;
+
+    TCPTransportTestBlocker blocker;
+    AlarmListener* listener = &blocker;
+    ASSERT_EQ(ER_OK, authWorkers.AddAlarm(Alarm(listener)));
+    ASSERT_EQ(ER_OK, Event::Wait(blocker.running, 5000));
+
+    /*
+     * The endpoint now belongs to an auth worker, which has not run it yet
+     */
+    transport->DispatchAuth(ep);
+    EXPECT_FALSE(ep->IsAuthWaiting());
+    EXPECT_EQ(2, ep.GetRefCount());
+
+    /*
+     * Stopping the authentication must leave the endpoint alone until the
+     * worker is done with it
+     */
+    ep->AuthStop();
+    EXPECT_EQ(_TCPEndpoint::AUTH_AUTHENTICATING, ep->GetAuthState());
+    EXPECT_FALSE(ep->IsAuthWaiting());
+
+    /*
+     * The client has sent nothing so without the stop the worker would hand
+     * the endpoint back still authenticating
+     */
+    blocker.release.SetEvent();
+    EXPECT_TRUE(WaitForAuthState(_TCPEndpoint::AUTH_FAILED));
+    EXPECT_FALSE(ep->IsAuthWaiting());
+}
+
+TEST_F(TCPTransportTest, DispatchAuthWorkersStopped)
+{
+    ASSERT_NO_FATAL_FAILURE(Accept());
+    TCPEndpoint& ep = *conn;
+
+    /*
+     * The auth workers have not been started so they refuse the endpoint,
+     * which fails the authentication instead of leaving it owned by nobody
+     */
+    transport->DispatchAuth(ep);
+    EXPECT_EQ(_TCPEndpoint::AUTH_FAILED, ep->GetAuthState());
+    EXPECT_FALSE(ep->IsAuthWaiting());
+    EXPECT_EQ(1, ep.GetRefCount());
+
+    /*
+     * A failed endpoint is not dispatched again
+     */
+    transport->DispatchAuth(ep);
+    EXPECT_EQ(_TCPEndpoint::AUTH_FAILED, ep->GetAuthState());
+    EXPECT_EQ(1, ep.GetRefCount());
+}
+
+TEST_F(TCPTransportTest, ReadableConnectionIsDispatched)
+{
+    ASSERT_EQ(ER_OK, authWorkers.Start());
+    ASSERT_NO_FATAL_FAILURE(Accept());
+    TCPEndpoint& ep = *conn;
+
+    /*
+     * The accept loop is not running, so only IODispatch can notice that the
+     * client went away and hand the endpoint to an auth worker
+     */
+    qcc::Close(peerFd);
+    peerFd = qcc::INVALID_SOCKET_FD;
+    EXPECT_TRUE(WaitForAuthState(_TCPEndpoint::AUTH_FAILED));
+    EXPECT_FALSE(ep->IsAuthWaiting());
+    ep->AuthJoin();
+    EXPECT_EQ(1, ep.GetRefCount());
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <qcc/platform.h>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/Pipe.h>
+#include <qcc/String.h>
+#include <qcc/Util.h>
+
+#include <alljoyn/BusAttachment.h>
+#include <alljoyn/Message.h>
+#include <alljoyn/MsgArg.h>
+#include <alljoyn/Session.h>
+
+#include <alljoyn/Status.h>
+
+/* Private files included for unit testing */
+#include <RemoteEndpoint.h>
+#include <VirtualEndpoint.h>
+
+/* Header files included for Google Test Framework */
+#include <gtest/gtest.h>
+
+using namespace qcc;
+using namespace std;
+using namespace ajn;
+
+class VirtualEndpointTestMessage : public _Message {
+  public:
+    VirtualEndpointTestMessage(BusAttachment& bus) : _Message(bus) { }
+
+    QStatus Signal()
+    {
+        MsgArg arg("u", 0);
+        return SignalMsg("u", NULL, 0, "/VirtualEndpointTest", "org.alljoyn.VirtualEndpointTest", "Signal", &arg, 1, 0, 0);
+    }
+};
+
+/*
+ * A virtual endpoint with three routes over bus-to-bus endpoints that are never
+ * started, so that whatever is pushed to them stays in their transmit queues.
+ */
+class VirtualEndpointTest : public testing::Test {
+  public:
+    VirtualEndpointTest() : bus("VirtualEndpointTest", false), nextId(1) { }
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(ER_OK, bus.Start());
+        for (size_t i = 0; i < ArraySize(links); ++i) {
+            Stream* stream = &streams[i];
+            static const bool truthiness = true;
+            links[i] = RemoteEndpoint(bus, truthiness, String::Empty, stream);
+            /* The reference of the connection itself; links are stopped when they have none */
+            links[i]->IncrementRef();
+        }
+        vep = VirtualEndpoint(":remote.2", links[0]);
+        vep->AddBusToBusEndpoint(links[1]);
+        vep->AddBusToBusEndpoint(links[2]);
+    }
+
+    /*
+     * Set up a new session and return the index of the link it is routed over
+     */
+    size_t AddSession(SessionId* sessionId = NULL)
+    {
+        SessionId id = nextId++;
+        SessionOpts opts;
+        RemoteEndpoint b2bEp;
+        EXPECT_EQ(ER_OK, vep->AddSessionRef(id, &opts, b2bEp));
+        if (sessionId) {
+            *sessionId = id;
+        }
+        for (size_t i = 0; i < ArraySize(links); ++i) {
+            if (b2bEp == links[i]) {
+                return i;
+            }
+        }
+        ADD_FAILURE() << "Session routed over an unknown endpoint";
+        return ArraySize(links);
+    }
+
+    void Queue(size_t link, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            ManagedObj<VirtualEndpointTestMessage> testMsg(bus);
+            ASSERT_EQ(ER_OK, testMsg->Signal());
+            Message msg = Message::cast(testMsg);
+            ASSERT_EQ(ER_OK, links[link]->PushMessage(msg));
+        }
+    }
+
+    BusAttachment bus;
+    Pipe streams[3];
+    RemoteEndpoint links[3];
+    VirtualEndpoint vep;
+    SessionId nextId;
+};
+
+TEST_F(VirtualEndpointTest, SessionsAreSpreadOverEqualRoutes)
+{
+    size_t count[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < 9; ++i) {
+        ++count[AddSession()];
+    }
+    EXPECT_EQ(3U, count[0]);
+    EXPECT_EQ(3U, count[1]);
+    EXPECT_EQ(3U, count[2]);
+}
+
+TEST_F(VirtualEndpointTest, QueuedMessagesCountAsLoad)
+{
+    Queue(0, 4);
+    size_t count[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < 6; ++i) {
+        ++count[AddSession()];
+    }
+    EXPECT_EQ(0U, count[0]);
+    EXPECT_EQ(3U, count[1]);
+    EXPECT_EQ(3U, count[2]);
+}
+
+TEST_F(VirtualEndpointTest, RemovedSessionsNoLongerCountAsLoad)
+{
+    SessionId ids[6];
+    size_t route[6];
+    for (size_t i = 0; i < 6; ++i) {
+        route[i] = AddSession(&ids[i]);
+    }
+    /* Take both sessions off one of the links; the next two sessions go there */
+    size_t freed = route[0];
+    for (size_t i = 0; i < 6; ++i) {
+        if (route[i] == freed) {
+            vep->RemoveSessionRef(ids[i]);
+        }
+    }
+    EXPECT_EQ(freed, AddSession());
+    EXPECT_EQ(freed, AddSession());
+
+    /* A session that already has a route keeps it */
+    SessionOpts opts;
+    RemoteEndpoint b2bEp;
+    ASSERT_EQ(ER_OK, vep->AddSessionRef(ids[1], &opts, b2bEp));
+    EXPECT_TRUE(b2bEp == links[route[1]]);
+}
+
+TEST_F(VirtualEndpointTest, RemovedRouteNoLongerCountsSessions)
+{
+    for (size_t i = 0; i < 6; ++i) {
+        AddSession();
+    }
+    vep->RemoveBusToBusEndpoint(links[0]);
+    vep->AddBusToBusEndpoint(links[0]);
+    EXPECT_EQ(0U, AddSession());
+    EXPECT_EQ(0U, AddSession());
+}
+
+TEST_F(VirtualEndpointTest, UnmeasuredRouteIsNotTakenForFast)
+{
+    /* Busy links are not probed so the busiest link is the one without a round trip time */
+    Queue(0, 4);
+    links[1]->AddRttSample(50);
+    links[2]->AddRttSample(50);
+    EXPECT_NE(0U, AddSession());
+    EXPECT_NE(0U, AddSession());
+}
+
+TEST_F(VirtualEndpointTest, FasterRoutesGetMoreSessions)
+{
+    links[0]->AddRttSample(10);
+    links[1]->AddRttSample(40);
+    /* No round trip time counts as the mean of the others */
+    size_t count[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < 12; ++i) {
+        ++count[AddSession()];
+    }
+    EXPECT_GT(count[0], count[2]);
+    EXPECT_GT(count[2], count[1]);
+    /* The slow link is still used, just less */
+    EXPECT_GT(count[1], 0U);
+}
+
+TEST_F(VirtualEndpointTest, RoundTripTimeDoesNotOutweighLoad)
+{
+    /* The round trip time scales the load by no more than twice, so a long queue still counts */
+    links[0]->AddRttSample(1);
+    links[1]->AddRttSample(1000);
+    links[2]->AddRttSample(1000);
+    Queue(0, 20);
+    EXPECT_NE(0U, AddSession());
+}
@@ -25,12 +25,16 @@
 #include <algorithm>
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
+#include <vector>
 
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
 #include <qcc/Crypto.h>
 #include <qcc/KeyBlob.h>
+#include <qcc/Mutex.h>
+#include <qcc/Util.h>
 
 #include <Status.h>
 #include "OpenSsl.h"
@@ -52,19 +56,169 @@ static void Trace(const char* tag, void* data, size_t len)
 #define Trace(x, y, z)
 #endif
 
+/*
+ * The EVP interface has provided AES-CCM since OpenSSL 1.0.1
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x10001000L
+#define QCC_EVP_CCM
+#endif
+
+#ifdef QCC_EVP_CCM
+/*
+ * Number of length octets the EVP CCM contexts are keyed for. Every nonce of up to 11 octets is
+ * zero padded to 11 octets and so uses 4 length octets.
+ */
+static const uint8_t EVP_CCM_L = 4;
+
+/*
+ * An EVP CCM cipher context keyed for one direction and authentication field length. OpenSSL fixes
+ * the direction, the authentication field length and the number of length octets when the key is
+ * set, so the key is expanded once into a template context for each combination that is supported.
+ * Cipher contexts carry per-operation state so each operation works on its own copy of the template,
+ * the copies are kept in a pool and reused by resetting only the nonce.
+ */
+class CCMContext {
+  public:
+
+    CCMContext() : authLen(0), encrypt(false), keyed(NULL) { }
+
+    ~CCMContext()
+    {
+        while (!idle.empty()) {
+            EVP_CIPHER_CTX_free(idle.back());
+            idle.pop_back();
+        }
+        if (keyed) {
+            EVP_CIPHER_CTX_free(keyed);
+        }
+    }
+
+    bool Init(const EVP_CIPHER* cipher, const uint8_t* key, uint8_t authLen, bool encrypt)
+    {
+        keyed = EVP_CIPHER_CTX_new();
+        if (keyed &&
+            (EVP_CipherInit_ex(keyed, cipher, NULL, NULL, NULL, encrypt) == 1) &&
+            (EVP_CIPHER_CTX_ctrl(keyed, EVP_CTRL_CCM_SET_IVLEN, 15 - EVP_CCM_L, NULL) == 1) &&
+            (EVP_CIPHER_CTX_ctrl(keyed, EVP_CTRL_CCM_SET_TAG, authLen, NULL) == 1) &&
+            (EVP_CipherInit_ex(keyed, NULL, NULL, key, NULL, encrypt) == 1)) {
+            this->authLen = authLen;
+            this->encrypt = encrypt;
+        } else {
+            EVP_CIPHER_CTX_free(keyed);
+            keyed = NULL;
+        }
+        return keyed != NULL;
+    }
+
+    /*
+     * Get a keyed context for one operation, returns NULL if a context could not be allocated.
+     */
+    EVP_CIPHER_CTX* Acquire()
+    {
+        EVP_CIPHER_CTX* ctx = NULL;
+        lock.Lock();
+        if (!idle.empty()) {
+            ctx = idle.back();
+            idle.pop_back();
+        }
+        lock.Unlock();
+        if (!ctx) {
+            ctx = EVP_CIPHER_CTX_new();
+            if (ctx && (EVP_CIPHER_CTX_copy(ctx, keyed) != 1)) {
+                EVP_CIPHER_CTX_free(ctx);
+                ctx = NULL;
+            }
+        }
+        return ctx;
+    }
+
+    /*
+     * Return a context to the pool once the operation has completed.
+     */
+    void Release(EVP_CIPHER_CTX* ctx)
+    {
+        lock.Lock();
+        idle.push_back(ctx);
+        lock.Unlock();
+    }
+
+    uint8_t authLen;   /* Authentication field length or zero if the context could not be keyed */
+    bool encrypt;      /* True if the context is keyed for encryption */
+
+  private:
+
+    EVP_CIPHER_CTX* keyed;
+    Mutex lock;
+    std::vector<EVP_CIPHER_CTX*> idle;
+};
+#endif
+
+/*
+ * The OpenSSL AES primitives only operate on the key schedule and buffers passed in by the caller
+ * and have no shared state, so unlike the rest of the OpenSSL wrappers they are called without
+ * taking the OpenSSL lock. An instance of this class can be used by several threads at once for
+ * CCM mode because the key schedule and the keyed EVP templates are never modified after they
+ * have been constructed.
+ */
 struct Crypto_AES::KeyState {
+
     AES_KEY key;
-};
 
-Crypto_AES::Crypto_AES(const KeyBlob& key, Mode mode) : mode(mode), keyState(new KeyState())
-{
+#ifdef QCC_EVP_CCM
     /*
-     * Protect the open ssl APIs.
+     * EVP contexts for encryption and decryption with the authentication field lengths used by
+     * AllJoyn, other lengths use the block-at-a-time implementation.
      */
-    OpenSsl_ScopedLock lock;
+    CCMContext ccm[4];
 
+    void InitCCM(const KeyBlob& keyBlob)
+    {
+        const EVP_CIPHER* cipher;
+        switch (keyBlob.GetSize()) {
+        case 16:
+            cipher = EVP_aes_128_ccm();
+            break;
+
+        case 24:
+            cipher = EVP_aes_192_ccm();
+            break;
+
+        case 32:
+            cipher = EVP_aes_256_ccm();
+            break;
+
+        default:
+            return;
+        }
+        ccm[0].Init(cipher, keyBlob.GetData(), 8, true);
+        ccm[1].Init(cipher, keyBlob.GetData(), 8, false);
+        ccm[2].Init(cipher, keyBlob.GetData(), 16, true);
+        ccm[3].Init(cipher, keyBlob.GetData(), 16, false);
+    }
+
+    CCMContext* GetCCM(bool encrypt, uint8_t authLen, uint8_t L)
+    {
+        if (L == EVP_CCM_L) {
+            for (size_t i = 0; i < ArraySize(ccm); ++i) {
+                if ((ccm[i].authLen == authLen) && (ccm[i].encrypt == encrypt)) {
+                    return &ccm[i];
+                }
+            }
+        }
+        return NULL;
+    }
+#endif
+};
+
+Crypto_AES::Crypto_AES(const KeyBlob& key, Mode mode) : mode(mode), keyState(new KeyState())
+{
     if ((mode == ECB_ENCRYPT) || (mode == CCM)) {
         AES_set_encrypt_key((unsigned char*)key.GetData(), key.GetSize() * 8, &keyState->key);
+#ifdef QCC_EVP_CCM
+        if (mode == CCM) {
+            keyState->InitCCM(key);
+        }
+#endif
     } else {
         AES_set_decrypt_key((unsigned char*)key.GetData(), key.GetSize() * 8, &keyState->key);
     }
@@ -77,10 +231,6 @@ Crypto_AES::~Crypto_AES()
 
 QStatus Crypto_AES::Encrypt(const Block* in, Block* out, uint32_t numBlocks)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     if (!in || !out) {
         return in ? ER_BAD_ARG_1 : ER_BAD_ARG_2;
     }
@@ -100,10 +250,6 @@ QStatus Crypto_AES::Encrypt(const Block* in, Block* out, uint32_t numBlocks)
 
 QStatus Crypto_AES::Encrypt(const void* in, size_t len, Block* out, uint32_t numBlocks)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     QStatus status;
 
     if (!in || !out) {
@@ -135,10 +281,6 @@ QStatus Crypto_AES::Encrypt(const void* in, size_t len, Block* out, uint32_t num
 
 QStatus Crypto_AES::Decrypt(const Block* in, Block* out, uint32_t numBlocks)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     if (!in || !out) {
         return in ? ER_BAD_ARG_1 : ER_BAD_ARG_2;
     }
@@ -158,10 +300,6 @@ QStatus Crypto_AES::Decrypt(const Block* in, Block* out, uint32_t numBlocks)
 
 QStatus Crypto_AES::Decrypt(const Block* in, uint32_t numBlocks, void* out, size_t len)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     QStatus status;
 
     if (!in || !out) {
@@ -281,6 +419,60 @@ static void Compute_CCM_AuthField(AES_KEY* key, Crypto_AES::Block& T, uint8_t M,
 }
 
 
+#ifdef QCC_EVP_CCM
+/*
+ * AES-CCM using the OpenSSL EVP interface. This computes the CBC-MAC and the CTR encryption in a
+ * single pass over the data and uses the AES instructions of the CPU when they are available.
+ *
+ * Returns ER_NOT_IMPLEMENTED without touching the data if the EVP cipher cannot be used for these
+ * parameters, the caller must then fall back to the block-at-a-time implementation.
+ */
+static QStatus EVP_CCM(CCMContext& ccm, const uint8_t* nonce, const uint8_t* in, uint8_t* out, size_t len,
+                       const uint8_t* addData, size_t addLen, uint8_t* tag)
+{
+    if ((len == 0) || (len > INT_MAX) || (addLen > INT_MAX)) {
+        return ER_NOT_IMPLEMENTED;
+    }
+    EVP_CIPHER_CTX* ctx = ccm.Acquire();
+    if (!ctx) {
+        return ER_NOT_IMPLEMENTED;
+    }
+    const bool encrypt = ccm.encrypt;
+    QStatus status = ER_NOT_IMPLEMENTED;
+    int outLen;
+    /*
+     * The context is already keyed so only the nonce and the expected authentication field are set
+     */
+    if ((EVP_CipherInit_ex(ctx, NULL, NULL, NULL, nonce, encrypt) == 1) &&
+        (encrypt || (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_SET_TAG, ccm.authLen, tag) == 1)) &&
+        (EVP_CipherUpdate(ctx, NULL, &outLen, NULL, (int)len) == 1) &&
+        (!addLen || (EVP_CipherUpdate(ctx, NULL, &outLen, addData, (int)addLen) == 1))) {
+        /*
+         * For decryption the update fails if the authentication field does not verify
+         */
+        if (EVP_CipherUpdate(ctx, out, &outLen, in, (int)len) > 0) {
+            if (!encrypt || (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_CCM_GET_TAG, ccm.authLen, tag) == 1)) {
+                status = ER_OK;
+            } else {
+                status = ER_CRYPTO_ERROR;
+            }
+        } else {
+            status = encrypt ? ER_CRYPTO_ERROR : ER_AUTH_FAIL;
+        }
+    }
+    /*
+     * A completed operation leaves the context ready for the next nonce, anything else may have
+     * left it part way through an operation.
+     */
+    if ((status == ER_OK) || (status == ER_AUTH_FAIL)) {
+        ccm.Release(ctx);
+    } else {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    return status;
+}
+#endif
+
 static inline uint8_t LengthOctetsFor(size_t len)
 {
     if (len <= 0xFFFF) {
@@ -297,10 +489,6 @@ static inline uint8_t LengthOctetsFor(size_t len)
  */
 QStatus Crypto_AES::Encrypt_CCM(const void* in, void* out, size_t& len, const KeyBlob& nonce, const void* addData, size_t addLen, uint8_t authLen)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     /*
      * Check we are initialized for CCM
      */
@@ -325,16 +513,29 @@ QStatus Crypto_AES::Encrypt_CCM(const void* in, void* out, size_t& len, const Ke
         return ER_BAD_ARG_3;
     }
     /*
-     * Compute the authentication field T.
-     */
-    Block T;
-    Compute_CCM_AuthField(&keyState->key, T, authLen, L, nonce, (uint8_t*)in, len, (uint8_t*)addData, addLen);
-    /*
-     * Initialize ivec and other initial args.
+     * Initialize ivec and other initial args. The nonce is zero padded to 15 - L bytes.
      */
     Block ivec(0);
     ivec.data[0] = (L - 1);
     memcpy(&ivec.data[1], nonce.GetData(), nLen);
+#ifdef QCC_EVP_CCM
+    CCMContext* ccm = keyState->GetCCM(true, authLen, L);
+    if (ccm) {
+        QStatus status = EVP_CCM(*ccm, &ivec.data[1], (const uint8_t*)in, (uint8_t*)out, len,
+                                 (const uint8_t*)addData, addLen, (uint8_t*)out + len);
+        if (status != ER_NOT_IMPLEMENTED) {
+            if (status == ER_OK) {
+                len += authLen;
+            }
+            return status;
+        }
+    }
+#endif
+    /*
+     * Compute the authentication field T.
+     */
+    Block T;
+    Compute_CCM_AuthField(&keyState->key, T, authLen, L, nonce, (uint8_t*)in, len, (uint8_t*)addData, addLen);
     unsigned int num = 0;
     Block ecount_buf(0);
     /*
@@ -352,10 +553,6 @@ QStatus Crypto_AES::Encrypt_CCM(const void* in, void* out, size_t& len, const Ke
 
 QStatus Crypto_AES::Decrypt_CCM(const void* in, void* out, size_t& len, const KeyBlob& nonce, const void* addData, size_t addLen, uint8_t authLen)
 {
-    /*
-     * Protect the open ssl APIs.
-     */
-    OpenSsl_ScopedLock lock;
     /*
      * Check we are initialized for CCM
      */
@@ -385,6 +582,24 @@ QStatus Crypto_AES::Decrypt_CCM(const void* in, void* out, size_t& len, const Ke
     Block ivec(0);
     ivec.data[0] = (L - 1);
     memcpy(&ivec.data[1], nonce.GetData(), nLen);
+#ifdef QCC_EVP_CCM
+    CCMContext* ccm = keyState->GetCCM(false, authLen, L);
+    if (ccm) {
+        uint8_t tag[16];
+        memcpy(tag, (const uint8_t*)in + len - authLen, authLen);
+        QStatus status = EVP_CCM(*ccm, &ivec.data[1], (const uint8_t*)in, (uint8_t*)out, len - authLen,
+                                 (const uint8_t*)addData, addLen, tag);
+        if (status == ER_OK) {
+            len -= authLen;
+            return ER_OK;
+        } else if (status != ER_NOT_IMPLEMENTED) {
+            /* Clear the decrypted data */
+            memset(out, 0, len);
+            len = 0;
+            return status;
+        }
+    }
+#endif
     unsigned int num = 0;
     Block ecount_buf(0);
     /*
@@ -0,0 +1,121 @@
+/**
+ * @file
+ *
+ * Process-wide table of interned strings.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef _QCC_ATOMTABLE_H
+#define _QCC_ATOMTABLE_H
+
+#include <qcc/platform.h>
+
+#include <qcc/String.h>
+
+namespace qcc {
+
+/**
+ * An atom is a small integer that stands for an interned string. Two atoms obtained from the
+ * atom table are equal if and only if the strings they stand for are equal.
+ */
+typedef uint32_t Atom;
+
+/**
+ * AtomTable maps strings such as interface, member and object path names to atoms so that
+ * they can be compared with a single integer comparison. Atoms are never released so an
+ * atom remains valid for the life of the process.
+ *
+ * Strings are only added to the table by Intern(). Strings taken from untrusted input (for
+ * example received message headers) should be resolved with Lookup() so that a peer cannot
+ * grow the table without bound.
+ *
+ * Lookup() takes no lock. Intern() serializes with other calls to Intern() but never blocks
+ * Lookup(). When Intern() grows the table it waits for the lookups already probing the old
+ * table before freeing it.
+ */
+class AtomTable {
+  public:
+
+    /** Atom for the empty string */
+    static const Atom NONE = 0;
+
+    /**
+     * Atom returned by Lookup() for a string that has not been interned. It never compares
+     * equal to an atom returned by Intern().
+     */
+    static const Atom UNKNOWN = 0xFFFFFFFF;
+
+    /**
+     * Atom table statistics
+     */
+    struct Stats {
+        size_t size;        /**< Number of interned strings */
+        size_t capacity;    /**< Number of slots in the hash table */
+        uint64_t lookups;   /**< Approximate number of calls to Lookup() for non-empty strings */
+        uint64_t hits;      /**< Approximate number of those lookups that found an interned string */
+    };
+
+    /**
+     * Intern a string, adding it to the table if it is not already there.
+     *
+     * @param str   The string to intern.
+     *
+     * @return  The atom for str or #NONE if str is empty.
+     */
+    static Atom Intern(const char* str);
+
+    /**
+     * Intern a string, adding it to the table if it is not already there.
+     *
+     * @param str   The string to intern.
+     *
+     * @return  The atom for str or #NONE if str is empty.
+     */
+    static Atom Intern(const qcc::String& str) { return Intern(str.c_str()); }
+
+    /**
+     * Get the atom for a string without adding it to the table.
+     *
+     * @param str   The string to look up.
+     *
+     * @return  The atom for str, #NONE if str is empty or #UNKNOWN if str has not been interned.
+     */
+    static Atom Lookup(const char* str);
+
+    /**
+     * Get the statistics for the atom table.
+     *
+     * @param[out] stats   Returns the current statistics.
+     */
+    static void GetStats(Stats& stats);
+};
+
+/** @cond ALLJOYN_DEV */
+/**
+ * @internal
+ * Creates the atom table before static constructors that include this header can use it.
+ */
+static class AtomTableInitializer {
+  public:
+    AtomTableInitializer();
+    ~AtomTableInitializer();
+} atomTableInitializer;
+/** @endcond */
+
+}
+
+#endif
@@ -318,7 +318,8 @@ class Crypto_RSA {
 };
 
 /**
- * AES block encryption/decryption class
+ * AES block encryption/decryption class. The key is only written by the constructor so a single
+ * instance can be used to encrypt and decrypt from several threads concurrently.
  */
 class Crypto_AES  {
 
@@ -24,10 +24,13 @@
 
 #include <qcc/platform.h>
 
+#include <qcc/STLContainer.h>
 #include <qcc/Stream.h>
 #include <qcc/Timer.h>
 #include <Status.h>
 #include <map>
+#include <vector>
+
 namespace qcc {
 
 /* Forward References */
@@ -149,6 +152,12 @@ struct IODispatchEntry {
     bool writeInProgress;   /* Whether write is currently in progress for this stream */
     StoppingState stopping_state;          /* Whether this stream is in the process of being stopped*/
 
+    /* File descriptors and event masks registered with epoll for this stream (Linux only) */
+    int sourceFd;
+    int sinkFd;
+    uint32_t sourcePollEvents;
+    uint32_t sinkPollEvents;
+
     /**
      * Default Unusable entry
      *
@@ -162,7 +171,11 @@ struct IODispatchEntry {
         writeEnable(false),
         readInProgress(false),
         writeInProgress(false),
-        stopping_state(IO_RUNNING) { }
+        stopping_state(IO_RUNNING),
+        sourceFd(-1),
+        sinkFd(-1),
+        sourcePollEvents(0),
+        sinkPollEvents(0) { }
 
     /**
      * Constructor
@@ -185,13 +198,152 @@ struct IODispatchEntry {
         writeEnable(writeEnable),
         readInProgress(readInProgress),
         writeInProgress(writeInProgress),
-        stopping_state(IO_RUNNING)
+        stopping_state(IO_RUNNING),
+        sourceFd(-1),
+        sinkFd(-1),
+        sourcePollEvents(0),
+        sinkPollEvents(0)
     { }
 };
 
-class IODispatch : public Thread, public AlarmListener {
+/**
+ * A single event loop of an IODispatch. Each loop has its own thread, timer,
+ * callback threads and lock, and services the streams that are pinned to it.
+ * Applications use IODispatch, which shards streams across one or more loops.
+ */
+class IODispatchLoop : public Thread, public AlarmListener {
   public:
-    IODispatch(const char* name, uint32_t concurrency);
+    /**
+     * Constructor.
+     *
+     * @param name          Name of the loop thread.
+     * @param timerName     Name of the timer threads that run the callbacks. All loops of an
+     *                      IODispatch use the same name so callbacks can tell that they are
+     *                      running on a dispatch thread.
+     * @param concurrency   Number of callback threads.
+     */
+    IODispatchLoop(const char* name, const char* timerName, uint32_t concurrency);
+
+    ~IODispatchLoop();
+
+    /** Start the loop thread and timer. */
+    QStatus Start();
+
+    /** Stop the loop thread and timer, and stop all streams in this loop. */
+    QStatus Stop();
+
+    /** Join the loop thread and timer, and all streams in this loop. */
+    QStatus Join();
+
+    /** See IODispatch::StartStream. */
+    QStatus StartStream(Stream* stream, IOReadListener* readListener, IOWriteListener* writeListener, IOExitListener* exitListener, bool readEnable = true, bool writeEnable = true);
+
+    /** See IODispatch::StopStream. */
+    QStatus StopStream(Stream* stream);
+
+    /** See IODispatch::JoinStream. */
+    QStatus JoinStream(Stream* stream);
+
+    /** See IODispatch::EnableReadCallback. */
+    QStatus EnableReadCallback(const Source* source, uint32_t timeout = 0);
+
+    /** See IODispatch::DisableReadCallback. */
+    QStatus DisableReadCallback(const Source* source);
+
+    /** See IODispatch::EnableWriteCallback. */
+    QStatus EnableWriteCallback(Sink* sink, uint32_t timeout = 0);
+
+    /** See IODispatch::EnableWriteCallbackNow. */
+    QStatus EnableWriteCallbackNow(Sink* sink);
+
+    /** See IODispatch::DisableWriteCallback. */
+    QStatus DisableWriteCallback(const Sink* sink);
+
+    /** See IODispatch::EnableTimeoutCallback. */
+    QStatus EnableTimeoutCallback(const Source* source, uint32_t linkTimeout = 0);
+
+    /**
+     * Process a read/write/timeout/exit callback.
+     */
+    void AlarmTriggered(const Alarm& alarm, QStatus reason);
+
+    /**
+     * Loop main thread
+     */
+    virtual ThreadReturn STDCALL Run(void* arg);
+
+  private:
+
+    /**
+     * Add an alarm to make a read or write callback now for a stream whose source
+     * or sink event has fired. Must be called with lock held. The lock is released
+     * and re-acquired while removing any pending timeout alarm.
+     *
+     * @param it       The dispatch entry of the stream that is ready.
+     * @param type     IO_READ or IO_WRITE.
+     */
+    void AddReadyAlarm(std::map<Stream*, IODispatchEntry>::iterator it, CallbackType type);
+
+#if defined(QCC_OS_LINUX)
+    /**
+     * Register the source and sink file descriptors of a stream with epoll.
+     * Must be called with lock held.
+     */
+    QStatus RegisterPoll(Stream* stream, IODispatchEntry& entry);
+
+    /**
+     * Remove the source and sink file descriptors of a stream from epoll.
+     * Must be called with lock held.
+     */
+    void UnregisterPoll(IODispatchEntry& entry);
+
+    /**
+     * Re-arm the edge-triggered epoll registration of a stream to reflect its
+     * current read/write enable state. Re-arming makes the kernel re-check
+     * readiness, so data that arrived while a callback was in progress is not lost.
+     * Must be called with lock held.
+     */
+    void UpdatePoll(IODispatchEntry& entry);
+
+    int epollFd;                                /* epoll instance holding a persistent registration per stream */
+    /* Registered file descriptors and the dispatch entries they belong to */
+    std::unordered_map<int, std::map<Stream*, IODispatchEntry>::iterator> pollFds;
+    std::vector<Stream*> pendingExits;          /* Stopped streams that still need an exit alarm */
+#else
+    /* Source and sink events of running streams and the dispatch entries they belong to */
+    std::unordered_map<Event*, std::map<Stream*, IODispatchEntry>::iterator> eventEntries;
+#endif
+
+    Timer timer;                                /* The timer used to add and process callbacks */
+    Mutex lock;                                 /* Lock for mutual exclusion of dispatchEntries */
+    std::map<Stream*, IODispatchEntry> dispatchEntries; /* map holding details of various streams registered with this loop */
+    bool reload;                                /* Flag used for synchronization of various methods with the Run thread */
+    bool isRunning;                             /* Whether the run thread is still running. */
+    int32_t numAlarmsInProgress;                /* Number of alarms currently in progress. */
+    /* Whether the main loop is in an event wait.
+     * This is used to ensure that a source/sink event is not deleted while the main thread
+     * is waiting on it.
+     */
+    bool crit;
+};
+
+/**
+ * IODispatch listens for IO events on a set of streams and makes read, write,
+ * timeout and exit callbacks for them. The work is sharded across one or more
+ * IODispatchLoops. A stream is pinned to one loop for its lifetime, chosen by
+ * hashing the stream pointer, so selecting a loop needs no shared state.
+ */
+class IODispatch {
+  public:
+    /**
+     * Constructor
+     *
+     * @param name          Name for the loop threads.
+     * @param concurrency   Maximum number of concurrent callbacks, divided across the loops
+     *                      with at least one per loop.
+     * @param numLoops      Number of event loops to shard streams across.
+     */
+    IODispatch(const char* name, uint32_t concurrency, uint32_t numLoops = 1);
     ~IODispatch();
 
     /**
@@ -302,32 +454,27 @@ class IODispatch : public Thread, public AlarmListener {
     QStatus EnableTimeoutCallback(const Source* source, uint32_t linkTimeout = 0);
 
     /**
-     * Process a read/write/timeout/exit callback.
+     * Get the number of event loops streams are sharded across.
+     *
+     * @return The number of loops.
      */
-    void AlarmTriggered(const Alarm& alarm, QStatus reason);
+    uint32_t GetNumLoops() const { return static_cast<uint32_t>(loops.size()); }
+
+  private:
+
+    /* Copying is not allowed */
+    IODispatch(const IODispatch& other);
+    IODispatch& operator=(const IODispatch& other);
 
     /**
-     * IODispatch main thread
+     * Get the loop a stream is pinned to.
      */
-    virtual ThreadReturn STDCALL Run(void* arg);
+    IODispatchLoop& LoopFor(const Stream* stream);
 
-  private:
-    Timer timer;                                /* The timer used to add and process callbacks */
-    Mutex lock;                                 /* Lock for mutual exclusion of dispatchEntries */
-    std::map<Stream*, IODispatchEntry> dispatchEntries; /* map holding details of various streams registered with this IODispatch */
-    bool reload;                                /* Flag used for synchronization of various methods with the Run thread */
-    bool isRunning;                             /* Whether the run thread is still running. */
-    int32_t numAlarmsInProgress;                /* Number of alarms currently in progress. */
-    /* Whether the main loop is in an event wait.
-     * This is used to ensure that a source/sink event is not deleted while the main thread
-     * is waiting on it.
-     */
-    bool crit;
+    std::vector<IODispatchLoop*> loops;         /* Event loops, each with its own thread, timer and lock */
 };
 
 
-
 }
 
 #endif
-
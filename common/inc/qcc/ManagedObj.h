@@ -150,6 +150,17 @@ class ManagedObj {
         return ManagedObj<T>((ManagedCtx*)((char*)naked - offset), naked);
     }
 
+    /**
+     * Static method to get a managed object that does not refer to any T. It can be copied,
+     * assigned and destroyed but must not be dereferenced. Its reference count is zero.
+     *
+     * @returns      A managed object that does not refer to any T
+     */
+    static ManagedObj<T> Null()
+    {
+        return ManagedObj<T>((ManagedCtx*)NULL, (T*)NULL);
+    }
+
     /**
      * Static method to convert between managed objects of related types.
      *
@@ -423,12 +434,17 @@ class ManagedObj {
     /** Increment the ref count */
     void IncRef()
     {
-        IncrementAndFetch(&context->refCount);
+        if (context) {
+            IncrementAndFetch(&context->refCount);
+        }
     }
 
     /** Decrement the ref count and deallocate if necessary. */
     void DecRef()
     {
+        if (!context) {
+            return;
+        }
         uint32_t refs = DecrementAndFetch(&context->refCount);
         if (0 == refs) {
             /* Call the overriden destructor */
@@ -448,7 +464,7 @@ class ManagedObj {
 
     ManagedObj<T>(ManagedCtx * context, T * object) : context(context), object(object)
     {
-        assert(context->magic == ManagedCtxMagic);
+        assert(!context || (context->magic == ManagedCtxMagic));
         IncRef();
     }
 };
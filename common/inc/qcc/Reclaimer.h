@@ -0,0 +1,110 @@
+/**
+ * @file
+ *
+ * Tracks lock-free readers so that data they may be using is freed only once they are done.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef _QCC_RECLAIMER_H
+#define _QCC_RECLAIMER_H
+
+#include <qcc/platform.h>
+
+#include <qcc/Mutex.h>
+
+namespace qcc {
+
+/**
+ * Reclaimer lets readers use published data without taking a lock while a writer replaces it.
+ * Readers bracket their use of the data with Enter() and Leave(). A writer unpublishes the data
+ * it replaces, calls Synchronize() and may then free it.
+ *
+ * Readers are counted in per-thread slots so that readers on different threads do not contend
+ * on the same counter. Synchronize() waits only for the readers that entered before it was
+ * called, so a steady stream of new readers cannot hold it up.
+ */
+class Reclaimer {
+  public:
+
+    /**
+     * Keeps the calling thread registered as a reader for as long as it is in scope.
+     */
+    class ScopedReader {
+      public:
+
+        /**
+         * Constructor
+         *
+         * @param reclaimer   The reclaimer to register with.
+         */
+        ScopedReader(const Reclaimer& reclaimer) : reclaimer(reclaimer), token(reclaimer.Enter()) { }
+
+        ~ScopedReader() { reclaimer.Leave(token); }
+
+      private:
+        ScopedReader(const ScopedReader& other);
+        ScopedReader& operator=(const ScopedReader& other);
+
+        const Reclaimer& reclaimer;
+        const uint32_t token;
+    };
+
+    Reclaimer();
+
+    /**
+     * Register the calling thread as a reader. This never blocks.
+     *
+     * @return  A token to pass to Leave().
+     */
+    uint32_t Enter() const;
+
+    /**
+     * Unregister a reader.
+     *
+     * @param token   The token returned by Enter().
+     */
+    void Leave(uint32_t token) const;
+
+    /**
+     * Wait until every reader that entered before this call has left. Data unpublished before
+     * the call can no longer be in use when it returns. Must not be called between Enter() and
+     * Leave() on the same thread.
+     */
+    void Synchronize();
+
+  private:
+
+    Reclaimer(const Reclaimer& other);
+    Reclaimer& operator=(const Reclaimer& other);
+
+    /** Number of reader slots, a power of 2 */
+    static const size_t SLOTS = 16;
+
+    /** Readers in progress for even and odd epochs, padded to a cache line */
+    struct Slot {
+        volatile int32_t readers[2];
+        uint8_t pad[64 - 2 * sizeof(int32_t)];
+    };
+
+    mutable Slot slots[SLOTS];
+    volatile int32_t epoch;    /**< Incremented by each Synchronize() */
+    Mutex lock;                /**< Serializes Synchronize() */
+};
+
+}
+
+#endif
@@ -257,6 +257,18 @@ QStatus RecvFrom(SocketFd sockfd, IPAddress& remoteAddr, uint16_t& remotePort,
  */
 QStatus RecvWithFds(SocketFd sockfd, void* buf, size_t len, size_t& received, SocketFd* fdList, size_t maxFds, size_t& recvdFds);
 
+/**
+ * Send data gathered from a list of buffers on a socket in a single operation.
+ *
+ * @param sockfd    Socket descriptor.
+ * @param iov       Array of buffers containing the data to send.
+ * @param iovLen    Number of buffers in the array.
+ * @param sent      [OUT] Number of octets sent.
+ *
+ * @return  Indication of success of failure.
+ */
+QStatus SendSG(SocketFd sockfd, const IOVec* iov, size_t iovLen, size_t& sent);
+
 /**
  * Send a buffer of data with file descriptors to a socket. Depending on the transport this may may use out-of-band
  * or in-band data or some mix of the two.
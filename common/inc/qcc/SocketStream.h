@@ -129,6 +129,16 @@ class SocketStream : public Stream {
      */
     QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent);
 
+    /**
+     * Push bytes gathered from a list of buffers into the sink with a single socket send.
+     *
+     * @param iov          Array of buffers containing bytes to push.
+     * @param iovLen       Number of buffers in the array.
+     * @param numSent      [OUT] Number of bytes actually consumed by sink.
+     * @return   ER_OK if successful.
+     */
+    QStatus PushBytesSG(const IOVec* iov, size_t iovLen, size_t& numSent);
+
     /**
      * Push bytes accompanied by one or more file/socket descriptors to a sink.
      *
@@ -133,6 +133,28 @@ class Sink {
      */
     virtual QStatus PushBytes(const void* buf, size_t numBytes, size_t& numSent, uint32_t ttl) { return PushBytes(buf, numBytes, numSent); }
 
+    /**
+     * Push bytes gathered from a list of buffers into the sink. Sinks that cannot write
+     * several buffers in one operation push the first non-empty buffer only.
+     *
+     * @param iov          Array of buffers containing bytes to push.
+     * @param iovLen       Number of buffers in the array.
+     * @param numSent      [OUT] Number of bytes actually consumed by sink.
+     * @return   ER_OK if successful.
+     */
+    virtual QStatus PushBytesSG(const IOVec* iov, size_t iovLen, size_t& numSent)
+    {
+        while (iovLen && (iov->len == 0)) {
+            ++iov;
+            --iovLen;
+        }
+        if (iovLen == 0) {
+            numSent = 0;
+            return ER_OK;
+        }
+        return PushBytes(iov->buf, iov->len, numSent);
+    }
+
     /**
      * Push one or more byte accompanied by one or more file/socket descriptors to a sink.
      *
@@ -32,6 +32,7 @@
 #include <qcc/Thread.h>
 #include <qcc/time.h>
 #include <qcc/ManagedObj.h>
+#include <qcc/TimerWheel.h>
 
 #if defined(QCC_OS_GROUP_POSIX)
 #include <qcc/posix/OSTimer.h>
@@ -80,6 +81,7 @@ class _Alarm : public OSAlarm {
     friend class TimerThread;
     friend class OSTimer;
     friend class CompareAlarm;
+    friend class TimerWheel;
 
   public:
 
@@ -279,6 +281,15 @@ class Timer : public OSTimer, public ThreadListener {
      */
     void RemoveAlarmsWithListener(const AlarmListener& listener);
 
+    /**
+     * Wait until this timer has room for another alarm. Returns at once if the timer does not
+     * limit the number of alarms, is not full or is not running. This lets a caller that must not
+     * block in AddAlarm() retry AddAlarmNonBlocking() as soon as an alarm has been dispatched.
+     *
+     * @param maxWaitMs   Maximum time to wait in ms.
+     */
+    void WaitForRoom(uint32_t maxWaitMs);
+
     /*
      * Test if the specified alarm is associated with this timer.
      *
@@ -331,7 +342,7 @@ class Timer : public OSTimer, public ThreadListener {
   protected:
 
     Mutex lock;
-    std::set<Alarm, std::less<Alarm> >  alarms;
+    TimerWheel alarms;
     Alarm* currentAlarm;
     bool expireOnExit;
     std::vector<TimerThread*> timerThreads;
@@ -343,6 +354,7 @@ class Timer : public OSTimer, public ThreadListener {
     qcc::String nameStr;
     const uint32_t maxAlarms;
     std::deque<qcc::Thread*> addWaitQueue; /**< Threads waiting for alarms set to become not-full */
+    Event notFullEvent;                    /**< Set when alarms may have dropped below maxAlarms */
 };
 
 }
@@ -0,0 +1,188 @@
+/**
+ * @file
+ *
+ * Hierarchical timing wheel that holds the pending alarms of a Timer.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#ifndef _QCC_TIMERWHEEL_H
+#define _QCC_TIMERWHEEL_H
+
+#include <qcc/platform.h>
+
+#include <list>
+
+#include <qcc/ManagedObj.h>
+#include <qcc/time.h>
+
+#include <qcc/STLContainer.h>
+
+namespace qcc {
+
+/** @internal Forward references */
+class _Alarm;
+class AlarmListener;
+typedef qcc::ManagedObj<_Alarm> Alarm;
+
+/**
+ * TimerWheel holds the alarms of a Timer. Adding and removing an alarm takes constant time.
+ *
+ * Alarms that are due are kept on a FIFO queue. An alarm that is already due when it is added
+ * goes straight onto that queue, so "run now" alarms never touch the wheel. Other alarms are
+ * hashed into the slots of one of five wheels according to how far away they are. The wheels
+ * have 1 ms, 256 ms, 16 s, 17 min and 18 h slots. Alarms in the coarser wheels move down to
+ * the finer ones as their time approaches. Alarms more than 49 days away wait on an overflow
+ * list.
+ *
+ * TimerWheel is not thread safe. The Timer accesses it with its lock held.
+ */
+class TimerWheel {
+  public:
+
+    /**
+     * Constructor
+     */
+    TimerWheel();
+
+    /**
+     * Return true if there are no alarms.
+     */
+    bool empty() const { return index.empty(); }
+
+    /**
+     * Return the number of alarms.
+     */
+    size_t size() const { return index.size(); }
+
+    /**
+     * Add an alarm. Adding an alarm that is already present has no effect.
+     *
+     * @param alarm   The alarm to add.
+     * @param now     The current time.
+     *
+     * @return  true if the alarm is due before the time returned by the last call to
+     *          NextDelay(), so a thread waiting for that time must be woken.
+     */
+    bool Insert(const Alarm& alarm, const Timespec& now);
+
+    /**
+     * Remove an alarm. Alarms are matched the same way Timer matches them: by id, and also by
+     * time unless the alarm is periodic.
+     *
+     * @param alarm   The alarm to remove.
+     *
+     * @return  true if the alarm was found and removed.
+     */
+    bool Remove(const Alarm& alarm);
+
+    /**
+     * Test if an alarm is present.
+     *
+     * @param alarm   The alarm to look for.
+     *
+     * @return  true if the alarm is present.
+     */
+    bool Contains(const Alarm& alarm) const;
+
+    /**
+     * Remove one alarm for a listener.
+     *
+     * @param listener   The listener.
+     * @param[out] alarm Returns the alarm that was removed.
+     *
+     * @return  true if an alarm was found and removed.
+     */
+    bool RemoveListener(const AlarmListener* listener, Alarm& alarm);
+
+    /**
+     * Move the alarms that are due by now onto the due queue and get the time until the next
+     * alarm is due.
+     *
+     * @param now   The current time.
+     *
+     * @return  0 if an alarm is due, otherwise the number of ms to wait before calling
+     *          NextDelay() again. The wait may end before an alarm is due when alarms have to
+     *          move to a finer wheel.
+     */
+    int64_t NextDelay(const Timespec& now);
+
+    /**
+     * Get the oldest due alarm.
+     *
+     * @return  The oldest due alarm or NULL if no alarm is due.
+     */
+    const Alarm* FrontDue() const { return due.empty() ? NULL : &due.front(); }
+
+    /**
+     * Remove the oldest due alarm.
+     */
+    void PopDue();
+
+    /**
+     * Remove the alarm with the earliest time whether or not it is due. This takes time in
+     * proportion to the number of alarms and is meant for expiring alarms when a timer exits.
+     *
+     * @param[out] alarm  Returns the alarm that was removed.
+     *
+     * @return  true if an alarm was removed, false if there are no alarms.
+     */
+    bool PopEarliest(Alarm& alarm);
+
+  private:
+
+    /** Number of wheels */
+    static const size_t LEVELS = 5;
+
+    /** Slots in each wheel */
+    static const size_t SLOTS_0 = 256;
+    static const size_t SLOTS_N = 64;
+
+    /** Location of an alarm */
+    struct Location {
+        std::list<Alarm>* list;          /**< List holding the alarm */
+        std::list<Alarm>::iterator it;   /**< Position of the alarm in list */
+        size_t level;                    /**< Wheel holding list or LEVELS if list is not a slot */
+
+        Location(std::list<Alarm>* list, std::list<Alarm>::iterator it) : list(list), it(it), level(LEVELS) { }
+    };
+
+    /**
+     * Number of low order bits of a time that are below the slot size of a wheel. Shift(LEVELS)
+     * is the number of bits covered by all the wheels together.
+     */
+    static uint32_t Shift(size_t level) { return (level == 0) ? 0 : 8 + 6 * (level - 1); }
+
+    std::list<Alarm>& Slot(size_t level, uint64_t when);
+    bool Matches(const Location& loc, const Alarm& alarm) const;
+    void Erase(std::unordered_map<int32_t, Location>::iterator iter);
+    void Place(std::list<Alarm>& from, std::list<Alarm>::iterator it);
+    void Cascade(std::list<Alarm>& slot, size_t level);
+    void Advance(uint64_t now);
+
+    uint64_t cursor;                        /**< All alarms due before this time are on the due queue */
+    uint64_t wakeTime;                      /**< Time returned by the last call to NextDelay() */
+    size_t counts[LEVELS];                  /**< Number of alarms in each wheel */
+    std::list<Alarm> slots0[SLOTS_0];       /**< 1 ms slots */
+    std::list<Alarm> slotsN[LEVELS - 1][SLOTS_N];  /**< Slots of the coarser wheels */
+    std::list<Alarm> overflow;              /**< Alarms beyond the coarsest wheel */
+    std::list<Alarm> due;                   /**< Alarms that are due in the order they became due */
+    std::unordered_map<int32_t, Location> index;  /**< Location of each alarm by alarm id */
+};
+
+}
+
+#endif
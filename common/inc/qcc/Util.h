@@ -152,6 +152,16 @@ uint64_t Rand64();
  */
 uint32_t GetPid();
 
+/**
+ * Pick one of a number of slots for the calling thread. Different threads tend to get different
+ * slots so per-thread data kept in slots is rarely written by two threads at once.
+ *
+ * @param slots   Number of slots, a power of 2.
+ *
+ * @return The slot of the calling thread, less than slots.
+ */
+size_t GetThreadSlot(size_t slots);
+
 /**
  * Return the User ID as an unsigned 32 bit integer.
  *
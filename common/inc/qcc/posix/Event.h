@@ -182,6 +182,12 @@ class Event {
      */
     int GetFD() { return (fd == -1) ? ioFd : fd; }
 
+    /**
+     * Get the type of this event.
+     * @return  The event type.
+     */
+    EventType GetEventType() const { return eventType; }
+
     /**
      * Get the number of threads that are currently blocked waiting for this event
      *
@@ -72,6 +72,14 @@ inline int32_t DecrementAndFetch(volatile int32_t* mem)
     return __atomic_dec(mem) - 1;
 }
 
+/**
+ * Full memory barrier. Loads and stores before the barrier are complete before any load or
+ * store after it.
+ */
+inline void MemoryFence() {
+    __sync_synchronize();
+}
+
 #elif defined(QCC_OS_LINUX)
 
 /**
@@ -94,6 +102,14 @@ inline int32_t DecrementAndFetch(volatile int32_t* mem) {
     return __sync_sub_and_fetch(mem, 1);
 }
 
+/**
+ * Full memory barrier. Loads and stores before the barrier are complete before any load or
+ * store after it.
+ */
+inline void MemoryFence() {
+    __sync_synchronize();
+}
+
 #elif defined(QCC_OS_DARWIN)
 
 /**
@@ -116,6 +132,14 @@ inline int32_t DecrementAndFetch(volatile int32_t* mem) {
     return OSAtomicDecrement32(mem);
 }
 
+/**
+ * Full memory barrier. Loads and stores before the barrier are complete before any load or
+ * store after it.
+ */
+inline void MemoryFence() {
+    OSMemoryBarrier();
+}
+
 #else
 
 /**
@@ -134,6 +158,12 @@ int32_t IncrementAndFetch(volatile int32_t* mem);
  */
 int32_t DecrementAndFetch(volatile int32_t* mem);
 
+/**
+ * Full memory barrier. Loads and stores before the barrier are complete before any load or
+ * store after it.
+ */
+void MemoryFence();
+
 #endif
 
 }
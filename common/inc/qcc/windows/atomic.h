@@ -48,6 +48,14 @@ inline int32_t DecrementAndFetch(volatile int32_t* mem) {
     return InterlockedDecrement(reinterpret_cast<volatile long*>(mem));
 }
 
+/**
+ * Full memory barrier. Loads and stores before the barrier are complete before any load or
+ * store after it.
+ */
+inline void MemoryFence() {
+    MemoryBarrier();
+}
+
 }
 
 #endif
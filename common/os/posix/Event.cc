@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
 #include <time.h>
 #include <unistd.h>
@@ -52,22 +53,20 @@ Event Event::neverSet(WAIT_FOREVER, 0);
 
 QStatus Event::Wait(Event& evt, uint32_t maxWaitMs)
 {
-    fd_set set;
-    fd_set stopSet;
-    int maxFd = -1;
-    struct timeval tval;
-    struct timeval* pTval = NULL;
+    /*
+     * poll() rather than select() is used so that file descriptors beyond
+     * FD_SETSIZE can be waited on.
+     */
+    struct pollfd fds[3];
+    nfds_t numFds = 0;
+    int timeout = (maxWaitMs == WAIT_FOREVER) ? -1 : static_cast<int>(maxWaitMs);
+    int evtFdIdx = -1;
+    int evtIoFdIdx = -1;
+    int stopFdIdx = -1;
 
     Thread* thread = Thread::GetThread();
 
-    FD_ZERO(&set);
-    FD_ZERO(&stopSet);
-
-    if (maxWaitMs != WAIT_FOREVER) {
-        tval.tv_sec = maxWaitMs / 1000;
-        tval.tv_usec = (maxWaitMs % 1000) * 1000;
-        pTval = &tval;
-    }
+    short evtEvents = (evt.eventType == IO_WRITE) ? POLLOUT : POLLIN;
 
     if (evt.eventType == TIMED) {
         uint32_t now = GetTimestamp();
@@ -76,44 +75,38 @@ QStatus Event::Wait(Event& evt, uint32_t maxWaitMs)
                 evt.timestamp += (((now - evt.timestamp) / evt.period) + 1) * evt.period;
             }
             return ER_OK;
-        } else if (!pTval || ((evt.timestamp - now) < (uint32_t) (tval.tv_sec * 1000 + tval.tv_usec / 1000))) {
-            tval.tv_sec = (evt.timestamp - now) / 1000;
-            tval.tv_usec = 1000 * ((evt.timestamp - now) % 1000);
-            pTval = &tval;
+        } else if ((timeout < 0) || ((evt.timestamp - now) < static_cast<uint32_t>(timeout))) {
+            timeout = static_cast<int>(evt.timestamp - now);
         }
     } else {
         if (0 <= evt.fd) {
-            FD_SET(evt.fd, &set);
-            maxFd = max(maxFd, evt.fd);
+            evtFdIdx = numFds;
+            fds[numFds].fd = evt.fd;
+            fds[numFds].events = evtEvents;
+            fds[numFds++].revents = 0;
         }
         if (0 <= evt.ioFd) {
-            FD_SET(evt.ioFd, &set);
-            maxFd = max(maxFd, evt.ioFd);
+            evtIoFdIdx = numFds;
+            fds[numFds].fd = evt.ioFd;
+            fds[numFds].events = evtEvents;
+            fds[numFds++].revents = 0;
         }
     }
 
-    int stopFd = -1;
     if (thread) {
-        stopFd = thread->GetStopEvent().fd;
-        if (evt.eventType == IO_WRITE) {
-            FD_SET(stopFd, &stopSet);
-        } else {
-            FD_SET(stopFd, &set);
-        }
-        maxFd = max(maxFd, stopFd);
+        stopFdIdx = numFds;
+        fds[numFds].fd = thread->GetStopEvent().fd;
+        fds[numFds].events = POLLIN;
+        fds[numFds++].revents = 0;
     }
 
     evt.IncrementNumThreads();
 
-    int ret = select(maxFd + 1,
-                     (evt.eventType == IO_WRITE) ? &stopSet : &set,
-                     (evt.eventType == IO_WRITE) ? &set : NULL,
-                     NULL,
-                     pTval);
+    int ret = poll(fds, numFds, timeout);
 
     evt.DecrementNumThreads();
 
-    if ((0 <= stopFd) && (FD_ISSET(stopFd, &set) || FD_ISSET(stopFd, &stopSet))) {
+    if ((0 <= stopFdIdx) && (fds[stopFdIdx].revents != 0)) {
         return thread->IsStopping() ? ER_STOPPING_THREAD : ER_ALERTED_THREAD;
     } else if (evt.eventType == TIMED) {
         uint32_t now = GetTimestamp();
@@ -125,7 +118,7 @@ QStatus Event::Wait(Event& evt, uint32_t maxWaitMs)
         } else {
             return ER_TIMEOUT;
         }
-    } else if ((0 < ret) && (((0 <= evt.fd) && FD_ISSET(evt.fd, &set)) || ((0 <= evt.ioFd) && FD_ISSET(evt.ioFd, &set)))) {
+    } else if ((0 < ret) && (((0 <= evtFdIdx) && (fds[evtFdIdx].revents != 0)) || ((0 <= evtIoFdIdx) && (fds[evtIoFdIdx].revents != 0)))) {
         return ER_OK;
     } else if (0 <= ret) {
         return ER_TIMEOUT;
@@ -136,78 +129,54 @@ QStatus Event::Wait(Event& evt, uint32_t maxWaitMs)
 
 QStatus Event::Wait(const vector<Event*>& checkEvents, vector<Event*>& signaledEvents, uint32_t maxWaitMs)
 {
-    fd_set rdset;
-    fd_set wrset;
-    struct timeval tval;
-    struct timeval* pTval = NULL;
-    bool rdSetEmpty = true;
-    bool wrSetEmpty = true;
-
-    if (maxWaitMs != WAIT_FOREVER) {
-        tval.tv_sec = maxWaitMs / 1000;
-        tval.tv_usec = (maxWaitMs % 1000) * 1000;
-        pTval = &tval;
-    }
+    /*
+     * Each I/O or general purpose event contributes up to two entries (fd and ioFd) to
+     * the poll set. firstFd[i] records where checkEvents[i]'s entries start.
+     */
+    vector<struct pollfd> fds;
+    vector<size_t> firstFd;
+    int timeout = (maxWaitMs == WAIT_FOREVER) ? -1 : static_cast<int>(maxWaitMs);
+
+    fds.reserve(2 * checkEvents.size());
+    firstFd.reserve(checkEvents.size() + 1);
 
-    FD_ZERO(&rdset);
-    FD_ZERO(&wrset);
-    int maxFd = 0;
     vector<Event*>::const_iterator it;
 
     for (it = checkEvents.begin(); it != checkEvents.end(); ++it) {
         Event* evt = *it;
         evt->IncrementNumThreads();
-        if ((evt->eventType == IO_READ) || (evt->eventType == GEN_PURPOSE)) {
+        firstFd.push_back(fds.size());
+        if ((evt->eventType == IO_READ) || (evt->eventType == GEN_PURPOSE) || (evt->eventType == IO_WRITE)) {
+            struct pollfd pfd;
+            pfd.events = (evt->eventType == IO_WRITE) ? POLLOUT : POLLIN;
+            pfd.revents = 0;
             if (0 <= evt->fd) {
-                FD_SET(evt->fd, &rdset);
-                maxFd = std::max(maxFd, evt->fd);
-                rdSetEmpty = false;
+                pfd.fd = evt->fd;
+                fds.push_back(pfd);
             }
             if (0 <= evt->ioFd) {
-                FD_SET(evt->ioFd, &rdset);
-                maxFd = std::max(maxFd, evt->ioFd);
-                rdSetEmpty = false;
-            }
-        } else if (evt->eventType == IO_WRITE) {
-            if (0 <= evt->fd) {
-                FD_SET(evt->fd, &wrset);
-                wrSetEmpty = false;
-                maxFd = std::max(maxFd, evt->fd);
-            }
-            if (0 <= evt->ioFd) {
-                FD_SET(evt->ioFd, &wrset);
-                wrSetEmpty = false;
-                maxFd = std::max(maxFd, evt->ioFd);
+                pfd.fd = evt->ioFd;
+                fds.push_back(pfd);
             }
         } else if (evt->eventType == TIMED) {
             uint32_t now = GetTimestamp();
             if (evt->timestamp <= now) {
-                tval.tv_sec = 0;
-                tval.tv_usec = 0;
-                pTval = &tval;
-            } else if (!pTval || ((evt->timestamp - now) < (uint32_t) (tval.tv_sec * 1000 + tval.tv_usec / 1000))) {
-                tval.tv_sec = (evt->timestamp - now) / 1000;
-                tval.tv_usec = 1000 * ((evt->timestamp - now) % 1000);
-                pTval = &tval;
+                timeout = 0;
+            } else if ((timeout < 0) || ((evt->timestamp - now) < static_cast<uint32_t>(timeout))) {
+                timeout = static_cast<int>(evt->timestamp - now);
             }
         }
     }
+    firstFd.push_back(fds.size());
 
-    int ret = select(maxFd + 1, rdSetEmpty ? NULL : &rdset, wrSetEmpty ? NULL : &wrset, NULL, pTval);
+    int ret = poll(fds.empty() ? NULL : &fds[0], fds.size(), timeout);
 
     if (0 <= ret) {
-        for (it = checkEvents.begin(); it != checkEvents.end(); ++it) {
+        size_t i = 0;
+        for (it = checkEvents.begin(); it != checkEvents.end(); ++it, ++i) {
             Event* evt = *it;
             evt->DecrementNumThreads();
-            if (!rdSetEmpty && ((evt->eventType == IO_READ) || (evt->eventType == GEN_PURPOSE))) {
-                if (((0 <= evt->fd) && FD_ISSET(evt->fd, &rdset)) || ((0 <= evt->ioFd) && FD_ISSET(evt->ioFd, &rdset))) {
-                    signaledEvents.push_back(evt);
-                }
-            } else if (!wrSetEmpty && (evt->eventType == IO_WRITE)) {
-                if (((0 <= evt->fd) && FD_ISSET(evt->fd, &wrset)) || ((0 <= evt->ioFd) && FD_ISSET(evt->ioFd, &wrset))) {
-                    signaledEvents.push_back(evt);
-                }
-            } else if (evt->eventType == TIMED) {
+            if (evt->eventType == TIMED) {
                 uint32_t now = GetTimestamp();
                 if (evt->timestamp <= now) {
                     signaledEvents.push_back(evt);
@@ -215,6 +184,13 @@ QStatus Event::Wait(const vector<Event*>& checkEvents, vector<Event*>& signaledE
                         evt->timestamp += (((now - evt->timestamp) / evt->period) + 1) * evt->period;
                     }
                 }
+            } else if (0 < ret) {
+                for (size_t j = firstFd[i]; j < firstFd[i + 1]; ++j) {
+                    if (fds[j].revents != 0) {
+                        signaledEvents.push_back(evt);
+                        break;
+                    }
+                }
             }
         }
         return signaledEvents.empty() ? ER_TIMEOUT : ER_OK;
@@ -222,7 +198,7 @@ QStatus Event::Wait(const vector<Event*>& checkEvents, vector<Event*>& signaledE
         for (it = checkEvents.begin(); it != checkEvents.end(); ++it) {
             (*it)->DecrementNumThreads();
         }
-        QCC_LogError(ER_FAIL, ("select failed with %d (%s)", errno, strerror(errno)));
+        QCC_LogError(ER_FAIL, ("poll failed with %d (%s)", errno, strerror(errno)));
         return ER_FAIL;
     }
 }
@@ -383,12 +359,11 @@ QStatus Event::SetEvent()
 
     if (GEN_PURPOSE == eventType) {
         char val = 's';
-        fd_set rdSet;
-        struct timeval tv;
-        tv.tv_sec = tv.tv_usec = 0;
-        FD_ZERO(&rdSet);
-        FD_SET(fd, &rdSet);
-        int ret = select(fd + 1, &rdSet, NULL, NULL, &tv);
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, 0);
         if (ret == 0) {
             ret = write(signalFd, &val, sizeof(val));
         }
@@ -28,11 +28,13 @@
 #include <net/if.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
 #include <stddef.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -487,6 +489,48 @@ QStatus Send(SocketFd sockfd, const void* buf, size_t len, size_t& sent)
 }
 
 
+/* SendSG hands an IOVec array straight to sendmsg() so the layouts must agree */
+static_assert(sizeof(IOVec) == sizeof(struct iovec), "IOVec does not match struct iovec");
+static_assert(offsetof(IOVec, buf) == offsetof(struct iovec, iov_base), "IOVec::buf does not match iovec::iov_base");
+static_assert(offsetof(IOVec, len) == offsetof(struct iovec, iov_len), "IOVec::len does not match iovec::iov_len");
+
+QStatus SendSG(SocketFd sockfd, const IOVec* iov, size_t iovLen, size_t& sent)
+{
+    QStatus status = ER_OK;
+    ssize_t ret;
+    struct msghdr msg;
+
+    QCC_DbgTrace(("SendSG(sockfd = %d, *iov = <>, iovLen = %lu, sent = <>)",
+                  sockfd, iovLen));
+    assert(iov != NULL);
+
+    /*
+     * sendmsg() fails with EMSGSIZE beyond IOV_MAX entries.  Sending fewer is
+     * just a short write which the caller already has to deal with.
+     */
+    if (iovLen > IOV_MAX) {
+        iovLen = IOV_MAX;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = reinterpret_cast<struct iovec*>(const_cast<IOVec*>(iov));
+    msg.msg_iovlen = iovLen;
+
+    ret = sendmsg(static_cast<int>(sockfd), &msg, MSG_NOSIGNAL);
+    if (ret == -1) {
+        if (errno == EAGAIN) {
+            status = ER_WOULDBLOCK;
+        } else {
+            status = ER_OS_ERROR;
+            QCC_DbgHLPrintf(("SendSG (sockfd = %u): %d - %s", sockfd, errno, strerror(errno)));
+        }
+    } else {
+        sent = static_cast<size_t>(ret);
+    }
+    return status;
+}
+
+
 QStatus SendTo(SocketFd sockfd, IPAddress& remoteAddr, uint16_t remotePort,
                const void* buf, size_t len, size_t& sent)
 {
@@ -212,6 +212,7 @@ QStatus Timer::Stop()
     while (it != addWaitQueue.end()) {
         (*it++)->Alert(TIMER_IS_DEAD_ALERTCODE);
     }
+    notFullEvent.SetEvent();
     lock.Unlock();
     return status;
 }
@@ -264,8 +265,9 @@ QStatus Timer::AddAlarm(const Alarm& alarm)
         /* Ensure timer is still running */
         if (isRunning) {
             /* Insert the alarm and alert the Timer thread if necessary */
-            bool alertThread = alarms.empty() || (alarm < *alarms.begin());
-            alarms.insert(alarm);
+            Timespec now;
+            GetTimeNow(&now);
+            bool alertThread = alarms.Insert(alarm, now);
 
             if (alertThread && (controllerIdx >= 0)) {
                 TimerThread* tt = timerThreads[controllerIdx];
@@ -297,8 +299,9 @@ QStatus Timer::AddAlarmNonBlocking(const Alarm& alarm)
         }
 
         /* Insert the alarm and alert the Timer thread if necessary */
-        bool alertThread = alarms.empty() || (alarm < *alarms.begin());
-        alarms.insert(alarm);
+        Timespec now;
+        GetTimeNow(&now);
+        bool alertThread = alarms.Insert(alarm, now);
 
         if (alertThread && (controllerIdx >= 0)) {
             TimerThread* tt = timerThreads[controllerIdx];
@@ -319,22 +322,9 @@ bool Timer::RemoveAlarm(const Alarm& alarm, bool blockIfTriggered)
     bool foundAlarm = false;
     lock.Lock();
     if (isRunning || expireOnExit) {
-        if (alarm->periodMs) {
-            set<Alarm>::iterator it = alarms.begin();
-            while (it != alarms.end()) {
-                if ((*it)->id == alarm->id) {
-                    foundAlarm = true;
-                    alarms.erase(it);
-                    break;
-                }
-                ++it;
-            }
-        } else {
-            set<Alarm>::iterator it = alarms.find(alarm);
-            if (it != alarms.end()) {
-                foundAlarm = true;
-                alarms.erase(it);
-            }
+        foundAlarm = alarms.Remove(alarm);
+        if (foundAlarm && maxAlarms) {
+            notFullEvent.SetEvent();
         }
         if (blockIfTriggered && !foundAlarm) {
             /*
@@ -367,22 +357,9 @@ bool Timer::ForceRemoveAlarm(const Alarm& alarm, bool blockIfTriggered)
     bool foundAlarm = false;
     lock.Lock();
     if (isRunning || expireOnExit) {
-        if (alarm->periodMs) {
-            set<Alarm>::iterator it = alarms.begin();
-            while (it != alarms.end()) {
-                if ((*it)->id == alarm->id) {
-                    foundAlarm = true;
-                    alarms.erase(it);
-                    break;
-                }
-                ++it;
-            }
-        } else {
-            set<Alarm>::iterator it = alarms.find(alarm);
-            if (it != alarms.end()) {
-                foundAlarm = true;
-                alarms.erase(it);
-            }
+        foundAlarm = alarms.Remove(alarm);
+        if (foundAlarm && maxAlarms) {
+            notFullEvent.SetEvent();
         }
         if (blockIfTriggered && !foundAlarm) {
             /*
@@ -416,9 +393,7 @@ QStatus Timer::ReplaceAlarm(const Alarm& origAlarm, const Alarm& newAlarm, bool
     QStatus status = ER_NO_SUCH_ALARM;
     lock.Lock();
     if (isRunning) {
-        set<Alarm>::iterator it = alarms.find(origAlarm);
-        if (it != alarms.end()) {
-            alarms.erase(it);
+        if (alarms.Remove(origAlarm)) {
             status = AddAlarm(newAlarm);
         } else if (blockIfTriggered) {
             /*
@@ -451,12 +426,9 @@ bool Timer::RemoveAlarm(const AlarmListener& listener, Alarm& alarm)
     bool removedOne = false;
     lock.Lock();
     if (isRunning) {
-        for (set<Alarm>::iterator it = alarms.begin(); it != alarms.end(); ++it) {
-            if ((*it)->listener == &listener) {
-                alarms.erase(it);
-                removedOne = true;
-                break;
-            }
+        removedOne = alarms.RemoveListener(&listener, alarm);
+        if (removedOne && maxAlarms) {
+            notFullEvent.SetEvent();
         }
         /*
          * This function is most likely being called because the listener is about to be freed. If there
@@ -492,12 +464,29 @@ void Timer::RemoveAlarmsWithListener(const AlarmListener& listener)
     }
 }
 
+void Timer::WaitForRoom(uint32_t maxWaitMs)
+{
+    lock.Lock();
+    if (!isRunning || !maxAlarms || (alarms.size() < maxAlarms)) {
+        lock.Unlock();
+        return;
+    }
+    /* Any alarm that is dispatched or removed after this point sets the event again */
+    notFullEvent.ResetEvent();
+    lock.Unlock();
+
+    /* Wait on the event alone so an alert of the calling thread does not end the wait early */
+    vector<Event*> checkEvents(1, &notFullEvent);
+    vector<Event*> signaledEvents;
+    Event::Wait(checkEvents, signaledEvents, maxWaitMs);
+}
+
 bool Timer::HasAlarm(const Alarm& alarm)
 {
     bool ret = false;
     lock.Lock();
     if (isRunning) {
-        ret = alarms.count(alarm) != 0;
+        ret = alarms.Contains(alarm);
     }
     lock.Unlock();
     return ret;
@@ -561,8 +550,7 @@ ThreadReturn STDCALL TimerThread::Run(void* arg)
          */
         if (!timer->alarms.empty()) {
             QCC_DbgPrintf(("TimerThread::Run(): Alarms pending"));
-            const Alarm topAlarm = *(timer->alarms.begin());
-            int64_t delay = topAlarm->alarmTime - now;
+            int64_t delay = timer->alarms.NextDelay(now);
 
             /*
              * There is an alarm waiting to go off, but there is some delay
@@ -591,7 +579,7 @@ ThreadReturn STDCALL TimerThread::Run(void* arg)
                                 status = Event::Wait(Event::neverSet, WORKER_IDLE_TIMEOUT_MS);
                                 timer->lock.Lock();
                                 GetTimeNow(&now);
-                                delay = topAlarm->alarmTime - now;
+                                delay = timer->alarms.NextDelay(now);
                             }
 
                             if (status == ER_ALERTED_THREAD || status == ER_STOPPING_THREAD || !timer->isRunning || delay <= WORKER_IDLE_TIMEOUT_MS) {
@@ -630,6 +618,7 @@ ThreadReturn STDCALL TimerThread::Run(void* arg)
                  * if the system gets too far behind.  We define "too far" by
                  * the constant FALLBEHIND_WARNING_MS.
                  */
+                delay = (*timer->alarms.FrontDue())->alarmTime - now;
                 if (delay < 0 && std::abs((long)delay) > FALLBEHIND_WARNING_MS) {
                     QCC_LogError(ER_TIMER_FALLBEHIND, ("TimerThread::Run(): Timer \"%s\" alarm is late by %ld ms",
                                                        Thread::GetThreadName(), std::abs((long)delay)));
@@ -771,11 +760,14 @@ ThreadReturn STDCALL TimerThread::Run(void* arg)
                  * If it has already been serviced by another thread, just ignore
                  * and go back to the top of the loop.
                  */
-                set<Alarm>::iterator it = timer->alarms.find(topAlarm);
-                if (it != timer->alarms.end()) {
-                    Alarm top = *it;
-                    timer->alarms.erase(it);
+                const Alarm* due = timer->alarms.FrontDue();
+                if (due) {
+                    Alarm top = *due;
+                    timer->alarms.PopDue();
                     currentAlarm = &top;
+                    if (timer->maxAlarms) {
+                        timer->notFullEvent.SetEvent();
+                    }
                     if (0 < timer->addWaitQueue.size()) {
                         Thread* wakeMe = timer->addWaitQueue.back();
                         timer->addWaitQueue.pop_back();
@@ -909,13 +901,11 @@ void Timer::ThreadExit(Thread* thread)
     lock.Lock();
     if ((!isRunning) && expireOnExit) {
         /* Call all alarms */
-        while (!alarms.empty()) {
+        Alarm alarm;
+        while (alarms.PopEarliest(alarm)) {
             /*
              * Note it is possible that the callback will call RemoveAlarm()
              */
-            set<Alarm>::iterator it = alarms.begin();
-            Alarm alarm = *it;
-            alarms.erase(it);
             tt->SetCurrentAlarm(&alarm);
             lock.Unlock();
             tt->hasTimerLock = preventReentrancy;
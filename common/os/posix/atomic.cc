@@ -46,6 +46,13 @@ int32_t DecrementAndFetch(volatile int32_t* mem)
     return ret;
 }
 
+void MemoryFence()
+{
+    /* Locking and unlocking a mutex is a full barrier */
+    pthread_mutex_lock(&atomicLock);
+    pthread_mutex_unlock(&atomicLock);
+}
+
 }
 
 #endif
@@ -28,6 +28,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #include <qcc/Debug.h>
@@ -48,6 +49,13 @@ uint32_t qcc::GetPid()
     return static_cast<uint32_t>(getpid());
 }
 
+size_t qcc::GetThreadSlot(size_t slots)
+{
+    uint64_t id = (uint64_t)(uintptr_t)pthread_self();
+    /* Thread ids are often aligned addresses so they are hashed rather than taken modulo slots */
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 56) & (slots - 1);
+}
+
 uint32_t qcc::GetUid()
 {
     return static_cast<uint32_t>(getuid());
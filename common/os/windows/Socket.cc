@@ -22,6 +22,8 @@
 
 #include <qcc/platform.h>
 
+#include <stddef.h>
+
 // Do not change the order of these includes; they are order dependent.
 #include <Winsock2.h>
 #include <Mswsock.h>
@@ -454,6 +456,35 @@ QStatus Send(SocketFd sockfd, const void* buf, size_t len, size_t& sent)
 }
 
 
+/* SendSG hands an IOVec array straight to WSASend() so the layouts must agree */
+static_assert(sizeof(IOVec) == sizeof(WSABUF), "IOVec does not match WSABUF");
+static_assert(offsetof(IOVec, len) == offsetof(WSABUF, len), "IOVec::len does not match WSABUF::len");
+static_assert(offsetof(IOVec, buf) == offsetof(WSABUF, buf), "IOVec::buf does not match WSABUF::buf");
+
+QStatus SendSG(SocketFd sockfd, const IOVec* iov, size_t iovLen, size_t& sent)
+{
+    QStatus status = ER_OK;
+    DWORD ret;
+
+    QCC_DbgTrace(("SendSG(sockfd = %d, *iov = <>, iovLen = %lu, sent = <>)", sockfd, iovLen));
+    assert(iov != NULL);
+
+    if (WSASend(static_cast<SOCKET>(sockfd), reinterpret_cast<LPWSABUF>(const_cast<IOVec*>(iov)), static_cast<DWORD>(iovLen), &ret, 0, NULL, NULL) == SOCKET_ERROR) {
+        if (WSAGetLastError() == WSAEWOULDBLOCK) {
+            sent = 0;
+            status = ER_WOULDBLOCK;
+        } else {
+            status = ER_OS_ERROR;
+            QCC_LogError(status, ("SendSG: %s", StrError().c_str()));
+        }
+    } else {
+        sent = static_cast<size_t>(ret);
+        QCC_DbgPrintf(("Sent %u bytes", sent));
+    }
+    return status;
+}
+
+
 QStatus SendTo(SocketFd sockfd, IPAddress& remoteAddr, uint16_t remotePort,
                const void* buf, size_t len, size_t& sent)
 {
@@ -49,6 +49,13 @@ uint32_t qcc::GetPid()
     return static_cast<uint32_t>(_getpid());
 }
 
+size_t qcc::GetThreadSlot(size_t slots)
+{
+    uint64_t id = GetCurrentThreadId();
+    /* Thread ids are often aligned addresses so they are hashed rather than taken modulo slots */
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 56) & (slots - 1);
+}
+
 static uint32_t ComputeId(const char* buf, size_t len)
 {
     QCC_DbgPrintf(("ComputeId %s", buf));
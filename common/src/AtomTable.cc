@@ -0,0 +1,222 @@
+/**
+ * @file
+ *
+ * This file implements the process-wide table of interned strings.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <string.h>
+
+#include <qcc/AtomTable.h>
+#include <qcc/Mutex.h>
+#include <qcc/Reclaimer.h>
+#include <qcc/String.h>
+#include <qcc/Util.h>
+#include <qcc/atomic.h>
+
+namespace qcc {
+
+const Atom AtomTable::NONE;
+const Atom AtomTable::UNKNOWN;
+
+/*
+ * An interned string. Entries are never modified or freed once they have been published.
+ */
+struct AtomEntry {
+    const qcc::String str;
+    const size_t hash;
+    const Atom atom;
+
+    AtomEntry(const char* str, size_t hash, Atom atom) : str(str), hash(hash), atom(atom) { }
+};
+
+/*
+ * Open addressed hash table of entries. A table that has been replaced by a larger one is freed
+ * once no lookup can still be probing it; the entries are moved to the larger table.
+ */
+struct AtomSlots {
+    const size_t mask;
+    AtomEntry* volatile* const slots;
+
+    AtomSlots(size_t size) : mask(size - 1), slots(new AtomEntry* volatile[size])
+    {
+        for (size_t i = 0; i < size; ++i) {
+            slots[i] = NULL;
+        }
+    }
+
+    ~AtomSlots()
+    {
+        delete [] slots;
+    }
+
+    /* Find the slot for a string, either the slot holding it or the empty slot it belongs in */
+    size_t Probe(const char* str, size_t hash) const
+    {
+        size_t i = hash & mask;
+        const AtomEntry* entry;
+        while (((entry = slots[i]) != NULL) && ((entry->hash != hash) || (strcmp(entry->str.c_str(), str) != 0))) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+};
+
+/*
+ * Lookups read the current table without taking the lock. Intern() takes the lock, fills in an
+ * empty slot or publishes a larger table, and uses a memory fence so that a lookup that finds the
+ * new slot or table also sees what it points to.
+ */
+struct AtomTableState {
+    Mutex lock;
+    AtomSlots* volatile table;
+    size_t count;
+    Reclaimer readers;
+
+    /*
+     * Lookup counters of a slot of threads, each on its own cache line. They are updated
+     * without atomic operations so a count may be lost when two threads share a slot.
+     */
+    struct LookupCounters {
+        uint64_t lookups;
+        uint64_t hits;
+        uint8_t pad[64 - 2 * sizeof(uint64_t)];
+    };
+    static const size_t COUNTER_SLOTS = 16;
+    LookupCounters counters[COUNTER_SLOTS];
+
+    AtomTableState() : table(new AtomSlots(INITIAL_SIZE)), count(0)
+    {
+        for (size_t i = 0; i < COUNTER_SLOTS; ++i) {
+            counters[i].lookups = counters[i].hits = 0;
+        }
+    }
+
+    ~AtomTableState()
+    {
+        AtomSlots* t = table;
+        for (size_t i = 0; i <= t->mask; ++i) {
+            delete t->slots[i];
+        }
+        delete t;
+    }
+
+    static const size_t INITIAL_SIZE = 256;
+};
+
+static int atomTableCounter = 0;
+static AtomTableState* atomTableState = NULL;
+
+AtomTableInitializer::AtomTableInitializer()
+{
+    if (0 == atomTableCounter++) {
+        atomTableState = new AtomTableState();
+    }
+}
+
+AtomTableInitializer::~AtomTableInitializer()
+{
+    if (0 == --atomTableCounter) {
+        delete atomTableState;
+        atomTableState = NULL;
+    }
+}
+
+Atom AtomTable::Intern(const char* str)
+{
+    if (!str || !*str) {
+        return NONE;
+    }
+    AtomTableState& state = *atomTableState;
+    size_t hash = hash_string(str);
+    state.lock.Lock(MUTEX_CONTEXT);
+    AtomSlots* table = state.table;
+    AtomSlots* replaced = NULL;
+    size_t i = table->Probe(str, hash);
+    Atom atom;
+    if (table->slots[i] != NULL) {
+        atom = table->slots[i]->atom;
+    } else {
+        atom = static_cast<Atom>(++state.count);
+        AtomEntry* entry = new AtomEntry(str, hash, atom);
+        if ((state.count * 2) > table->mask) {
+            /* Keep the load factor under 1/2 so probe sequences stay short */
+            AtomSlots* larger = new AtomSlots((table->mask + 1) * 2);
+            for (size_t j = 0; j <= table->mask; ++j) {
+                AtomEntry* e = table->slots[j];
+                if (e) {
+                    larger->slots[larger->Probe(e->str.c_str(), e->hash)] = e;
+                }
+            }
+            larger->slots[larger->Probe(str, hash)] = entry;
+            MemoryFence();
+            state.table = larger;
+            replaced = table;
+        } else {
+            MemoryFence();
+            table->slots[i] = entry;
+        }
+    }
+    state.lock.Unlock(MUTEX_CONTEXT);
+    if (replaced) {
+        /* Lookups that started before the larger table was published may still be probing this one */
+        state.readers.Synchronize();
+        delete replaced;
+    }
+    return atom;
+}
+
+Atom AtomTable::Lookup(const char* str)
+{
+    if (!str || !*str) {
+        return NONE;
+    }
+    /*
+     * The entry and table pointers are only dereferenced after they are loaded so the fence in
+     * Intern() is sufficient for the lookup to see the entries they point to.
+     */
+    AtomTableState& state = *atomTableState;
+    size_t hash = hash_string(str);
+    Reclaimer::ScopedReader reader(state.readers);
+    const AtomSlots* table = state.table;
+    const AtomEntry* entry = table->slots[table->Probe(str, hash)];
+    AtomTableState::LookupCounters& counters = state.counters[GetThreadSlot(AtomTableState::COUNTER_SLOTS)];
+    ++counters.lookups;
+    if (entry) {
+        ++counters.hits;
+    }
+    return entry ? entry->atom : UNKNOWN;
+}
+
+void AtomTable::GetStats(Stats& stats)
+{
+    AtomTableState& state = *atomTableState;
+    state.lock.Lock(MUTEX_CONTEXT);
+    stats.size = state.count;
+    stats.capacity = state.table->mask + 1;
+    state.lock.Unlock(MUTEX_CONTEXT);
+    stats.lookups = stats.hits = 0;
+    for (size_t i = 0; i < AtomTableState::COUNTER_SLOTS; ++i) {
+        stats.lookups += state.counters[i].lookups;
+        stats.hits += state.counters[i].hits;
+    }
+}
+
+}
@@ -20,22 +20,62 @@
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
 #include <qcc/IODispatch.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Util.h>
+
+#if defined(QCC_OS_LINUX)
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
 #define QCC_MODULE "IODISPATCH"
 
 using namespace qcc;
 using namespace std;
 
+/* Longest wait for the timer to make room for an alarm before the stream state is checked again */
+static const uint32_t TIMER_FULL_WAIT_MS = 50;
 
-IODispatch::IODispatch(const char* name, uint32_t concurrency) :
-    timer(name, true, concurrency, false, 96),
+#if defined(QCC_OS_LINUX)
+/* Maximum number of ready file descriptors harvested per epoll_wait */
+static const int MAX_EPOLL_EVENTS = 64;
+
+/* epoll events that indicate readiness for a given Event */
+static uint32_t PollEventsFor(Event& evt)
+{
+    return (evt.GetEventType() == Event::IO_WRITE) ? EPOLLOUT : EPOLLIN;
+}
+#endif
+
+IODispatchLoop::IODispatchLoop(const char* name, const char* timerName, uint32_t concurrency) :
+    Thread(name),
+    timer(timerName, true, concurrency, false, 96),
     reload(false),
     isRunning(false),
     numAlarmsInProgress(0),
     crit(false)
 {
-
+#if defined(QCC_OS_LINUX)
+    epollFd = epoll_create(MAX_EPOLL_EVENTS);
+    if (epollFd < 0) {
+        QCC_LogError(ER_OS_ERROR, ("epoll_create failed with %d (%s)", errno, strerror(errno)));
+    } else {
+        fcntl(epollFd, F_SETFD, FD_CLOEXEC);
+        /* The stop event is level-triggered so that an alert is never missed */
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = stopEvent.GetFD();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("epoll_ctl(ADD) of stop event failed with %d (%s)", errno, strerror(errno)));
+        }
+    }
+#endif
 }
-IODispatch::~IODispatch()
+IODispatchLoop::~IODispatchLoop()
 {
     reload = true;
     Stop();
@@ -46,8 +86,13 @@ IODispatch::~IODispatch()
      * Just a sanity check.
      */
     assert(dispatchEntries.size() == 0);
+#if defined(QCC_OS_LINUX)
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+#endif
 }
-QStatus IODispatch::Start()
+QStatus IODispatchLoop::Start()
 {
     /* Start the timer thread */
     QStatus status = timer.Start();
@@ -63,7 +108,7 @@ QStatus IODispatch::Start()
     }
 }
 
-QStatus IODispatch::Stop()
+QStatus IODispatchLoop::Stop()
 {
     lock.Lock();
     isRunning = false;
@@ -84,7 +129,7 @@ QStatus IODispatch::Stop()
     return ER_OK;
 }
 
-QStatus IODispatch::Join()
+QStatus IODispatchLoop::Join()
 {
     lock.Lock();
 
@@ -104,7 +149,7 @@ QStatus IODispatch::Join()
     return ER_OK;
 }
 
-QStatus IODispatch::StartStream(Stream* stream, IOReadListener* readListener, IOWriteListener* writeListener, IOExitListener* exitListener, bool readEnable, bool writeEnable)
+QStatus IODispatchLoop::StartStream(Stream* stream, IOReadListener* readListener, IOWriteListener* writeListener, IOExitListener* exitListener, bool readEnable, bool writeEnable)
 {
     QCC_DbgTrace(("StartStream %p", stream));
 
@@ -126,19 +171,41 @@ QStatus IODispatch::StartStream(Stream* stream, IOReadListener* readListener, IO
     dispatchEntries[stream].readTimeoutCtxt = new CallbackContext(stream, IO_READ_TIMEOUT);
     dispatchEntries[stream].exitCtxt = new CallbackContext(stream, IO_EXIT);
 
-    /* Set reload to false and alert the IODispatch::Run thread */
+#if defined(QCC_OS_LINUX)
+    /* The epoll registration persists for the lifetime of the stream,
+     * so there is no need to alert the IODispatchLoop::Run thread.
+     */
+    QStatus status = RegisterPoll(stream, dispatchEntries[stream]);
+    if (status != ER_OK) {
+        IODispatchEntry& entry = dispatchEntries[stream];
+        delete entry.readCtxt;
+        delete entry.writeCtxt;
+        delete entry.writeTimeoutCtxt;
+        delete entry.readTimeoutCtxt;
+        delete entry.exitCtxt;
+        dispatchEntries.erase(stream);
+    }
+    lock.Unlock();
+    return status;
+#else
+    map<Stream*, IODispatchEntry>::iterator it = dispatchEntries.find(stream);
+    eventEntries[&stream->GetSourceEvent()] = it;
+    eventEntries[&stream->GetSinkEvent()] = it;
+
+    /* Set reload to false and alert the IODispatchLoop::Run thread */
     reload = false;
     lock.Unlock();
 
     Thread::Alert();
-    /* Dont need to wait for the IODispatch::Run thread to reload
+    /* Dont need to wait for the IODispatchLoop::Run thread to reload
      * the set of file descriptors since we are adding a new stream.
      */
     return ER_OK;
+#endif
 }
 
 
-QStatus IODispatch::StopStream(Stream* stream) {
+QStatus IODispatchLoop::StopStream(Stream* stream) {
     lock.Lock();
     QCC_DbgTrace(("StopStream %p", stream));
     map<Stream*, IODispatchEntry>::iterator it = dispatchEntries.find(stream);
@@ -157,23 +224,43 @@ QStatus IODispatch::StopStream(Stream* stream) {
     /* Disable further read and writes on this stream */
     it->second.stopping_state = IO_STOPPING;
 
-    /* Set reload to false and alert the IODispatch::Run thread */
+#if defined(QCC_OS_LINUX)
+    /* Remove the stream from epoll now. Any readiness the Run thread has already
+     * harvested for it is discarded since the stream is no longer IO_RUNNING.
+     */
+    UnregisterPoll(it->second);
+#else
+    /* The stream must not be touched by the Run thread once it has been stopped */
+    eventEntries.erase(&stream->GetSourceEvent());
+    eventEntries.erase(&stream->GetSinkEvent());
+#endif
+
+    /* Set reload to false and alert the IODispatchLoop::Run thread */
     reload = false;
     int when = 0;
     AlarmListener* listener = this;
     if (isRunning) {
+#if defined(QCC_OS_LINUX)
+        /* The main thread is responsible for adding the exit alarm. It does not
+         * need to reload anything, so there is nothing to wait for.
+         */
+        pendingExits.push_back(stream);
+        lock.Unlock();
+        Thread::Alert();
+#else
         /* The main thread is running, so we must wait for it to reload the events.
          * The main thread is responsible for adding the exit alarm in this case.
          */
         Thread::Alert();
 
-        /* Wait until the IODispatch::Run thread reloads the set of check events */
+        /* Wait until the IODispatchLoop::Run thread reloads the set of check events */
         while (!reload && crit && isRunning) {
             lock.Unlock();
             Sleep(1);
             lock.Lock();
         }
         lock.Unlock();
+#endif
     } else {
 
         /* If the main thread has been asked to stopped, it may or may not have
@@ -181,14 +268,14 @@ QStatus IODispatch::StopStream(Stream* stream) {
          * which ensures that the RemoteEndpoint can be joined.
          */
         if (it->second.stopping_state == IO_STOPPING) {
-            /* Add the exit alarm since it has not added by the main IODispatch::Run thread. */
+            /* Add the exit alarm since it has not added by the main IODispatchLoop::Run thread. */
             it->second.stopping_state = IO_STOPPED;
             /* We dont need to keep track of the exit alarm, since we never remove
              * the exit alarm. Hence it is not a part of IODispatchEntry.
              */
             Alarm exitAlarm = Alarm(when, listener, it->second.exitCtxt);
             lock.Unlock();
-            /* At this point, the IODispatch::Run thread will not add any more alarms since it
+            /* At this point, the IODispatchLoop::Run thread will not add any more alarms since it
              * has been told to stop, so it is ok to call the blocking version of AddAlarm
              */
             timer.AddAlarm(exitAlarm);
@@ -199,7 +286,7 @@ QStatus IODispatch::StopStream(Stream* stream) {
 
     return ER_OK;
 }
-QStatus IODispatch::JoinStream(Stream* stream) {
+QStatus IODispatchLoop::JoinStream(Stream* stream) {
     lock.Lock();
     QCC_DbgTrace(("JoinStream %p", stream));
 
@@ -216,7 +303,7 @@ QStatus IODispatch::JoinStream(Stream* stream) {
     lock.Unlock();
     return ER_OK;
 }
-void IODispatch::AlarmTriggered(const Alarm& alarm, QStatus reason)
+void IODispatchLoop::AlarmTriggered(const Alarm& alarm, QStatus reason)
 {
     lock.Lock();
     /* Find the stream associated with this alarm */
@@ -366,7 +453,225 @@ void IODispatch::AlarmTriggered(const Alarm& alarm, QStatus reason)
     }
 }
 
-ThreadReturn STDCALL IODispatch::Run(void* arg) {
+void IODispatchLoop::AddReadyAlarm(map<Stream*, IODispatchEntry>::iterator it, CallbackType type)
+{
+    assert(type == IO_READ || type == IO_WRITE);
+    Stream* stream = it->first;
+    int32_t when = 0;
+    AlarmListener* listener = this;
+
+    Alarm prevAlarm;
+    Alarm alarm;
+    if (type == IO_READ) {
+        prevAlarm = it->second.readAlarm;
+        alarm = Alarm(when, listener, it->second.readCtxt);
+        it->second.readInProgress = true;
+    } else {
+        prevAlarm = it->second.writeAlarm;
+        alarm = Alarm(when, listener, it->second.writeCtxt);
+        it->second.writeInProgress = true;
+    }
+    lock.Unlock();
+    /* Remove the timeout alarm if any first */
+    timer.RemoveAlarm(prevAlarm, true);
+    lock.Lock();
+    QStatus status = ER_TIMER_FULL;
+    it = dispatchEntries.find(stream);
+
+    while (isRunning && status == ER_TIMER_FULL && it != dispatchEntries.end() && it->second.stopping_state == IO_RUNNING) {
+        /* Call the non-blocking version of AddAlarm, while holding the
+         * locks to ensure that the state of the dispatchEntry is valid.
+         */
+        status = timer.AddAlarmNonBlocking(alarm);
+
+        if (status == ER_TIMER_FULL) {
+            lock.Unlock();
+            timer.WaitForRoom(TIMER_FULL_WAIT_MS);
+            lock.Lock();
+        }
+
+        it = dispatchEntries.find(stream);
+    }
+    if (status == ER_OK && it != dispatchEntries.end()) {
+        if (type == IO_READ) {
+            it->second.readAlarm = alarm;
+        } else {
+            it->second.writeAlarm = alarm;
+        }
+    }
+}
+
+#if defined(QCC_OS_LINUX)
+QStatus IODispatchLoop::RegisterPoll(Stream* stream, IODispatchEntry& entry)
+{
+    if (epollFd < 0) {
+        return ER_OS_ERROR;
+    }
+    Event& sourceEvent = stream->GetSourceEvent();
+    Event& sinkEvent = stream->GetSinkEvent();
+    entry.sourceFd = sourceEvent.GetFD();
+    entry.sinkFd = sinkEvent.GetFD();
+    entry.sourcePollEvents = PollEventsFor(sourceEvent);
+    entry.sinkPollEvents = PollEventsFor(sinkEvent);
+
+    int fds[2] = { entry.sourceFd, (entry.sinkFd != entry.sourceFd) ? entry.sinkFd : -1 };
+    for (size_t i = 0; i < ArraySize(fds); ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        /* Register with an empty interest set, UpdatePoll arms it below */
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLET;
+        ev.data.fd = fds[i];
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fds[i], &ev) < 0) {
+            QCC_LogError(ER_OS_ERROR, ("epoll_ctl(ADD) failed for fd %d with %d (%s)", fds[i], errno, strerror(errno)));
+            UnregisterPoll(entry);
+            return ER_OS_ERROR;
+        }
+        pollFds[fds[i]] = dispatchEntries.find(stream);
+    }
+    UpdatePoll(entry);
+    return ER_OK;
+}
+
+void IODispatchLoop::UnregisterPoll(IODispatchEntry& entry)
+{
+    int fds[2] = { entry.sourceFd, (entry.sinkFd != entry.sourceFd) ? entry.sinkFd : -1 };
+    for (size_t i = 0; i < ArraySize(fds); ++i) {
+        if (fds[i] >= 0 && pollFds.erase(fds[i])) {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fds[i], &ev);
+        }
+    }
+    entry.sourceFd = -1;
+    entry.sinkFd = -1;
+}
+
+void IODispatchLoop::UpdatePoll(IODispatchEntry& entry)
+{
+    bool running = (entry.stopping_state == IO_RUNNING);
+    uint32_t readEvents = (running && entry.readEnable && !entry.readInProgress) ? entry.sourcePollEvents : 0;
+    uint32_t writeEvents = (running && entry.writeEnable && !entry.writeInProgress) ? entry.sinkPollEvents : 0;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (entry.sourceFd == entry.sinkFd) {
+        if (entry.sourceFd >= 0) {
+            ev.events = EPOLLET | readEvents | writeEvents;
+            ev.data.fd = entry.sourceFd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, entry.sourceFd, &ev);
+        }
+    } else {
+        if (entry.sourceFd >= 0) {
+            ev.events = EPOLLET | readEvents;
+            ev.data.fd = entry.sourceFd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, entry.sourceFd, &ev);
+        }
+        if (entry.sinkFd >= 0) {
+            ev.events = EPOLLET | writeEvents;
+            ev.data.fd = entry.sinkFd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, entry.sinkFd, &ev);
+        }
+    }
+}
+
+ThreadReturn STDCALL IODispatchLoop::Run(void* arg) {
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    int stopFd = stopEvent.GetFD();
+    int32_t when =  0;
+    AlarmListener* listener = this;
+
+    while (!IsStopping()) {
+        /* Only the file descriptors that are ready are returned, the set of
+         * registered streams is maintained incrementally by the kernel.
+         */
+        int numEvents = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, -1);
+        if (numEvents < 0) {
+            if (errno != EINTR) {
+                QCC_LogError(ER_OS_ERROR, ("epoll_wait failed with %d (%s)", errno, strerror(errno)));
+                qcc::Sleep(10);
+            }
+            continue;
+        }
+
+        bool alerted = false;
+        lock.Lock();
+        for (int i = 0; i < numEvents && isRunning; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == stopFd) {
+                alerted = true;
+                continue;
+            }
+            /* The registration maps the descriptor straight to its dispatch entry */
+            unordered_map<int, map<Stream*, IODispatchEntry>::iterator>::iterator pit = pollFds.find(fd);
+            if (pit == pollFds.end()) {
+                /* Stream was stopped after this event was harvested */
+                continue;
+            }
+            map<Stream*, IODispatchEntry>::iterator it = pit->second;
+            Stream* stream = it->first;
+            if (it->second.stopping_state != IO_RUNNING) {
+                continue;
+            }
+            /* Errors and hangups are reported as readiness, just as select() would */
+            uint32_t ready = events[i].events;
+            uint32_t errs = EPOLLERR | EPOLLHUP;
+            bool writeReady = (fd == it->second.sinkFd) && (ready & (it->second.sinkPollEvents | errs));
+            bool readReady = (fd == it->second.sourceFd) && (ready & (it->second.sourcePollEvents | errs));
+            if (readReady && it->second.readEnable && !it->second.readInProgress) {
+                AddReadyAlarm(it, IO_READ);
+                /* The lock may have been released, so look the entry up again */
+                it = dispatchEntries.find(stream);
+                if (it == dispatchEntries.end() || it->second.stopping_state != IO_RUNNING) {
+                    continue;
+                }
+            }
+            if (writeReady && it->second.writeEnable && !it->second.writeInProgress) {
+                AddReadyAlarm(it, IO_WRITE);
+            }
+        }
+
+        if (alerted) {
+            /* This thread has been alerted or is being stopped. Add exit alarms for any
+             * streams that have been stopped. This is done only after all harvested events
+             * have been processed so that the callback contexts they refer to are still valid.
+             */
+            stopEvent.ResetEvent();
+            while (isRunning && !pendingExits.empty()) {
+                Stream* lookup = pendingExits.back();
+                map<Stream*, IODispatchEntry>::iterator it = dispatchEntries.find(lookup);
+                if (it == dispatchEntries.end() || it->second.stopping_state != IO_STOPPING) {
+                    pendingExits.pop_back();
+                    continue;
+                }
+                Alarm exitAlarm = Alarm(when, listener, it->second.exitCtxt);
+                QStatus status = timer.AddAlarmNonBlocking(exitAlarm);
+                if (status == ER_TIMER_FULL) {
+                    lock.Unlock();
+                    timer.WaitForRoom(TIMER_FULL_WAIT_MS);
+                    lock.Lock();
+                } else if (status == ER_OK) {
+                    it->second.stopping_state = IO_STOPPED;
+                    pendingExits.pop_back();
+                } else {
+                    pendingExits.pop_back();
+                }
+            }
+        }
+        lock.Unlock();
+    }
+    lock.Lock();
+    reload = true;
+    QCC_DbgPrintf(("IODispatchLoop::Run exiting"));
+    lock.Unlock();
+
+    return (ThreadReturn) 0;
+}
+#else
+ThreadReturn STDCALL IODispatchLoop::Run(void* arg) {
 
     vector<qcc::Event*> checkEvents, signaledEvents;
     int32_t when =  0;
@@ -441,7 +746,7 @@ ThreadReturn STDCALL IODispatch::Run(void* arg) {
 
                             if (status == ER_TIMER_FULL) {
                                 lock.Unlock();
-                                qcc::Sleep(2);
+                                timer.WaitForRoom(TIMER_FULL_WAIT_MS);
                                 lock.Lock();
                             }
                             it = dispatchEntries.find(lookup);
@@ -459,90 +764,27 @@ ThreadReturn STDCALL IODispatch::Run(void* arg) {
                 continue;
             } else {
                 lock.Lock();
-                map<Stream*, IODispatchEntry>::iterator it = dispatchEntries.begin();
-                while (it != dispatchEntries.end()) {
-
+                /* Find the stream that owns the signalled event without scanning dispatchEntries */
+                unordered_map<Event*, map<Stream*, IODispatchEntry>::iterator>::iterator eit = eventEntries.find(*i);
+                if (eit != eventEntries.end() && eit->second->second.stopping_state == IO_RUNNING) {
+                    map<Stream*, IODispatchEntry>::iterator it = eit->second;
                     Stream* stream = it->first;
 
-                    if (it->second.stopping_state == IO_RUNNING) {
-                        if (&stream->GetSourceEvent() == *i) {
-
-                            if (it->second.readEnable && !it->second.readInProgress) {
-                                /* If the source event for a particular stream has been signalled,
-                                 * add a readAlarm to fire now, and set readInProgress to true.
-                                 */
-                                Alarm prevAlarm = it->second.readAlarm;
-                                Alarm readAlarm = Alarm(when, listener, it->second.readCtxt);
-                                it->second.readInProgress = true;
-                                lock.Unlock();
-                                /* Remove the read timeout alarm if any first */
-                                timer.RemoveAlarm(prevAlarm, true);
-                                lock.Lock();
-                                QStatus status = ER_TIMER_FULL;
-                                it = dispatchEntries.find(stream);
-
-                                while (isRunning && status == ER_TIMER_FULL && it != dispatchEntries.end() && it->second.stopping_state == IO_RUNNING) {
-                                    /* Call the non-blocking version of AddAlarm, while holding the
-                                     * locks to ensure that the state of the dispatchEntry is valid.
-                                     */
-                                    status = timer.AddAlarmNonBlocking(readAlarm);
-
-                                    if (status == ER_TIMER_FULL) {
-                                        lock.Unlock();
-                                        qcc::Sleep(2);
-                                        lock.Lock();
-                                    }
-
-                                    it = dispatchEntries.find(stream);
-                                }
-                                if (status == ER_OK && it != dispatchEntries.end()) {
-                                    it->second.readAlarm = readAlarm;
-
-                                }
-
-                                break;
-                            }
-
-                        } else if (&stream->GetSinkEvent() == *i) {
-                            if (it->second.writeEnable && !it->second.writeInProgress) {
-                                /* If the sink event for a particular stream has been signalled,
-                                 * add a writeAlarm to fire now, and set writeInProgress to true.
-                                 */
-                                Alarm prevAlarm = it->second.writeAlarm;
-
-                                Alarm writeAlarm = Alarm(when, listener, it->second.writeCtxt);
-                                it->second.writeInProgress = true;
-                                lock.Unlock();
-                                /* Remove the write timeout alarm if any first */
-                                timer.RemoveAlarm(prevAlarm, true);
-                                lock.Lock();
-                                QStatus status = ER_TIMER_FULL;
-
-                                map<Stream*, IODispatchEntry>::iterator it = dispatchEntries.find(stream);
-                                while (isRunning && status == ER_TIMER_FULL &&  it != dispatchEntries.end() && it->second.stopping_state == IO_RUNNING) {
-                                    /* Call the non-blocking version of AddAlarm, while holding the
-                                     * locks to ensure that the state of the dispatchEntry is valid.
-                                     */
-                                    status = timer.AddAlarmNonBlocking(writeAlarm);
-
-                                    if (status == ER_TIMER_FULL) {
-                                        lock.Unlock();
-                                        qcc::Sleep(2);
-                                        lock.Lock();
-                                    }
-
-                                    it = dispatchEntries.find(stream);
-                                }
-                                if (status == ER_OK && it != dispatchEntries.end()) {
-
-                                    it->second.writeAlarm = writeAlarm;
-                                }
-
-                                break;
-                            }
+                    if (&stream->GetSourceEvent() == *i) {
+                        if (it->second.readEnable && !it->second.readInProgress) {
+                            /* If the source event for a particular stream has been signalled,
+                             * add a readAlarm to fire now, and set readInProgress to true.
+                             */
+                            AddReadyAlarm(it, IO_READ);
+                        }
+                    } else if (&stream->GetSinkEvent() == *i) {
+                        if (it->second.writeEnable && !it->second.writeInProgress) {
+                            /* If the sink event for a particular stream has been signalled,
+                             * add a writeAlarm to fire now, and set writeInProgress to true.
+                             */
+                            AddReadyAlarm(it, IO_WRITE);
                         }
                     }
-                    it++;
                 }
                 lock.Unlock();
             }
@@ -551,14 +793,14 @@ ThreadReturn STDCALL IODispatch::Run(void* arg) {
     lock.Lock();
     /* Set isRunning flag and reload flag. */
     reload = true;
-    QCC_DbgPrintf(("IODispatch::Run exiting"));
+    QCC_DbgPrintf(("IODispatchLoop::Run exiting"));
     lock.Unlock();
 
     return (ThreadReturn) 0;
 }
+#endif
 
-
-QStatus IODispatch::EnableReadCallback(const Source* source, uint32_t timeout)
+QStatus IODispatchLoop::EnableReadCallback(const Source* source, uint32_t timeout)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -592,7 +834,7 @@ QStatus IODispatch::EnableReadCallback(const Source* source, uint32_t timeout)
 
             if (status == ER_TIMER_FULL) {
                 lock.Unlock();
-                qcc::Sleep(2);
+                timer.WaitForRoom(TIMER_FULL_WAIT_MS);
                 lock.Lock();
             }
 
@@ -611,16 +853,23 @@ QStatus IODispatch::EnableReadCallback(const Source* source, uint32_t timeout)
         /* Timeout = 0 indicates that no timeout alarm is required for this stream */
         it->second.readInProgress = false;
     }
+#if defined(QCC_OS_LINUX)
+    if (it != dispatchEntries.end()) {
+        UpdatePoll(it->second);
+    }
+    lock.Unlock();
+#else
     lock.Unlock();
 
     Thread::Alert();
-    /* Dont need to wait for the IODispatch::Run thread to reload
+    /* Dont need to wait for the IODispatchLoop::Run thread to reload
      * the set of file descriptors since we're enabling read.
      */
+#endif
     return ER_OK;
 }
 
-QStatus IODispatch::EnableTimeoutCallback(const Source* source, uint32_t timeout)
+QStatus IODispatchLoop::EnableTimeoutCallback(const Source* source, uint32_t timeout)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -665,7 +914,7 @@ QStatus IODispatch::EnableTimeoutCallback(const Source* source, uint32_t timeout
 
             if (status == ER_TIMER_FULL) {
                 lock.Unlock();
-                qcc::Sleep(2);
+                timer.WaitForRoom(TIMER_FULL_WAIT_MS);
                 lock.Lock();
             }
 
@@ -683,7 +932,7 @@ QStatus IODispatch::EnableTimeoutCallback(const Source* source, uint32_t timeout
     lock.Unlock();
     return ER_OK;
 }
-QStatus IODispatch::DisableReadCallback(const Source* source)
+QStatus IODispatchLoop::DisableReadCallback(const Source* source)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -700,18 +949,26 @@ QStatus IODispatch::DisableReadCallback(const Source* source)
         return ER_INVALID_STREAM;
     }
     it->second.readEnable = false;
+#if defined(QCC_OS_LINUX)
+    /* The Run thread checks readEnable under the lock before adding a read alarm,
+     * so there is no need to wait for it.
+     */
+    UpdatePoll(it->second);
+    lock.Unlock();
+#else
     lock.Unlock();
     Thread::Alert();
-    /* Wait until the IODispatch::Run thread reloads the set of check events
+    /* Wait until the IODispatchLoop::Run thread reloads the set of check events
      * since we are disabling read.
      */
     while (!reload && crit && isRunning) {
         Sleep(10);
     }
+#endif
     return ER_OK;
 }
 
-QStatus IODispatch::EnableWriteCallbackNow(Sink* sink)
+QStatus IODispatchLoop::EnableWriteCallbackNow(Sink* sink)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -747,13 +1004,17 @@ QStatus IODispatch::EnableWriteCallbackNow(Sink* sink)
          * Do not block here, since it can create deadlocks.
          */
         it->second.writeInProgress = false;
+#if defined(QCC_OS_LINUX)
+        UpdatePoll(it->second);
+#else
         Thread::Alert();
+#endif
     }
     lock.Unlock();
     return ER_OK;
 }
 
-QStatus IODispatch::EnableWriteCallback(Sink* sink, uint32_t timeout)
+QStatus IODispatchLoop::EnableWriteCallback(Sink* sink, uint32_t timeout)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -788,7 +1049,7 @@ QStatus IODispatch::EnableWriteCallback(Sink* sink, uint32_t timeout)
 
             if (status == ER_TIMER_FULL) {
                 lock.Unlock();
-                qcc::Sleep(2);
+                timer.WaitForRoom(TIMER_FULL_WAIT_MS);
                 lock.Lock();
             }
 
@@ -802,15 +1063,23 @@ QStatus IODispatch::EnableWriteCallback(Sink* sink, uint32_t timeout)
     } else {
         it->second.writeInProgress = false;
     }
+#if defined(QCC_OS_LINUX)
+    it = dispatchEntries.find(lookup);
+    if (it != dispatchEntries.end()) {
+        UpdatePoll(it->second);
+    }
+    lock.Unlock();
+#else
     lock.Unlock();
     Thread::Alert();
 
-    /* Dont need to wait for the IODispatch::Run thread to reload
+    /* Dont need to wait for the IODispatchLoop::Run thread to reload
      * the set of file descriptors, since we are enabling write callback.
      */
+#endif
     return ER_OK;
 }
-QStatus IODispatch::DisableWriteCallback(const Sink* sink)
+QStatus IODispatchLoop::DisableWriteCallback(const Sink* sink)
 {
     lock.Lock();
     /* Dont attempt to modify an entry if the IODispatch is shutting down */
@@ -827,15 +1096,138 @@ QStatus IODispatch::DisableWriteCallback(const Sink* sink)
     }
     it->second.writeEnable = false;
 
+#if defined(QCC_OS_LINUX)
+    UpdatePoll(it->second);
+    lock.Unlock();
+#else
     lock.Unlock();
     Thread::Alert();
-    /* Wait until the IODispatch::Run thread reloads the set of check events
+    /* Wait until the IODispatchLoop::Run thread reloads the set of check events
      * since we are disabling write.
      */
     while (!reload && crit && isRunning) {
         Sleep(10);
     }
+#endif
     return ER_OK;
 }
 
+IODispatch::IODispatch(const char* name, uint32_t concurrency, uint32_t numLoops)
+{
+    if (numLoops == 0) {
+        numLoops = 1;
+    }
+    for (uint32_t i = 0; i < numLoops; ++i) {
+        qcc::String loopName = name;
+        if (numLoops > 1) {
+            loopName += "-";
+            loopName += U32ToString(i);
+        }
+        /*
+         * The callback threads are split across the loops so that adding loops
+         * does not add threads, but every loop needs at least one.
+         */
+        uint32_t loopConcurrency = concurrency / numLoops + ((i < concurrency % numLoops) ? 1 : 0);
+        if (loopConcurrency == 0) {
+            loopConcurrency = 1;
+        }
+        loops.push_back(new IODispatchLoop(loopName.c_str(), name, loopConcurrency));
+    }
+}
+
+IODispatch::~IODispatch()
+{
+    for (size_t i = 0; i < loops.size(); ++i) {
+        delete loops[i];
+    }
+    loops.clear();
+}
 
+IODispatchLoop& IODispatch::LoopFor(const Stream* stream)
+{
+    if (loops.size() == 1) {
+        return *loops[0];
+    }
+    /* Streams are heap allocated, so drop the alignment bits and mix the rest */
+    uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(stream)) >> 4;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return *loops[(h >> 32) % loops.size()];
+}
+
+QStatus IODispatch::Start()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < loops.size() && status == ER_OK; ++i) {
+        status = loops[i]->Start();
+    }
+    if (status != ER_OK) {
+        Stop();
+        Join();
+    }
+    return status;
+}
+
+QStatus IODispatch::Stop()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < loops.size(); ++i) {
+        QStatus s = loops[i]->Stop();
+        status = (status == ER_OK) ? s : status;
+    }
+    return status;
+}
+
+QStatus IODispatch::Join()
+{
+    QStatus status = ER_OK;
+    for (size_t i = 0; i < loops.size(); ++i) {
+        QStatus s = loops[i]->Join();
+        status = (status == ER_OK) ? s : status;
+    }
+    return status;
+}
+
+QStatus IODispatch::StartStream(Stream* stream, IOReadListener* readListener, IOWriteListener* writeListener, IOExitListener* exitListener, bool readEnable, bool writeEnable)
+{
+    return LoopFor(stream).StartStream(stream, readListener, writeListener, exitListener, readEnable, writeEnable);
+}
+
+QStatus IODispatch::StopStream(Stream* stream)
+{
+    return LoopFor(stream).StopStream(stream);
+}
+
+QStatus IODispatch::JoinStream(Stream* stream)
+{
+    return LoopFor(stream).JoinStream(stream);
+}
+
+QStatus IODispatch::EnableReadCallback(const Source* source, uint32_t timeout)
+{
+    return LoopFor((Stream*)source).EnableReadCallback(source, timeout);
+}
+
+QStatus IODispatch::DisableReadCallback(const Source* source)
+{
+    return LoopFor((Stream*)source).DisableReadCallback(source);
+}
+
+QStatus IODispatch::EnableWriteCallback(Sink* sink, uint32_t timeout)
+{
+    return LoopFor((Stream*)sink).EnableWriteCallback(sink, timeout);
+}
+
+QStatus IODispatch::EnableWriteCallbackNow(Sink* sink)
+{
+    return LoopFor((Stream*)sink).EnableWriteCallbackNow(sink);
+}
+
+QStatus IODispatch::DisableWriteCallback(const Sink* sink)
+{
+    return LoopFor((Stream*)sink).DisableWriteCallback(sink);
+}
+
+QStatus IODispatch::EnableTimeoutCallback(const Source* source, uint32_t timeout)
+{
+    return LoopFor((Stream*)source).EnableTimeoutCallback(source, timeout);
+}
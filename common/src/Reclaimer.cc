@@ -0,0 +1,82 @@
+/**
+ * @file
+ *
+ * Tracks lock-free readers so that data they may be using is freed only once they are done.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <qcc/Mutex.h>
+#include <qcc/Reclaimer.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+#include <qcc/atomic.h>
+
+namespace qcc {
+
+const size_t Reclaimer::SLOTS;
+
+Reclaimer::Reclaimer() : epoch(0)
+{
+    for (size_t i = 0; i < SLOTS; ++i) {
+        slots[i].readers[0] = slots[i].readers[1] = 0;
+    }
+}
+
+uint32_t Reclaimer::Enter() const
+{
+    size_t slot = GetThreadSlot(SLOTS);
+    /*
+     * Count the reader in the current epoch. If the epoch changed before it was counted
+     * Synchronize() may not have seen it so count it again in the new epoch.
+     */
+    while (true) {
+        int32_t e = epoch;
+        volatile int32_t* readers = &slots[slot].readers[e & 1];
+        IncrementAndFetch(readers);
+        if (e == epoch) {
+            return static_cast<uint32_t>((slot << 1) | (e & 1));
+        }
+        DecrementAndFetch(readers);
+    }
+}
+
+void Reclaimer::Leave(uint32_t token) const
+{
+    DecrementAndFetch(&slots[token >> 1].readers[token & 1]);
+}
+
+void Reclaimer::Synchronize()
+{
+    /*
+     * Readers that enter after the epoch changes count in the other parity and cannot see data
+     * that was unpublished before. Synchronize() calls are serialized so the readers of the old
+     * epoch are not mixed with those of a later epoch of the same parity.
+     */
+    lock.Lock(MUTEX_CONTEXT);
+    int32_t oldEpoch = IncrementAndFetch(&epoch) - 1;
+    for (size_t i = 0; i < SLOTS; ++i) {
+        while (slots[i].readers[oldEpoch & 1] != 0) {
+            qcc::Sleep(0);
+        }
+    }
+    lock.Unlock(MUTEX_CONTEXT);
+}
+
+}
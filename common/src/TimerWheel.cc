@@ -0,0 +1,273 @@
+/**
+ * @file
+ *
+ * Hierarchical timing wheel that holds the pending alarms of a Timer.
+ */
+
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+
+#include <qcc/platform.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <list>
+
+#include <qcc/Timer.h>
+#include <qcc/TimerWheel.h>
+
+#define QCC_MODULE "TIMER"
+
+using namespace std;
+using namespace qcc;
+
+/* Longest delay returned by NextDelay() so it fits the timeout of an Event */
+static const int64_t MAX_DELAY_MS = 0x3FFFFFFF;
+
+TimerWheel::TimerWheel() : cursor(0), wakeTime(END_OF_TIME)
+{
+    for (size_t i = 0; i < LEVELS; ++i) {
+        counts[i] = 0;
+    }
+}
+
+list<Alarm>& TimerWheel::Slot(size_t level, uint64_t when)
+{
+    if (level == 0) {
+        return slots0[when & (SLOTS_0 - 1)];
+    } else {
+        return slotsN[level - 1][(when >> Shift(level)) & (SLOTS_N - 1)];
+    }
+}
+
+bool TimerWheel::Matches(const Location& loc, const Alarm& alarm) const
+{
+    /* Like Timer, match periodic alarms by id alone since their time changes each period */
+    return alarm->periodMs || ((*loc.it)->alarmTime == alarm->alarmTime);
+}
+
+void TimerWheel::Erase(unordered_map<int32_t, Location>::iterator iter)
+{
+    Location& loc = iter->second;
+    if (loc.level < LEVELS) {
+        --counts[loc.level];
+    }
+    loc.list->erase(loc.it);
+    index.erase(iter);
+}
+
+void TimerWheel::Place(list<Alarm>& from, list<Alarm>::iterator it)
+{
+    uint64_t when = (*it)->alarmTime.GetAbsoluteMillis();
+    list<Alarm>* to;
+    size_t level = LEVELS;
+
+    if (when < cursor) {
+        to = &due;
+    } else {
+        /* Use the finest wheel whose slots reach from the cursor to the alarm */
+        level = 0;
+        while ((level < LEVELS) && ((when >> Shift(level + 1)) != (cursor >> Shift(level + 1)))) {
+            ++level;
+        }
+        if (level < LEVELS) {
+            to = &Slot(level, when);
+            ++counts[level];
+        } else {
+            to = &overflow;
+        }
+    }
+    Location& loc = index.find((*it)->id)->second;
+    to->splice(to->end(), from, it);
+    loc.list = to;
+    loc.level = level;
+}
+
+void TimerWheel::Cascade(list<Alarm>& slot, size_t level)
+{
+    if (level < LEVELS) {
+        counts[level] -= slot.size();
+    }
+    list<Alarm> moving;
+    moving.splice(moving.end(), slot);
+    while (!moving.empty()) {
+        Place(moving, moving.begin());
+    }
+}
+
+void TimerWheel::Advance(uint64_t now)
+{
+    while (cursor <= now) {
+        /* Move alarms in slots that start at this tick down to the finer wheels, coarsest first */
+        if (((cursor & ((static_cast<uint64_t>(1) << Shift(LEVELS)) - 1)) == 0) && !overflow.empty()) {
+            Cascade(overflow, LEVELS);
+        }
+        for (size_t level = LEVELS - 1; level > 0; --level) {
+            if ((cursor & ((static_cast<uint64_t>(1) << Shift(level)) - 1)) == 0) {
+                Cascade(Slot(level, cursor), level);
+            }
+        }
+
+        /* Alarms in the 1 ms slot for this tick are due */
+        list<Alarm>& slot = Slot(0, cursor);
+        if (!slot.empty()) {
+            counts[0] -= slot.size();
+            for (list<Alarm>::iterator it = slot.begin(); it != slot.end(); ++it) {
+                Location& loc = index.find((*it)->id)->second;
+                loc.list = &due;
+                loc.level = LEVELS;
+            }
+            due.splice(due.end(), slot);
+        }
+        ++cursor;
+
+        /* Skip to the next tick where a slot that holds alarms comes up */
+        size_t level = 0;
+        while ((level < LEVELS) && (counts[level] == 0)) {
+            ++level;
+        }
+        if ((level == LEVELS) && overflow.empty()) {
+            cursor = now + 1;
+        } else {
+            uint64_t mask = (static_cast<uint64_t>(1) << Shift(level)) - 1;
+            uint64_t next = (cursor + mask) & ~mask;
+            cursor = (next <= now) ? next : now + 1;
+        }
+    }
+}
+
+bool TimerWheel::Insert(const Alarm& alarm, const Timespec& now)
+{
+    if (index.find(alarm->id) != index.end()) {
+        return false;
+    }
+    uint64_t nowMs = now.GetAbsoluteMillis();
+    uint64_t when = alarm->alarmTime.GetAbsoluteMillis();
+    bool isEarlier = index.empty() || (when < wakeTime);
+
+    /* With nothing on the wheels the cursor can jump straight to now */
+    if (counts[0] == 0 && counts[1] == 0 && counts[2] == 0 && counts[3] == 0 && counts[4] == 0 && overflow.empty()) {
+        cursor = nowMs + 1;
+    }
+
+    list<Alarm> adding;
+    adding.push_back(alarm);
+    index.insert(pair<int32_t, Location>(alarm->id, Location(&adding, adding.begin())));
+    if (when <= nowMs) {
+        /* Alarms that are already due skip the wheels */
+        Location& loc = index.find(alarm->id)->second;
+        due.splice(due.end(), adding);
+        loc.list = &due;
+    } else {
+        Place(adding, adding.begin());
+    }
+    if (isEarlier) {
+        wakeTime = when;
+    }
+    return isEarlier;
+}
+
+bool TimerWheel::Remove(const Alarm& alarm)
+{
+    unordered_map<int32_t, Location>::iterator iter = index.find(alarm->id);
+    if ((iter == index.end()) || !Matches(iter->second, alarm)) {
+        return false;
+    }
+    Erase(iter);
+    return true;
+}
+
+bool TimerWheel::Contains(const Alarm& alarm) const
+{
+    unordered_map<int32_t, Location>::const_iterator iter = index.find(alarm->id);
+    return (iter != index.end()) && Matches(iter->second, alarm);
+}
+
+bool TimerWheel::RemoveListener(const AlarmListener* listener, Alarm& alarm)
+{
+    for (unordered_map<int32_t, Location>::iterator iter = index.begin(); iter != index.end(); ++iter) {
+        if ((*iter->second.it)->listener == listener) {
+            alarm = *iter->second.it;
+            Erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+int64_t TimerWheel::NextDelay(const Timespec& now)
+{
+    uint64_t nowMs = now.GetAbsoluteMillis();
+    Advance(nowMs);
+    if (!due.empty()) {
+        wakeTime = nowMs;
+        return 0;
+    }
+
+    /*
+     * Alarms on a wheel are all in slots from the cursor's slot on and within the cursor's slot
+     * of the next coarser wheel, so a short scan finds the first slot holding alarms. The slot of
+     * a coarser wheel that starts at the cursor may not have moved down yet, so every wheel that
+     * holds alarms is checked.
+     */
+    uint64_t next = END_OF_TIME;
+    for (size_t level = 0; level < LEVELS; ++level) {
+        if (counts[level] == 0) {
+            continue;
+        }
+        size_t slots = (level == 0) ? SLOTS_0 : SLOTS_N;
+        uint64_t base = (cursor >> Shift(level + 1)) << Shift(level + 1);
+        size_t i = (cursor >> Shift(level)) & (slots - 1);
+        while ((i < slots) && Slot(level, base | (static_cast<uint64_t>(i) << Shift(level))).empty()) {
+            ++i;
+        }
+        assert(i < slots);
+        next = min(next, base | (static_cast<uint64_t>(i) << Shift(level)));
+    }
+    if (!overflow.empty()) {
+        uint64_t mask = (static_cast<uint64_t>(1) << Shift(LEVELS)) - 1;
+        next = min(next, (cursor + mask) & ~mask);
+    }
+    if (next == END_OF_TIME) {
+        wakeTime = END_OF_TIME;
+        return MAX_DELAY_MS;
+    }
+    wakeTime = next;
+    return min(static_cast<int64_t>(next - nowMs), MAX_DELAY_MS);
+}
+
+void TimerWheel::PopDue()
+{
+    if (!due.empty()) {
+        Erase(index.find(due.front()->id));
+    }
+}
+
+bool TimerWheel::PopEarliest(Alarm& alarm)
+{
+    unordered_map<int32_t, Location>::iterator earliest = index.end();
+    for (unordered_map<int32_t, Location>::iterator iter = index.begin(); iter != index.end(); ++iter) {
+        if ((earliest == index.end()) || (**iter->second.it < **earliest->second.it)) {
+            earliest = iter;
+        }
+    }
+    if (earliest == index.end()) {
+        return false;
+    }
+    alarm = *earliest->second.it;
+    Erase(earliest);
+    return true;
+}
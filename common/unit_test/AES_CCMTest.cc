@@ -27,7 +27,9 @@
 #include <qcc/KeyBlob.h>
 #include <qcc/String.h>
 #include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
 #include <qcc/Util.h>
+#include <qcc/time.h>
 
 #include <Status.h>
 
@@ -320,3 +322,105 @@ TEST(AES_CCMTest, AES_CCM_Test_Vecter) {
     }
 }
 
+TEST(AES_CCMTest, AES_CCM_Tampered) {
+    for (size_t i = 0; i < ArraySize(testVector); i++) {
+        uint8_t key[16];
+        uint8_t msg[64];
+
+        size_t keyLen = HexStringToBytes(testVector[i].key, key, sizeof(key), ' ');
+        KeyBlob nonce(HexStringToByteString(testVector[i].nonce, ' '), KeyBlob::GENERIC);
+        size_t len = HexStringToBytes(testVector[i].output, msg, sizeof(msg), ' ');
+
+        KeyBlob kb(key, keyLen, KeyBlob::AES);
+        Crypto_AES aes(kb, Crypto_AES::CCM);
+
+        /*
+         * Flip a bit in the encrypted data, decryption must fail and not return any data.
+         */
+        msg[len - testVector[i].authLen - 1] ^= 1;
+        QStatus status = aes.Decrypt_CCM(msg, len, testVector[i].hdrLen, nonce, testVector[i].authLen);
+        EXPECT_EQ(ER_AUTH_FAIL, status) << "Tampered data was not detected for test #" << (i + 1);
+        EXPECT_EQ(testVector[i].hdrLen, len);
+    }
+}
+
+/*
+ * Encrypts and decrypts messages with an AES-CCM instance shared with other threads.
+ */
+class AES_CCMThread : public Thread {
+  public:
+    AES_CCMThread(Crypto_AES& aes, uint8_t id, size_t iterations) :
+        Thread("AES_CCMThread"), failures(0), aes(aes), id(id), iterations(iterations) { }
+
+    size_t failures;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        static const size_t HDR_LEN = 32;
+        static const size_t MSG_LEN = 256;
+        static const uint8_t AUTH_LEN = 8;
+        uint8_t msg[MSG_LEN + AUTH_LEN];
+        uint8_t nd[5];
+        nd[0] = id;
+
+        for (uint32_t n = 0; n < iterations; ++n) {
+            for (size_t i = 0; i < MSG_LEN; ++i) {
+                msg[i] = (uint8_t)(i + n);
+            }
+            nd[1] = (uint8_t)(n >> 24);
+            nd[2] = (uint8_t)(n >> 16);
+            nd[3] = (uint8_t)(n >> 8);
+            nd[4] = (uint8_t)(n);
+            KeyBlob nonce(nd, sizeof(nd), KeyBlob::GENERIC);
+            size_t len = MSG_LEN;
+            if ((aes.Encrypt_CCM(msg, len, HDR_LEN, nonce, AUTH_LEN) != ER_OK) ||
+                (aes.Decrypt_CCM(msg, len, HDR_LEN, nonce, AUTH_LEN) != ER_OK) ||
+                (len != MSG_LEN) || (msg[MSG_LEN - 1] != (uint8_t)(MSG_LEN - 1 + n))) {
+                ++failures;
+            }
+        }
+        return 0;
+    }
+
+  private:
+    Crypto_AES& aes;
+    uint8_t id;
+    size_t iterations;
+};
+
+/*
+ * Benchmark: encrypt and decrypt with a shared key from an increasing number of threads.
+ * Throughput should scale with the thread count because AES-CCM does not take a global lock.
+ */
+TEST(AES_CCMTest, MultiThreadedThroughput) {
+    static const size_t ITERATIONS = 10000;
+    uint8_t key[Crypto_AES::AES128_SIZE];
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (uint8_t)i;
+    }
+    KeyBlob kb(key, sizeof(key), KeyBlob::AES);
+    Crypto_AES aes(kb, Crypto_AES::CCM);
+
+    for (size_t numThreads = 1; numThreads <= 8; numThreads *= 2) {
+        std::vector<AES_CCMThread*> threads;
+        for (size_t i = 0; i < numThreads; ++i) {
+            threads.push_back(new AES_CCMThread(aes, (uint8_t)i, ITERATIONS));
+        }
+        uint64_t start = GetTimestamp64();
+        for (size_t i = 0; i < numThreads; ++i) {
+            EXPECT_EQ(ER_OK, threads[i]->Start());
+        }
+        for (size_t i = 0; i < numThreads; ++i) {
+            threads[i]->Join();
+        }
+        uint64_t elapsed = GetTimestamp64() - start;
+
+        for (size_t i = 0; i < numThreads; ++i) {
+            EXPECT_EQ((size_t)0, threads[i]->failures);
+            delete threads[i];
+        }
+        printf("%u threads: %.0f encrypt+decrypt/sec\n", (unsigned int)numThreads,
+               (1000.0 * numThreads * ITERATIONS) / (elapsed ? elapsed : 1));
+    }
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <qcc/AtomTable.h>
+#include <qcc/String.h>
+#include <qcc/StringUtil.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+
+using namespace qcc;
+
+static qcc::String AtomName(const char* prefix, size_t i)
+{
+    return qcc::String("org.alljoyn.test.AtomTable.") + prefix + U32ToString(static_cast<uint32_t>(i));
+}
+
+TEST(AtomTableTest, InternAndLookup)
+{
+    EXPECT_EQ(AtomTable::NONE, AtomTable::Intern(""));
+    EXPECT_EQ(AtomTable::NONE, AtomTable::Lookup(""));
+
+    Atom a = AtomTable::Intern("org.alljoyn.test.AtomTable");
+    Atom b = AtomTable::Intern(qcc::String("org.alljoyn.test.AtomTable.Other"));
+    EXPECT_NE(AtomTable::NONE, a);
+    EXPECT_NE(AtomTable::UNKNOWN, a);
+    EXPECT_NE(a, b);
+
+    /* Interning the same string from a different buffer gives the same atom */
+    qcc::String copy("org.alljoyn.test.AtomTable");
+    EXPECT_EQ(a, AtomTable::Intern(copy));
+    EXPECT_EQ(a, AtomTable::Lookup(copy.c_str()));
+    EXPECT_EQ(b, AtomTable::Lookup("org.alljoyn.test.AtomTable.Other"));
+}
+
+TEST(AtomTableTest, LookupDoesNotIntern)
+{
+    AtomTable::Stats before;
+    AtomTable::GetStats(before);
+
+    EXPECT_EQ(AtomTable::UNKNOWN, AtomTable::Lookup("org.alljoyn.test.AtomTable.NotInterned"));
+    EXPECT_EQ(AtomTable::UNKNOWN, AtomTable::Lookup("org.alljoyn.test.AtomTable.NotInterned"));
+    Atom a = AtomTable::Intern("org.alljoyn.test.AtomTable.Hit");
+    EXPECT_EQ(a, AtomTable::Lookup("org.alljoyn.test.AtomTable.Hit"));
+
+    AtomTable::Stats after;
+    AtomTable::GetStats(after);
+    EXPECT_EQ(before.size + 1, after.size);
+    EXPECT_EQ(before.lookups + 3, after.lookups);
+    EXPECT_EQ(before.hits + 1, after.hits);
+}
+
+/*
+ * Looks up atoms interned before the thread started while another thread grows the table.
+ */
+class AtomLookupThread : public Thread {
+  public:
+    AtomLookupThread(const std::vector<Atom>& atoms) : Thread("AtomLookupThread"), failures(0), atoms(atoms) { }
+
+    size_t failures;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        for (size_t n = 0; n < 20; ++n) {
+            for (size_t i = 0; i < atoms.size(); ++i) {
+                if (AtomTable::Lookup(AtomName("Known", i).c_str()) != atoms[i]) {
+                    ++failures;
+                }
+            }
+        }
+        return 0;
+    }
+
+  private:
+    const std::vector<Atom>& atoms;
+};
+
+TEST(AtomTableTest, LookupWhileGrowing)
+{
+    std::vector<Atom> atoms;
+    for (size_t i = 0; i < 100; ++i) {
+        atoms.push_back(AtomTable::Intern(AtomName("Known", i)));
+    }
+    AtomTable::Stats before;
+    AtomTable::GetStats(before);
+
+    AtomLookupThread* threads[4];
+    for (size_t t = 0; t < ArraySize(threads); ++t) {
+        threads[t] = new AtomLookupThread(atoms);
+        threads[t]->Start();
+    }
+    /* Intern enough new strings that the table has to grow at least once */
+    for (size_t i = 0; i < before.capacity; ++i) {
+        Atom a = AtomTable::Intern(AtomName("Added", i));
+        EXPECT_EQ(a, AtomTable::Lookup(AtomName("Added", i).c_str()));
+    }
+    for (size_t t = 0; t < ArraySize(threads); ++t) {
+        threads[t]->Join();
+        EXPECT_EQ((size_t)0, threads[t]->failures);
+        delete threads[t];
+    }
+
+    AtomTable::Stats after;
+    AtomTable::GetStats(after);
+    EXPECT_GT(after.capacity, before.capacity);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        EXPECT_EQ(atoms[i], AtomTable::Lookup(AtomName("Known", i).c_str()));
+    }
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * Copyright (c) 2013, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include <sys/resource.h>
+#include <vector>
+
+#include <qcc/IODispatch.h>
+#include <qcc/Socket.h>
+#include <qcc/SocketStream.h>
+#include <qcc/atomic.h>
+#include <qcc/time.h>
+#include <Status.h>
+
+using namespace qcc;
+
+class TestStream : public SocketStream, public IOReadListener, public IOWriteListener, public IOExitListener {
+  public:
+    TestStream(SocketFd sock, IODispatch& dispatch) :
+        SocketStream(sock), dispatch(dispatch), reads(0), writes(0), exited(false) { }
+
+    QStatus ReadCallback(Source& source, bool isTimedOut)
+    {
+        /* Consume a single byte so that re-arming is required to see the rest */
+        char c;
+        size_t actual;
+        if (PullBytes(&c, 1, actual, 0) == ER_OK && actual == 1) {
+            IncrementAndFetch(&reads);
+            IncrementAndFetch(&totalReads);
+        }
+        return dispatch.EnableReadCallback(&source);
+    }
+
+    QStatus WriteCallback(Sink& sink, bool isTimedOut)
+    {
+        IncrementAndFetch(&writes);
+        return dispatch.DisableWriteCallback(&sink);
+    }
+
+    void ExitCallback()
+    {
+        exited = true;
+    }
+
+    IODispatch& dispatch;
+    volatile int32_t reads;
+    volatile int32_t writes;
+    volatile bool exited;
+
+    static volatile int32_t totalReads;
+};
+
+volatile int32_t TestStream::totalReads = 0;
+
+static bool WaitFor(volatile int32_t& counter, int32_t expected)
+{
+    for (int i = 0; i < 500 && counter < expected; ++i) {
+        qcc::Sleep(10);
+    }
+    return counter == expected;
+}
+
+TEST(IODispatchTest, ReadWriteAndExit)
+{
+    IODispatch dispatch("iodispatchtest", 4);
+    ASSERT_EQ(ER_OK, dispatch.Start());
+
+    SocketFd fds[2];
+    ASSERT_EQ(ER_OK, SocketPair(fds));
+    TestStream* stream = new TestStream(fds[0], dispatch);
+    SocketStream peer(fds[1]);
+
+    ASSERT_EQ(ER_OK, dispatch.StartStream(stream, stream, stream, stream, true, true));
+
+    /* The socket is writable so the write callback must fire once and then be disabled */
+    EXPECT_TRUE(WaitFor(stream->writes, 1));
+
+    /* Each byte is consumed by a separate read callback */
+    size_t sent;
+    ASSERT_EQ(ER_OK, peer.PushBytes("abcde", 5, sent));
+    EXPECT_TRUE(WaitFor(stream->reads, 5));
+
+    EXPECT_EQ(ER_OK, dispatch.EnableWriteCallbackNow(stream));
+    EXPECT_TRUE(WaitFor(stream->writes, 2));
+
+    EXPECT_EQ(ER_OK, dispatch.StopStream(stream));
+    EXPECT_EQ(ER_OK, dispatch.JoinStream(stream));
+    EXPECT_TRUE(stream->exited);
+    delete stream;
+
+    dispatch.Stop();
+    dispatch.Join();
+}
+
+static void TestManyStreams(uint32_t numLoops)
+{
+    static const size_t NUM_STREAMS = 200;
+    IODispatch dispatch("iodispatchtest", 4, numLoops);
+    ASSERT_EQ(numLoops, dispatch.GetNumLoops());
+    ASSERT_EQ(ER_OK, dispatch.Start());
+
+    TestStream* streams[NUM_STREAMS];
+    SocketStream* peers[NUM_STREAMS];
+    for (size_t i = 0; i < NUM_STREAMS; ++i) {
+        SocketFd fds[2];
+        ASSERT_EQ(ER_OK, SocketPair(fds));
+        streams[i] = new TestStream(fds[0], dispatch);
+        peers[i] = new SocketStream(fds[1]);
+        ASSERT_EQ(ER_OK, dispatch.StartStream(streams[i], streams[i], streams[i], streams[i], true, false));
+    }
+
+    /* Only the streams that have data must see read callbacks */
+    size_t sent;
+    for (size_t i = 0; i < NUM_STREAMS; i += 2) {
+        ASSERT_EQ(ER_OK, peers[i]->PushBytes("x", 1, sent));
+    }
+    for (size_t i = 0; i < NUM_STREAMS; ++i) {
+        EXPECT_TRUE(WaitFor(streams[i]->reads, (i % 2) ? 0 : 1));
+    }
+
+    for (size_t i = 0; i < NUM_STREAMS; ++i) {
+        EXPECT_EQ(ER_OK, dispatch.StopStream(streams[i]));
+    }
+    for (size_t i = 0; i < NUM_STREAMS; ++i) {
+        EXPECT_EQ(ER_OK, dispatch.JoinStream(streams[i]));
+        EXPECT_TRUE(streams[i]->exited);
+        delete streams[i];
+        delete peers[i];
+    }
+
+    dispatch.Stop();
+    dispatch.Join();
+}
+
+TEST(IODispatchTest, ManyStreams)
+{
+    TestManyStreams(1);
+}
+
+TEST(IODispatchTest, ManyStreamsShardedLoops)
+{
+    TestManyStreams(4);
+}
+
+/*
+ * Micro-benchmark: time taken to dispatch read callbacks for a small number of ready
+ * streams while many idle streams are registered. Dispatch cost should depend on the
+ * number of ready streams, not on the number registered.
+ */
+TEST(IODispatchTest, ReadyDispatchWithManyRegisteredStreams)
+{
+    static const size_t NUM_STREAMS = 5000;
+    static const size_t NUM_READY = 500;
+    static const size_t NUM_ROUNDS = 20;
+
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    size_t numStreams = NUM_STREAMS;
+    if (rl.rlim_cur != RLIM_INFINITY && (2 * numStreams + 64) > rl.rlim_cur) {
+        numStreams = (rl.rlim_cur - 64) / 2;
+        printf("File descriptor limit allows only %u streams\n", (unsigned int)numStreams);
+    }
+
+    IODispatch dispatch("iodispatchbench", 4);
+    ASSERT_EQ(ER_OK, dispatch.Start());
+    TestStream::totalReads = 0;
+
+    std::vector<TestStream*> streams(numStreams);
+    std::vector<SocketStream*> peers(numStreams);
+    for (size_t i = 0; i < numStreams; ++i) {
+        SocketFd fds[2];
+        ASSERT_EQ(ER_OK, SocketPair(fds));
+        streams[i] = new TestStream(fds[0], dispatch);
+        peers[i] = new SocketStream(fds[1]);
+        ASSERT_EQ(ER_OK, dispatch.StartStream(streams[i], streams[i], streams[i], streams[i], true, false));
+    }
+
+    size_t sent;
+    size_t stride = numStreams / NUM_READY;
+    int32_t expected = 0;
+    uint64_t start = GetTimestamp64();
+    for (size_t round = 0; round < NUM_ROUNDS; ++round) {
+        for (size_t i = 0; i < NUM_READY; ++i) {
+            ASSERT_EQ(ER_OK, peers[i * stride + round % stride]->PushBytes("x", 1, sent));
+        }
+        expected += NUM_READY;
+        for (int i = 0; i < 5000 && TestStream::totalReads < expected; ++i) {
+            qcc::Sleep(1);
+        }
+        ASSERT_EQ(expected, TestStream::totalReads);
+    }
+    uint64_t elapsed = GetTimestamp64() - start;
+    printf("%u registered streams: %u ready events dispatched in %u ms (%.1f us/event)\n",
+           (unsigned int)numStreams, (unsigned int)(NUM_READY * NUM_ROUNDS), (unsigned int)elapsed,
+           (1000.0 * elapsed) / (NUM_READY * NUM_ROUNDS));
+
+    for (size_t i = 0; i < numStreams; ++i) {
+        EXPECT_EQ(ER_OK, dispatch.StopStream(streams[i]));
+    }
+    for (size_t i = 0; i < numStreams; ++i) {
+        EXPECT_EQ(ER_OK, dispatch.JoinStream(streams[i]));
+        delete streams[i];
+        delete peers[i];
+    }
+
+    dispatch.Stop();
+    dispatch.Join();
+}
@@ -54,4 +54,25 @@ TEST(ManagedObjTest, ManagedObj) {
     EXPECT_EQ(0, foo0->GetValue());
     EXPECT_EQ(0, foo1->GetValue());
 
-}
\ No newline at end of file
+}
+TEST(ManagedObjTest, Null) {
+    ManagedObj<Managed> null = ManagedObj<Managed>::Null();
+    EXPECT_EQ(0, null.GetRefCount());
+    EXPECT_TRUE(null.unwrap() == NULL);
+
+    /* Copies of a null managed object are null too */
+    ManagedObj<Managed> copy(null);
+    EXPECT_TRUE(copy.unwrap() == NULL);
+
+    /* A null managed object can be assigned and then refers to the assigned object */
+    ManagedObj<Managed> foo;
+    foo->SetValue(1);
+    copy = foo;
+    EXPECT_EQ(2, foo.GetRefCount());
+    EXPECT_EQ(1, copy->GetValue());
+
+    /* Assigning null releases the reference */
+    copy = ManagedObj<Managed>::Null();
+    EXPECT_EQ(1, foo.GetRefCount());
+    EXPECT_TRUE(copy.unwrap() == NULL);
+}
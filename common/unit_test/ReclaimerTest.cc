@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright (c) 2014, AllSeen Alliance. All rights reserved.
+ *
+ *    Permission to use, copy, modify, and/or distribute this software for any
+ *    purpose with or without fee is hereby granted, provided that the above
+ *    copyright notice and this permission notice appear in all copies.
+ *
+ *    THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *    WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *    MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *    ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *    WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ ******************************************************************************/
+#include <gtest/gtest.h>
+
+#include <qcc/Reclaimer.h>
+#include <qcc/Thread.h>
+#include <qcc/Util.h>
+#include <qcc/atomic.h>
+
+using namespace qcc;
+
+/*
+ * Calls Synchronize() and records whether it has returned.
+ */
+class SynchronizeThread : public Thread {
+  public:
+    SynchronizeThread(Reclaimer& reclaimer) : Thread("SynchronizeThread"), done(0), reclaimer(reclaimer) { }
+
+    volatile int32_t done;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        reclaimer.Synchronize();
+        IncrementAndFetch(&done);
+        return 0;
+    }
+
+  private:
+    Reclaimer& reclaimer;
+};
+
+TEST(ReclaimerTest, SynchronizeWaitsForEarlierReaders)
+{
+    Reclaimer reclaimer;
+    uint32_t token = reclaimer.Enter();
+
+    SynchronizeThread thread(reclaimer);
+    thread.Start();
+    qcc::Sleep(100);
+    EXPECT_EQ(0, thread.done);
+
+    /* A reader that enters after Synchronize() was called does not hold it up */
+    uint32_t later = reclaimer.Enter();
+    reclaimer.Leave(token);
+    thread.Join();
+    EXPECT_EQ(1, thread.done);
+    reclaimer.Leave(later);
+}
+
+TEST(ReclaimerTest, SynchronizeWithoutReaders)
+{
+    Reclaimer reclaimer;
+    reclaimer.Synchronize();
+    {
+        Reclaimer::ScopedReader reader(reclaimer);
+    }
+    reclaimer.Synchronize();
+}
+
+/*
+ * Reads a published value until stopped, checking that it has not been freed.
+ */
+class ReaderThread : public Thread {
+  public:
+    ReaderThread(const Reclaimer& reclaimer, int32_t* volatile& published) :
+        Thread("ReaderThread"), failures(0), reads(0), reclaimer(reclaimer), published(published) { }
+
+    size_t failures;
+    volatile size_t reads;
+
+  protected:
+    ThreadReturn STDCALL Run(void* arg)
+    {
+        while (!IsStopping()) {
+            Reclaimer::ScopedReader reader(reclaimer);
+            int32_t* value = published;
+            if (*value != 42) {
+                ++failures;
+            }
+            ++reads;
+        }
+        return 0;
+    }
+
+  private:
+    const Reclaimer& reclaimer;
+    int32_t* volatile& published;
+};
+
+TEST(ReclaimerTest, ReplacedValuesAreNotInUseWhenFreed)
+{
+    Reclaimer reclaimer;
+    int32_t* volatile published = new int32_t(42);
+
+    ReaderThread* threads[4];
+    for (size_t t = 0; t < ArraySize(threads); ++t) {
+        threads[t] = new ReaderThread(reclaimer, published);
+        threads[t]->Start();
+    }
+    for (size_t t = 0; t < ArraySize(threads); ++t) {
+        while (threads[t]->reads == 0) {
+            qcc::Sleep(1);
+        }
+    }
+    for (size_t i = 0; i < 2000; ++i) {
+        int32_t* replaced = published;
+        int32_t* value = new int32_t(42);
+        MemoryFence();
+        published = value;
+        reclaimer.Synchronize();
+        /* Poison the value so a reader still using it would notice */
+        *replaced = 0;
+        delete replaced;
+    }
+    for (size_t t = 0; t < ArraySize(threads); ++t) {
+        threads[t]->Stop();
+        threads[t]->Join();
+        EXPECT_EQ((size_t)0, threads[t]->failures);
+        delete threads[t];
+    }
+    delete published;
+}
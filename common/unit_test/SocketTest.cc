@@ -14,6 +14,8 @@
  *    ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
  *    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  ******************************************************************************/
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <Status.h>
@@ -375,3 +377,56 @@ TEST(SocketTest, send_and_receive_with_dummy_fds) {
                "\n\t      Status (socket pair creation) was %s.", QCC_StatusText(status));
     }
 }
+
+TEST(SocketTest, send_sg_gathers_buffers) {
+    const char* parts[] = { "That smugness ", "", "of yours really is ", "an attractive quality." };
+    IOVec iov[ArraySize(parts)];
+    size_t total = 0;
+    for (size_t i = 0; i < ArraySize(parts); ++i) {
+        iov[i].buf = const_cast<char*>(parts[i]);
+        iov[i].len = strlen(parts[i]);
+        total += iov[i].len;
+    }
+
+    SocketFd fds[2];
+    ASSERT_EQ(ER_OK, SocketPair(fds));
+
+    size_t sent = 0;
+    EXPECT_EQ(ER_OK, SendSG(fds[0], iov, ArraySize(iov), sent));
+    EXPECT_EQ(total, sent);
+
+    char heard[128];
+    size_t received = 0;
+    EXPECT_EQ(ER_OK, Recv(fds[1], heard, sizeof(heard), received));
+    EXPECT_EQ(total, received);
+    EXPECT_EQ(0, memcmp(heard, "That smugness of yours really is an attractive quality.", total));
+
+    Close(fds[0]);
+    Close(fds[1]);
+}
+
+#if defined(QCC_OS_GROUP_POSIX)
+TEST(SocketTest, send_sg_more_entries_than_the_os_takes) {
+    /*
+     * One byte per entry.  Anything beyond the OS limit on entries is left
+     * for the caller to send later, as with any other short write.
+     */
+    std::vector<IOVec> iov(QCC_MAX_SG_ENTRIES + 1);
+    char byte = 'x';
+    for (size_t i = 0; i < iov.size(); ++i) {
+        iov[i].buf = &byte;
+        iov[i].len = 1;
+    }
+
+    SocketFd fds[2];
+    ASSERT_EQ(ER_OK, SocketPair(fds));
+
+    size_t sent = 0;
+    EXPECT_EQ(ER_OK, SendSG(fds[0], &iov[0], iov.size(), sent));
+    EXPECT_LT((size_t)0, sent);
+    EXPECT_GT(iov.size(), sent);
+
+    Close(fds[0]);
+    Close(fds[1]);
+}
+#endif
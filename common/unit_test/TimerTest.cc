@@ -16,8 +16,10 @@
 #include <gtest/gtest.h>
 
 #include <deque>
+#include <vector>
 
 #include <qcc/Timer.h>
+#include <qcc/Util.h>
 #include <Status.h>
 
 using namespace std;
@@ -198,3 +200,46 @@ TEST(TimerTest, TestReplaceTimer) {
 
     ASSERT_TRUE(testNextAlarm(ts + 5000, 0));
 }
+
+TEST(TimerTest, TimerWheelOrdering) {
+    TimerWheel wheel;
+    const uint64_t start = 1400000000000ULL;
+    Timespec now(start);
+
+    /* Spread alarms across every wheel and the overflow list */
+    static const uint64_t offsets[] = { 0, 1, 2, 255, 256, 257, 1000, 16383, 16384, 70000, 1048576, 5000000, 67108864, 300000000, 4294967296ULL, 5000000000ULL };
+    static const size_t numOffsets = ArraySize(offsets);
+    AlarmListener* listener = NULL;
+    std::vector<Alarm> alarms;
+    for (size_t i = 0; i < numOffsets; ++i) {
+        Timespec when(start + offsets[i]);
+        alarms.push_back(Alarm(when, listener));
+        wheel.Insert(alarms.back(), now);
+    }
+    Timespec later(start + 20000);
+    Alarm canceled(later, listener);
+    wheel.Insert(canceled, now);
+    EXPECT_EQ(numOffsets + 1, wheel.size());
+    EXPECT_TRUE(wheel.Contains(canceled));
+    EXPECT_TRUE(wheel.Remove(canceled));
+    EXPECT_FALSE(wheel.Contains(canceled));
+    EXPECT_FALSE(wheel.Remove(canceled));
+
+    /* Each alarm must come off the due queue exactly when its time is reached */
+    size_t next = 0;
+    while (!wheel.empty()) {
+        int64_t delay = wheel.NextDelay(now);
+        if (delay > 0) {
+            now = Timespec(now.GetAbsoluteMillis() + delay);
+            continue;
+        }
+        const Alarm* due = wheel.FrontDue();
+        ASSERT_TRUE(due != NULL);
+        ASSERT_LT(next, numOffsets);
+        EXPECT_TRUE(*due == alarms[next]);
+        EXPECT_EQ(start + offsets[next], now.GetAbsoluteMillis());
+        wheel.PopDue();
+        ++next;
+    }
+    EXPECT_EQ(numOffsets, next);
+}